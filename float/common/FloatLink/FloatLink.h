@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// FLOAT <-> CONTROL STATION BULK LINK (ESP-NOW)
+// ============================================================================
+// Shared by onboard_float and control_station (lib_extra_dirs = ../common).
+//
+// A transfer moves one byte blob (e.g. the mission log) as numbered chunks
+// of up to LINK_CHUNK_BYTES, one chunk per ESP-NOW frame. The sender keeps
+// at most LINK_WINDOW chunks in flight. The receiver answers with a
+// cumulative base plus a selective-ACK bitmap; any chunk still missing
+// after LINK_RTO_MS is sent again. Every data frame carries the blob size,
+// so the receiver knows when it is complete from whichever frame arrives,
+// and a transfer number the sender gives the blob. A receiver holding part
+// of a blob resumes it only when both match; anything else starts over, and
+// an ACK for another transfer is ignored.
+//
+// Frames start with a type byte outside the printable range, so they can
+// not be confused with the legacy struct_* packets that start with text.
+//
+// Live telemetry (link_telemetry_frame) uses the same framing but is fire
+// and forget: no ACK, no retransmit, a lost frame is simply superseded.
+
+#define LINK_MAX_FRAME 250          // ESP-NOW payload limit
+#define LINK_DATA_HEADER 10
+#define LINK_CHUNK_BYTES 240
+#define LINK_WINDOW 16              // chunks in flight (<= 32, SACK width)
+#define LINK_ACK_EVERY 4            // receiver acks at least every N chunks
+#define LINK_RTO_MS 100             // retransmit a chunk unacked this long
+#define LINK_GIVE_UP_MS 5000        // sender stops after this long without an ack
+#define LINK_BURST 8                // frames sent per poll()
+
+enum LinkFrameType : uint8_t {
+    LINK_DATA = 0xD1,
+    LINK_ACK = 0xA1,
+    LINK_TELEMETRY = 0xE1
+};
+
+enum LinkStream : uint8_t {
+    STREAM_MISSION_LOG = 1,
+    STREAM_TRACE = 2,           // high-rate engineering trace (TraceLog.h)
+    STREAM_PROBES = 3           // hot-path timing report (FloatProbe.h)
+};
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // LINK_DATA
+    uint8_t stream;         // LinkStream
+    uint8_t transfer;       // same number and size: the same blob
+    uint16_t seq;           // chunk index
+    uint32_t total_bytes;   // size of the whole blob
+    uint8_t len;            // payload bytes in this frame
+    uint8_t payload[LINK_CHUNK_BYTES];
+} link_data_frame;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // LINK_ACK
+    uint8_t stream;
+    uint8_t transfer;       // of the data frames being acked
+    uint16_t base;          // every chunk below this has arrived
+    uint32_t sack;          // bit i set: chunk base + 1 + i has arrived
+} link_ack_frame;
+
+static_assert(sizeof(link_data_frame) <= LINK_MAX_FRAME, "a data frame must fit one ESP-NOW frame");
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // LINK_TELEMETRY
+    uint16_t seq;           // +1 per frame the float tried to send
+    uint32_t sent_ms;       // float clock (millis) at send
+    uint8_t state;          // MissionState
+    uint8_t segment;        // mission segment index (MissionPlan.h)
+    uint8_t hold_packets;   // valid packets of the current hold (0-7)
+    int16_t depth_mm;       // filtered depth
+    int16_t velocity_mm_s;  // filtered, + = sinking
+    int16_t piston;         // position (steps)
+} link_telemetry_frame;
+
+inline bool isLinkFrame(const uint8_t* data, int len) {
+    return len >= 1 && (data[0] == LINK_DATA || data[0] == LINK_ACK || data[0] == LINK_TELEMETRY);
+}
+
+inline uint16_t linkChunkCount(uint32_t total_bytes) {
+    // An empty blob still takes one (empty) chunk to announce its size
+    if (total_bytes == 0) return 1;
+    return (uint16_t)((total_bytes + LINK_CHUNK_BYTES - 1) / LINK_CHUNK_BYTES);
+}
@@ -0,0 +1,192 @@
+#include "LogLink.h"
+#include <string.h>
+
+// ============================================================================
+// SENDER
+// ============================================================================
+
+LogLinkSender::LogLinkSender(SendFn send, void* send_ctx)
+    : send_(send), send_ctx_(send_ctx) {
+    memset(sent_ms_, 0, sizeof(sent_ms_));
+}
+
+void LogLinkSender::begin(uint8_t stream, uint8_t transfer, uint32_t total_bytes, ReadFn read,
+                          void* read_ctx, uint32_t now_ms) {
+    stream_ = stream;
+    transfer_ = transfer;
+    total_bytes_ = total_bytes;
+    total_chunks_ = linkChunkCount(total_bytes);
+    read_ = read;
+    read_ctx_ = read_ctx;
+    base_ = 0;
+    next_ = 0;
+    acked_ = 0;
+    last_ack_ms_ = now_ms;
+    active_ = true;
+    complete_ = false;
+    failed_ = false;
+    frames_sent_ = 0;
+    retransmits_ = 0;
+}
+
+bool LogLinkSender::sendChunk(uint16_t seq) {
+    link_data_frame frame;
+    uint32_t offset = (uint32_t)seq * LINK_CHUNK_BYTES;
+    uint32_t remaining = total_bytes_ > offset ? total_bytes_ - offset : 0;
+    size_t len = remaining > LINK_CHUNK_BYTES ? LINK_CHUNK_BYTES : remaining;
+
+    frame.type = LINK_DATA;
+    frame.stream = stream_;
+    frame.transfer = transfer_;
+    frame.seq = seq;
+    frame.total_bytes = total_bytes_;
+    frame.len = (uint8_t)read_(offset, frame.payload, len, read_ctx_);
+
+    if (!send_((const uint8_t*)&frame, LINK_DATA_HEADER + frame.len, send_ctx_)) return false;
+    frames_sent_++;
+    return true;
+}
+
+void LogLinkSender::onAck(const link_ack_frame& ack, uint32_t now_ms) {
+    if (!active_ || ack.type != LINK_ACK || ack.stream != stream_ || ack.transfer != transfer_) return;
+    last_ack_ms_ = now_ms;
+
+    // The receiver may already hold chunks from an earlier, interrupted
+    // request: its base can run ahead of what this sender has sent
+    uint16_t base = ack.base > total_chunks_ ? total_chunks_ : ack.base;
+    if (base > base_) {
+        uint16_t shift = base - base_;
+        acked_ = shift >= 32 ? 0 : acked_ >> shift;
+        base_ = base;
+        if (next_ < base_) next_ = base_;
+    }
+    if (base == base_) acked_ |= ack.sack << 1;
+
+    if (base_ >= total_chunks_) {
+        active_ = false;
+        complete_ = true;
+    }
+}
+
+void LogLinkSender::poll(uint32_t now_ms) {
+    if (!active_) return;
+
+    if (now_ms - last_ack_ms_ >= LINK_GIVE_UP_MS) {
+        active_ = false;
+        failed_ = true;
+        return;
+    }
+
+    int budget = LINK_BURST;
+
+    // Retransmit anything in flight that has not been acked in time
+    for (uint16_t seq = base_; seq < next_ && budget > 0; seq++) {
+        uint16_t rel = seq - base_;
+        if (acked_ & (1u << rel)) continue;
+        uint32_t& sent = sent_ms_[seq % LINK_WINDOW];
+        if (now_ms - sent < LINK_RTO_MS) continue;
+        if (!sendChunk(seq)) return;     // radio queue full, try next poll
+        sent = now_ms;
+        retransmits_++;
+        budget--;
+    }
+
+    // Then open the window with new chunks
+    while (budget > 0 && next_ < total_chunks_ && next_ < base_ + LINK_WINDOW) {
+        if (acked_ & (1u << (next_ - base_))) {
+            next_++;                     // receiver kept it from an earlier try
+            continue;
+        }
+        if (!sendChunk(next_)) return;
+        sent_ms_[next_ % LINK_WINDOW] = now_ms;
+        next_++;
+        budget--;
+    }
+}
+
+// ============================================================================
+// RECEIVER
+// ============================================================================
+
+LogLinkReceiver::LogLinkReceiver(uint8_t stream, DeliverFn deliver, void* ctx)
+    : stream_(stream), deliver_(deliver), ctx_(ctx) {
+    memset(slot_len_, 0, sizeof(slot_len_));
+}
+
+void LogLinkReceiver::reset() {
+    started_ = false;
+    transfer_ = 0;
+    total_bytes_ = 0;
+    base_ = 0;
+    have_ = 0;
+    since_ack_ = 0;
+    delivered_bytes_ = 0;
+    duplicates_ = 0;
+}
+
+void LogLinkReceiver::fillAck(link_ack_frame& ack) const {
+    ack.type = LINK_ACK;
+    ack.stream = stream_;
+    ack.transfer = transfer_;
+    ack.base = base_;
+    ack.sack = have_ >> 1;
+}
+
+bool LogLinkReceiver::onFrame(const uint8_t* data, size_t len, link_ack_frame& ack) {
+    if (len < LINK_DATA_HEADER || data[0] != LINK_DATA) return false;
+    link_data_frame frame;
+    memcpy(&frame, data, len > sizeof(frame) ? sizeof(frame) : len);
+    if (frame.stream != stream_) return false;
+    if (frame.len > LINK_CHUNK_BYTES || (size_t)LINK_DATA_HEADER + frame.len > len) return false;
+
+    // First frame of a transfer, or a different blob than the one in progress
+    if (!started_ || frame.transfer != transfer_ || frame.total_bytes != total_bytes_) {
+        reset();
+        started_ = true;
+        transfer_ = frame.transfer;
+        total_bytes_ = frame.total_bytes;
+    }
+
+    uint16_t seq = frame.seq;
+    if (seq < base_) {
+        // Already delivered: our ack got lost, repeat it now
+        duplicates_++;
+        fillAck(ack);
+        return true;
+    }
+    if (seq >= base_ + LINK_WINDOW) {
+        // Sender is ahead of our window; tell it where we are
+        fillAck(ack);
+        return true;
+    }
+
+    uint16_t rel = seq - base_;
+    if (have_ & (1u << rel)) {
+        duplicates_++;
+    } else {
+        uint8_t slot = seq % LINK_WINDOW;
+        memcpy(slots_[slot], frame.payload, frame.len);
+        slot_len_[slot] = frame.len;
+        have_ |= 1u << rel;
+        since_ack_++;
+    }
+
+    // Hand over everything that is now contiguous
+    while (have_ & 1u) {
+        uint8_t slot = base_ % LINK_WINDOW;
+        if (slot_len_[slot]) deliver_(slots_[slot], slot_len_[slot], ctx_);
+        delivered_bytes_ += slot_len_[slot];
+        have_ >>= 1;
+        base_++;
+    }
+
+    // Ack promptly on a gap (so the sender can fill it) or at the end,
+    // otherwise every LINK_ACK_EVERY chunks
+    bool gap = have_ != 0;
+    if (gap || complete() || since_ack_ >= LINK_ACK_EVERY) {
+        since_ack_ = 0;
+        fillAck(ack);
+        return true;
+    }
+    return false;
+}
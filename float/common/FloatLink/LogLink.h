@@ -0,0 +1,95 @@
+#pragma once
+
+#include "FloatLink.h"
+
+// ============================================================================
+// SLIDING-WINDOW SENDER / RECEIVER
+// ============================================================================
+// Both ends are transport-agnostic: the sender pulls blob bytes through a
+// read callback and pushes frames through a send callback, the receiver
+// hands in-order bytes to a deliver callback and returns the ACK to send.
+// Neither allocates; the receiver buffers at most one window of chunks.
+
+class LogLinkSender {
+public:
+    typedef size_t (*ReadFn)(uint32_t offset, uint8_t* dst, size_t len, void* ctx);
+    typedef bool (*SendFn)(const uint8_t* frame, size_t len, void* ctx);
+
+    LogLinkSender(SendFn send, void* send_ctx);
+
+    // 'transfer' names the blob: give a changed blob a new number, and the
+    // same number to a repeat of an unchanged one so the receiver resumes.
+    void begin(uint8_t stream, uint8_t transfer, uint32_t total_bytes, ReadFn read, void* read_ctx,
+               uint32_t now_ms);
+    void onAck(const link_ack_frame& ack, uint32_t now_ms);
+
+    // Send new chunks and retransmit overdue ones. Call every loop.
+    void poll(uint32_t now_ms);
+
+    bool active() const { return active_; }
+    bool complete() const { return complete_; }
+    bool failed() const { return failed_; }
+    uint32_t framesSent() const { return frames_sent_; }
+    uint32_t retransmits() const { return retransmits_; }
+
+private:
+    bool sendChunk(uint16_t seq);
+
+    SendFn send_;
+    void* send_ctx_;
+    ReadFn read_ = nullptr;
+    void* read_ctx_ = nullptr;
+
+    uint8_t stream_ = 0;
+    uint8_t transfer_ = 0;
+    uint32_t total_bytes_ = 0;
+    uint16_t total_chunks_ = 0;
+    uint16_t base_ = 0;             // oldest unacked chunk
+    uint16_t next_ = 0;             // next never-sent chunk
+    uint32_t acked_ = 0;            // bit i: chunk base_ + i acked
+    uint32_t sent_ms_[LINK_WINDOW];
+    uint32_t last_ack_ms_ = 0;
+
+    bool active_ = false;
+    bool complete_ = false;
+    bool failed_ = false;
+    uint32_t frames_sent_ = 0;
+    uint32_t retransmits_ = 0;
+};
+
+class LogLinkReceiver {
+public:
+    typedef void (*DeliverFn)(const uint8_t* data, size_t len, void* ctx);
+
+    LogLinkReceiver(uint8_t stream, DeliverFn deliver, void* ctx);
+
+    void reset();
+
+    // Feed one received data frame. Returns true when 'ack' should be sent.
+    bool onFrame(const uint8_t* frame, size_t len, link_ack_frame& ack);
+
+    bool started() const { return started_; }
+    uint8_t transfer() const { return transfer_; }
+    bool complete() const { return started_ && base_ >= linkChunkCount(total_bytes_); }
+    uint32_t totalBytes() const { return total_bytes_; }
+    uint32_t deliveredBytes() const { return delivered_bytes_; }
+    uint32_t duplicates() const { return duplicates_; }
+
+private:
+    void fillAck(link_ack_frame& ack) const;
+
+    uint8_t stream_;
+    DeliverFn deliver_;
+    void* ctx_;
+
+    bool started_ = false;
+    uint8_t transfer_ = 0;
+    uint32_t total_bytes_ = 0;
+    uint16_t base_ = 0;             // next chunk to deliver
+    uint32_t have_ = 0;             // bit i: chunk base_ + i buffered
+    uint8_t since_ack_ = 0;
+    uint32_t delivered_bytes_ = 0;
+    uint32_t duplicates_ = 0;
+    uint8_t slot_len_[LINK_WINDOW];
+    uint8_t slots_[LINK_WINDOW][LINK_CHUNK_BYTES];
+};
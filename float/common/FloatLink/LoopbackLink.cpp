@@ -0,0 +1,39 @@
+#include "LoopbackLink.h"
+
+LoopbackLink::LoopbackLink(uint32_t seed) : rng_(seed), uniform_(0.0f, 1.0f) {}
+
+void LoopbackLink::attach(int side, Handler handler, void* ctx) {
+    handler_[side] = handler;
+    ctx_[side] = ctx;
+}
+
+bool LoopbackLink::send(int from_side, const uint8_t* data, size_t len, uint64_t now_us) {
+    sent_[from_side]++;
+    // Lost frames still count as sent: ESP-NOW reports success either way
+    if (loss_ > 0 && uniform_(rng_) < loss_) {
+        dropped_[from_side]++;
+        return true;
+    }
+    Frame frame;
+    frame.due_us = now_us + latency_us_;
+    if (jitter_us_ > 0) frame.due_us += (uint64_t)(uniform_(rng_) * jitter_us_);
+    frame.to_side = 1 - from_side;
+    frame.data.assign(data, data + len);
+    queue_.push_back(frame);
+    return true;
+}
+
+void LoopbackLink::pump(uint64_t now_us) {
+    // Without jitter the queue is in due order; with it, scan for due frames
+    for (size_t i = 0; i < queue_.size();) {
+        if (queue_[i].due_us > now_us) {
+            if (jitter_us_ == 0) break;
+            i++;
+            continue;
+        }
+        Frame frame = queue_[i];
+        queue_.erase(queue_.begin() + i);
+        Handler handler = handler_[frame.to_side];
+        if (handler) handler(frame.data.data(), frame.data.size(), ctx_[frame.to_side]);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+// ============================================================================
+// LOOPBACK RADIO (host testing)
+// ============================================================================
+// Two in-memory endpoints standing in for the ESP-NOW link, with seeded
+// frame loss, latency and jitter so runs are repeatable. Frames are
+// delivered to the far side's handler from pump(); with jitter they can
+// arrive out of order.
+
+class LoopbackLink {
+public:
+    typedef void (*Handler)(const uint8_t* data, size_t len, void* ctx);
+
+    explicit LoopbackLink(uint32_t seed = 1);
+
+    void setLoss(float probability) { loss_ = probability; }
+    void setLatencyUs(uint32_t latency_us) { latency_us_ = latency_us; }
+    void setJitterUs(uint32_t jitter_us) { jitter_us_ = jitter_us; }    // extra 0..jitter
+
+    // side is 0 or 1; frames sent from one side arrive at the other
+    void attach(int side, Handler handler, void* ctx);
+    bool send(int from_side, const uint8_t* data, size_t len, uint64_t now_us);
+    void pump(uint64_t now_us);
+
+    uint32_t sent(int side) const { return sent_[side]; }
+    uint32_t dropped(int side) const { return dropped_[side]; }
+
+private:
+    struct Frame {
+        uint64_t due_us;
+        int to_side;
+        std::vector<uint8_t> data;
+    };
+
+    std::mt19937 rng_;
+    std::uniform_real_distribution<float> uniform_;
+    float loss_ = 0;
+    uint32_t latency_us_ = 1000;
+    uint32_t jitter_us_ = 0;
+    Handler handler_[2] = {nullptr, nullptr};
+    void* ctx_[2] = {nullptr, nullptr};
+    std::deque<Frame> queue_;
+    uint32_t sent_[2] = {0, 0};
+    uint32_t dropped_[2] = {0, 0};
+};
@@ -0,0 +1,52 @@
+#include "Telemetry.h"
+
+void TelemetryStats::reset() {
+    received_ = 0;
+    lost_ = 0;
+    late_ = 0;
+    next_seq_ = 0;
+    last_offset_ = 0;
+    min_offset_ = 0;
+    max_offset_ = 0;
+    sum_offset_ = 0;
+    last_rx_ms_ = 0;
+    longest_gap_ms_ = 0;
+}
+
+void TelemetryStats::onFrame(const link_telemetry_frame& frame, uint32_t rx_ms) {
+    int32_t offset = (int32_t)(rx_ms - frame.sent_ms);
+
+    if (received_ == 0) {
+        min_offset_ = max_offset_ = offset;
+        next_seq_ = frame.seq + 1;
+    } else {
+        int16_t ahead = (int16_t)(frame.seq - next_seq_);
+        if (ahead < 0) {
+            // A frame counted as lost turned up after all
+            late_++;
+            if (lost_ > 0) lost_--;
+        } else {
+            lost_ += ahead;
+            next_seq_ = frame.seq + 1;
+        }
+        uint32_t gap = rx_ms - last_rx_ms_;
+        if (gap > longest_gap_ms_) longest_gap_ms_ = gap;
+        if (offset < min_offset_) min_offset_ = offset;
+        if (offset > max_offset_) max_offset_ = offset;
+    }
+
+    received_++;
+    last_offset_ = offset;
+    sum_offset_ += offset;
+    last_rx_ms_ = rx_ms;
+}
+
+float TelemetryStats::lossRatio() const {
+    uint32_t total = received_ + lost_;
+    return total ? (float)lost_ / total : 0.0f;
+}
+
+uint32_t TelemetryStats::meanDelayMs() const {
+    if (received_ == 0) return 0;
+    return (uint32_t)(sum_offset_ / received_ - min_offset_);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FloatLink.h"
+
+// ============================================================================
+// LIVE TELEMETRY STATISTICS (station side)
+// ============================================================================
+// Loss from gaps in the frame sequence numbers, latency from the offset
+// between the station clock at reception and the float clock at send.
+// The two clocks are not synchronised, so latency is reported relative to
+// the fastest frame seen (its offset is taken as the clock difference plus
+// the minimum flight time). Crystal drift, ~20 ppm, adds ~1 ms per minute.
+
+class TelemetryStats {
+public:
+    TelemetryStats() { reset(); }
+
+    void reset();
+
+    // rx_ms: station clock when the frame arrived
+    void onFrame(const link_telemetry_frame& frame, uint32_t rx_ms);
+
+    uint32_t received() const { return received_; }
+    uint32_t lost() const { return lost_; }                 // never arrived
+    uint32_t late() const { return late_; }                 // arrived out of order
+    float lossRatio() const;
+
+    // Delay of the last frame / mean / max, above the fastest frame
+    uint32_t lastDelayMs() const { return last_offset_ - min_offset_; }
+    uint32_t meanDelayMs() const;
+    uint32_t maxDelayMs() const { return max_offset_ - min_offset_; }
+    int32_t minOffsetMs() const { return min_offset_; }
+
+    // Longest time without a frame, station clock
+    uint32_t longestGapMs() const { return longest_gap_ms_; }
+
+private:
+    uint32_t received_;
+    uint32_t lost_;
+    uint32_t late_;
+    uint16_t next_seq_;
+    int32_t last_offset_;
+    int32_t min_offset_;
+    int32_t max_offset_;
+    int64_t sum_offset_;
+    uint32_t last_rx_ms_;
+    uint32_t longest_gap_ms_;
+};
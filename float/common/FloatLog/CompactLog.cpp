@@ -0,0 +1,239 @@
+#include "CompactLog.h"
+#include <math.h>
+#include <string.h>
+
+static const float GRAVITY = 9.80665f;
+
+// Exp-Golomb order per field (see CompactLog.h)
+static const int K_INTERVAL = 0;
+static const int K_PRESSURE = 3;
+static const int K_DEPTH = 0;
+static const int K_TEMP = 1;
+
+static int32_t quantize(float value, float scale) {
+    return (int32_t)floorf(value * scale + 0.5f);
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+static int bitLength(uint64_t x) {
+    int n = 0;
+    while (x) { n++; x >>= 1; }
+    return n;
+}
+
+static int codeBits(uint32_t value, int k) {
+    return 2 * bitLength((uint64_t)value + (1u << k)) - 1 - k;
+}
+
+static int32_t predictDepthMm(const compact_log_header& h, int32_t pressure) {
+    int64_t mm = ((int64_t)(pressure - h.surface_pressure) * h.depth_scale_q16 + 32768) >> 16;
+    return mm > 0 ? (int32_t)mm : 0;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+CompactLogWriter::CompactLogWriter(uint8_t* buffer, size_t size)
+    : buffer_(buffer), size_(size) {
+    begin("", 0, 1025.0f);
+}
+
+void CompactLogWriter::begin(const char* company_id, float surface_pressure_kpa, float fluid_density) {
+    memset(&header_, 0, sizeof(header_));
+    header_.magic = COMPACT_LOG_MAGIC;
+    header_.version = COMPACT_LOG_VERSION;
+    memcpy(header_.company_id, company_id, strnlen(company_id, sizeof(header_.company_id)));
+    header_.surface_pressure = quantize(surface_pressure_kpa, 100.0f);
+    // 0.01 kPa = 10 Pa -> 10 / (rho * g) m -> * 1000 mm, in Q16
+    header_.depth_scale_q16 = (uint32_t)(10000.0f / (fluid_density * GRAVITY) * 65536.0f + 0.5f);
+    header_.fluid_density = (uint16_t)(fluid_density + 0.5f);
+
+    prev_time_ = 0;
+    prev_interval_ = 0;
+    prev_pressure_ = header_.surface_pressure;
+    prev_temp_ = 0;
+    memcpy(buffer_, &header_, sizeof(header_));
+}
+
+void CompactLogWriter::putBits(uint64_t value, int bits) {
+    uint8_t* stream = buffer_ + sizeof(header_);
+    while (bits-- > 0) {
+        uint32_t byte = header_.bit_count >> 3;
+        uint8_t mask = 0x80 >> (header_.bit_count & 7);
+        if (mask == 0x80) stream[byte] = 0;     // fresh byte
+        if ((value >> bits) & 1) stream[byte] |= mask;
+        header_.bit_count++;
+    }
+}
+
+void CompactLogWriter::putCode(uint32_t value, int k) {
+    uint64_t x = (uint64_t)value + (1u << k);
+    int n = bitLength(x);
+    putBits(0, n - 1 - k);
+    putBits(x, n);
+}
+
+bool CompactLogWriter::append(const LogSample& sample) {
+    uint32_t time = sample.time_ms / 10;
+    int32_t interval = (int32_t)(time - prev_time_);
+    int32_t pressure = quantize(sample.pressure_kpa, 100.0f);
+    int32_t depth = quantize(sample.depth_m, 1000.0f);
+    int32_t temp = quantize(sample.temp_c, 100.0f);
+
+    uint32_t c_interval = zigzag(interval - prev_interval_);
+    uint32_t c_pressure = zigzag(pressure - prev_pressure_);
+    uint32_t c_depth = zigzag(depth - predictDepthMm(header_, pressure));
+    uint32_t c_temp = zigzag(temp - prev_temp_);
+
+    size_t bits = codeBits(c_interval, K_INTERVAL) + codeBits(c_pressure, K_PRESSURE)
+                + codeBits(c_depth, K_DEPTH) + codeBits(c_temp, K_TEMP);
+    if (sizeof(header_) * 8 + header_.bit_count + bits > size_ * 8) return false;
+
+    putCode(c_interval, K_INTERVAL);
+    putCode(c_pressure, K_PRESSURE);
+    putCode(c_depth, K_DEPTH);
+    putCode(c_temp, K_TEMP);
+
+    prev_time_ = time;
+    prev_interval_ = interval;
+    prev_pressure_ = pressure;
+    prev_temp_ = temp;
+    header_.record_count++;
+    memcpy(buffer_, &header_, sizeof(header_));
+    return true;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+CompactLogReader::CompactLogReader(const uint8_t* data, size_t len)
+    : stream_(data + sizeof(header_)) {
+    memset(&header_, 0, sizeof(header_));
+    if (len < sizeof(header_)) return;
+    memcpy(&header_, data, sizeof(header_));
+    valid_ = header_.magic == COMPACT_LOG_MAGIC
+          && header_.version == COMPACT_LOG_VERSION
+          && (header_.bit_count + 7) / 8 <= len - sizeof(header_);
+    prev_pressure_ = header_.surface_pressure;
+}
+
+bool CompactLogReader::getBits(int bits, uint64_t& value) {
+    value = 0;
+    while (bits-- > 0) {
+        if (bit_pos_ >= header_.bit_count) return false;
+        uint8_t bit = (stream_[bit_pos_ >> 3] >> (7 - (bit_pos_ & 7))) & 1;
+        value = (value << 1) | bit;
+        bit_pos_++;
+    }
+    return true;
+}
+
+bool CompactLogReader::getCode(int k, uint32_t& value) {
+    int zeros = 0;
+    uint64_t bit = 0;
+    for (;;) {
+        if (!getBits(1, bit)) return false;
+        if (bit) break;
+        if (++zeros > 32) return false;     // corrupt stream
+    }
+    uint64_t rest = 0;
+    if (!getBits(zeros + k, rest)) return false;
+    uint64_t x = ((uint64_t)1 << (zeros + k)) | rest;
+    value = (uint32_t)(x - (1u << k));
+    return true;
+}
+
+bool CompactLogReader::next(LogSample& sample) {
+    if (!valid_ || decoded_ >= header_.record_count) return false;
+
+    uint32_t c_interval, c_pressure, c_depth, c_temp;
+    if (!getCode(K_INTERVAL, c_interval) || !getCode(K_PRESSURE, c_pressure) ||
+        !getCode(K_DEPTH, c_depth) || !getCode(K_TEMP, c_temp)) {
+        valid_ = false;
+        return false;
+    }
+
+    int32_t interval = prev_interval_ + unzigzag(c_interval);
+    uint32_t time = prev_time_ + (uint32_t)interval;
+    int32_t pressure = prev_pressure_ + unzigzag(c_pressure);
+    int32_t depth = predictDepthMm(header_, pressure) + unzigzag(c_depth);
+    int32_t temp = prev_temp_ + unzigzag(c_temp);
+
+    sample.time_ms = time * 10;
+    sample.pressure_kpa = pressure / 100.0f;
+    sample.depth_m = depth / 1000.0f;
+    sample.temp_c = temp / 100.0f;
+
+    prev_time_ = time;
+    prev_interval_ = interval;
+    prev_pressure_ = pressure;
+    prev_temp_ = temp;
+    decoded_++;
+    return true;
+}
+
+// ============================================================================
+// SEGMENT STREAM
+// ============================================================================
+
+CompactLogStreamReader::CompactLogStreamReader(SampleFn on_sample, void* ctx)
+    : on_sample_(on_sample), ctx_(ctx) {}
+
+void CompactLogStreamReader::reset() {
+    fill_ = 0;
+    expected_ = 0;
+    corrupt_ = false;
+    samples_ = 0;
+    segments_ = 0;
+    bad_segments_ = 0;
+}
+
+void CompactLogStreamReader::feed(const uint8_t* data, size_t len) {
+    while (len > 0 && !corrupt_) {
+        size_t want = expected_ ? expected_ : sizeof(compact_log_header);
+        size_t take = want - fill_;
+        if (take > len) take = len;
+        memcpy(segment_ + fill_, data, take);
+        fill_ += take;
+        data += take;
+        len -= take;
+        if (fill_ < want) return;
+
+        if (!expected_) {
+            compact_log_header header;
+            memcpy(&header, segment_, sizeof(header));
+            expected_ = sizeof(header) + (header.bit_count + 7) / 8;
+            if (header.magic != COMPACT_LOG_MAGIC || expected_ > sizeof(segment_)) {
+                corrupt_ = true;
+                bad_segments_++;
+                return;
+            }
+            if (expected_ > fill_) continue;
+        }
+        decodeSegment();
+        fill_ = 0;
+        expected_ = 0;
+    }
+}
+
+void CompactLogStreamReader::decodeSegment() {
+    CompactLogReader reader(segment_, fill_);
+    LogSample sample;
+    uint32_t decoded = 0;
+    while (reader.next(sample)) {
+        on_sample_(reader.header(), sample, ctx_);
+        decoded++;
+    }
+    segments_++;
+    samples_ += decoded;
+    if (!reader.valid() || decoded != reader.header().record_count) bad_segments_++;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// COMPACT MISSION LOG
+// ============================================================================
+// On-board log layout, also the blob sent at recovery (STREAM_MISSION_LOG).
+// A compact log is one header with the company ID and the surface
+// calibration, then a bit-packed stream of fixed-point deltas, one record
+// per sample:
+//
+//   time      10 ms units, change of the sample interval   (k = 0)
+//   pressure  0.01 kPa (0.1 mbar, the MS5837 resolution), delta   (k = 3)
+//   depth     mm, difference from the depth the calibration
+//             predicts for this pressure (almost always 0)  (k = 0)
+//   temp      0.01 C, delta                                 (k = 1)
+//
+// Each value is zigzag-mapped and written as an order-k Exp-Golomb code, so
+// small changes take a few bits: a sample at rest costs ~2 bytes against 26
+// for a struct_message. The depth prediction is integer-only so encoder and
+// decoder agree bit for bit on any CPU.
+//
+// The float keeps its log in flash pages, one compact log per page (see
+// FlashRingLog), so the mission blob is a run of segments back to back,
+// each an independent compact log of at most COMPACT_LOG_SEGMENT_BYTES
+// whose header gives its length. A corrupt segment costs only its own
+// entries.
+
+#define COMPACT_LOG_MAGIC 0x4346    // "FC"
+#define COMPACT_LOG_VERSION 1
+
+#define COMPACT_LOG_SEGMENT_BYTES 244   // 256-byte flash page minus its header
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    char company_id[10];
+    int32_t surface_pressure;       // 0.01 kPa
+    uint32_t depth_scale_q16;       // mm per 0.01 kPa, Q16
+    uint16_t fluid_density;         // kg/m^3, for reference
+    uint32_t record_count;
+    uint32_t bit_count;             // valid bits after the header
+} compact_log_header;
+
+struct LogSample {
+    uint32_t time_ms;               // since mission start
+    float pressure_kpa;
+    float depth_m;
+    float temp_c;
+};
+
+class CompactLogWriter {
+public:
+    // Header and stream both live in 'buffer' (header first), so the
+    // downloadable log is simply data()[0 .. bytes()).
+    CompactLogWriter(uint8_t* buffer, size_t size);
+
+    // Start a new log. Pressures are absolute; depth is predicted as
+    // (pressure - surface) / (density * g), clamped at 0.
+    void begin(const char* company_id, float surface_pressure_kpa, float fluid_density);
+
+    // Quantize and append one sample. Returns false (and stores nothing)
+    // when the buffer is full.
+    bool append(const LogSample& sample);
+
+    uint32_t count() const { return header_.record_count; }
+    size_t bytes() const { return sizeof(header_) + (header_.bit_count + 7) / 8; }
+    size_t capacity() const { return size_; }
+    const uint8_t* data() const { return buffer_; }
+
+private:
+    void putBits(uint64_t value, int bits);
+    void putCode(uint32_t value, int k);
+
+    uint8_t* buffer_;
+    size_t size_;
+    compact_log_header header_;
+    uint32_t prev_time_ = 0;
+    int32_t prev_interval_ = 0;
+    int32_t prev_pressure_ = 0;
+    int32_t prev_temp_ = 0;
+};
+
+class CompactLogReader {
+public:
+    CompactLogReader(const uint8_t* data, size_t len);
+
+    // Header present, right magic/version and the stream fully inside 'len'
+    bool valid() const { return valid_; }
+    const compact_log_header& header() const { return header_; }
+
+    // Decode the next sample. False at the end of the log.
+    bool next(LogSample& sample);
+
+private:
+    bool getBits(int bits, uint64_t& value);
+    bool getCode(int k, uint32_t& value);
+
+    const uint8_t* stream_;
+    compact_log_header header_;
+    bool valid_ = false;
+    uint32_t bit_pos_ = 0;
+    uint32_t decoded_ = 0;
+    uint32_t prev_time_ = 0;
+    int32_t prev_interval_ = 0;
+    int32_t prev_pressure_ = 0;
+    int32_t prev_temp_ = 0;
+};
+
+// Decodes a mission blob (a run of segments) as it arrives in order,
+// buffering one segment at a time. A segment header that makes no sense
+// ends decoding: the segment lengths can no longer be trusted.
+class CompactLogStreamReader {
+public:
+    typedef void (*SampleFn)(const compact_log_header& header, const LogSample& sample, void* ctx);
+
+    CompactLogStreamReader(SampleFn on_sample, void* ctx);
+
+    void reset();
+    void feed(const uint8_t* data, size_t len);
+
+    uint32_t samples() const { return samples_; }
+    uint32_t segments() const { return segments_; }
+    uint32_t badSegments() const { return bad_segments_; }
+    bool corrupt() const { return corrupt_; }
+
+private:
+    void decodeSegment();
+
+    SampleFn on_sample_;
+    void* ctx_;
+    uint8_t segment_[COMPACT_LOG_SEGMENT_BYTES];
+    size_t fill_ = 0;
+    size_t expected_ = 0;           // length of the current segment, 0 = header pending
+    bool corrupt_ = false;
+    uint32_t samples_ = 0;
+    uint32_t segments_ = 0;
+    uint32_t bad_segments_ = 0;
+};
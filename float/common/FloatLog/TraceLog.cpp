@@ -0,0 +1,98 @@
+#include "TraceLog.h"
+#include <string.h>
+
+// ============================================================================
+// RING
+// ============================================================================
+
+TraceLog::TraceLog(trace_record* buffer, uint32_t capacity)
+    : buffer_(buffer), capacity_(capacity) {}
+
+void TraceLog::begin(uint16_t period_ms) {
+    head_ = 0;
+    count_ = 0;
+    overwritten_ = 0;
+    period_ms_ = period_ms;
+}
+
+size_t TraceLog::read(uint32_t offset, uint8_t* dst, size_t len) const {
+    trace_log_header header;
+    header.magic = TRACE_LOG_MAGIC;
+    header.version = TRACE_LOG_VERSION;
+    header.record_bytes = sizeof(trace_record);
+    header.period_ms = period_ms_;
+    header.record_count = count_;
+    header.overwritten = overwritten_;
+
+    size_t done = 0;
+    while (done < len && offset < blobBytes()) {
+        const uint8_t* src;
+        size_t avail;
+        if (offset < sizeof(header)) {
+            src = (const uint8_t*)&header + offset;
+            avail = sizeof(header) - offset;
+        } else {
+            // Records run oldest first from head_ - count_, wrapping
+            uint32_t rel = offset - sizeof(header);
+            uint32_t index = rel / sizeof(trace_record);
+            uint32_t slot = (head_ + capacity_ - count_ + index) % capacity_;
+            uint32_t within = rel % sizeof(trace_record);
+            src = (const uint8_t*)&buffer_[slot] + within;
+            avail = sizeof(trace_record) - within;
+        }
+        if (avail > len - done) avail = len - done;
+        memcpy(dst + done, src, avail);
+        done += avail;
+        offset += avail;
+    }
+    return done;
+}
+
+// ============================================================================
+// STREAM READER
+// ============================================================================
+
+TraceStreamReader::TraceStreamReader(RecordFn on_record, void* ctx)
+    : on_record_(on_record), ctx_(ctx) {
+    memset(&header_, 0, sizeof(header_));
+}
+
+void TraceStreamReader::reset() {
+    memset(&header_, 0, sizeof(header_));
+    have_header_ = false;
+    corrupt_ = false;
+    records_ = 0;
+    fill_ = 0;
+}
+
+void TraceStreamReader::feed(const uint8_t* data, size_t len) {
+    while (len > 0 && !corrupt_) {
+        size_t want = have_header_ ? sizeof(trace_record) : sizeof(trace_log_header);
+        size_t take = want - fill_;
+        if (take > len) take = len;
+        memcpy(pending_ + fill_, data, take);
+        fill_ += take;
+        data += take;
+        len -= take;
+        if (fill_ < want) return;
+        fill_ = 0;
+
+        if (!have_header_) {
+            memcpy(&header_, pending_, sizeof(header_));
+            if (header_.magic != TRACE_LOG_MAGIC || header_.record_bytes != sizeof(trace_record)) {
+                corrupt_ = true;
+                return;
+            }
+            have_header_ = true;
+            continue;
+        }
+        if (records_ >= header_.record_count) {
+            corrupt_ = true;            // more bytes than the header announced
+            return;
+        }
+        trace_record record;
+        memcpy(&record, pending_, sizeof(record));
+        records_++;
+        on_record_(header_, record, ctx_);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// HIGH-RATE TRACE
+// ============================================================================
+// Engineering trace for tuning the buoyancy engine: depth, velocity, piston
+// and state on every sensor tick. It is a second channel next to the 5 s
+// scoring log (CompactLog) and does not touch it.
+//
+// Records are fixed-size and go into a caller-provided ring, so recording
+// one is a single struct copy: no encoding, no allocation, no flash. When
+// the ring is full the oldest records are overwritten, so it always holds
+// the latest part of the mission.
+//
+// The blob sent at recovery (STREAM_TRACE) is a trace_log_header followed
+// by its records, oldest first.
+
+#define TRACE_LOG_MAGIC 0x5254      // "TR"
+#define TRACE_LOG_VERSION 2
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t record_bytes;           // sizeof(trace_record)
+    uint16_t period_ms;             // nominal sample period
+    uint32_t record_count;          // records that follow
+    uint32_t overwritten;           // older records lost to the ring
+} trace_log_header;
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;               // since mission start
+    int16_t depth_mm;               // filtered depth
+    int16_t measured_mm;            // depth of the raw sample
+    int16_t velocity_mm_s;          // filtered, + = sinking
+    int16_t piston;                 // position (steps)
+    int16_t piston_target;          // commanded position (steps)
+    uint8_t state;                  // MissionState
+    uint8_t segment;                // mission segment index (MissionPlan.h)
+} trace_record;
+
+class TraceLog {
+public:
+    TraceLog(trace_record* buffer, uint32_t capacity);
+
+    // Drop all records and start a new trace.
+    void begin(uint16_t period_ms);
+
+    // Hot path: one copy and an index wrap.
+    void record(const trace_record& r) {
+        buffer_[head_] = r;
+        if (++head_ == capacity_) head_ = 0;
+        if (count_ < capacity_) count_++;
+        else overwritten_++;
+    }
+
+    uint32_t count() const { return count_; }
+    uint32_t capacity() const { return capacity_; }
+    uint32_t overwritten() const { return overwritten_; }
+
+    // Download blob: header, then the records oldest first. Stop recording
+    // while it is being read.
+    uint32_t blobBytes() const { return sizeof(trace_log_header) + count_ * sizeof(trace_record); }
+    size_t read(uint32_t offset, uint8_t* dst, size_t len) const;
+
+private:
+    trace_record* buffer_;
+    uint32_t capacity_;
+    uint32_t head_ = 0;             // next slot to write
+    uint32_t count_ = 0;
+    uint32_t overwritten_ = 0;
+    uint16_t period_ms_ = 0;
+};
+
+// Decodes a trace blob fed in pieces of any size, as they arrive.
+class TraceStreamReader {
+public:
+    typedef void (*RecordFn)(const trace_log_header& header, const trace_record& record, void* ctx);
+
+    TraceStreamReader(RecordFn on_record, void* ctx);
+
+    void reset();
+    void feed(const uint8_t* data, size_t len);
+
+    bool started() const { return have_header_; }
+    bool corrupt() const { return corrupt_; }
+    const trace_log_header& header() const { return header_; }
+    uint32_t records() const { return records_; }
+
+private:
+    RecordFn on_record_;
+    void* ctx_;
+
+    trace_log_header header_;
+    bool have_header_ = false;
+    bool corrupt_ = false;
+    uint32_t records_ = 0;
+    size_t fill_ = 0;
+    uint8_t pending_[sizeof(trace_log_header) > sizeof(trace_record)
+                     ? sizeof(trace_log_header) : sizeof(trace_record)];
+};
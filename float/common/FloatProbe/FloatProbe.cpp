@@ -0,0 +1,198 @@
+#include "FloatProbe.h"
+#include <string.h>
+
+static const char* const SECTION_NAMES[PROBE_SECTION_COUNT] = {
+    "control_tick", "sensor_read", "depth_update", "mission", "move_piston", "log_data",
+    "log_write", "flash_service", "link_send", "radio_send", "log_step", "radio_step"
+};
+
+const char* probeSectionName(uint8_t section) {
+    return section < PROBE_SECTION_COUNT ? SECTION_NAMES[section] : "?";
+}
+
+// ============================================================================
+// HISTOGRAM BUCKETS
+// ============================================================================
+
+static uint8_t bucketFor(uint32_t cycles) {
+    if (cycles < 16) return 0;
+    int octave = 31 - __builtin_clz(cycles);        // >= 4
+    if (octave > 27) return PROBE_BUCKETS - 1;
+    uint32_t quarter = (cycles >> (octave - 2)) & 3;
+    return (uint8_t)(1 + (octave - 4) * 4 + quarter);
+}
+
+// Smallest value that does not fit in 'bucket'
+static uint32_t bucketLimit(uint8_t bucket) {
+    if (bucket == 0) return 16;
+    int octave = 4 + (bucket - 1) / 4;
+    uint32_t quarter = (bucket - 1) % 4;
+    return (1u << octave) + (quarter + 1) * (1u << (octave - 2));
+}
+
+// Upper edge of the bucket holding the q-th fraction of 'count' samples,
+// kept inside [min, max]
+static uint32_t percentile(const uint32_t* buckets, uint32_t count, uint32_t min, uint32_t max,
+                           uint32_t per_mille) {
+    uint32_t rank = (uint32_t)(((uint64_t)count * per_mille + 999) / 1000);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            uint32_t value = bucketLimit((uint8_t)b) - 1;
+            if (value > max || b == PROBE_BUCKETS - 1) value = max;
+            if (value < min) value = min;
+            return value;
+        }
+    }
+    return max;
+}
+
+// ============================================================================
+// PROBE TABLE
+// ============================================================================
+
+void ProbeTable::setBudget(uint8_t section, uint32_t cycles) {
+    if (section < PROBE_SECTION_COUNT) budgets_[section] = cycles;
+}
+
+void ProbeTable::record(uint8_t section, uint8_t state, uint32_t cycles) {
+    if (section >= PROBE_SECTION_COUNT) return;
+    if (state >= PROBE_MAX_STATES) state = PROBE_MAX_STATES - 1;
+    Cell& c = cells_[section][state];
+    const std::memory_order relaxed = std::memory_order_relaxed;
+
+    // Single writer: load + store, no atomic read-modify-write needed
+    uint32_t n = c.count.load(relaxed);
+    if (n == 0 || cycles < c.min.load(relaxed)) c.min.store(cycles, relaxed);
+    if (cycles > c.max.load(relaxed)) c.max.store(cycles, relaxed);
+    uint32_t lo = c.sum_lo.load(relaxed);
+    if (lo + cycles < lo) c.sum_hi.store(c.sum_hi.load(relaxed) + 1, relaxed);
+    c.sum_lo.store(lo + cycles, relaxed);
+    std::atomic<uint32_t>& bucket = c.buckets[bucketFor(cycles)];
+    bucket.store(bucket.load(relaxed) + 1, relaxed);
+    if (budgets_[section] && cycles > budgets_[section]) c.overruns.store(c.overruns.load(relaxed) + 1, relaxed);
+    c.count.store(n + 1, std::memory_order_release);
+}
+
+size_t ProbeTable::report(uint8_t* dst, size_t capacity, uint16_t cpu_mhz, uint32_t uptime_ms) const {
+    if (capacity < PROBE_REPORT_MAX_BYTES) return 0;
+    const std::memory_order relaxed = std::memory_order_relaxed;
+
+    probe_report_header header;
+    header.magic = PROBE_REPORT_MAGIC;
+    header.version = PROBE_REPORT_VERSION;
+    header.entry_bytes = sizeof(probe_report_entry);
+    header.cpu_mhz = cpu_mhz;
+    header.entry_count = 0;
+    header.uptime_ms = uptime_ms;
+    size_t pos = sizeof(header);
+
+    for (int s = 0; s < PROBE_SECTION_COUNT; s++) {
+        // Merged over all states, built alongside the per-state rows
+        uint32_t all_buckets[PROBE_BUCKETS];
+        memset(all_buckets, 0, sizeof(all_buckets));
+        probe_report_entry all;
+        memset(&all, 0, sizeof(all));
+        uint64_t all_sum = 0;
+
+        for (int st = 0; st <= PROBE_MAX_STATES; st++) {
+            probe_report_entry e;
+            memset(&e, 0, sizeof(e));
+            e.section = (uint8_t)s;
+            e.budget_cycles = budgets_[s];
+            uint32_t buckets[PROBE_BUCKETS];
+            uint64_t sum;
+
+            if (st < PROBE_MAX_STATES) {
+                const Cell& c = cells_[s][st];
+                e.count = c.count.load(std::memory_order_acquire);
+                if (e.count == 0) continue;
+                e.state = (uint8_t)st;
+                e.overruns = c.overruns.load(relaxed);
+                e.min_cycles = c.min.load(relaxed);
+                e.max_cycles = c.max.load(relaxed);
+                sum = ((uint64_t)c.sum_hi.load(relaxed) << 32) | c.sum_lo.load(relaxed);
+                for (int b = 0; b < PROBE_BUCKETS; b++) buckets[b] = c.buckets[b].load(relaxed);
+
+                if (all.count == 0 || e.min_cycles < all.min_cycles) all.min_cycles = e.min_cycles;
+                if (e.max_cycles > all.max_cycles) all.max_cycles = e.max_cycles;
+                all.count += e.count;
+                all.overruns += e.overruns;
+                all_sum += sum;
+                for (int b = 0; b < PROBE_BUCKETS; b++) all_buckets[b] += buckets[b];
+            } else {
+                if (all.count == 0) continue;
+                e = all;
+                e.section = (uint8_t)s;
+                e.state = PROBE_ALL_STATES;
+                e.budget_cycles = budgets_[s];
+                sum = all_sum;
+                memcpy(buckets, all_buckets, sizeof(buckets));
+            }
+
+            // Bucket counts may run a sample ahead of 'count'
+            uint32_t total = 0;
+            for (int b = 0; b < PROBE_BUCKETS; b++) total += buckets[b];
+            e.mean_cycles = (uint32_t)(sum / e.count);
+            e.p50_cycles = percentile(buckets, total, e.min_cycles, e.max_cycles, 500);
+            e.p99_cycles = percentile(buckets, total, e.min_cycles, e.max_cycles, 990);
+            memcpy(dst + pos, &e, sizeof(e));
+            pos += sizeof(e);
+            header.entry_count++;
+        }
+    }
+    memcpy(dst, &header, sizeof(header));
+    return pos;
+}
+
+// ============================================================================
+// REPORT READER
+// ============================================================================
+
+ProbeReportReader::ProbeReportReader(EntryFn on_entry, void* ctx)
+    : on_entry_(on_entry), ctx_(ctx) {
+    memset(&header_, 0, sizeof(header_));
+}
+
+void ProbeReportReader::reset() {
+    memset(&header_, 0, sizeof(header_));
+    have_header_ = false;
+    corrupt_ = false;
+    entries_ = 0;
+    fill_ = 0;
+}
+
+void ProbeReportReader::feed(const uint8_t* data, size_t len) {
+    while (len > 0 && !corrupt_) {
+        size_t want = have_header_ ? sizeof(probe_report_entry) : sizeof(probe_report_header);
+        size_t take = want - fill_;
+        if (take > len) take = len;
+        memcpy(pending_ + fill_, data, take);
+        fill_ += take;
+        data += take;
+        len -= take;
+        if (fill_ < want) return;
+        fill_ = 0;
+
+        if (!have_header_) {
+            memcpy(&header_, pending_, sizeof(header_));
+            if (header_.magic != PROBE_REPORT_MAGIC || header_.entry_bytes != sizeof(probe_report_entry) ||
+                header_.cpu_mhz == 0) {
+                corrupt_ = true;
+                return;
+            }
+            have_header_ = true;
+            continue;
+        }
+        if (entries_ >= header_.entry_count) {
+            corrupt_ = true;            // more bytes than the header announced
+            return;
+        }
+        probe_report_entry entry;
+        memcpy(&entry, pending_, sizeof(entry));
+        entries_++;
+        on_entry_(header_, entry, ctx_);
+    }
+}
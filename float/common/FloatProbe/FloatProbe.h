@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ============================================================================
+// HOT-PATH PROBES
+// ============================================================================
+// Shared by onboard_float and control_station (lib_extra_dirs = ../common).
+//
+// The float times its hot paths with the CPU cycle counter (PROBE_SCOPE in
+// onboard_float/include/float_probes.h, compiled in with -DFLOAT_PROBES)
+// and keeps, per section and per MissionState: count, min, mean, max, a
+// log-scale histogram for p50/p99, and how often a section overran its
+// budget. The report (probe_report_header + entries) is printed over
+// Serial at MISSION_DONE and sent after the mission log (STREAM_PROBES).
+//
+// Each section is recorded by one task only, so a record is plain loads
+// and stores (relaxed atomics, no read-modify-write). A report taken while
+// the float runs may be a few samples out of step between fields.
+
+enum ProbeSection : uint8_t {
+    PROBE_CONTROL_TICK,     // control task: one sample, start to end
+    PROBE_SENSOR_READ,      // sample task: sensor.read()
+    PROBE_DEPTH_UPDATE,     // control task: estimator update
+    PROBE_MISSION,          // control task: executor + depth controller
+    PROBE_MOVE_PISTON,      // control task: movePistonTo()
+    PROBE_LOG_DATA,         // control task: queue a log entry
+    PROBE_LOG_WRITE,        // log task: append to the flash log
+    PROBE_FLASH_SERVICE,    // log task: program a page / erase ahead
+    PROBE_LINK_SEND,        // log task: esp_now_send() of a download frame
+    PROBE_RADIO_SEND,       // radio task: esp_now_send() of telemetry/replies
+    PROBE_LOG_STEP,         // log task: one pass
+    PROBE_RADIO_STEP,       // radio task: one pass
+    PROBE_SECTION_COUNT
+};
+
+const char* probeSectionName(uint8_t section);
+
+#define PROBE_MAX_STATES 6          // MissionState values (float_defs.h)
+#define PROBE_ALL_STATES 0xFF       // report row merged over every state
+
+// Histogram: bucket 0 is < 16 cycles, then 4 buckets per octave up to
+// 2^28 cycles (1.1 s at 240 MHz); the last bucket also takes anything longer.
+#define PROBE_BUCKETS 97
+
+#define PROBE_REPORT_MAGIC 0x5250   // "PR"
+#define PROBE_REPORT_VERSION 1
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t entry_bytes;            // sizeof(probe_report_entry)
+    uint16_t cpu_mhz;               // cycles per us
+    uint16_t entry_count;           // entries that follow
+    uint32_t uptime_ms;
+} probe_report_header;
+
+typedef struct __attribute__((packed)) {
+    uint8_t section;                // ProbeSection
+    uint8_t state;                  // MissionState, or PROBE_ALL_STATES
+    uint32_t count;
+    uint32_t overruns;              // over the section's budget
+    uint32_t budget_cycles;         // 0 = none
+    uint32_t min_cycles;
+    uint32_t mean_cycles;
+    uint32_t p50_cycles;            // bucket upper edge (within 25%)
+    uint32_t p99_cycles;
+    uint32_t max_cycles;
+} probe_report_entry;
+
+// Room for every section in every state plus the merged rows
+#define PROBE_REPORT_MAX_BYTES (sizeof(probe_report_header) + \
+    PROBE_SECTION_COUNT * (PROBE_MAX_STATES + 1) * sizeof(probe_report_entry))
+
+class ProbeTable {
+public:
+    // Lives in static storage (zeroed); there is no constructor to run.
+
+    // Overruns are counted above this (0 = no budget). Set before the
+    // tasks start.
+    void setBudget(uint8_t section, uint32_t cycles);
+
+    // Hot path. One task per section.
+    void record(uint8_t section, uint8_t state, uint32_t cycles);
+
+    // Current state for probes that do not know it (PROBE_SCOPE)
+    void setState(uint8_t state) { state_.store(state, std::memory_order_relaxed); }
+    uint8_t state() const { return state_.load(std::memory_order_relaxed); }
+
+    // Build the report blob. Returns its size (0 if 'capacity' is short).
+    size_t report(uint8_t* dst, size_t capacity, uint16_t cpu_mhz, uint32_t uptime_ms) const;
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> overruns;
+        std::atomic<uint32_t> min;
+        std::atomic<uint32_t> max;
+        std::atomic<uint32_t> sum_lo;
+        std::atomic<uint32_t> sum_hi;
+        std::atomic<uint32_t> buckets[PROBE_BUCKETS];
+    };
+
+    Cell cells_[PROBE_SECTION_COUNT][PROBE_MAX_STATES];
+    uint32_t budgets_[PROBE_SECTION_COUNT];
+    std::atomic<uint8_t> state_;
+};
+
+// Decodes a report blob fed in pieces of any size, as they arrive.
+class ProbeReportReader {
+public:
+    typedef void (*EntryFn)(const probe_report_header& header, const probe_report_entry& entry, void* ctx);
+
+    ProbeReportReader(EntryFn on_entry, void* ctx);
+
+    void reset();
+    void feed(const uint8_t* data, size_t len);
+
+    bool started() const { return have_header_; }
+    bool corrupt() const { return corrupt_; }
+    const probe_report_header& header() const { return header_; }
+    uint32_t entries() const { return entries_; }
+
+private:
+    EntryFn on_entry_;
+    void* ctx_;
+
+    probe_report_header header_;
+    bool have_header_ = false;
+    bool corrupt_ = false;
+    uint32_t entries_ = 0;
+    size_t fill_ = 0;
+    uint8_t pending_[sizeof(probe_report_header) > sizeof(probe_report_entry)
+                     ? sizeof(probe_report_header) : sizeof(probe_report_entry)];
+};
@@ -0,0 +1,40 @@
+#include "MissionCompliance.h"
+#include <string.h>
+
+MissionCompliance::MissionCompliance(const MissionPlan& plan, uint32_t packet_interval_ms)
+    : plan_(plan), interval_ms_(packet_interval_ms) {
+    if (plan_.count > MISSION_MAX_SEGMENTS) plan_.count = MISSION_MAX_SEGMENTS;
+    memset(&run_, 0, sizeof(run_));
+    memset(holds_, 0, sizeof(holds_));
+}
+
+void MissionCompliance::addPacket(uint32_t time_ms, float depth_m) {
+    bool gap = have_last_ && time_ms - last_ms_ > interval_ms_ * 3 / 2;
+    have_last_ = true;
+    last_ms_ = time_ms;
+    if (complete()) return;
+
+    const mission_segment& s = plan_.segments[index_];
+    float error = depth_m + s.offset_mm / 1000.0f - s.target_mm / 1000.0f;
+    if (error < 0) error = -error;
+    if (gap || error > s.tolerance_mm / 1000.0f) run_.packets = 0;
+    if (error > s.tolerance_mm / 1000.0f) return;
+
+    if (run_.packets == 0) {
+        run_.first_ms = time_ms;
+        run_.max_error_m = 0;
+    }
+    if (run_.packets < 255) run_.packets++;
+    run_.last_ms = time_ms;
+    if (error > run_.max_error_m) run_.max_error_m = error;
+
+    hold_compliance& best = holds_[index_];
+    if (run_.packets > best.packets) best = run_;
+    if (run_.packets >= missionHoldPackets(s, interval_ms_) &&
+        time_ms - run_.first_ms >= missionHoldSpanMs(s, interval_ms_)) {
+        best = run_;
+        best.met = true;
+        index_++;
+        run_.packets = 0;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MissionPlan.h"
+
+// ============================================================================
+// HOLD COMPLIANCE (log packets)
+// ============================================================================
+// Scores a mission the way the judge does: from the logged packets only.
+// For each segment in turn it looks for consecutive packets with the
+// judged depth within tolerance_mm of the target, as many and spanning as
+// long as the executor requires (missionHoldPackets(), missionHoldSpanMs()).
+// A packet out of the band, or a gap of more than 1.5 intervals
+// (a packet missing from the log), restarts the run. Once a hold is met the
+// next packet starts on the next segment.
+//
+// No hardware access: the simulator checks the downloaded log with it and
+// station tools can run it over a saved log.
+
+struct hold_compliance {
+    bool met;
+    uint8_t packets;                // of the qualifying run (best run if not met)
+    uint32_t first_ms, last_ms;     // packet times of that run
+    float max_error_m;              // largest |judged - target| in it
+};
+
+class MissionCompliance {
+public:
+    MissionCompliance(const MissionPlan& plan, uint32_t packet_interval_ms);
+
+    // Packets in log order (time since mission start, depth as logged)
+    void addPacket(uint32_t time_ms, float depth_m);
+
+    uint8_t segmentCount() const { return plan_.count; }
+    uint8_t holdsMet() const { return index_; }
+    bool complete() const { return index_ >= plan_.count; }
+    const hold_compliance& hold(uint8_t i) const { return holds_[i]; }
+
+private:
+    MissionPlan plan_;
+    uint32_t interval_ms_;
+    uint8_t index_ = 0;             // segment being looked for
+    hold_compliance run_;           // current run for it
+    bool have_last_ = false;
+    uint32_t last_ms_ = 0;
+    hold_compliance holds_[MISSION_MAX_SEGMENTS];
+};
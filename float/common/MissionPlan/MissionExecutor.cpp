@@ -0,0 +1,128 @@
+#include "MissionExecutor.h"
+#include <string.h>
+
+static const float SURFACE_DONE_M = 0.10f;      // judged depth that counts as surfaced
+static const int16_t MAX_TARGET_MM = 10000;
+
+MissionExecutor::MissionExecutor(uint32_t packet_interval_ms) : interval_ms_(packet_interval_ms) {
+    memset(&plan_, 0, sizeof(plan_));
+}
+
+bool MissionExecutor::valid(const MissionPlan& plan) {
+    if (plan.count == 0 || plan.count > MISSION_MAX_SEGMENTS) return false;
+    for (int i = 0; i < plan.count; i++) {
+        const mission_segment& s = plan.segments[i];
+        if (s.target_mm <= 0 || s.target_mm > MAX_TARGET_MM) return false;
+        if (s.tolerance_mm == 0 || s.arrive_mm == 0 || s.arrive_mm > s.tolerance_mm) return false;
+    }
+    return true;
+}
+
+bool MissionExecutor::load(const MissionPlan& plan) {
+    if (!valid(plan)) return false;
+    plan_ = plan;
+    phase_ = PHASE_DONE;
+    index_ = 0;
+    return true;
+}
+
+void MissionExecutor::start(uint32_t now_ms) {
+    index_ = 0;
+    packets_ = 0;
+    hold_start_ms_ = now_ms;
+    last_packet_ms_ = now_ms;
+    packet_now_ = true;
+    band_lost_ = false;
+    phase_ = plan_.count ? PHASE_TRAVEL : PHASE_SURFACING;
+}
+
+float MissionExecutor::targetDepth() const {
+    if (phase_ == PHASE_TRAVEL || phase_ == PHASE_HOLD) return segment().target_mm / 1000.0f;
+    return 0;
+}
+
+float MissionExecutor::judgedDepth(float depth_m) const {
+    int16_t offset = (phase_ == PHASE_TRAVEL || phase_ == PHASE_HOLD)
+                   ? segment().offset_mm : plan_.surface_offset_mm;
+    return depth_m + offset / 1000.0f;
+}
+
+bool MissionExecutor::inBand(float depth_m) const {
+    if (phase_ != PHASE_TRAVEL && phase_ != PHASE_HOLD) return false;
+    float error = judgedDepth(depth_m) - targetDepth();
+    if (error < 0) error = -error;
+    return error <= segment().tolerance_mm / 1000.0f;
+}
+
+void MissionExecutor::nextSegment(uint32_t now_ms) {
+    index_++;
+    packets_ = 0;
+    band_lost_ = false;
+    hold_start_ms_ = now_ms;
+    phase_ = index_ < plan_.count ? PHASE_TRAVEL : PHASE_SURFACING;
+}
+
+bool MissionExecutor::update(float depth_m, uint32_t now_ms) {
+    MissionPhase phase = phase_;
+    uint8_t index = index_;
+    float judged = judgedDepth(depth_m);
+
+    switch (phase_) {
+        case PHASE_TRAVEL: {
+            float error = judged - targetDepth();
+            if (error < 0) error = -error;
+            if (error < segment().arrive_mm / 1000.0f) {
+                phase_ = PHASE_HOLD;
+                hold_start_ms_ = now_ms;
+                packets_ = 0;
+                packet_now_ = true;
+                band_lost_ = false;
+            }
+            break;
+        }
+
+        case PHASE_HOLD:
+            // Ends on a packet (onPacket); back in the band, restart the
+            // count at once rather than at the next interval
+            if (band_lost_ && inBand(depth_m)) {
+                band_lost_ = false;
+                packet_now_ = true;
+            }
+            break;
+
+        case PHASE_SURFACING:
+            if (judged < SURFACE_DONE_M) phase_ = PHASE_DONE;
+            break;
+
+        case PHASE_DONE:
+            break;
+    }
+    return phase_ != phase || index_ != index;
+}
+
+bool MissionExecutor::packetDue(uint32_t now_ms) const {
+    if (phase_ == PHASE_DONE) return false;
+    return packet_now_ || now_ms - last_packet_ms_ >= interval_ms_;
+}
+
+bool MissionExecutor::onPacket(float depth_m, uint32_t now_ms) {
+    packet_now_ = false;
+    last_packet_ms_ = now_ms;
+    if (phase_ != PHASE_HOLD) return false;
+
+    const mission_segment& s = segment();
+    if (!inBand(depth_m)) {
+        packets_ = 0;
+        band_lost_ = true;
+        return false;
+    }
+    band_lost_ = false;
+    if (packets_ == 0) hold_start_ms_ = now_ms;
+    if (packets_ < 255) packets_++;
+    if (packets_ >= missionHoldPackets(s, interval_ms_) &&
+        now_ms - hold_start_ms_ >= missionHoldSpanMs(s, interval_ms_)) {
+        nextSegment(now_ms);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MissionPlan.h"
+
+// ============================================================================
+// MISSION SEGMENT EXECUTOR
+// ============================================================================
+// Runs a MissionPlan one depth sample at a time. Each update only looks at
+// the current segment, so the cost per tick does not depend on the length
+// of the mission. No hardware access: the firmware feeds it the filtered
+// depth and drives the piston toward targetDepth(); the simulator replays
+// recorded depth traces through the same code.
+//
+// It also schedules the log packets: one every packet_interval_ms, and one
+// at once when a hold begins, so the hold's packets start with it. Holds
+// are scored on the packets actually logged: each in-band packet counts,
+// one out of band restarts the count, and the hold ends on the packet that
+// completes the requirement (missionHoldPackets() over missionHoldSpanMs(),
+// no waiting out a further interval). After an out-of-band packet the next
+// one is due as soon as the depth is back in the band, so the restarted
+// count starts there too.
+
+enum MissionPhase : uint8_t {
+    PHASE_TRAVEL,       // moving toward the segment target
+    PHASE_HOLD,         // in (or fighting to stay in) the band
+    PHASE_SURFACING,    // after the last segment
+    PHASE_DONE          // at the surface
+};
+
+class MissionExecutor {
+public:
+    // packet_interval_ms: spacing of the log packets a hold is counted in
+    explicit MissionExecutor(uint32_t packet_interval_ms);
+
+    // Check and take a plan. Returns false (keeping the old plan) if it is
+    // empty, too long or has an out-of-range segment.
+    bool load(const MissionPlan& plan);
+    static bool valid(const MissionPlan& plan);
+
+    void start(uint32_t now_ms);
+
+    // Feed the latest sensor depth (m, >= 0). Returns true when the phase or
+    // the segment changed.
+    bool update(float depth_m, uint32_t now_ms);
+
+    // Log packets: take one when packetDue(), then report the depth that
+    // was logged with onPacket(). Returns true when that packet completed
+    // the hold (segment changed).
+    bool packetDue(uint32_t now_ms) const;
+    bool onPacket(float depth_m, uint32_t now_ms);
+
+    MissionPhase phase() const { return phase_; }
+    uint8_t segmentIndex() const { return index_; }
+    uint8_t segmentCount() const { return plan_.count; }
+    // Current segment (the last one once surfacing)
+    const mission_segment& segment() const {
+        return plan_.segments[index_ < plan_.count ? index_ : (plan_.count ? plan_.count - 1 : 0)];
+    }
+    const MissionPlan& plan() const { return plan_; }
+
+    // Depth to steer for (0 while surfacing)
+    float targetDepth() const;
+    // Sensor depth corrected by the current segment's offset
+    float judgedDepth(float depth_m) const;
+    bool inBand(float depth_m) const;
+
+    // Consecutive in-band packets logged in the current hold, and when the
+    // first of them was logged
+    uint8_t validPackets() const { return packets_; }
+    uint32_t holdStartMs() const { return hold_start_ms_; }
+    uint32_t lastPacketMs() const { return last_packet_ms_; }
+
+private:
+    void nextSegment(uint32_t now_ms);
+
+    uint32_t interval_ms_;
+    MissionPlan plan_;
+    MissionPhase phase_ = PHASE_DONE;
+    uint8_t index_ = 0;
+    uint8_t packets_ = 0;
+    uint32_t hold_start_ms_ = 0;
+    uint32_t last_packet_ms_ = 0;
+    bool packet_now_ = false;           // a hold began: log at once
+    bool band_lost_ = false;            // last packet out of band: log on re-entry
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// MISSION PLAN (segment table)
+// ============================================================================
+// Shared by onboard_float and control_station (lib_extra_dirs = ../common).
+//
+// A mission is a short table of segments. Each segment is: travel until the
+// judged depth (sensor depth + offset) is within arrive_mm of the target,
+// then hold until 'packets' consecutive log packets, the first logged as
+// the hold begins, have been within tolerance_mm of it and span at least
+// hold_s seconds. A packet out of the band restarts the count. After the
+// last segment the float surfaces.
+//
+// 'packets' at the packet interval is a span as well (7 x 5 s = 35 s for
+// MATE), so a hold never ends before that, whatever hold_s says: see
+// missionHoldSpanMs() and missionHoldPackets().
+//
+// The table rides in struct_command with "deploy"; a deploy without one
+// (segment_count = 0) flies the classic two profiles built by
+// missionPlanTwoProfiles().
+
+#define MISSION_MAX_SEGMENTS 8
+
+typedef struct __attribute__((packed)) {
+    int16_t target_mm;              // depth to reach and hold
+    uint16_t tolerance_mm;          // hold band: target +/- this
+    uint16_t arrive_mm;             // travel ends within target +/- this
+    uint16_t hold_s;                // minimum time in the band
+    int16_t offset_mm;              // sensor offset for this target (declared to the judge)
+    uint8_t packets;                // consecutive in-band log packets required
+} mission_segment;
+
+struct MissionPlan {
+    uint8_t count;
+    int16_t surface_offset_mm;      // offset used to judge the final surfacing
+    mission_segment segments[MISSION_MAX_SEGMENTS];
+};
+
+// MATE scoring: +/-33 cm for 7 consecutive packets (5 s apart)
+#define MISSION_TOLERANCE_MM 330
+#define MISSION_ARRIVE_MM 50
+#define MISSION_PACKETS 7
+
+inline mission_segment missionSegment(float target_m, int hold_s, float offset_m) {
+    mission_segment s;
+    s.target_mm = (int16_t)(target_m * 1000.0f + (target_m >= 0 ? 0.5f : -0.5f));
+    s.tolerance_mm = MISSION_TOLERANCE_MM;
+    s.arrive_mm = MISSION_ARRIVE_MM;
+    s.hold_s = (uint16_t)(hold_s > 0 ? hold_s : 0);
+    s.offset_mm = (int16_t)(offset_m * 1000.0f + (offset_m >= 0 ? 0.5f : -0.5f));
+    s.packets = MISSION_PACKETS;
+    return s;
+}
+
+// Span the packets of a hold must cover: hold_s, and at least 'packets'
+// intervals
+inline uint32_t missionHoldSpanMs(const mission_segment& s, uint32_t packet_interval_ms) {
+    uint32_t hold_ms = (uint32_t)s.hold_s * 1000;
+    uint32_t packets_ms = (uint32_t)s.packets * packet_interval_ms;
+    return hold_ms > packets_ms ? hold_ms : packets_ms;
+}
+
+// Consecutive in-band packets a hold needs: 'packets', and enough to cover
+// the span at one per interval (8 for 7 x 5 s)
+inline uint32_t missionHoldPackets(const mission_segment& s, uint32_t packet_interval_ms) {
+    uint32_t span_ms = missionHoldSpanMs(s, packet_interval_ms);
+    uint32_t needed = packet_interval_ms ? (span_ms + packet_interval_ms - 1) / packet_interval_ms + 1 : s.packets;
+    return needed > s.packets ? needed : s.packets;
+}
+
+// Two profiles: fd, sd, fd, sd. The deep target is judged at the bottom of
+// the float, the shallow one at the top.
+inline void missionPlanTwoProfiles(MissionPlan& plan, float fd, int fdt, float sd, int sdt,
+                                   float bottom_offset_m, float top_offset_m) {
+    plan.count = 4;
+    plan.surface_offset_mm = (int16_t)(top_offset_m * 1000.0f);
+    for (int p = 0; p < 2; p++) {
+        plan.segments[2 * p] = missionSegment(fd, fdt, bottom_offset_m);
+        plan.segments[2 * p + 1] = missionSegment(sd, sdt, top_offset_m);
+    }
+}
@@ -0,0 +1,101 @@
+#include "SerialFrame.h"
+#include <string.h>
+
+// CRC-16/CCITT, as FlashRingLog uses for its pages
+static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+size_t serialFrameEncode(uint8_t type, const void* payload, size_t len, uint8_t* out) {
+    if (len > SERIAL_FRAME_MAX_PAYLOAD) len = SERIAL_FRAME_MAX_PAYLOAD;
+    uint8_t plain[SERIAL_FRAME_MAX_PAYLOAD + 4];
+    plain[0] = type;
+    plain[1] = (uint8_t)len;
+    memcpy(plain + 2, payload, len);
+    uint16_t crc = crc16(0xFFFF, plain, len + 2);
+    plain[len + 2] = (uint8_t)crc;
+    plain[len + 3] = (uint8_t)(crc >> 8);
+
+    // COBS: each code byte is the distance to the next zero (or block end)
+    size_t n = 0;
+    size_t code_at = n++;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len + 4; i++) {
+        if (plain[i] != 0) {
+            out[n++] = plain[i];
+            code++;
+        }
+        if (plain[i] == 0 || code == 0xFF) {
+            out[code_at] = code;
+            code_at = n++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    out[n++] = 0;
+    return n;
+}
+
+SerialFrameReader::SerialFrameReader(FrameFn on_frame, void* ctx)
+    : on_frame_(on_frame), ctx_(ctx) {}
+
+void SerialFrameReader::reset() {
+    fill_ = 0;
+    overrun_ = false;
+    frames_ = 0;
+    bad_frames_ = 0;
+}
+
+void SerialFrameReader::feed(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0) {
+            endFrame();
+            continue;
+        }
+        if (fill_ < sizeof(raw_)) raw_[fill_++] = data[i];
+        else overrun_ = true;
+    }
+}
+
+void SerialFrameReader::endFrame() {
+    size_t fill = fill_;
+    bool overrun = overrun_;
+    fill_ = 0;
+    overrun_ = false;
+    if (fill == 0 && !overrun) return;          // back-to-back delimiters
+    if (overrun) {
+        bad_frames_++;
+        return;
+    }
+
+    // Decode in place: the output never runs ahead of the input
+    size_t n = 0;
+    size_t i = 0;
+    while (i < fill) {
+        uint8_t code = raw_[i++];
+        if (i + code - 1 > fill) {
+            bad_frames_++;
+            return;
+        }
+        for (uint8_t k = 1; k < code; k++) raw_[n++] = raw_[i++];
+        if (code != 0xFF && i < fill) raw_[n++] = 0;
+    }
+
+    if (n < 4 || raw_[1] != n - 4) {
+        bad_frames_++;
+        return;
+    }
+    uint16_t crc = (uint16_t)(raw_[n - 2] | (raw_[n - 1] << 8));
+    if (crc16(0xFFFF, raw_, n - 2) != crc) {
+        bad_frames_++;
+        return;
+    }
+    frames_++;
+    on_frame_(raw_[0], raw_ + 2, raw_[1], ctx_);
+}
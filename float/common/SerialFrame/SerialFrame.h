@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// SERIAL FRAMES (station -> laptop)
+// ============================================================================
+// Binary records on the control station's USB serial, decoded on the laptop
+// by control_station/tools/station_decode. One frame is
+//
+//   COBS( type u8 | len u8 | payload[len] | crc16 LE ) 0x00
+//
+// The CRC is CRC-16/CCITT (0x1021, init 0xFFFF) over type, len and payload.
+// COBS removes every zero from the frame, so the 0x00 delimiter can only
+// mean "frame ends here": a reader that starts mid-stream, or loses bytes,
+// drops one frame and is back in step at the next delimiter.
+//
+// Record types and layouts are in StationRecords.h.
+
+#define SERIAL_FRAME_MAX_PAYLOAD 240
+// type + len + payload + crc, one COBS overhead byte per 254, delimiter
+#define SERIAL_FRAME_MAX_BYTES (SERIAL_FRAME_MAX_PAYLOAD + 4 + 2 + 1)
+
+// Encode one record into 'out' (SERIAL_FRAME_MAX_BYTES); returns the bytes
+// to send, delimiter included. A payload over the maximum is cut short.
+size_t serialFrameEncode(uint8_t type, const void* payload, size_t len, uint8_t* out);
+
+class SerialFrameReader {
+public:
+    typedef void (*FrameFn)(uint8_t type, const uint8_t* payload, uint8_t len, void* ctx);
+
+    SerialFrameReader(FrameFn on_frame, void* ctx);
+
+    void reset();
+    void feed(const uint8_t* data, size_t len);
+
+    uint32_t frames() const { return frames_; }
+    uint32_t badFrames() const { return bad_frames_; }     // CRC, length or COBS errors
+
+private:
+    void endFrame();
+
+    FrameFn on_frame_;
+    void* ctx_;
+    uint8_t raw_[SERIAL_FRAME_MAX_BYTES];   // COBS bytes since the last delimiter
+    size_t fill_ = 0;
+    bool overrun_ = false;
+    uint32_t frames_ = 0;
+    uint32_t bad_frames_ = 0;
+};
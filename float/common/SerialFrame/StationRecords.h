@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include "FloatLink.h"
+#include "TraceLog.h"
+#include "MissionPlan.h"
+
+// ============================================================================
+// STATION RECORDS (SerialFrame payloads)
+// ============================================================================
+// What the control station sends in binary serial mode. All little-endian,
+// packed. A download is REC_DOWNLOAD_BEGIN, its records, REC_DOWNLOAD_END;
+// the mission plan goes out at deploy and again before each log download,
+// so a decoder started after a station reset can still score the holds.
+
+enum StationRecordType : uint8_t {
+    REC_TEXT = 1,               // one console line, no newline
+    REC_PLAN = 2,               // station_plan_record
+    REC_DOWNLOAD_BEGIN = 3,     // station_download_begin
+    REC_LOG_HEADER = 4,         // station_log_header: first sample, or a new company ID
+    REC_LOG_SAMPLE = 5,         // station_log_sample
+    REC_TRACE_RECORD = 6,       // trace_record (TraceLog.h)
+    REC_DOWNLOAD_END = 7,       // station_download_end
+    REC_TELEMETRY = 8           // station_telemetry
+};
+
+typedef struct __attribute__((packed)) {
+    char company_id[10];
+    uint16_t log_interval_ms;       // float's log packet interval
+    uint8_t count;
+    int16_t surface_offset_mm;
+    mission_segment segments[MISSION_MAX_SEGMENTS];
+} station_plan_record;
+
+typedef struct __attribute__((packed)) {
+    uint8_t stream;                 // LinkStream
+} station_download_begin;
+
+typedef struct __attribute__((packed)) {
+    char company_id[10];
+    float surface_kpa;              // the log's surface calibration
+} station_log_header;
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_ms;               // since mission start
+    float pressure_kpa;
+    float depth_m;
+    float temp_c;
+} station_log_sample;
+
+typedef struct __attribute__((packed)) {
+    uint8_t stream;                 // LinkStream
+    uint8_t ok;                     // decoded cleanly, nothing lost on the station
+    uint32_t entries;               // samples or trace records
+    uint32_t bytes;                 // blob size on the radio link
+    uint32_t bad;                   // log: bad segments; trace: records overwritten on board
+    uint32_t duplicates;            // duplicate radio frames
+} station_download_end;
+
+typedef struct __attribute__((packed)) {
+    uint32_t rx_ms;                 // station clock at reception
+    link_telemetry_frame frame;
+    uint32_t lost;                  // TelemetryStats, since deploy
+    uint16_t mean_delay_ms;
+} station_telemetry;
@@ -1,6 +1,15 @@
 #include <Arduino.h>
+#include <stdarg.h>
 #include <esp_now.h>
 #include <WiFi.h>
+#include <LogLink.h>
+#include <Telemetry.h>
+#include <CompactLog.h>
+#include <TraceLog.h>
+#include <MissionPlan.h>
+#include <FloatProbe.h>
+#include <SerialFrame.h>
+#include <StationRecords.h>
 
 // --- SHARED STRUCTURES (PACKED) ---
 typedef struct __attribute__((packed)) {
@@ -11,6 +20,14 @@ typedef struct __attribute__((packed)) {
     float temp_c;
 } struct_message;
 
+typedef struct __attribute__((packed)) {
+    struct_message sample;
+    float surface_kpa;
+    float surface_var_pa2;
+    uint16_t surface_samples;
+    uint16_t surface_outliers;
+} struct_predive;
+
 typedef struct __attribute__((packed)) {
     char cmd[16];
     char company_id[10]; 
@@ -18,6 +35,11 @@ typedef struct __attribute__((packed)) {
     float target_sd;
     int fdt;
     int sdt;
+    int max_sps;
+    int accel_sps2;
+    uint8_t segment_count;
+    int16_t surface_offset_mm;
+    mission_segment segments[MISSION_MAX_SEGMENTS];
 } struct_command;
 
 typedef struct __attribute__((packed)) {
@@ -32,56 +54,446 @@ float my_target_fd     = 2.50;       // Target 1: 2.5m [cite: 34, 107]
 float my_target_sd     = 0.40;       // Target 2: 40cm [cite: 34, 111]
 int my_fdt             = 30;         // Hold 1: 30 seconds [cite: 34]
 int my_sdt             = 30;         // Hold 2: 30 seconds [cite: 34]
+int my_max_sps         = 2000;       // Piston cruise rate (steps/s), 0 = float default
+int my_accel_sps2      = 8000;       // Piston acceleration (steps/s^2), 0 = float default
+bool my_binary_serial  = true;       // false: Teleplot text at 115200 (no station_decode)
+
+// Mission table (MissionPlan.h). Leave my_segment_count at 0 to fly the two
+// profiles above; otherwise these segments are flown in order. Offsets are
+// the sensor offsets declared to the judge for each target.
+// {target_mm, tolerance_mm, arrive_mm, hold_s, offset_mm, packets}
+int my_segment_count   = 0;
+int my_surface_offset_mm = 0;
+mission_segment my_segments[MISSION_MAX_SEGMENTS] = {
+    {2500, 330, 50, 30, 0, 7},
+    { 400, 330, 50, 30, 0, 7},
+    {2500, 330, 50, 30, 0, 7},
+    { 400, 330, 50, 30, 0, 7},
+    {2500, 330, 50, 30, 0, 7},
+    { 400, 330, 50, 30, 0, 7},
+};
 // ============================================================================
 
+// As set on the float (onboard_float/src/main.cpp), for the plan record the
+// laptop scores the holds with
+const float SENSOR_BOTTOM_OFFSET = 0.0;
+const float SENSOR_TOP_OFFSET = 0.0;
+const uint16_t FLOAT_LOG_INTERVAL_MS = 5000;
+
 #define DEPLOY_BTN 15
 #define SEND_BTN 16
 #define PREDIVE_BTN 17 
+#define TRACE_BTN 18       // download the high-rate trace after recovery
 
 uint8_t floatMac[] = {0xAC, 0xA7, 0x04, 0x29, 0x86, 0x44};
 bool predive_confirmed = false;
 
+// ============================================================================
+// SERIAL OUTPUT
+// ============================================================================
+// Binary mode: every console line and every decoded sample, trace record
+// and telemetry frame is a CRC-checked COBS frame (SerialFrame.h,
+// StationRecords.h) at 921600 baud; control_station/tools/station_decode
+// turns them into CSV, a columnar file and the hold scores. A whole log
+// sample costs 23 bytes; its Teleplot line took ~25 for depth and time.
+// Teleplot mode: the text lines and >Depth_cm plots at 115200, for the
+// VS Code serial monitor.
+
+#define SERIAL_BINARY_BAUD 921600
+#define SERIAL_TEXT_BAUD 115200
+
+void sendRecord(uint8_t type, const void* payload, size_t len) {
+    uint8_t frame[SERIAL_FRAME_MAX_BYTES];
+    Serial.write(frame, serialFrameEncode(type, payload, len, frame));
+}
+
+// One console line; in binary mode a REC_TEXT record without the newline
+void stationPrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void stationPrintf(const char* format, ...) {
+    char line[SERIAL_FRAME_MAX_PAYLOAD + 1];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0) return;
+    if (n >= (int)sizeof(line)) n = sizeof(line) - 1;
+    if (!my_binary_serial) {
+        Serial.print(line);
+        return;
+    }
+    if (n > 0 && line[n - 1] == '\n') n--;
+    sendRecord(REC_TEXT, line, n);
+}
+
+// The plan the float will fly for the current parameters (as the float
+// builds it from struct_command)
+void sendPlan() {
+    if (!my_binary_serial) return;
+    station_plan_record r = {};
+    memcpy(r.company_id, my_company_id, sizeof(r.company_id));
+    r.log_interval_ms = FLOAT_LOG_INTERVAL_MS;
+    MissionPlan plan;
+    if (my_segment_count == 0) {
+        missionPlanTwoProfiles(plan, my_target_fd, my_fdt, my_target_sd, my_sdt,
+                               SENSOR_BOTTOM_OFFSET, SENSOR_TOP_OFFSET);
+    } else {
+        plan.count = my_segment_count;
+        plan.surface_offset_mm = my_surface_offset_mm;
+        memcpy(plan.segments, my_segments, sizeof(plan.segments));
+    }
+    r.count = plan.count;
+    r.surface_offset_mm = plan.surface_offset_mm;
+    memcpy(r.segments, plan.segments, sizeof(r.segments));
+    sendRecord(REC_PLAN, &r, sizeof(r));
+}
+
+// ============================================================================
+// LIVE TELEMETRY
+// ============================================================================
+// While its antenna is out of the water the float sends a state frame
+// every 500 ms (link_telemetry_frame). The WiFi callback updates the
+// statistics and keeps the newest frame; loop() prints it (or sends it as
+// REC_TELEMETRY in binary mode).
+
+// Keep in sync with MissionState (onboard_float/include/float_defs.h)
+const char* const STATE_NAMES[] = {
+    "IDLE", "CALIBRATING", "TRAVEL", "HOLD", "SURFACING", "MISSION_DONE"
+};
+
+portMUX_TYPE liveMux = portMUX_INITIALIZER_UNLOCKED;
+TelemetryStats liveStats;
+link_telemetry_frame live_frame;
+volatile bool live_pending = false;
+
+void onTelemetry(const uint8_t* data) {
+    uint32_t rx_ms = millis();
+    portENTER_CRITICAL(&liveMux);
+    memcpy(&live_frame, data, sizeof(live_frame));
+    liveStats.onFrame(live_frame, rx_ms);
+    live_pending = true;
+    portEXIT_CRITICAL(&liveMux);
+}
+
+void printTelemetry() {
+    if (!live_pending) return;
+    portENTER_CRITICAL(&liveMux);
+    link_telemetry_frame f = live_frame;
+    TelemetryStats stats = liveStats;
+    live_pending = false;
+    portEXIT_CRITICAL(&liveMux);
+
+    if (my_binary_serial) {
+        station_telemetry r;
+        r.rx_ms = millis();
+        r.frame = f;
+        r.lost = stats.lost();
+        r.mean_delay_ms = (uint16_t)stats.meanDelayMs();
+        sendRecord(REC_TELEMETRY, &r, sizeof(r));
+        return;
+    }
+    const char* state = f.state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[f.state] : "?";
+    Serial.printf(">Live_depth_cm:%.1f\n", f.depth_mm * -0.1f);
+    Serial.printf(">Live_piston:%d\n", f.piston);
+    Serial.printf("[LIVE #%u] %s seg %u D:%.2fm V:%+.2fm/s P:%d hold %u/7 | +%ums (mean +%u, max +%u), %u lost (%.0f%%)\n",
+                  f.seq, state, f.segment + 1, f.depth_mm / 1000.0f, f.velocity_mm_s / 1000.0f, f.piston,
+                  f.hold_packets, stats.lastDelayMs(), stats.meanDelayMs(), stats.maxDelayMs(),
+                  stats.lost(), stats.lossRatio() * 100.0f);
+}
+
+// ============================================================================
+// LOG RECOVERY
+// ============================================================================
+// The float streams its flash log (CompactLog segments) as a windowed,
+// acknowledged blob (LogLink.h). The WiFi callback only queues the link
+// frames; loop() runs the receivers on them, sends the acks, and decodes
+// the bytes from a ring at Serial speed. The receivers, the ring and the
+// decoders are thus only touched by the loop task. The high-rate trace
+// (TraceLog.h) comes the same way on its own stream; one download runs at
+// a time and rx_stream says which one owns the ring.
+
+// Link frames from the WiFi callback, under liveMux
+#define LINK_RX_FRAMES 32           // two windows
+struct link_rx_slot {
+    uint8_t len;
+    uint8_t data[sizeof(link_data_frame)];
+};
+link_rx_slot link_rx[LINK_RX_FRAMES];
+uint32_t link_rx_head = 0;
+uint32_t link_rx_tail = 0;
+
+#define LOG_RX_BYTES 32768          // ~15000 entries in flight
+uint8_t log_rx[LOG_RX_BYTES];
+uint32_t log_rx_head = 0;
+uint32_t log_rx_tail = 0;
+uint32_t log_rx_overflow = 0;
+uint8_t rx_stream = STREAM_MISSION_LOG;
+int16_t rx_transfer = -1;           // LogLink transfer in the ring, -1 before its first bytes
+bool recovery_reported = false;
+
+extern LogLinkReceiver logReceiver;
+extern LogLinkReceiver traceReceiver;
+void restartDownload(uint8_t stream);
+
+// ctx is the LinkStream the receiver belongs to
+void onLogBytes(const uint8_t* data, size_t len, void* ctx) {
+    if ((uintptr_t)ctx != rx_stream) return;    // late frames of the other download
+    // The float sent another blob on this stream and the receiver started
+    // it over: drop what the ring and the decoders hold of the last one
+    LogLinkReceiver& receiver = rx_stream == STREAM_TRACE ? traceReceiver : logReceiver;
+    if (rx_transfer >= 0 && receiver.transfer() != rx_transfer) restartDownload(rx_stream);
+    rx_transfer = receiver.transfer();
+    for (size_t i = 0; i < len; i++) {
+        if (log_rx_head - log_rx_tail >= LOG_RX_BYTES) {
+            log_rx_overflow++;
+            return;
+        }
+        log_rx[log_rx_head % LOG_RX_BYTES] = data[i];
+        log_rx_head++;
+    }
+}
+
+// Binary mode: a REC_LOG_HEADER before the first sample (and if the company
+// ID changes), then one REC_LOG_SAMPLE per sample
+char sent_company_id[10];
+bool log_header_sent = false;
+
+// Teleplot Format for VSCode
+// Logic: Meters to negative centimeters for depth-profile visualization
+void onLogSample(const compact_log_header& header, const LogSample& data, void* ctx) {
+    if (my_binary_serial) {
+        if (!log_header_sent || memcmp(sent_company_id, header.company_id, sizeof(sent_company_id)) != 0) {
+            station_log_header h;
+            memcpy(h.company_id, header.company_id, sizeof(h.company_id));
+            h.surface_kpa = header.surface_pressure / 100.0f;
+            sendRecord(REC_LOG_HEADER, &h, sizeof(h));
+            memcpy(sent_company_id, header.company_id, sizeof(sent_company_id));
+            log_header_sent = true;
+        }
+        station_log_sample r = {data.time_ms, data.pressure_kpa, data.depth_m, data.temp_c};
+        sendRecord(REC_LOG_SAMPLE, &r, sizeof(r));
+        return;
+    }
+    Serial.print(">Depth_cm:");
+    Serial.print(data.depth_m * -100.0f); 
+    Serial.print("|u:");
+    Serial.println(data.time_ms / 1000.0f);
+}
+
+CompactLogStreamReader logDecoder(onLogSample, nullptr);
+
+// Trace records as CSV lines, to be captured from the serial monitor
+void onTraceRecord(const trace_log_header& header, const trace_record& r, void* ctx) {
+    if (my_binary_serial) {
+        sendRecord(REC_TRACE_RECORD, &r, sizeof(r));
+        return;
+    }
+    Serial.printf("trace,%.2f,%u,%.3f,%.3f,%.3f,%d,%d\n", r.time_ms / 1000.0f, r.state,
+                  r.depth_mm / 1000.0f, r.measured_mm / 1000.0f, r.velocity_mm_s / 1000.0f,
+                  r.piston, r.piston_target);
+}
+
+TraceStreamReader traceDecoder(onTraceRecord, nullptr);
+
+LogLinkReceiver logReceiver(STREAM_MISSION_LOG, onLogBytes, (void*)STREAM_MISSION_LOG);
+LogLinkReceiver traceReceiver(STREAM_TRACE, onLogBytes, (void*)STREAM_TRACE);
+
+// Probe report (FloatProbe.h): sent by a float built with -DFLOAT_PROBES
+// right after its log, on its own stream. Small enough to keep whole;
+// printed as CSV lines once complete.
+uint8_t probe_rx[PROBE_REPORT_MAX_BYTES];
+uint32_t probe_rx_bytes = 0;
+bool probes_reported = false;
+
+void onProbeBytes(const uint8_t* data, size_t len, void* ctx) {
+    if (probe_rx_bytes + len > sizeof(probe_rx)) return;
+    memcpy(probe_rx + probe_rx_bytes, data, len);
+    probe_rx_bytes += len;
+}
+
+void onProbeEntry(const probe_report_header& header, const probe_report_entry& e, void* ctx) {
+    float mhz = header.cpu_mhz;
+    const char* state = e.state == PROBE_ALL_STATES ? "all"
+                      : e.state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[e.state] : "?";
+    stationPrintf("probe,%s,%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u\n", probeSectionName(e.section), state,
+                  e.count, e.min_cycles / mhz, e.mean_cycles / mhz, e.p50_cycles / mhz,
+                  e.p99_cycles / mhz, e.max_cycles / mhz, e.budget_cycles / mhz, e.overruns);
+}
+
+LogLinkReceiver probeReceiver(STREAM_PROBES, onProbeBytes, nullptr);
+
+void printProbeReport() {
+    if (!probeReceiver.complete() || probes_reported) return;
+    probes_reported = true;
+    ProbeReportReader reader(onProbeEntry, nullptr);
+    stationPrintf("probe,section,state,count,min_us,mean_us,p50_us,p99_us,max_us,budget_us,overruns\n");
+    reader.feed(probe_rx, probe_rx_bytes);
+    bool ok = !reader.corrupt() && reader.entries() == reader.header().entry_count;
+    stationPrintf(">>> PROBES %s: %u rows, float up %.1f s\n", ok ? "COMPLETE" : "CORRUPT",
+                  reader.entries(), reader.header().uptime_ms / 1000.0f);
+}
+
+// Switch the ring to 'stream' and start that download from scratch if it
+// completed before. A repeat press mid-transfer resumes it: the float sends
+// the same transfer again, or another one, which onLogBytes() starts over.
+void selectDownload(uint8_t stream) {
+    LogLinkReceiver& receiver = stream == STREAM_TRACE ? traceReceiver : logReceiver;
+    if (stream == rx_stream && !receiver.complete()) return;
+    receiver.reset();
+    restartDownload(stream);
+}
+
+// Empty the ring and the decoders for a new download on 'stream'
+void restartDownload(uint8_t stream) {
+    logDecoder.reset();
+    traceDecoder.reset();
+    rx_stream = stream;
+    rx_transfer = -1;
+    log_rx_tail = log_rx_head;
+    log_rx_overflow = 0;
+    recovery_reported = false;
+    log_header_sent = false;
+    if (stream == STREAM_MISSION_LOG) sendPlan();
+    if (my_binary_serial) {
+        station_download_begin r = {stream};
+        sendRecord(REC_DOWNLOAD_BEGIN, &r, sizeof(r));
+    } else if (stream == STREAM_TRACE) {
+        Serial.println("trace,t_s,state,depth_m,measured_m,velocity_mps,piston_steps,piston_target");
+    }
+}
+
+// End of a download, for the decoder (binary mode only)
+void reportDownload(uint8_t stream, bool ok, uint32_t entries, uint32_t bad) {
+    if (!my_binary_serial) return;
+    LogLinkReceiver& receiver = stream == STREAM_TRACE ? traceReceiver : logReceiver;
+    station_download_end r;
+    r.stream = stream;
+    r.ok = ok;
+    r.entries = entries;
+    r.bytes = receiver.totalBytes();
+    r.bad = bad;
+    r.duplicates = receiver.duplicates();
+    sendRecord(REC_DOWNLOAD_END, &r, sizeof(r));
+}
+
+// ============================================================================
+// STATUS AND PRE-DIVE MESSAGES
+// ============================================================================
+// Copied by the WiFi callback, printed by loop()
+
+struct_status rx_status;
+struct_predive rx_predive;
+volatile bool status_pending = false;
+volatile bool predive_pending = false;
+
+void printStatus() {
+    if (!status_pending) return;
+    portENTER_CRITICAL(&liveMux);
+    struct_status status = rx_status;
+    status_pending = false;
+    portEXIT_CRITICAL(&liveMux);
+
+    stationPrintf(">>> [STATUS RECEIVED]: %.*s\n", (int)sizeof(status.msg), status.msg);
+    if (strncmp(status.msg, "Ready: 0x76 OK", sizeof(status.msg)) == 0) {
+        stationPrintf(">>> STEP 1: Press 'Pre-dive Transmission' (Pin 17) <<<\n");
+    }
+}
+
+void printPredive() {
+    if (!predive_pending) return;
+    portENTER_CRITICAL(&liveMux);
+    struct_predive predive = rx_predive;
+    predive_pending = false;
+    portEXIT_CRITICAL(&liveMux);
+    const struct_message& data = predive.sample;
+
+    // PRE-DIVE VERIFICATION (For the Mission Judge)
+    stationPrintf("--- PRE-DIVE VERIFICATION ---\n");
+    stationPrintf("Company ID: %.*s\n", (int)sizeof(data.company_id), data.company_id);
+    stationPrintf("Pressure: %.2f kPa\n", data.pressure_kpa);
+    stationPrintf("Depth: %.2f m\n", data.depth_m);
+    stationPrintf("-----------------------------\n");
+    // The surface reference deploy will dive on (tracked while idle;
+    // ready at the float's surfaceConfig.min_samples)
+    if (predive.surface_samples < 10) {
+        stationPrintf("Surface: not settled yet (%u samples), deploy will calibrate first\n",
+                      predive.surface_samples);
+    } else {
+        stationPrintf("Surface: %.3f kPa, sd %.1f Pa over %u samples, %u outliers rejected\n",
+                      predive.surface_kpa, sqrtf(predive.surface_var_pa2),
+                      predive.surface_samples, predive.surface_outliers);
+    }
+    stationPrintf(">>> STEP 2: Pre-dive OK. Press 'Deploy' (Pin 15) to dive <<<\n");
+}
+
+// Hand the queued link frames to the receivers and acknowledge them
+void processLinkFrames() {
+    link_rx_slot frame;
+    for (;;) {
+        // Serial is slower than the radio: with no room left for a full
+        // window, leave the frames queued. Once the queue is full the
+        // callback drops them and the float resends them later.
+        if (LOG_RX_BYTES - (log_rx_head - log_rx_tail) < (LINK_WINDOW + 1) * LINK_CHUNK_BYTES) return;
+        portENTER_CRITICAL(&liveMux);
+        bool have = link_rx_tail != link_rx_head;
+        if (have) {
+            frame = link_rx[link_rx_tail % LINK_RX_FRAMES];
+            link_rx_tail++;
+        }
+        portEXIT_CRITICAL(&liveMux);
+        if (!have) return;
+
+        link_ack_frame ack;
+        if (logReceiver.onFrame(frame.data, frame.len, ack) ||
+            traceReceiver.onFrame(frame.data, frame.len, ack) ||
+            probeReceiver.onFrame(frame.data, frame.len, ack)) {
+            esp_now_send(floatMac, (uint8_t *) &ack, sizeof(ack));
+        }
+    }
+}
+
 void onDataRecv(const uint8_t * mac, const uint8_t *incomingData, int len) {
-    if (len == sizeof(struct_status)) {
-        struct_status status;
-        memcpy(&status, incomingData, sizeof(status));
-        Serial.print(">>> [STATUS RECEIVED]: "); Serial.println(status.msg);
-        
-        if (strcmp(status.msg, "Ready: 0x76 OK") == 0) {
-            Serial.println(">>> STEP 1: Press 'Pre-dive Transmission' (Pin 17) <<<");
+    if (isLinkFrame(incomingData, len)) {
+        if (incomingData[0] == LINK_TELEMETRY) {
+            if (len == sizeof(link_telemetry_frame)) onTelemetry(incomingData);
+            return;
         }
-    } 
-    else if (len == sizeof(struct_message)) {
-        struct_message data;
-        memcpy(&data, incomingData, sizeof(data));
-
-        if (!predive_confirmed) {
-            // PHASE 1: PRE-DIVE VERIFICATION (For the Mission Judge)
-            Serial.println("--- PRE-DIVE VERIFICATION ---");
-            Serial.print("Company ID: "); Serial.println(data.company_id);
-            Serial.print("Pressure: "); Serial.print(data.pressure_kpa); Serial.println(" kPa");
-            Serial.print("Depth: "); Serial.print(data.depth_m); Serial.println(" m");
-            Serial.println("-----------------------------");
-            
-            predive_confirmed = true;
-            Serial.println(">>> STEP 2: Pre-dive OK. Press 'Deploy' (Pin 15) to dive <<<");
-        } 
-        else {
-            // PHASE 2: DATA RECOVERY (Teleplot Format for VSCode)
-            // Logic: Meters to negative centimeters for depth-profile visualization
-            Serial.print(">Depth_cm:");
-            Serial.print(data.depth_m * -100.0f); 
-            Serial.print("|u:");
-            Serial.println(data.timestamp);        
+        if (len > (int)sizeof(link_rx[0].data)) return;
+        portENTER_CRITICAL(&liveMux);
+        if (link_rx_head - link_rx_tail < LINK_RX_FRAMES) {     // else the float resends it
+            link_rx_slot& slot = link_rx[link_rx_head % LINK_RX_FRAMES];
+            slot.len = (uint8_t)len;
+            memcpy(slot.data, incomingData, len);
+            link_rx_head++;
         }
+        portEXIT_CRITICAL(&liveMux);
+        return;
+    }
+    if (len == sizeof(struct_status)) {
+        portENTER_CRITICAL(&liveMux);
+        memcpy(&rx_status, incomingData, sizeof(rx_status));
+        status_pending = true;
+        portEXIT_CRITICAL(&liveMux);
+    } 
+    else if (len == sizeof(struct_predive)) {
+        portENTER_CRITICAL(&liveMux);
+        memcpy(&rx_predive, incomingData, sizeof(rx_predive));
+        predive_pending = true;
+        portEXIT_CRITICAL(&liveMux);
+        predive_confirmed = true;
     }
 }
 
 void setup() {
-    Serial.begin(115200);
+    if (my_binary_serial) {
+        Serial.setTxBufferSize(4096);   // a window of log samples without blocking loop()
+        Serial.begin(SERIAL_BINARY_BAUD);
+    } else {
+        Serial.begin(SERIAL_TEXT_BAUD);
+    }
     pinMode(DEPLOY_BTN, INPUT_PULLUP);
     pinMode(SEND_BTN, INPUT_PULLUP);
     pinMode(PREDIVE_BTN, INPUT_PULLUP);
+    pinMode(TRACE_BTN, INPUT_PULLUP);
     WiFi.mode(WIFI_STA);
     if (esp_now_init() != ESP_OK) return;
     esp_now_register_recv_cb(onDataRecv);
@@ -92,14 +504,14 @@ void setup() {
     peerInfo.encrypt = false;
     esp_now_add_peer(&peerInfo);
     
-    Serial.println("--- Control Station Ready ---");
-    Serial.print("Active Company ID: "); Serial.println(my_company_id);
+    stationPrintf("--- Control Station Ready ---\n");
+    stationPrintf("Active Company ID: %s\n", my_company_id);
 }
 
 void loop() {
     // 1. Pre-dive Command (Uses global ID)
     if (digitalRead(PREDIVE_BTN) == LOW) {
-        struct_command cmd;
+        struct_command cmd = {};
         strcpy(cmd.cmd, "predive");
         strcpy(cmd.company_id, my_company_id); 
         esp_now_send(floatMac, (uint8_t *) &cmd, sizeof(cmd));
@@ -108,26 +520,100 @@ void loop() {
 
     // 2. Deploy Command (Uses all global parameters)
     if (digitalRead(DEPLOY_BTN) == LOW && predive_confirmed) {
-        struct_command cmd;
+        struct_command cmd = {};
         strcpy(cmd.cmd, "deploy");
         strcpy(cmd.company_id, my_company_id);
         cmd.target_fd = my_target_fd; 
         cmd.target_sd = my_target_sd; 
         cmd.fdt       = my_fdt;       
         cmd.sdt       = my_sdt;       
+        cmd.max_sps    = my_max_sps;
+        cmd.accel_sps2 = my_accel_sps2;
+        cmd.segment_count = my_segment_count;
+        cmd.surface_offset_mm = my_surface_offset_mm;
+        memcpy(cmd.segments, my_segments, sizeof(cmd.segments));
         
         esp_now_send(floatMac, (uint8_t *) &cmd, sizeof(cmd));
-        Serial.println(">>> Mission Config Sent to Float");
-        Serial.printf("ID:%s | FD:%.2f | SD:%.2f | FDT:%d | SDT:%d\n", 
+        portENTER_CRITICAL(&liveMux);
+        liveStats.reset();              // fresh statistics for each dive
+        portEXIT_CRITICAL(&liveMux);
+        stationPrintf(">>> Mission Config Sent to Float\n");
+        stationPrintf("ID:%s | FD:%.2f | SD:%.2f | FDT:%d | SDT:%d\n", 
                       my_company_id, my_target_fd, my_target_sd, my_fdt, my_sdt);
+        stationPrintf("Piston: %d steps/s, %d steps/s^2\n", my_max_sps, my_accel_sps2);
+        for (int i = 0; i < my_segment_count; i++) {
+            stationPrintf("Segment %d: %.2fm +/-%.2fm, %u packets, hold >=%us\n", i + 1,
+                          my_segments[i].target_mm / 1000.0f, my_segments[i].tolerance_mm / 1000.0f,
+                          my_segments[i].packets, my_segments[i].hold_s);
+        }
+        sendPlan();
         delay(1000);
     }
 
     // 3. Data Recovery Command
+    // Pressing again mid-transfer resumes it; after a complete log it
+    // starts a fresh download
     if (digitalRead(SEND_BTN) == LOW) {
+        selectDownload(STREAM_MISSION_LOG);
+        if (probeReceiver.complete()) {
+            // The float sends a fresh report after the log
+            probeReceiver.reset();
+            probe_rx_bytes = 0;
+            probes_reported = false;
+        }
         struct_command cmd = {"send_now"};
         esp_now_send(floatMac, (uint8_t *) &cmd, sizeof(cmd));
-        Serial.println(">>> Requesting Log Data...");
+        stationPrintf(">>> Requesting Log Data...\n");
+        delay(1000);
+    }
+
+    // 4. High-rate trace download (engineering data, not scored)
+    if (digitalRead(TRACE_BTN) == LOW) {
+        selectDownload(STREAM_TRACE);
+        struct_command cmd = {"send_trace"};
+        esp_now_send(floatMac, (uint8_t *) &cmd, sizeof(cmd));
+        stationPrintf(">>> Requesting Trace...\n");
         delay(1000);
     }
+
+    // 5. Live telemetry and messages from the float
+    printTelemetry();
+    printStatus();
+    printPredive();
+
+    // 6. Timing report from a probe build of the float
+    printProbeReport();
+
+    // 7. Acknowledge, decode and write out the recovered log or trace as
+    // it arrives
+    processLinkFrames();
+    while (log_rx_tail != log_rx_head) {
+        uint8_t byte = log_rx[log_rx_tail % LOG_RX_BYTES];
+        log_rx_tail++;
+        if (rx_stream == STREAM_TRACE) traceDecoder.feed(&byte, 1);
+        else logDecoder.feed(&byte, 1);
+    }
+    if (rx_stream == STREAM_TRACE) {
+        if (traceReceiver.complete() && !recovery_reported && log_rx_tail == log_rx_head) {
+            recovery_reported = true;
+            bool ok = !traceDecoder.corrupt() && !log_rx_overflow &&
+                      traceDecoder.records() == traceDecoder.header().record_count;
+            reportDownload(STREAM_TRACE, ok, traceDecoder.records(), traceDecoder.header().overwritten);
+            stationPrintf(">>> TRACE %s: %u records at %u ms (%u overwritten on board)\n",
+                          ok ? "COMPLETE" : "CORRUPT", traceDecoder.records(),
+                          traceDecoder.header().period_ms, traceDecoder.header().overwritten);
+        }
+    } else if (logReceiver.complete() && !recovery_reported && log_rx_tail == log_rx_head) {
+        recovery_reported = true;
+        bool ok = !logDecoder.corrupt() && !log_rx_overflow;
+        reportDownload(STREAM_MISSION_LOG, ok, logDecoder.samples(), logDecoder.badSegments());
+        if (!ok) {
+            stationPrintf(">>> LOG CORRUPT after %u entries - press Send to download again\n",
+                          logDecoder.samples());
+        } else {
+            stationPrintf(">>> LOG COMPLETE: %u entries in %u bytes, %u bad segments (%u duplicate frames)\n",
+                          logDecoder.samples(), logReceiver.totalBytes(), logDecoder.badSegments(),
+                          logReceiver.duplicates());
+        }
+    }
 }
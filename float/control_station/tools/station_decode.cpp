@@ -0,0 +1,446 @@
+// Decoder for the control station's binary serial output (SerialFrame.h,
+// StationRecords.h), on the laptop the station is plugged into:
+//
+//   pio run -e decoder
+//   .pio/build/decoder/program /dev/ttyUSB0 --log-csv log.csv --log-bin log.fcol
+//
+// The input is a serial device (set raw at --baud, default 921600) or a
+// file captured earlier (--raw keeps one; "-" reads stdin). Console lines
+// and live telemetry are printed as they come. At the end of each
+// download the outputs are written (the latest download wins) and the log
+// is scored hold by hold against the plan the station sent (MissionCompliance.h;
+// --fd/--sd/--hold/--profiles stand in for a capture without one).
+//
+//   --log-csv FILE     company_id,timestamp_s,pressure_kpa,depth_m,temp_c
+//                      (as the simulator's --log, so --check-log reads it)
+//   --trace-csv FILE   t_s,state,segment,depth_m,measured_m,velocity_mps,
+//                      piston_steps,piston_target (as the simulator's --trace)
+//   --log-bin FILE     the log as a columnar file
+//   --trace-bin FILE   the trace as a columnar file
+//
+// Columnar file, little-endian: "FCOL", u16 version (1), u16 columns,
+// u32 rows, then per column char name[16], u8 type (1 u8, 2 i16, 3 u32,
+// 4 f32), 3 pad bytes; then each column's rows back to back. A column
+// reads straight into a numpy array:
+//   np.fromfile(f, dtype, count=rows, offset=...)
+//
+// From a file the exit code is 0 if the last log met every hold, 1 if not
+// (or there was no log), 2 on a usage or I/O error. From a device it runs
+// until Ctrl-C.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <SerialFrame.h>
+#include <StationRecords.h>
+#include <MissionCompliance.h>
+
+// Keep in sync with MissionState (onboard_float/include/float_defs.h)
+static const char* const STATE_NAMES[] = {
+    "IDLE", "CALIBRATING", "TRAVEL", "HOLD", "SURFACING", "MISSION_DONE"
+};
+
+struct Options {
+    const char* input = nullptr;
+    int baud = 921600;
+    const char* raw_path = nullptr;
+    const char* log_csv = nullptr;
+    const char* trace_csv = nullptr;
+    const char* log_bin = nullptr;
+    const char* trace_bin = nullptr;
+    bool quiet = false;
+    // Plan for a capture without REC_PLAN (as sim_main's --check-log)
+    float target_fd = 2.5f;
+    float target_sd = 0.4f;
+    int hold_s = 30;
+    int profiles = 2;
+};
+
+struct Decoder {
+    Options opt;
+    station_plan_record plan;
+    bool have_plan = false;
+    uint8_t stream = 0;             // download in progress (LinkStream), 0 = none
+    char company_id[11] = "";
+    float surface_kpa = 0;
+    std::vector<station_log_sample> log;
+    std::vector<trace_record> trace;
+    int logs = 0;                   // completed log downloads
+    bool last_log_met = false;
+};
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int) { stop = 1; }
+
+// ============================================================================
+// OUTPUT FILES
+// ============================================================================
+
+enum ColumnType : uint8_t { COL_U8 = 1, COL_I16 = 2, COL_U32 = 3, COL_F32 = 4 };
+
+struct Column {
+    const char* name;
+    uint8_t type;
+    std::vector<uint8_t> data;
+
+    template <class T> void add(T v) {
+        const uint8_t* p = (const uint8_t*)&v;
+        data.insert(data.end(), p, p + sizeof(v));
+    }
+};
+
+static bool writeColumns(const char* path, const std::vector<Column>& columns, uint32_t rows) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint16_t version = 1, count = (uint16_t)columns.size();
+    fwrite("FCOL", 1, 4, f);
+    fwrite(&version, sizeof(version), 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+    fwrite(&rows, sizeof(rows), 1, f);
+    for (const Column& c : columns) {
+        char name[16] = {};
+        strncpy(name, c.name, sizeof(name) - 1);
+        uint8_t type[4] = {c.type, 0, 0, 0};
+        fwrite(name, 1, sizeof(name), f);
+        fwrite(type, 1, sizeof(type), f);
+    }
+    for (const Column& c : columns) fwrite(c.data.data(), 1, c.data.size(), f);
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "%s: write failed\n", path);
+    return ok;
+}
+
+static void writeLog(const Decoder& d) {
+    const Options& opt = d.opt;
+    if (opt.log_csv) {
+        FILE* f = fopen(opt.log_csv, "w");
+        if (!f) {
+            perror(opt.log_csv);
+        } else {
+            fprintf(f, "company_id,timestamp_s,pressure_kpa,depth_m,temp_c\n");
+            for (const station_log_sample& s : d.log) {
+                fprintf(f, "%s,%.2f,%.2f,%.3f,%.2f\n", d.company_id, s.time_ms / 1000.0, s.pressure_kpa,
+                        s.depth_m, s.temp_c);
+            }
+            fclose(f);
+        }
+    }
+    if (opt.log_bin) {
+        Column t = {"time_ms", COL_U32, {}}, p = {"pressure_kpa", COL_F32, {}};
+        Column depth = {"depth_m", COL_F32, {}}, temp = {"temp_c", COL_F32, {}};
+        for (const station_log_sample& s : d.log) {
+            t.add(s.time_ms);
+            p.add(s.pressure_kpa);
+            depth.add(s.depth_m);
+            temp.add(s.temp_c);
+        }
+        writeColumns(opt.log_bin, {t, p, depth, temp}, (uint32_t)d.log.size());
+    }
+}
+
+static void writeTrace(const Decoder& d) {
+    const Options& opt = d.opt;
+    if (opt.trace_csv) {
+        FILE* f = fopen(opt.trace_csv, "w");
+        if (!f) {
+            perror(opt.trace_csv);
+        } else {
+            fprintf(f, "t_s,state,segment,depth_m,measured_m,velocity_mps,piston_steps,piston_target\n");
+            for (const trace_record& r : d.trace) {
+                fprintf(f, "%.2f,%u,%u,%.3f,%.3f,%.3f,%d,%d\n", r.time_ms / 1000.0, r.state, r.segment,
+                        r.depth_mm / 1000.0, r.measured_mm / 1000.0, r.velocity_mm_s / 1000.0,
+                        r.piston, r.piston_target);
+            }
+            fclose(f);
+        }
+    }
+    if (opt.trace_bin) {
+        Column t = {"time_ms", COL_U32, {}}, depth = {"depth_mm", COL_I16, {}};
+        Column measured = {"measured_mm", COL_I16, {}}, velocity = {"velocity_mm_s", COL_I16, {}};
+        Column piston = {"piston", COL_I16, {}}, target = {"piston_target", COL_I16, {}};
+        Column state = {"state", COL_U8, {}}, segment = {"segment", COL_U8, {}};
+        for (const trace_record& r : d.trace) {
+            t.add(r.time_ms);
+            depth.add(r.depth_mm);
+            measured.add(r.measured_mm);
+            velocity.add(r.velocity_mm_s);
+            piston.add(r.piston);
+            target.add(r.piston_target);
+            state.add(r.state);
+            segment.add(r.segment);
+        }
+        writeColumns(opt.trace_bin, {t, depth, measured, velocity, piston, target, state, segment},
+                     (uint32_t)d.trace.size());
+    }
+}
+
+// ============================================================================
+// HOLD COMPLIANCE
+// ============================================================================
+
+static void buildPlan(const Decoder& d, MissionPlan& plan, uint16_t& interval_ms) {
+    if (d.have_plan) {
+        plan.count = d.plan.count;
+        plan.surface_offset_mm = d.plan.surface_offset_mm;
+        memcpy(plan.segments, d.plan.segments, sizeof(plan.segments));
+        interval_ms = d.plan.log_interval_ms;
+        return;
+    }
+    const Options& opt = d.opt;
+    missionPlanTwoProfiles(plan, opt.target_fd, opt.hold_s, opt.target_sd, opt.hold_s, 0, 0);
+    plan.count = (uint8_t)(2 * opt.profiles);
+    for (int i = 0; i < plan.count; i++) {
+        plan.segments[i] = missionSegment(i % 2 ? opt.target_sd : opt.target_fd, opt.hold_s, 0);
+    }
+    interval_ms = 5000;
+}
+
+// MissionCompliance's verdict per hold, plus the error and depth spread
+// over the packets of the qualifying (or best) run; true if all were met
+static bool reportCompliance(const Decoder& d) {
+    MissionPlan plan;
+    uint16_t interval_ms;
+    buildPlan(d, plan, interval_ms);
+    MissionCompliance compliance(plan, interval_ms);
+    for (const station_log_sample& s : d.log) compliance.addPacket(s.time_ms, s.depth_m);
+
+    printf("Hold compliance (from %zu logged packets, %s plan): %u of %u holds met\n", d.log.size(),
+           d.have_plan ? "station" : "command-line", compliance.holdsMet(), compliance.segmentCount());
+    for (int i = 0; i < compliance.segmentCount(); i++) {
+        const hold_compliance& h = compliance.hold(i);
+        const mission_segment& seg = plan.segments[i];
+        printf("  segment %d %5.2f m  ", i + 1, seg.target_mm / 1000.0);
+        if (!h.packets) {
+            printf("NOT MET: no packet in the band\n");
+            continue;
+        }
+        double sum = 0, sum_sq = 0, sum_err = 0;
+        int n = 0;
+        for (const station_log_sample& s : d.log) {
+            if (s.time_ms < h.first_ms || s.time_ms > h.last_ms) continue;
+            double judged = s.depth_m + seg.offset_mm / 1000.0;
+            sum += judged;
+            sum_sq += judged * judged;
+            sum_err += fabs(judged - seg.target_mm / 1000.0);
+            n++;
+        }
+        double mean = n ? sum / n : 0;
+        double sd = n > 1 ? sqrt(fmax(0.0, (sum_sq - n * mean * mean) / (n - 1))) : 0;
+        printf("%s %u packets %.1f..%.1f s (%.0f s), error mean %.3f max %.3f m, depth sd %.3f m\n",
+               h.met ? "met:" : "NOT MET, best run", h.packets, h.first_ms / 1000.0, h.last_ms / 1000.0,
+               (h.last_ms - h.first_ms) / 1000.0, n ? sum_err / n : 0.0, h.max_error_m, sd);
+    }
+    return compliance.complete();
+}
+
+// ============================================================================
+// RECORDS
+// ============================================================================
+
+static void onRecord(uint8_t type, const uint8_t* payload, uint8_t len, void* ctx) {
+    Decoder& d = *(Decoder*)ctx;
+    switch (type) {
+    case REC_TEXT:
+        if (!d.opt.quiet) printf("%.*s\n", len, (const char*)payload);
+        break;
+    case REC_PLAN:
+        if (len != sizeof(station_plan_record)) break;
+        memcpy(&d.plan, payload, len);
+        if (d.plan.count > MISSION_MAX_SEGMENTS) d.plan.count = MISSION_MAX_SEGMENTS;
+        d.have_plan = true;
+        break;
+    case REC_DOWNLOAD_BEGIN: {
+        if (len != sizeof(station_download_begin)) break;
+        d.stream = ((const station_download_begin*)payload)->stream;
+        if (d.stream == STREAM_TRACE) d.trace.clear();
+        else d.log.clear();
+        break;
+    }
+    case REC_LOG_HEADER: {
+        if (len != sizeof(station_log_header)) break;
+        station_log_header h;
+        memcpy(&h, payload, len);
+        memcpy(d.company_id, h.company_id, sizeof(h.company_id));
+        d.company_id[sizeof(h.company_id)] = 0;
+        d.surface_kpa = h.surface_kpa;
+        break;
+    }
+    case REC_LOG_SAMPLE: {
+        if (len != sizeof(station_log_sample)) break;
+        station_log_sample s;
+        memcpy(&s, payload, len);
+        d.log.push_back(s);
+        break;
+    }
+    case REC_TRACE_RECORD: {
+        if (len != sizeof(trace_record)) break;
+        trace_record r;
+        memcpy(&r, payload, len);
+        d.trace.push_back(r);
+        break;
+    }
+    case REC_DOWNLOAD_END: {
+        if (len != sizeof(station_download_end)) break;
+        station_download_end e;
+        memcpy(&e, payload, len);
+        d.stream = 0;
+        if (e.stream == STREAM_TRACE) {
+            printf("Trace: %zu of %u records received%s\n", d.trace.size(), e.entries,
+                   e.ok ? "" : " (CORRUPT on the station)");
+            writeTrace(d);
+            break;
+        }
+        printf("Log: %zu of %u samples received, company %s, surface %.2f kPa, %u bad segments%s\n",
+               d.log.size(), e.entries, d.company_id, d.surface_kpa, e.bad, e.ok ? "" : " (CORRUPT on the station)");
+        writeLog(d);
+        d.logs++;
+        d.last_log_met = reportCompliance(d) && e.ok && d.log.size() == e.entries;
+        break;
+    }
+    case REC_TELEMETRY: {
+        if (len != sizeof(station_telemetry) || d.opt.quiet) break;
+        station_telemetry t;
+        memcpy(&t, payload, len);
+        const link_telemetry_frame& f = t.frame;
+        const char* state = f.state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[f.state] : "?";
+        printf("[LIVE #%u] %s seg %u D:%.2fm V:%+.2fm/s P:%d hold %u | mean +%u ms, %u lost\n", f.seq, state,
+               f.segment + 1, f.depth_mm / 1000.0, f.velocity_mm_s / 1000.0, f.piston, f.hold_packets,
+               t.mean_delay_ms, t.lost);
+        break;
+    }
+    default:
+        break;                      // a newer station; skip what is not known here
+    }
+    fflush(stdout);
+}
+
+// ============================================================================
+// INPUT
+// ============================================================================
+
+static speed_t baudConstant(int baud) {
+    switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default: return 0;
+    }
+}
+
+// Raw 8N1 at 'baud' if fd is a terminal; files are read as they are
+static bool setupSerial(int fd, int baud) {
+    if (!isatty(fd)) return true;
+    speed_t speed = baudConstant(baud);
+    if (!speed) {
+        fprintf(stderr, "Unsupported baud rate %d\n", baud);
+        return false;
+    }
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: station_decode DEVICE|FILE|- [--baud N] [--raw FILE] [--log-csv FILE]\n"
+            "                      [--log-bin FILE] [--trace-csv FILE] [--trace-bin FILE] [--quiet]\n"
+            "                      [--fd M] [--sd M] [--hold S] [--profiles N]\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool has_value = i + 1 < argc;
+        if (!strcmp(a, "--baud") && has_value) opt.baud = atoi(argv[++i]);
+        else if (!strcmp(a, "--raw") && has_value) opt.raw_path = argv[++i];
+        else if (!strcmp(a, "--log-csv") && has_value) opt.log_csv = argv[++i];
+        else if (!strcmp(a, "--log-bin") && has_value) opt.log_bin = argv[++i];
+        else if (!strcmp(a, "--trace-csv") && has_value) opt.trace_csv = argv[++i];
+        else if (!strcmp(a, "--trace-bin") && has_value) opt.trace_bin = argv[++i];
+        else if (!strcmp(a, "--quiet")) opt.quiet = true;
+        else if (!strcmp(a, "--fd") && has_value) opt.target_fd = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--sd") && has_value) opt.target_sd = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--hold") && has_value) opt.hold_s = atoi(argv[++i]);
+        else if (!strcmp(a, "--profiles") && has_value) opt.profiles = atoi(argv[++i]);
+        else if (a[0] != '-' || !strcmp(a, "-")) {
+            if (opt.input) return false;
+            opt.input = a;
+        } else {
+            return false;
+        }
+    }
+    if (opt.profiles < 1 || opt.profiles * 2 > MISSION_MAX_SEGMENTS) return false;
+    return opt.input != nullptr;
+}
+
+int main(int argc, char** argv) {
+    Decoder d;
+    if (!parseArgs(argc, argv, d.opt)) {
+        usage();
+        return 2;
+    }
+    const Options& opt = d.opt;
+
+    int fd = strcmp(opt.input, "-") ? open(opt.input, O_RDONLY | O_NOCTTY) : 0;
+    if (fd < 0) {
+        perror(opt.input);
+        return 2;
+    }
+    bool device = isatty(fd);
+    if (!setupSerial(fd, opt.baud)) {
+        fprintf(stderr, "%s: cannot set up the port: %s\n", opt.input, strerror(errno));
+        return 2;
+    }
+    FILE* raw = nullptr;
+    if (opt.raw_path && !(raw = fopen(opt.raw_path, "wb"))) {
+        perror(opt.raw_path);
+        return 2;
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    SerialFrameReader reader(onRecord, &d);
+    uint64_t bytes = 0;
+    uint8_t buf[4096];
+    while (!stop) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        bytes += n;
+        if (raw) fwrite(buf, 1, n, raw);
+        reader.feed(buf, n);
+    }
+    if (raw) fclose(raw);
+    if (fd != 0) close(fd);
+
+    fprintf(stderr, "%llu bytes, %u records, %u bad frames\n", (unsigned long long)bytes, reader.frames(),
+            reader.badFrames());
+    if (d.stream) fprintf(stderr, "Input ended inside a download: nothing written for it\n");
+    if (device) return 0;
+    return d.logs && d.last_log_met ? 0 : 1;
+}
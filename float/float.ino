@@ -9,6 +9,15 @@ const int backwardBtn = 4;
 const int stepper_switch = 7; 
 
 
+// Trapezoidal ramp for runSequence(): start slow, cruise, slow down again
+const float MAX_SPS = 1500.0;     // cruise step rate (steps/s), was 1000
+const float ACCEL_SPS2 = 6000.0;  // acceleration (steps/s^2)
+
+// Homing: ramped approach at MAX_SPS, back off, then a slow final touch
+const int HOMING_BACKOFF_STEPS = 60;
+const unsigned long HOMING_TOUCH_PERIOD_US = 5000;  // 200 steps/s
+const int SWITCH_DEBOUNCE_READS = 3;                // pressed on 3 steps in a row
+
 // State variable: 0 = Only Forward allowed, 1 = Only Backward allowed
 bool stepper_state = 0; 
 
@@ -24,28 +33,15 @@ void setup() {
   digitalWrite(enPin, LOW); // Enable motor
   delay(100);
 
-  
-  // Homing: Run forward until stepper_switch is pressed (connects to GND)
-  digitalWrite(dirPin, HIGH); 
-  while (digitalRead(stepper_switch) == HIGH) {
-    digitalWrite(stepPin, HIGH);
-    delayMicroseconds(500);     
-    digitalWrite(stepPin, LOW); 
-    delayMicroseconds(500);
-    // Safety check: if it reads LOW, wait 5ms and check again to confirm
-    if (digitalRead(stepper_switch) == LOW) {
-      delay(5); 
-      if (digitalRead(stepper_switch) == LOW) {
-        break; // 
-      }
-    }       
-  }
+  // Homing: run forward until stepper_switch is pressed (connects to GND),
+  // fast and then slowly for a clean final touch
+  seekSwitch(true);
+  stepSteps(LOW, HOMING_BACKOFF_STEPS, HOMING_TOUCH_PERIOD_US);
+  seekSwitch(false);
   // Power up logic: After hitting switch, set state to 1 (Backward move required next)
   stepper_state = 1; 
-  delay(1000);
   runSequence(LOW);
   stepper_state = 0;
-  delay(1000); 
  }
 
 void loop() {
@@ -65,15 +61,55 @@ void loop() {
   }
 }
 
-// Function to handle the 800-step movement
+// Step period for step k of a ramp: the time between t(k) and t(k+1)
+// with t(k) = sqrt(2k/a), never shorter than the cruise period
+unsigned long rampPeriodUs(long k) {
+  float period = (sqrt(k + 1.0) - sqrt((float)k)) * sqrt(2.0 / ACCEL_SPS2) * 1e6;
+  float cruise = 1e6 / MAX_SPS;
+  return (unsigned long)(period > cruise ? period : cruise);
+}
+
+// 'steps' steps in 'direction' at a fixed period
+void stepSteps(int direction, long steps, unsigned long period_us) {
+  digitalWrite(dirPin, direction);
+  for (long x = 0; x < steps; x++) {
+    digitalWrite(stepPin, HIGH);
+    delayMicroseconds(period_us / 2);
+    digitalWrite(stepPin, LOW);
+    delayMicroseconds(period_us - period_us / 2);
+  }
+}
+
+// Step forward until the switch reads pressed SWITCH_DEBOUNCE_READS times
+// in a row (once per step). fast: ramp up to MAX_SPS; the switch stops it
+// abruptly, so the slow touch after a back-off gives the reference.
+void seekSwitch(bool fast) {
+  digitalWrite(dirPin, HIGH);
+  int pressed = 0;
+  for (long k = 0; ; k++) {
+    pressed = (digitalRead(stepper_switch) == LOW) ? pressed + 1 : 0;
+    if (pressed >= SWITCH_DEBOUNCE_READS) return;
+    unsigned long period = fast ? rampPeriodUs(k) : HOMING_TOUCH_PERIOD_US;
+    digitalWrite(stepPin, HIGH);
+    delayMicroseconds(period / 2);
+    digitalWrite(stepPin, LOW);
+    delayMicroseconds(period - period / 2);
+  }
+}
+
+// Function to handle the 1800-step movement
 void runSequence(int direction) {
+  const long steps = 1800;
   digitalWrite(dirPin, direction);
   
-  for (int x = 0; x < 1800; x++) {
+  for (long x = 0; x < steps; x++) {
+    // Symmetric ramp: distance from the nearer end of the move
+    long k = min(x, steps - 1 - x);
+    unsigned long half = rampPeriodUs(k) / 2;
     digitalWrite(stepPin, HIGH);
-    delayMicroseconds(500);     
+    delayMicroseconds(half);     
     digitalWrite(stepPin, LOW); 
-    delayMicroseconds(500);     
+    delayMicroseconds(half);     
   }
   
   delay(200); // Debounce to prevent multiple triggers from one press
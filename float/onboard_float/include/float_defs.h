@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <MissionPlan.h>
+
+// Definitions shared by the firmware (src/main.cpp) and the host simulator
+// (sim/). Keep the packed structures in sync with the Control Station.
+
+// ============================================================================
+// SHARED STRUCTURES (PACKED for ESP-NOW)
+// ============================================================================
+
+typedef struct __attribute__((packed)) {
+    char company_id[10];
+    uint32_t timestamp;  
+    float pressure_kpa;
+    float depth_m;
+    float temp_c;
+} struct_message;
+
+// Reply to "predive": the judge's sample plus the quality of the surface
+// reference the dive will start from
+typedef struct __attribute__((packed)) {
+    struct_message sample;
+    float surface_kpa;              // tracked surface pressure
+    float surface_var_pa2;          // its variance (Pa^2)
+    uint16_t surface_samples;       // samples behind it (0 = not tracked yet)
+    uint16_t surface_outliers;      // samples rejected since it (re)started
+} struct_predive;
+
+typedef struct __attribute__((packed)) {
+    char cmd[16];
+    char company_id[10];
+    float target_fd;      // First depth target (2.5m)
+    float target_sd;      // Second depth target (0.4m)
+    int fdt;              // First depth hold time (30 sec)
+    int sdt;              // Second depth hold time (30 sec)
+    int max_sps;          // Piston cruise step rate (0 = keep default)
+    int accel_sps2;       // Piston acceleration (0 = keep default)
+    uint8_t segment_count;                          // 0 = two profiles from the fields above
+    int16_t surface_offset_mm;                      // judges the final surfacing
+    mission_segment segments[MISSION_MAX_SEGMENTS]; // deploy: the mission table
+} struct_command;
+
+typedef struct __attribute__((packed)) {
+    char msg[32];
+} struct_status;
+
+// ============================================================================
+// PIN DEFINITIONS
+// ============================================================================
+
+#define STEP_PIN 13
+#define DIR_PIN 12
+#define LIMIT_FWD 9
+#define LIMIT_BWD 10
+#define SDA_PIN 4
+#define SCL_PIN 5
+
+// ============================================================================
+// STATE MACHINE DEFINITION
+// ============================================================================
+
+// The mission itself is a table of segments (MissionPlan.h) run by one
+// executor; these states only say what the float is doing overall.
+enum MissionState { 
+    IDLE, 
+    CALIBRATING, 
+    TRAVEL,         // moving to the current segment's target
+    HOLD,           // holding the current segment's target
+    SURFACING, 
+    MISSION_DONE 
+};
+
+inline const char* missionStateName(MissionState state) {
+    switch (state) {
+        case IDLE:           return "IDLE";
+        case CALIBRATING:    return "CALIBRATING";
+        case TRAVEL:         return "TRAVEL";
+        case HOLD:           return "HOLD";
+        case SURFACING:      return "SURFACING";
+        case MISSION_DONE:   return "MISSION_DONE";
+    }
+    return "?";
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FloatProbe.h>
+
+// ============================================================================
+// HOT-PATH PROBES (build with -DFLOAT_PROBES)
+// ============================================================================
+// PROBE_SCOPE(section) times the rest of the enclosing block with the CPU
+// cycle counter and records it against the state last set with
+// PROBE_SET_STATE(). Without FLOAT_PROBES every macro is empty and the
+// probe table does not exist, so a competition build pays nothing.
+//
+//   void writeLogEntry(...) {
+//       PROBE_SCOPE(PROBE_LOG_WRITE);
+//       ...
+//   }
+
+#if defined(FLOAT_PROBES)
+
+extern ProbeTable probes;   // src/main.cpp
+
+class ProbeScope {
+public:
+    explicit ProbeScope(uint8_t section) : section_(section), start_(ESP.getCycleCount()) {}
+    ~ProbeScope() { probes.record(section_, probes.state(), ESP.getCycleCount() - start_); }
+
+private:
+    ProbeScope(const ProbeScope&);
+    ProbeScope& operator=(const ProbeScope&);
+
+    uint8_t section_;
+    uint32_t start_;
+};
+
+#define PROBE_JOIN_(a, b) a##b
+#define PROBE_JOIN(a, b) PROBE_JOIN_(a, b)
+#define PROBE_SCOPE(section) ProbeScope PROBE_JOIN(probe_scope_, __LINE__)(section)
+#define PROBE_SET_STATE(state) probes.setState((uint8_t)(state))
+#define PROBE_BUDGET_US(section, us) probes.setBudget((section), (uint32_t)(us) * ESP.getCpuFreqMHz())
+
+#else
+
+#define PROBE_SCOPE(section) ((void)0)
+#define PROBE_SET_STATE(state) ((void)0)
+#define PROBE_BUDGET_US(section, us) ((void)0)
+
+#endif
@@ -0,0 +1,51 @@
+#include "DepthController.h"
+
+DepthController::DepthController(const DepthControllerConfig& config)
+    : config_(config) {}
+
+void DepthController::reset() {
+    integral_ = 0;
+}
+
+float DepthController::neutralSteps(float depth_m) const {
+    return config_.neutral_surface_steps + config_.neutral_steps_per_m * depth_m;
+}
+
+void DepthController::setNeutral(float surface_steps, float steps_per_m) {
+    config_.neutral_surface_steps = surface_steps;
+    config_.neutral_steps_per_m = steps_per_m;
+}
+
+DepthGains DepthController::gainsAt(float depth_m) const {
+    float t = depth_m / config_.schedule_depth_m;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    DepthGains g;
+    g.kp = config_.shallow.kp + t * (config_.deep.kp - config_.shallow.kp);
+    g.ki = config_.shallow.ki + t * (config_.deep.ki - config_.shallow.ki);
+    g.kd = config_.shallow.kd + t * (config_.deep.kd - config_.shallow.kd);
+    return g;
+}
+
+int32_t DepthController::update(float target_m, float depth_m, float velocity_mps, float dt_s) {
+    DepthGains g = gainsAt(depth_m);
+    float error = target_m - depth_m;
+
+    float unclamped = neutralSteps(target_m) + g.kp * error + integral_ - g.kd * velocity_mps;
+
+    // Anti-windup: integrate near the target only, and never further into
+    // an end stop the piston is already pinned against
+    bool near = (error < config_.integrate_zone_m && error > -config_.integrate_zone_m);
+    bool pinned_high = unclamped >= config_.max_steps && error > 0;
+    bool pinned_low = unclamped <= config_.min_steps && error < 0;
+    if (near && !pinned_high && !pinned_low) {
+        integral_ += g.ki * error * dt_s;
+        if (integral_ > config_.integral_limit_steps) integral_ = config_.integral_limit_steps;
+        if (integral_ < -config_.integral_limit_steps) integral_ = -config_.integral_limit_steps;
+    }
+
+    float out = neutralSteps(target_m) + g.kp * error + integral_ - g.kd * velocity_mps;
+    if (out > config_.max_steps) out = config_.max_steps;
+    if (out < config_.min_steps) out = config_.min_steps;
+    return (int32_t)(out + 0.5f);
+}
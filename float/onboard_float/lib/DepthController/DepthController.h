@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// CLOSED-LOOP DEPTH CONTROLLER
+// ============================================================================
+// Turns a depth error into an absolute piston position:
+//
+//   steps = neutral(target) + Kp*e + I - Kd*v      e = target - depth (m)
+//                                                  v = depth rate, + = sinking
+//
+// neutral(target) is the feed-forward: the piston position that is expected
+// to be neutrally buoyant at the target depth (hull compression makes the
+// float heavier as it goes down, so it shrinks with depth). The PID only has
+// to correct the model error and drive the transit.
+//
+// Gains are scheduled by depth: interpolated between the 'shallow' set at
+// the surface and the 'deep' set at schedule_depth_m and below. The integral
+// only runs inside integrate_zone_m of the target and stops growing while
+// the output is pinned at a piston end stop (anti-windup).
+
+struct DepthGains {
+    float kp;   // steps per m of error
+    float ki;   // steps per m*s of error
+    float kd;   // steps per m/s of vertical velocity
+};
+
+struct DepthControllerConfig {
+    float neutral_surface_steps;    // feed-forward: neutral position at 0 m
+    float neutral_steps_per_m;      // feed-forward: change per m of depth
+    DepthGains shallow;
+    DepthGains deep;
+    float schedule_depth_m;
+    float integrate_zone_m;
+    float integral_limit_steps;
+    int32_t min_steps;
+    int32_t max_steps;
+};
+
+class DepthController {
+public:
+    explicit DepthController(const DepthControllerConfig& config);
+
+    void reset();
+
+    // Piston position for this tick. dt_s is the time since the last call.
+    int32_t update(float target_m, float depth_m, float velocity_mps, float dt_s);
+
+    // Feed-forward estimate of the neutral piston position at a depth.
+    float neutralSteps(float depth_m) const;
+
+    // Replace the feed-forward line (e.g. with a learned NeutralMap).
+    void setNeutral(float surface_steps, float steps_per_m);
+
+    const DepthControllerConfig& config() const { return config_; }
+    float integralSteps() const { return integral_; }
+
+private:
+    DepthGains gainsAt(float depth_m) const;
+
+    DepthControllerConfig config_;
+    float integral_ = 0;
+};
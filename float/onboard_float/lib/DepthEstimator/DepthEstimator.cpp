@@ -0,0 +1,32 @@
+#include "DepthEstimator.h"
+
+DepthEstimator::DepthEstimator(float alpha, float beta, float fluid_density)
+    : alpha_(alpha), beta_(beta), rho_g_(fluid_density * 9.80665f) {}
+
+void DepthEstimator::setSurfacePressurePa(float surface_pa) {
+    surface_pa_ = surface_pa;
+}
+
+void DepthEstimator::reset() {
+    primed_ = false;
+}
+
+void DepthEstimator::update(float pressure_mbar, float temp_c, float dt_s) {
+    pressure_mbar_ = pressure_mbar;
+    temp_c_ = temp_c;
+    samples_++;
+
+    // MS5837 pressure is in mbar: 1 mbar = 100 Pa. h = dP / (rho * g)
+    measured_ = (pressure_mbar * 100.0f - surface_pa_) / rho_g_;
+
+    if (!primed_ || dt_s <= 0) {
+        depth_ = measured_;
+        velocity_ = 0;
+        primed_ = true;
+    } else {
+        float predicted = depth_ + velocity_ * dt_s;
+        float residual = measured_ - predicted;
+        depth_ = predicted + alpha_ * residual;
+        velocity_ += (beta_ / dt_s) * residual;
+    }
+}
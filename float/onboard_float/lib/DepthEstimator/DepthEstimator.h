@@ -0,0 +1,46 @@
+#pragma once
+
+// ============================================================================
+// DEPTH ESTIMATOR
+// ============================================================================
+// Alpha-beta filter over one pressure sample per control tick. Everything
+// that needs depth, vertical velocity, pressure or temperature reads the
+// cached values here instead of triggering its own sensor.read().
+//
+//   predict:  d += v*dt
+//   correct:  r = measured - d;  d += alpha*r;  v += (beta/dt)*r
+
+class DepthEstimator {
+public:
+    DepthEstimator(float alpha, float beta, float fluid_density);
+
+    // Zero-depth reference (absolute pressure at the surface, Pa).
+    void setSurfacePressurePa(float surface_pa);
+    float surfacePressurePa() const { return surface_pa_; }
+
+    // Restart the filter at the next sample (e.g. after calibration).
+    void reset();
+
+    // Feed one raw sample. dt_s is the time since the previous sample.
+    void update(float pressure_mbar, float temp_c, float dt_s);
+
+    float depth() const { return depth_; }              // filtered, m
+    float velocity() const { return velocity_; }        // m/s, + = sinking
+    float measuredDepth() const { return measured_; }   // this sample, unfiltered
+    float pressureMbar() const { return pressure_mbar_; }
+    float temperatureC() const { return temp_c_; }
+    unsigned long samples() const { return samples_; }
+
+private:
+    float alpha_;
+    float beta_;
+    float rho_g_;
+    float surface_pa_ = 0;
+    float depth_ = 0;
+    float velocity_ = 0;
+    float measured_ = 0;
+    float pressure_mbar_ = 0;
+    float temp_c_ = 0;
+    bool primed_ = false;
+    unsigned long samples_ = 0;
+};
@@ -0,0 +1,287 @@
+#include "FlashRingLog.h"
+#include <string.h>
+
+static const uint32_t PAGES_PER_SECTOR = FLASH_SECTOR_BYTES / FLASH_PAGE_BYTES;
+
+static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t pageCrc(const flash_page_header& header, const uint8_t* payload) {
+    uint16_t crc = crc16(0xFFFF, (const uint8_t*)&header, offsetof(flash_page_header, crc));
+    return crc16(crc, payload, header.length);
+}
+
+FlashRingLog::FlashRingLog(FlashStore& flash)
+    : flash_(flash), writer_(staging_, sizeof(staging_)) {
+    memset(company_id_, 0, sizeof(company_id_));
+}
+
+bool FlashRingLog::readPage(uint32_t page, flash_page_header& header, uint8_t* payload) {
+    uint32_t offset = page * FLASH_PAGE_BYTES;
+    if (!flash_.read(offset, &header, sizeof(header))) return false;
+    if (header.magic != FLASH_LOG_MAGIC || header.length > COMPACT_LOG_SEGMENT_BYTES) return false;
+    if (!flash_.read(offset + sizeof(header), payload, header.length)) return false;
+    return pageCrc(header, payload) == header.crc;
+}
+
+// What a page contributes to the download: its payload, or nothing if it
+// fails the CRC (a failed program)
+uint16_t FlashRingLog::segmentLength(uint32_t page) {
+    flash_page_header header;
+    uint8_t payload[COMPACT_LOG_SEGMENT_BYTES];
+    return readPage(page, header, payload) ? header.length : 0;
+}
+
+bool FlashRingLog::pageBlank(uint32_t page) {
+    uint8_t buf[FLASH_PAGE_BYTES];
+    if (!flash_.read(page * FLASH_PAGE_BYTES, buf, sizeof(buf))) return false;
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        if (buf[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+bool FlashRingLog::begin() {
+    pages_ = 0;
+    if (flash_.size() == 0 || flash_.size() % FLASH_SECTOR_BYTES) return false;
+    pages_ = flash_.size() / FLASH_PAGE_BYTES;
+
+    // Newest valid page anywhere in the ring
+    flash_page_header header;
+    uint8_t payload[COMPACT_LOG_SEGMENT_BYTES];
+    bool found = false;
+    uint32_t head = 0;
+    flash_page_header newest = {};
+    for (uint32_t page = 0; page < pages_; page++) {
+        if (!readPage(page, header, payload)) continue;
+        if (!found || header.seq > newest.seq) {
+            newest = header;
+            head = page;
+            found = true;
+        }
+    }
+
+    active_ = false;
+    session_pages_ = 0;
+    session_bytes_ = 0;
+    session_entries_ = 0;
+    cursor_slot_ = 0xFFFFFFFF;
+    if (!found) {
+        write_page_ = 0;
+        erased_pages_ = 0;
+        next_seq_ = 0;
+        session_ = 0;
+        return true;
+    }
+
+    // Walk back through that page's session. A page that failed to program
+    // still used up its sequence number, so an invalid page is passed over
+    // as long as the next valid one further back continues the sequence;
+    // a blank page or another session ends the walk.
+    session_ = newest.session;
+    next_seq_ = newest.seq + 1;
+    uint32_t page = head;
+    uint32_t seq = newest.seq;
+    uint32_t skipped = 0;
+    for (uint32_t n = 0; n < pages_; n++) {
+        if (readPage(page, header, payload)) {
+            if (header.session != session_ || header.seq != seq) break;
+            CompactLogReader reader(payload, header.length);
+            session_entries_ += reader.header().record_count;
+            session_first_page_ = page;
+            session_pages_ += skipped + 1;
+            session_bytes_ += header.length;
+            skipped = 0;
+        } else {
+            if (pageBlank(page)) break;
+            skipped++;
+        }
+        page = (page + pages_ - 1) % pages_;
+        seq--;
+    }
+
+    // Resume after the head. Whatever is left of its sector must still be
+    // erased; a page torn by the reset means skipping to the next sector.
+    write_page_ = (head + 1) % pages_;
+    erased_pages_ = 0;
+    if (write_page_ % PAGES_PER_SECTOR) {
+        uint32_t left = PAGES_PER_SECTOR - write_page_ % PAGES_PER_SECTOR;
+        bool blank = true;
+        for (uint32_t i = 0; i < left && blank; i++) blank = pageBlank(write_page_ + i);
+        if (blank) {
+            erased_pages_ = left;
+        } else {
+            write_page_ = (write_page_ + left) % pages_;
+        }
+    }
+    return true;
+}
+
+void FlashRingLog::beginSession(const char* company_id, float surface_pressure_kpa, float fluid_density) {
+    if (!pages_) return;
+    memset(company_id_, 0, sizeof(company_id_));
+    memcpy(company_id_, company_id, strnlen(company_id, sizeof(company_id_)));
+    surface_pressure_kpa_ = surface_pressure_kpa;
+    fluid_density_ = fluid_density;
+
+    session_++;
+    session_first_page_ = write_page_;
+    session_pages_ = 0;
+    session_bytes_ = 0;
+    session_entries_ = 0;
+    queue_count_ = 0;
+    cursor_slot_ = 0xFFFFFFFF;
+    writer_.begin(company_id_, surface_pressure_kpa_, fluid_density_);
+    active_ = true;
+}
+
+void FlashRingLog::startStaging(uint32_t time_ms) {
+    writer_.begin(company_id_, surface_pressure_kpa_, fluid_density_);
+    staging_start_ms_ = time_ms;
+}
+
+bool FlashRingLog::append(const LogSample& sample) {
+    if (!active_) return false;
+    if (writer_.count() == 0) startStaging(sample.time_ms);
+    if (!writer_.append(sample)) {
+        seal();
+        startStaging(sample.time_ms);
+        if (!writer_.append(sample)) return false;
+    }
+    session_entries_++;
+    if (sample.time_ms - staging_start_ms_ >= FLASH_LOG_SYNC_MS) seal();
+    return true;
+}
+
+void FlashRingLog::seal() {
+    if (writer_.count() == 0) return;
+    if (queue_count_ == FLASH_LOG_QUEUE) programNext();    // flash fell behind
+
+    uint8_t slot = (queue_head_ + queue_count_) % FLASH_LOG_QUEUE;
+    memcpy(queue_[slot], writer_.data(), writer_.bytes());
+    queue_len_[slot] = (uint16_t)writer_.bytes();
+    queue_count_++;
+    writer_.begin(company_id_, surface_pressure_kpa_, fluid_density_);
+}
+
+void FlashRingLog::eraseAhead() {
+    // The ring has caught up with the start of this session: its oldest
+    // pages go with the sector
+    uint32_t room = pages_ - erased_pages_ - PAGES_PER_SECTOR;
+    while (session_pages_ > room) {
+        flash_page_header header;
+        uint8_t payload[COMPACT_LOG_SEGMENT_BYTES];
+        if (readPage(session_first_page_, header, payload)) {
+            CompactLogReader reader(payload, header.length);
+            session_bytes_ -= header.length;
+            session_entries_ -= reader.header().record_count;
+        }
+        session_first_page_ = (session_first_page_ + 1) % pages_;
+        session_pages_--;
+    }
+
+    uint32_t page = (write_page_ + erased_pages_) % pages_;
+    if (!flash_.eraseSector(page * FLASH_PAGE_BYTES)) page_errors_++;
+    erased_pages_ += PAGES_PER_SECTOR;
+    cursor_slot_ = 0xFFFFFFFF;
+}
+
+void FlashRingLog::programNext() {
+    if (queue_count_ == 0) return;
+    if (erased_pages_ == 0) eraseAhead();
+
+    uint8_t slot = queue_head_;
+    flash_page_header header;
+    header.magic = FLASH_LOG_MAGIC;
+    header.session = session_;
+    header.seq = next_seq_;
+    header.length = queue_len_[slot];
+    header.crc = pageCrc(header, queue_[slot]);
+
+    // Header and payload in one program operation
+    uint8_t page[FLASH_PAGE_BYTES];
+    memcpy(page, &header, sizeof(header));
+    memcpy(page + sizeof(header), queue_[slot], header.length);
+    // Even a failed page is used up: it can not be programmed again
+    uint32_t written = write_page_;
+    bool ok = flash_.write(written * FLASH_PAGE_BYTES, page, sizeof(header) + header.length);
+    write_page_ = (write_page_ + 1) % pages_;
+    erased_pages_--;
+    next_seq_++;
+    session_pages_++;
+    if (ok && segmentLength(written) == header.length) {
+        session_bytes_ += header.length;
+    } else {
+        // Its entries will not be downloaded
+        CompactLogReader reader(queue_[slot], header.length);
+        session_entries_ -= reader.header().record_count;
+        page_errors_++;
+    }
+    queue_head_ = (queue_head_ + 1) % FLASH_LOG_QUEUE;
+    queue_count_--;
+}
+
+void FlashRingLog::service(bool idle) {
+    if (queue_count_ == 0) return;
+    if (idle || queue_count_ >= FLASH_LOG_QUEUE - 1) programNext();
+}
+
+void FlashRingLog::prepare(int sectors) {
+    if (!pages_) return;
+    uint32_t want = (uint32_t)sectors * PAGES_PER_SECTOR;
+    if (want > pages_ / 2) want = pages_ / 2;
+    while (erased_pages_ < want) eraseAhead();
+}
+
+void FlashRingLog::sync() {
+    if (!active_) return;
+    seal();
+    while (queue_count_ > 0) programNext();
+}
+
+void FlashRingLog::loadCursor() {
+    flash_page_header header;
+    uint32_t page = (session_first_page_ + cursor_slot_) % pages_;
+    cursor_len_ = readPage(page, header, cursor_data_) ? header.length : 0;
+}
+
+size_t FlashRingLog::read(uint32_t offset, uint8_t* dst, size_t len) {
+    if (offset >= session_bytes_ || session_pages_ == 0) return 0;
+    if (len > session_bytes_ - offset) len = session_bytes_ - offset;
+
+    if (cursor_slot_ >= session_pages_) {
+        cursor_slot_ = 0;
+        cursor_start_ = 0;
+        loadCursor();
+    }
+
+    size_t done = 0;
+    while (done < len) {
+        uint32_t pos = offset + done;
+        // Walk the cursor to the page holding 'pos' (retransmits step back)
+        while (pos < cursor_start_ && cursor_slot_ > 0) {
+            cursor_slot_--;
+            loadCursor();
+            cursor_start_ -= cursor_len_;
+        }
+        while (pos >= cursor_start_ + cursor_len_ && cursor_slot_ + 1 < session_pages_) {
+            cursor_start_ += cursor_len_;
+            cursor_slot_++;
+            loadCursor();
+        }
+        if (pos < cursor_start_ || pos >= cursor_start_ + cursor_len_) break;
+
+        size_t n = cursor_start_ + cursor_len_ - pos;
+        if (n > len - done) n = len - done;
+        memcpy(dst + done, cursor_data_ + (pos - cursor_start_), n);
+        done += n;
+    }
+    return done;
+}
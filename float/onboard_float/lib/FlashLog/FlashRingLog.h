@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <CompactLog.h>
+#include "FlashStore.h"
+
+// ============================================================================
+// FLASH RING LOG
+// ============================================================================
+// Append-only mission log on raw flash. Samples are compact-encoded into a
+// RAM staging page (one CompactLog segment, see CompactLog.h); a full page,
+// or one spanning FLASH_LOG_SYNC_MS, is sealed and queued, and service()
+// programs queued pages one at a time (from the log task). Pages go round the whole
+// area as a ring, so wear spreads evenly and a new mission starts where the
+// last one stopped.
+//
+// Each page carries a session number, a sequence number and a CRC. After a
+// reset begin() scans the area, takes the newest valid page as the head and
+// recovers that page's session for download. A page torn by the reset, or
+// one that failed to program, fails its CRC and is ignored; at most the
+// unsealed staging page is lost.
+//
+// Erasing a 4 kB sector takes tens of ms, so sectors are erased ahead with
+// prepare() while the float is on the surface; programming a page is ~1 ms.
+
+#define FLASH_LOG_MAGIC 0x4C50          // "PL"
+#define FLASH_LOG_QUEUE 4               // sealed pages waiting to be programmed
+#define FLASH_LOG_SYNC_MS 30000         // seal a page once it spans this long
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t session;
+    uint32_t seq;           // increases by one per page, never reused
+    uint16_t length;        // payload bytes
+    uint16_t crc;           // CRC-16/CCITT over the fields above and the payload
+} flash_page_header;
+
+class FlashRingLog {
+public:
+    explicit FlashRingLog(FlashStore& flash);
+
+    // Scan the flash and recover the newest session. False if the flash is
+    // missing or not a whole number of sectors.
+    bool begin();
+
+    // Start logging a new session (mission).
+    void beginSession(const char* company_id, float surface_pressure_kpa, float fluid_density);
+
+    // Encode one sample into the staging page.
+    bool append(const LogSample& sample);
+
+    // Program at most one queued page. Pass idle = true when a short flash
+    // stall is harmless (piston not moving); a nearly full queue is
+    // programmed regardless.
+    void service(bool idle);
+
+    // Keep this many sectors erased ahead of the write position. Blocking.
+    void prepare(int sectors);
+
+    // Seal the staging page and program everything queued. Blocking.
+    void sync();
+
+    // Download view of the newest session: its segments back to back,
+    // straight from flash (pages programmed so far; sync() first to include
+    // the tail). Reads are expected to be mostly sequential.
+    uint32_t sessionBytes() const { return session_bytes_; }
+    size_t read(uint32_t offset, uint8_t* dst, size_t len);
+
+    bool ready() const { return pages_ > 0; }
+    uint16_t session() const { return session_; }
+    uint32_t sessionPages() const { return session_pages_; }
+    uint32_t sessionEntries() const { return session_entries_; }
+    uint32_t capacityPages() const { return pages_; }
+    uint32_t pageErrors() const { return page_errors_; }
+
+private:
+    void startStaging(uint32_t time_ms);
+    void seal();
+    void programNext();
+    void eraseAhead();
+    bool readPage(uint32_t page, flash_page_header& header, uint8_t* payload);
+    uint16_t segmentLength(uint32_t page);
+    bool pageBlank(uint32_t page);
+    void loadCursor();
+
+    FlashStore& flash_;
+    uint32_t pages_ = 0;
+    uint32_t write_page_ = 0;       // next page to program
+    uint32_t erased_pages_ = 0;     // known-erased pages from write_page_ on
+    uint32_t next_seq_ = 0;
+    uint32_t page_errors_ = 0;
+
+    // Newest session (being written, or recovered at boot)
+    uint16_t session_ = 0;
+    uint32_t session_first_page_ = 0;
+    uint32_t session_pages_ = 0;
+    uint32_t session_bytes_ = 0;
+    uint32_t session_entries_ = 0;
+    bool active_ = false;
+
+    char company_id_[10];
+    float surface_pressure_kpa_ = 0;
+    float fluid_density_ = 1025.0f;
+
+    uint8_t staging_[COMPACT_LOG_SEGMENT_BYTES];
+    CompactLogWriter writer_;
+    uint32_t staging_start_ms_ = 0;
+
+    uint8_t queue_[FLASH_LOG_QUEUE][COMPACT_LOG_SEGMENT_BYTES];
+    uint16_t queue_len_[FLASH_LOG_QUEUE];
+    uint8_t queue_head_ = 0;
+    uint8_t queue_count_ = 0;
+
+    // read() cursor: one page of the session and where it starts in the blob
+    uint32_t cursor_slot_ = 0xFFFFFFFF;
+    uint32_t cursor_start_ = 0;
+    uint16_t cursor_len_ = 0;
+    uint8_t cursor_data_[COMPACT_LOG_SEGMENT_BYTES];
+};
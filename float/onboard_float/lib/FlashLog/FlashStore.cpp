@@ -0,0 +1,98 @@
+#include "FlashStore.h"
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+const esp_partition_t* PartitionFlash::partition() const {
+    if (!partition_) {
+        partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label_);
+    }
+    return partition_;
+}
+
+size_t PartitionFlash::size() const {
+    return partition() ? partition()->size : 0;
+}
+
+bool PartitionFlash::read(uint32_t offset, void* dst, size_t len) {
+    return partition() && esp_partition_read(partition(), offset, dst, len) == ESP_OK;
+}
+
+bool PartitionFlash::write(uint32_t offset, const void* src, size_t len) {
+    return partition() && esp_partition_write(partition(), offset, src, len) == ESP_OK;
+}
+
+bool PartitionFlash::eraseSector(uint32_t offset) {
+    return partition() && esp_partition_erase_range(partition(), offset, FLASH_SECTOR_BYTES) == ESP_OK;
+}
+
+#else
+
+FileFlash::~FileFlash() {
+    if (file_) fclose(file_);
+}
+
+bool FileFlash::open(const char* path, size_t size) {
+    if (file_) fclose(file_);
+    size_ = size;
+    file_ = path ? fopen(path, "r+b") : nullptr;
+    if (!file_) file_ = path ? fopen(path, "w+b") : tmpfile();
+    if (!file_) return false;
+
+    // Extend with erased bytes up to the full size
+    fseek(file_, 0, SEEK_END);
+    long have = ftell(file_);
+    uint8_t blank[FLASH_PAGE_BYTES];
+    memset(blank, 0xFF, sizeof(blank));
+    while (have < (long)size) {
+        size_t n = size - have < sizeof(blank) ? size - have : sizeof(blank);
+        fwrite(blank, 1, n, file_);
+        have += n;
+    }
+    fflush(file_);
+    return true;
+}
+
+bool FileFlash::read(uint32_t offset, void* dst, size_t len) {
+    if (!file_ || offset + len > size_) return false;
+    fseek(file_, offset, SEEK_SET);
+    return fread(dst, 1, len, file_) == len;
+}
+
+bool FileFlash::write(uint32_t offset, const void* src, size_t len) {
+    if (!file_ || offset + len > size_) return false;
+    if (budget_ >= 0) {
+        if ((long)len > budget_) len = budget_;     // torn write
+        budget_ -= len;
+    }
+    uint8_t old[FLASH_PAGE_BYTES];
+    const uint8_t* in = (const uint8_t*)src;
+    while (len > 0) {
+        size_t n = len < sizeof(old) ? len : sizeof(old);
+        fseek(file_, offset, SEEK_SET);
+        if (fread(old, 1, n, file_) != n) return false;
+        for (size_t i = 0; i < n; i++) old[i] &= in[i];     // NOR: 1 -> 0 only
+        fseek(file_, offset, SEEK_SET);
+        fwrite(old, 1, n, file_);
+        offset += n;
+        in += n;
+        len -= n;
+    }
+    fflush(file_);
+    writes_++;
+    return true;
+}
+
+bool FileFlash::eraseSector(uint32_t offset) {
+    if (!file_ || offset % FLASH_SECTOR_BYTES || offset + FLASH_SECTOR_BYTES > size_) return false;
+    if (budget_ == 0) return true;
+    uint8_t blank[FLASH_SECTOR_BYTES];
+    memset(blank, 0xFF, sizeof(blank));
+    fseek(file_, offset, SEEK_SET);
+    fwrite(blank, 1, sizeof(blank), file_);
+    fflush(file_);
+    erases_++;
+    return true;
+}
+
+#endif
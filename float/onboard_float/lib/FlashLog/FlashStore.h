@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// FLASH BACK-ENDS
+// ============================================================================
+// Raw NOR flash as FlashRingLog sees it: erase sets a whole sector to 0xFF,
+// write can only clear bits, read anything. Offsets are relative to the
+// start of the log area.
+
+#define FLASH_SECTOR_BYTES 4096
+#define FLASH_PAGE_BYTES 256
+
+class FlashStore {
+public:
+    virtual ~FlashStore() {}
+    virtual size_t size() const = 0;
+    virtual bool read(uint32_t offset, void* dst, size_t len) = 0;
+    virtual bool write(uint32_t offset, const void* src, size_t len) = 0;
+    virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <esp_partition.h>
+
+// A data partition from partitions.csv (type data, any subtype) by label,
+// looked up on first use. size() is 0 if the partition table lacks it.
+class PartitionFlash : public FlashStore {
+public:
+    explicit PartitionFlash(const char* label) : label_(label) {}
+
+    size_t size() const override;
+    bool read(uint32_t offset, void* dst, size_t len) override;
+    bool write(uint32_t offset, const void* src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+
+private:
+    const esp_partition_t* partition() const;
+
+    const char* label_;
+    mutable const esp_partition_t* partition_ = nullptr;
+};
+
+#else
+
+#include <stdio.h>
+
+// Host stand-in backed by a file, with NOR semantics (writes AND into the
+// existing bytes) so a log written by one run can be recovered by the next.
+// setWriteBudget() simulates a power cut part-way through a write.
+class FileFlash : public FlashStore {
+public:
+    ~FileFlash();
+
+    // Open (or create, erased) 'path'; nullptr gives an anonymous temp file.
+    bool open(const char* path, size_t size);
+
+    size_t size() const override { return size_; }
+    bool read(uint32_t offset, void* dst, size_t len) override;
+    bool write(uint32_t offset, const void* src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+
+    // After 'bytes' more bytes are programmed, every write and erase is
+    // silently lost. Negative = unlimited.
+    void setWriteBudget(long bytes) { budget_ = bytes; }
+
+    unsigned long writes() const { return writes_; }
+    unsigned long erases() const { return erases_; }
+
+private:
+    FILE* file_ = nullptr;
+    size_t size_ = 0;
+    long budget_ = -1;
+    unsigned long writes_ = 0;
+    unsigned long erases_ = 0;
+};
+
+#endif
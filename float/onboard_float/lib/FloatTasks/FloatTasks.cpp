@@ -0,0 +1,260 @@
+#include "FloatTasks.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <Arduino.h>
+
+static FloatTaskSpec specs_[FLOAT_TASKS_MAX];
+static TaskHandle_t handles_[FLOAT_TASKS_MAX];
+
+static void taskMain(void* arg) {
+    const FloatTaskSpec* spec = (const FloatTaskSpec*)arg;
+    TickType_t period = pdMS_TO_TICKS(spec->period_ms);
+    if (period == 0) period = 1;
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        spec->step();
+        if (spec->on_notify) {
+            ulTaskNotifyTake(pdTRUE, period);
+        } else {
+            vTaskDelayUntil(&last_wake, period);
+        }
+    }
+}
+
+bool floatTasksStart(const FloatTaskSpec* specs, int count) {
+    if (count > FLOAT_TASKS_MAX) return false;
+    for (int i = 0; i < count; i++) {
+        specs_[i] = specs[i];
+        if (xTaskCreatePinnedToCore(taskMain, specs_[i].name, specs_[i].stack_bytes, &specs_[i],
+                                    specs_[i].priority, &handles_[i], specs_[i].core) != pdPASS) {
+            handles_[i] = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+void floatTaskNotify(int index) {
+    if (index >= 0 && index < FLOAT_TASKS_MAX && handles_[index]) xTaskNotifyGive(handles_[index]);
+}
+
+#else
+
+#include <stdlib.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct HostTask {
+    FloatTaskSpec spec;
+    std::thread thread;
+    uint64_t next_period_us;    // vTaskDelayUntil schedule
+    uint64_t wake_us;           // wake at this time...
+    bool wake_on_notify;        // ...or on a notification
+    bool notified;
+    bool released;              // running, or allowed to run
+};
+
+std::mutex mtx;
+std::condition_variable cv;
+HostTask tasks[FLOAT_TASKS_MAX];
+int task_count = 0;
+int running = 0;                // released tasks that have not blocked yet
+bool parallel = false;
+bool stopping = false;
+uint64_t (*clock_now)() = nullptr;
+void (*clock_advance)(uint64_t) = nullptr;
+thread_local HostTask* current = nullptr;
+
+bool due(const HostTask& t, uint64_t now) {
+    return !t.released && (t.wake_us <= now || (t.wake_on_notify && t.notified));
+}
+
+// mtx held
+void release(HostTask& t) {
+    if (t.wake_on_notify) t.notified = false;
+    t.released = true;
+    running++;
+}
+
+// mtx held: give the CPU back and sleep until the scheduler releases us
+void block(std::unique_lock<std::mutex>& lock, HostTask& t) {
+    t.released = false;
+    running--;
+    cv.notify_all();
+    cv.wait(lock, [&t] { return t.released || stopping; });
+}
+
+// mtx held, after a step: the next wake-up. True if a notification that
+// came in while the step ran wakes the task straight away (ulTaskNotifyTake).
+bool reschedule(HostTask& t) {
+    uint64_t period_us = (uint64_t)t.spec.period_ms * 1000;
+    if (t.spec.on_notify) {
+        t.wake_us = clock_now() + period_us;
+        t.wake_on_notify = true;
+        if (t.notified) {
+            t.notified = false;
+            return true;
+        }
+    } else {
+        t.next_period_us += period_us;
+        t.wake_us = t.next_period_us;
+    }
+    return false;
+}
+
+// Parallel mode: one thread per task
+void taskMain(HostTask* t) {
+    current = t;
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [t] { return t->released || stopping; });
+    while (!stopping) {
+        lock.unlock();
+        t->spec.step();
+        lock.lock();
+        if (stopping) break;
+        if (reschedule(*t)) continue;
+        block(lock, *t);
+    }
+}
+
+// Deterministic mode: the task runs on the caller's thread, as often as a
+// notification during its step asks for
+void runInline(std::unique_lock<std::mutex>& lock, HostTask& t) {
+    if (t.wake_on_notify) t.notified = false;
+    do {
+        current = &t;
+        lock.unlock();
+        t.spec.step();
+        lock.lock();
+        current = nullptr;
+    } while (reschedule(t));
+}
+
+}  // namespace
+
+bool floatTasksStart(const FloatTaskSpec* specs, int count) {
+    if (count > FLOAT_TASKS_MAX || task_count > 0 || !clock_now) return false;
+    std::unique_lock<std::mutex> lock(mtx);
+    uint64_t now = clock_now();
+    stopping = false;
+    for (int i = 0; i < count; i++) {
+        HostTask& t = tasks[i];
+        t.spec = specs[i];
+        t.next_period_us = now;
+        t.wake_us = now;
+        t.wake_on_notify = false;
+        t.notified = false;
+        t.released = false;
+        if (parallel) t.thread = std::thread(taskMain, &t);
+    }
+    task_count = count;
+    static bool registered = false;
+    if (!registered) {
+        atexit(floatTasksStop);
+        registered = true;
+    }
+    return true;
+}
+
+void floatTaskNotify(int index) {
+    if (index < 0 || index >= task_count) return;
+    std::unique_lock<std::mutex> lock(mtx);
+    HostTask& t = tasks[index];
+    t.notified = true;
+    // Parallel: a task may wake another at once. The main thread (radio
+    // callbacks while the world runs) leaves it to the scheduler, so time
+    // never moves while a task runs.
+    if (parallel && current && !t.released && t.wake_on_notify) {
+        release(t);
+        cv.notify_all();
+    }
+}
+
+void floatTasksSetClock(uint64_t (*now_us)(), void (*advance_us)(uint64_t us)) {
+    clock_now = now_us;
+    clock_advance = advance_us;
+}
+
+void floatTasksSetParallel(bool enable) { parallel = enable; }
+
+bool floatTasksOnTaskThread() { return current != nullptr; }
+
+void floatTaskSleepUs(uint64_t us) {
+    HostTask* t = current;
+    if (!t) return;
+    if (!parallel) {
+        // A step running inline has nothing to yield to: it busy-waits
+        clock_advance(us);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    t->wake_us = clock_now() + us;
+    t->wake_on_notify = false;
+    block(lock, *t);
+}
+
+void floatTasksRunUs(uint64_t us) {
+    if (task_count == 0) {
+        clock_advance(us);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    uint64_t target = clock_now() + us;
+    for (;;) {
+        cv.wait(lock, [] { return running == 0; });
+        uint64_t now = clock_now();
+
+        // Run what is due now: release all of it to the task threads, or
+        // run the highest priority task here
+        HostTask* best = nullptr;
+        int released = 0;
+        for (int i = 0; i < task_count; i++) {
+            if (!due(tasks[i], now)) continue;
+            if (parallel) {
+                release(tasks[i]);
+                released++;
+            } else if (!best || tasks[i].spec.priority > best->spec.priority) {
+                best = &tasks[i];
+            }
+        }
+        if (best) {
+            runInline(lock, *best);
+            continue;
+        }
+        if (released) {
+            cv.notify_all();
+            continue;
+        }
+
+        // Everyone is waiting: move the world to the next wake-up
+        if (now >= target) return;
+        uint64_t next = target;
+        for (int i = 0; i < task_count; i++) {
+            if (tasks[i].wake_us < next) next = tasks[i].wake_us;
+        }
+        lock.unlock();
+        clock_advance(next - now);
+        lock.lock();
+    }
+}
+
+void floatTasksStop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (task_count == 0) return;
+        stopping = true;
+    }
+    cv.notify_all();
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].thread.joinable()) tasks[i].thread.join();
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    task_count = 0;
+    running = 0;
+}
+
+#endif
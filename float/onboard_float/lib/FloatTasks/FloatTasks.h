@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// FIRMWARE TASKS
+// ============================================================================
+// Each task is a non-blocking step() function plus a schedule: run every
+// period_ms, and (if on_notify) also as soon as floatTaskNotify() is called.
+// On the ESP32 every task is a FreeRTOS task pinned to its core:
+//
+//     for (;;) { step(); vTaskDelayUntil(period) or ulTaskNotifyTake(period); }
+//
+// Tasks talk only through SpscRing / LatestValue (or atomics), never by
+// sharing plain globals.
+//
+// On the host the tasks run on the simulator's virtual clock
+// (floatTasksSetClock): time only moves while every task is waiting. By
+// default each due step() is called inline on the thread that runs the
+// clock, highest priority first, so a seeded run is repeatable and costs no
+// thread switches. floatTasksSetParallel() (before floatTasksStart) gives
+// each task its own std::thread and lets the steps due at the same instant
+// overlap instead, to shake out races.
+
+#define FLOAT_TASKS_MAX 8
+
+typedef void (*FloatTaskStep)();
+
+struct FloatTaskSpec {
+    const char* name;
+    FloatTaskStep step;
+    uint32_t period_ms;     // wake at least this often
+    bool on_notify;         // also wake on floatTaskNotify()
+    uint8_t core;           // 0 = PRO_CPU (WiFi), 1 = APP_CPU
+    uint8_t priority;       // FreeRTOS priority, higher runs first
+    uint32_t stack_bytes;
+};
+
+// Create and start the tasks (index = position in 'specs'). Returns false
+// if one could not be created. Call once, from setup().
+bool floatTasksStart(const FloatTaskSpec* specs, int count);
+
+// Wake an on_notify task early. Safe from any task or callback.
+void floatTaskNotify(int index);
+
+// ============================================================================
+// JITTER STATISTICS
+// ============================================================================
+// Deviation of a periodic event from its schedule, or a latency, in us.
+// Not thread-safe: keep one per task.
+
+class JitterStats {
+public:
+    explicit JitterStats(uint32_t bound_us) : bound_us_(bound_us) { reset(); }
+
+    void reset() {
+        count_ = 0;
+        over_ = 0;
+        min_ = 0;
+        max_ = 0;
+        sum_ = 0;
+    }
+
+    void add(int32_t us) {
+        if (count_ == 0 || us < min_) min_ = us;
+        if (count_ == 0 || us > max_) max_ = us;
+        sum_ += us;
+        count_++;
+        if ((us < 0 ? -us : us) > (int32_t)bound_us_) over_++;
+    }
+
+    uint32_t count() const { return count_; }
+    uint32_t overBound() const { return over_; }
+    uint32_t bound() const { return bound_us_; }
+    int32_t min() const { return min_; }
+    int32_t max() const { return max_; }
+    float mean() const { return count_ ? (float)sum_ / count_ : 0.0f; }
+
+private:
+    uint32_t bound_us_;
+    uint32_t count_;
+    uint32_t over_;
+    int32_t min_;
+    int32_t max_;
+    int64_t sum_;
+};
+
+#if !defined(ARDUINO_ARCH_ESP32)
+
+// ============================================================================
+// HOST STAND-IN (std::thread on a virtual clock)
+// ============================================================================
+
+// Where time comes from and how to move it (the simulator's world clock).
+void floatTasksSetClock(uint64_t (*now_us)(), void (*advance_us)(uint64_t us));
+
+// Let tasks that are due at the same instant run at the same time (one
+// thread per task). Call before floatTasksStart().
+void floatTasksSetParallel(bool parallel);
+
+// delay() inside a task: sleep on the virtual clock (inline: busy-wait)
+bool floatTasksOnTaskThread();
+void floatTaskSleepUs(uint64_t us);
+
+// delay() on the main thread: run the tasks and the world for 'us'.
+// Returns with every task waiting again.
+void floatTasksRunUs(uint64_t us);
+
+// Stop and join the task threads (also done at exit).
+void floatTasksStop();
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// ============================================================================
+// LATEST-VALUE MAILBOX (sequence lock)
+// ============================================================================
+// One writer publishes a small struct, any number of readers copy the most
+// recent one. The writer never waits. A reader that catches a publish half
+// way retries a few times and then gives up (tryRead() returns false), so a
+// high-priority reader can not spin on a preempted low-priority writer; it
+// simply tries again on its next tick.
+//
+// The payload is stored as atomic words, so there is no data race even
+// while a read overlaps a write. T must be trivially copyable.
+
+template <typename T>
+class LatestValue {
+public:
+    LatestValue() : seq_(0) {
+        for (uint32_t i = 0; i < WORDS; i++) words_[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Writer side (one task only)
+    void publish(const T& value) {
+        uint32_t words[WORDS] = {0};
+        memcpy(words, &value, sizeof(T));
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);     // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (uint32_t i = 0; i < WORDS; i++) words_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side. False if nothing has been published yet or the writer
+    // kept getting in the way.
+    bool tryRead(T& out) const {
+        for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+            uint32_t before = seq_.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) continue;
+            uint32_t words[WORDS];
+            for (uint32_t i = 0; i < WORDS; i++) words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) {
+                memcpy(&out, words, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of publishes so far
+    uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static const uint32_t WORDS = (sizeof(T) + 3) / 4;
+    static const int READ_ATTEMPTS = 4;
+
+    std::atomic<uint32_t> seq_;
+    std::atomic<uint32_t> words_[WORDS];
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// ============================================================================
+// SINGLE-PRODUCER / SINGLE-CONSUMER RING
+// ============================================================================
+// Lock-free FIFO between exactly two tasks (or a task and a callback): one
+// only ever calls push(), the other only pop(). Neither side blocks or takes
+// a lock, so a high-priority task can never be held up by a low-priority
+// one. When the ring is full push() fails and the item is counted as
+// dropped; the producer decides whether that matters.
+//
+// N must be a power of two. Items are copied in and out, keep them small.
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : head_(0), tail_(0), dropped_(0) {}
+
+    // Producer side
+    bool push(const T& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return false;
+        item = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side (a snapshot, may be stale by the time it is used)
+    uint32_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    uint32_t capacity() const { return N; }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    T items_[N];
+    std::atomic<uint32_t> head_;    // written by the producer only
+    std::atomic<uint32_t> tail_;    // written by the consumer only
+    std::atomic<uint32_t> dropped_;
+};
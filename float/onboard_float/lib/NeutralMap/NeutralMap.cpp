@@ -0,0 +1,114 @@
+#include "NeutralMap.h"
+#include <math.h>
+
+NeutralMap::NeutralMap(const NeutralMapConfig& config)
+    : config_(config), surface_(config.surface_steps), per_m_(config.steps_per_m) {}
+
+void NeutralMap::clear() {
+    sum_w_ = sum_d_ = sum_dd_ = sum_p_ = sum_dp_ = 0;
+    missions_ = 0;
+    holds_ = 0;
+    counted_mission_ = false;
+    fit();
+}
+
+bool NeutralMap::load(const neutral_map_record& r) {
+    clear();
+    if (r.magic != NEUTRAL_MAP_MAGIC || r.version != NEUTRAL_MAP_VERSION) return false;
+    if (!(r.w >= 0) || !isfinite(r.sd) || !isfinite(r.sdd) || !isfinite(r.sy) || !isfinite(r.sdy)) {
+        return false;
+    }
+    sum_w_ = r.w;
+    sum_d_ = r.sd;
+    sum_dd_ = r.sdd;
+    sum_p_ = r.sy;
+    sum_dp_ = r.sdy;
+    missions_ = r.missions;
+    holds_ = r.holds;
+    fit();
+    return true;
+}
+
+neutral_map_record NeutralMap::record() const {
+    neutral_map_record r;
+    r.magic = NEUTRAL_MAP_MAGIC;
+    r.version = NEUTRAL_MAP_VERSION;
+    r.missions = missions_;
+    r.holds = holds_;
+    r.w = sum_w_;
+    r.sd = sum_d_;
+    r.sdd = sum_dd_;
+    r.sy = sum_p_;
+    r.sdy = sum_dp_;
+    return r;
+}
+
+void NeutralMap::beginMission() {
+    sum_w_ *= config_.carry;
+    sum_d_ *= config_.carry;
+    sum_dd_ *= config_.carry;
+    sum_p_ *= config_.carry;
+    sum_dp_ *= config_.carry;
+    counted_mission_ = false;
+    fit();
+}
+
+void NeutralMap::beginHold() {
+    hold_n_ = 0;
+    hold_near_ = 0;
+    hold_d_ = hold_p_ = hold_v_ = 0;
+}
+
+void NeutralMap::addSample(float target_m, float depth_m, float velocity_mps, int32_t piston_steps) {
+    if (fabsf(depth_m - target_m) > config_.settle_error_m) return;
+    // Drift counts every sample near the target once the arrival is over
+    bool settled = fabsf(velocity_mps) <= config_.settle_velocity_mps;
+    if (!settled && !hold_n_) return;
+    hold_near_++;
+    hold_v_ += velocity_mps;
+    if (!settled) return;
+    hold_n_++;
+    hold_d_ += depth_m;
+    hold_p_ += (float)piston_steps;
+}
+
+bool NeutralMap::endHold() {
+    if (hold_n_ < config_.min_hold_samples) return false;
+    if (fabsf(holdVelocityMps()) > config_.drift_velocity_mps) return false;
+
+    float w = (float)hold_n_;
+    float d = holdDepthM();
+    float p = holdSteps();
+    sum_w_ += w;
+    sum_d_ += w * d;
+    sum_dd_ += w * d * d;
+    sum_p_ += w * p;
+    sum_dp_ += w * d * p;
+    holds_++;
+    if (!counted_mission_) {
+        missions_++;
+        counted_mission_ = true;
+    }
+    fit();
+    return true;
+}
+
+void NeutralMap::fit() {
+    surface_ = config_.surface_steps;
+    per_m_ = config_.steps_per_m;
+    slope_learned_ = false;
+    if (sum_w_ <= 0) return;
+
+    float mean_d = sum_d_ / sum_w_;
+    float mean_p = sum_p_ / sum_w_;
+    float var_d = sum_dd_ / sum_w_ - mean_d * mean_d;
+    if (var_d >= config_.min_depth_spread_m * config_.min_depth_spread_m) {
+        float slope = (sum_dp_ / sum_w_ - mean_d * mean_p) / var_d;
+        if (slope >= config_.min_slope && slope <= config_.max_slope) {
+            per_m_ = slope;
+            slope_learned_ = true;
+        }
+    }
+    // The line goes through the weighted mean point
+    surface_ = mean_p - per_m_ * mean_d;
+}
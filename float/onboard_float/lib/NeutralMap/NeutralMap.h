@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// NEUTRAL-BUOYANCY MAP
+// ============================================================================
+// Learns where the piston is neutral as a function of depth, for the
+// DepthController feed-forward:
+//
+//   neutral(depth) = surface_steps + steps_per_m * depth
+//
+// While a hold is settled (small vertical velocity, near the target) every
+// sample's piston position goes into a per-hold average; at the end of the
+// hold that average becomes one point (mean depth, mean piston), weighted
+// by its sample count, of a weighted least-squares line. A hold whose mean
+// velocity after the arrival is not ~0 was drifting and is dropped. With
+// points at one depth only, the offset is fitted under the configured slope.
+//
+// The sums are the persistent state (record(), saved in NVS): a new mission
+// scales them by 'carry', so older missions fade out after a ballast or
+// hull change instead of pinning the map.
+
+struct NeutralMapConfig {
+    float surface_steps;            // prior: used until the map has data
+    float steps_per_m;
+    float settle_velocity_mps;      // samples faster than this are ignored
+    float settle_error_m;           // ... and so are samples this far off target
+    float drift_velocity_mps;       // reject a hold whose mean velocity exceeds this
+    float min_hold_samples;         // settled samples for a hold to count
+    float min_depth_spread_m;       // depth std-dev needed to fit the slope
+    float min_slope, max_slope;     // plausible steps per m
+    float carry;                    // weight kept from earlier missions, 0..1
+};
+
+// NVS blob. The sums are over hold points (weight = settled samples).
+struct neutral_map_record {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t missions;              // missions that contributed
+    uint32_t holds;                 // holds that contributed
+    float w, sd, sdd, sy, sdy;      // sum of w, w*d, w*d^2, w*p, w*d*p
+};
+
+#define NEUTRAL_MAP_MAGIC 0x4E4D4150u    // "NMAP"
+#define NEUTRAL_MAP_VERSION 1
+
+class NeutralMap {
+public:
+    explicit NeutralMap(const NeutralMapConfig& config);
+
+    // Persistent state. load() returns false (and keeps the map empty) for
+    // a blob from another version or with impossible sums.
+    bool load(const neutral_map_record& record);
+    neutral_map_record record() const;
+    void clear();
+
+    // Fade earlier missions (call once per mission, before its holds).
+    void beginMission();
+
+    // One control tick inside a hold. piston_steps is the actual position.
+    void beginHold();
+    void addSample(float target_m, float depth_m, float velocity_mps, int32_t piston_steps);
+    // Fold the hold into the map; true if it counted (and the fit changed).
+    bool endHold();
+
+    // Current estimate (the prior while there is no data).
+    float surfaceSteps() const { return surface_; }
+    float stepsPerM() const { return per_m_; }
+    float neutralSteps(float depth_m) const { return surface_ + per_m_ * depth_m; }
+    bool learned() const { return sum_w_ > 0; }
+    bool slopeLearned() const { return slope_learned_; }
+    uint32_t holds() const { return holds_; }
+    uint16_t missions() const { return missions_; }
+
+    // The last hold, for the log line
+    float holdDepthM() const { return hold_n_ ? hold_d_ / hold_n_ : 0; }
+    float holdSteps() const { return hold_n_ ? hold_p_ / hold_n_ : 0; }
+    float holdVelocityMps() const { return hold_near_ ? hold_v_ / hold_near_ : 0; }
+    uint32_t holdSamples() const { return hold_n_; }
+
+private:
+    void fit();
+
+    NeutralMapConfig config_;
+    float sum_w_ = 0, sum_d_ = 0, sum_dd_ = 0, sum_p_ = 0, sum_dp_ = 0;
+    uint16_t missions_ = 0;
+    uint32_t holds_ = 0;
+    bool counted_mission_ = false;
+    float surface_;
+    float per_m_;
+    bool slope_learned_ = false;
+
+    uint32_t hold_n_ = 0;           // settled samples
+    uint32_t hold_near_ = 0;        // near the target since first settled
+    float hold_d_ = 0, hold_p_ = 0, hold_v_ = 0;
+};
@@ -0,0 +1,28 @@
+#include "MotionProfile.h"
+#include <math.h>
+
+uint32_t MotionProfile::rampSteps() const {
+    return (uint32_t)((max_sps * max_sps) / (2.0f * accel_sps2));
+}
+
+uint32_t MotionProfile::moveDurationUs(uint32_t steps) const {
+    if (steps == 0) return 0;
+    float ramp = (max_sps * max_sps) / (2.0f * accel_sps2);
+    float seconds;
+    if (steps >= 2.0f * ramp) {
+        // accelerate, cruise, decelerate
+        seconds = 2.0f * max_sps / accel_sps2 + (steps - 2.0f * ramp) / max_sps;
+    } else {
+        // triangle: never reaches max_sps
+        seconds = 2.0f * sqrtf(steps / accel_sps2);
+    }
+    return (uint32_t)(seconds * 1e6f);
+}
+
+int32_t MotionProfile::firstIntervalQ8() const {
+    return (int32_t)(0.676f * sqrtf(2.0f / accel_sps2) * 1e6f * 256.0f);
+}
+
+int32_t MotionProfile::cruiseIntervalQ8() const {
+    return (int32_t)(1e6f / max_sps * 256.0f);
+}
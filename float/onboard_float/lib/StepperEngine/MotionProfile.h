@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// TRAPEZOIDAL MOTION PROFILE
+// ============================================================================
+// Max step rate and acceleration for the buoyancy piston, plus the closed
+// form timings the planner and the mission controller need.
+
+struct MotionProfile {
+    float max_sps;          // cruise step rate (steps/s)
+    float accel_sps2;       // ramp acceleration (steps/s^2)
+
+    // Steps needed to reach max_sps from standstill.
+    uint32_t rampSteps() const;
+
+    // Time for a move of 'steps' from standstill to standstill.
+    uint32_t moveDurationUs(uint32_t steps) const;
+
+    // First step interval from standstill, 0.676 * sqrt(2/a) (Austin's
+    // correction of the first step), and the cruise interval, in 1/256 us.
+    int32_t firstIntervalQ8() const;
+    int32_t cruiseIntervalQ8() const;
+};
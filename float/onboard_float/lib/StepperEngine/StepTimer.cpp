@@ -0,0 +1,55 @@
+#include "StepTimer.h"
+#include "StepperEngine.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+Esp32StepTimer* Esp32StepTimer::instance_ = nullptr;
+
+void Esp32StepTimer::begin(StepperEngine& engine) {
+    engine_ = &engine;
+    instance_ = this;
+    timer_ = timerBegin(timer_num_, 80, true);   // 1 tick = 1 us
+    timerAttachInterrupt(timer_, &Esp32StepTimer::onAlarm, true);
+}
+
+void Esp32StepTimer::start(uint32_t delay_us) {
+    timerWrite(timer_, 0);
+    timerAlarmWrite(timer_, delay_us, true);
+    timerAlarmEnable(timer_);
+}
+
+void IRAM_ATTR Esp32StepTimer::onAlarm() {
+    Esp32StepTimer* self = instance_;
+    portENTER_CRITICAL_ISR(&self->mux_);
+    uint32_t next_us = self->engine_->onTimer();
+    // Auto-reload already restarted the counter; the new alarm applies to it
+    if (next_us) {
+        timerAlarmWrite(self->timer_, next_us, true);
+    } else {
+        timerAlarmDisable(self->timer_);
+    }
+    portEXIT_CRITICAL_ISR(&self->mux_);
+}
+
+#else
+
+void FakeStepTimer::start(uint32_t delay_us) {
+    due_us_ = now_us_ + delay_us;
+    armed_ = true;
+}
+
+void FakeStepTimer::advance(uint32_t us) {
+    uint64_t end_us = now_us_ + us;
+    while (armed_ && due_us_ <= end_us) {
+        now_us_ = due_us_;
+        uint32_t next_us = engine_->onTimer();
+        if (next_us) {
+            due_us_ = now_us_ + next_us;
+        } else {
+            armed_ = false;
+        }
+    }
+    now_us_ = end_us;
+}
+
+#endif
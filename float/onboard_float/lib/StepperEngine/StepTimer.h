@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+class StepperEngine;
+
+// ============================================================================
+// STEP TIMER BACK-ENDS
+// ============================================================================
+// A StepTimer calls engine.onTimer() after the requested delay and keeps
+// re-arming itself with whatever onTimer() returns until that is 0.
+// lock()/unlock() keep the timer callback out while a task updates the
+// engine's shared state.
+
+class StepTimer {
+public:
+    virtual ~StepTimer() {}
+    virtual void start(uint32_t delay_us) = 0;
+    virtual void lock() = 0;
+    virtual void unlock() = 0;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <Arduino.h>
+
+// Hardware timer at 1 MHz (APB 80 MHz / 80). Only one instance may exist,
+// the interrupt handler reaches it through a static pointer.
+class Esp32StepTimer : public StepTimer {
+public:
+    explicit Esp32StepTimer(uint8_t timer_num) : timer_num_(timer_num) {}
+
+    void begin(StepperEngine& engine);
+    void start(uint32_t delay_us) override;
+    void lock() override { portENTER_CRITICAL(&mux_); }
+    void unlock() override { portEXIT_CRITICAL(&mux_); }
+
+private:
+    static void IRAM_ATTR onAlarm();
+
+    static Esp32StepTimer* instance_;
+    uint8_t timer_num_;
+    hw_timer_t* timer_ = nullptr;
+    StepperEngine* engine_ = nullptr;
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#else
+
+// Host stand-in: time only moves when advance() is called, so step timing
+// can be checked edge by edge without real hardware.
+class FakeStepTimer : public StepTimer {
+public:
+    void begin(StepperEngine& engine) { engine_ = &engine; }
+    void start(uint32_t delay_us) override;
+    void lock() override {}
+    void unlock() override {}
+
+    // Run the clock forward, firing every callback that falls due.
+    void advance(uint32_t us);
+
+    uint64_t nowUs() const { return now_us_; }
+    bool armed() const { return armed_; }
+
+private:
+    StepperEngine* engine_ = nullptr;
+    uint64_t now_us_ = 0;
+    uint64_t due_us_ = 0;
+    bool armed_ = false;
+};
+
+#endif
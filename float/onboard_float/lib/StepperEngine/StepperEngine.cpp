@@ -0,0 +1,160 @@
+#include "StepperEngine.h"
+#include "StepTimer.h"
+
+// DIR must be stable this long before the next STEP rising edge
+static const uint32_t DIR_SETUP_US = 50;
+
+StepperEngine::StepperEngine(const StepperPins& pins, StepTimer& timer)
+    : pins_(pins), timer_(timer) {
+    c0_q8_ = profile_.firstIntervalQ8();
+    cmin_q8_ = profile_.cruiseIntervalQ8();
+}
+
+void StepperEngine::moveTo(int32_t target) {
+    timer_.lock();
+    target_ = target;
+    bool kick = !running_ && target_ != position_;
+    if (kick) {
+        running_ = true;
+        n_ = 0;
+    }
+    timer_.unlock();
+
+    if (kick) timer_.start(DIR_SETUP_US);
+}
+
+void StepperEngine::stop() {
+    timer_.lock();
+    // Let a pending STEP high finish its low edge so the count stays exact
+    target_ = step_high_ ? position_ + dir_ : position_;
+    n_ = 0;
+    timer_.unlock();
+}
+
+void StepperEngine::setPosition(int32_t position) {
+    timer_.lock();
+    if (!running_) {
+        position_ = position;
+        target_ = position;
+    }
+    timer_.unlock();
+}
+
+void StepperEngine::setForwardLimitPosition(int32_t position) {
+    limit_position_ = position;
+    has_limit_position_ = true;
+}
+
+void StepperEngine::setLimitDebounce(uint8_t reads) {
+    timer_.lock();
+    limit_debounce_ = reads ? reads : 1;
+    limit_reads_ = 0;
+    timer_.unlock();
+}
+
+void StepperEngine::setProfile(const MotionProfile& profile) {
+    // Float maths stays out here, the interrupt only sees the integers
+    int32_t c0 = profile.firstIntervalQ8();
+    int32_t cmin = profile.cruiseIntervalQ8();
+    if (cmin > c0) cmin = c0;
+
+    timer_.lock();
+    profile_ = profile;
+    c0_q8_ = c0;
+    cmin_q8_ = cmin;
+    timer_.unlock();
+}
+
+uint32_t StepperEngine::predictMoveMs(int32_t target) const {
+    int32_t steps = target - position_;
+    if (steps < 0) steps = -steps;
+    return profile_.moveDurationUs((uint32_t)steps) / 1000;
+}
+
+bool StepperEngine::consumeLimitEvent() {
+    if (!limit_event_) return false;
+    limit_event_ = false;
+    return true;
+}
+
+uint32_t STEPPER_ISR_ATTR StepperEngine::onTimer() {
+    // Second half of a step: drop STEP and count it
+    if (step_high_) {
+        pins_.setStep(false);
+        step_high_ = false;
+        position_ += dir_;
+        return low_us_;
+    }
+
+    int32_t distance = target_ - position_;
+    int32_t steps_to_stop = (n_ > 0) ? n_ : -n_;
+
+    if (distance == 0 && steps_to_stop <= 1) {
+        n_ = 0;
+        running_ = false;
+        return 0;
+    }
+
+    // Decide whether to keep accelerating, start braking or re-accelerate
+    if (distance > 0) {
+        if (n_ > 0) {
+            if (steps_to_stop >= distance || dir_ < 0) n_ = -steps_to_stop;
+        } else if (n_ < 0) {
+            if (steps_to_stop < distance && dir_ > 0) n_ = -n_;
+        }
+    } else if (distance < 0) {
+        if (n_ > 0) {
+            if (steps_to_stop >= -distance || dir_ > 0) n_ = -steps_to_stop;
+        } else if (n_ < 0) {
+            if (steps_to_stop < -distance && dir_ < 0) n_ = -n_;
+        }
+    } else if (n_ > 0) {
+        n_ = -steps_to_stop;   // on target but still moving: brake
+    }
+
+    if (n_ == 0) {
+        // Starting from standstill. Direction change costs a DIR setup delay.
+        int8_t wanted = (distance > 0) ? 1 : -1;
+        if (wanted != dir_) {
+            dir_ = wanted;
+            pins_.setDir(wanted > 0);
+            return DIR_SETUP_US;
+        }
+        c_q8_ = c0_q8_;
+        n_ = 1;
+    } else {
+        int32_t c = c_q8_ - (2 * c_q8_) / (4 * n_ + 1);
+        if (n_ > 0 && c <= cmin_q8_) {
+            c = cmin_q8_;          // cruising: ramp index stays put
+        } else {
+            n_++;
+        }
+        c_q8_ = c;
+    }
+
+    // Live limit abort: only the forward (SINK) direction has a switch.
+    // The first closed read was limit_debounce_ - 1 steps ago.
+    if (dir_ > 0 && pins_.forwardLimitHit) {
+        if (!pins_.forwardLimitHit()) {
+            limit_reads_ = 0;
+        } else if (limit_reads_ < limit_debounce_) {
+            limit_reads_++;
+        }
+    }
+    if (dir_ > 0 && limit_reads_ >= limit_debounce_) {
+        if (has_limit_position_) position_ = limit_position_ + limit_debounce_ - 1;
+        target_ = position_;
+        limit_event_ = true;
+        n_ = 0;
+        running_ = false;
+        return 0;
+    }
+
+    uint32_t period_us = (uint32_t)c_q8_ >> 8;
+    uint32_t high_us = period_us / 2;
+    low_us_ = period_us - high_us;
+
+    pins_.setStep(true);
+    step_high_ = true;
+    return high_us;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include "MotionProfile.h"
+
+// ============================================================================
+// TIMER-DRIVEN STEPPER ENGINE
+// ============================================================================
+// The engine owns the piston position and generates STEP/DIR edges from a
+// one-shot hardware timer, so the caller only queues a target and carries on.
+// Every call to onTimer() produces exactly one edge (STEP high, STEP low or a
+// DIR change) and returns the delay until the next call.
+//
+// Step intervals follow a trapezoidal profile: accelerate, cruise at the
+// max step rate, decelerate into the target. The per-step update is the
+// integer form of D. Austin's recurrence c[n] = c[n-1] - 2c[n-1]/(4n+1), so
+// the interrupt never touches the FPU. A retarget mid-move decelerates first
+// if the new target is behind or too close to stop in time.
+//
+// The engine is plain C++ so it also builds on the host, where FakeStepTimer
+// stands in for the ESP32 hardware timer (see StepTimer.h).
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_attr.h>
+#define STEPPER_ISR_ATTR IRAM_ATTR
+#else
+#define STEPPER_ISR_ATTR
+#endif
+
+// Pin hooks, called from the timer interrupt. Keep them short.
+struct StepperPins {
+    void (*setDir)(bool forward);   // forward = DIR HIGH = SINK
+    void (*setStep)(bool level);
+    bool (*forwardLimitHit)();      // may be nullptr when no switch is fitted
+};
+
+class StepTimer;
+
+class StepperEngine {
+public:
+    StepperEngine(const StepperPins& pins, StepTimer& timer);
+
+    // Queue a new target. Returns immediately; a running move is retargeted.
+    void moveTo(int32_t target);
+
+    // Abort the current move where it is.
+    void stop();
+
+    // Re-reference the position counter (only while stopped, e.g. after homing).
+    void setPosition(int32_t position);
+
+    // Position the piston is known to be at when the forward limit switch
+    // closes. A move that hits the switch is aborted and re-referenced here.
+    void setForwardLimitPosition(int32_t position);
+
+    // The switch counts as closed after this many consecutive closed reads,
+    // one per forward step (default 1). The re-reference allows for the
+    // steps taken while confirming, so it is exact at low step rates.
+    void setLimitDebounce(uint8_t reads);
+
+    // Motion limits. Applied to the next step, safe to call during a move.
+    void setProfile(const MotionProfile& profile);
+    const MotionProfile& profile() const { return profile_; }
+
+    // Predicted time for a move from standstill to target, in ms.
+    uint32_t predictMoveMs(int32_t target) const;
+
+    bool isMoving() const { return running_; }
+    int32_t currentPosition() const { return position_; }
+    int32_t targetPosition() const { return target_; }
+
+    // True once after the forward limit switch aborted a move.
+    bool consumeLimitEvent();
+
+    // Timer callback: emit one edge, return microseconds until the next call
+    // or 0 when the move has finished and the timer should stay idle.
+    uint32_t STEPPER_ISR_ATTR onTimer();
+
+private:
+    const StepperPins pins_;
+    StepTimer& timer_;
+
+    volatile int32_t position_ = 0;
+    volatile int32_t target_ = 0;
+    volatile bool running_ = false;
+    volatile bool step_high_ = false;
+    volatile bool limit_event_ = false;
+    volatile int8_t dir_ = 0;           // last direction written to DIR_PIN
+
+    // Step interval in 1/256 us, and the signed ramp index of the recurrence:
+    // n > 0 accelerating/cruising, n < 0 decelerating, |n| = steps to stop.
+    MotionProfile profile_ = {625.0f, 4000.0f};   // old fixed 800us rate
+    int32_t c0_q8_ = 0;
+    int32_t cmin_q8_ = 0;
+    volatile int32_t c_q8_ = 0;
+    volatile int32_t n_ = 0;
+    volatile uint32_t low_us_ = 0;
+    int32_t limit_position_ = 0;
+    bool has_limit_position_ = false;
+    uint8_t limit_debounce_ = 1;
+    volatile uint8_t limit_reads_ = 0;
+};
@@ -0,0 +1,50 @@
+#include "SurfaceTracker.h"
+#include <math.h>
+
+SurfaceTracker::SurfaceTracker(const SurfaceTrackerConfig& config) : config_(config) {
+    if (config_.reseed_after < 1) config_.reseed_after = 1;
+    if (config_.reseed_after > SURFACE_RESEED_MAX) config_.reseed_after = SURFACE_RESEED_MAX;
+}
+
+void SurfaceTracker::reset() {
+    mean_ = var_ = abs_dev_ = 0;
+    samples_ = rejected_ = rejected_run_ = 0;
+}
+
+bool SurfaceTracker::add(float pressure_pa) {
+    if (!isfinite(pressure_pa)) return false;
+    float diff = pressure_pa - mean_;
+    if (samples_ > 0) {
+        // Normal noise: sigma = 1.2533 * mean absolute deviation
+        float gate = config_.reject_sigma * 1.2533f * abs_dev_;
+        if (gate < config_.reject_floor_pa) gate = config_.reject_floor_pa;
+        if (fabsf(diff) > gate) {
+            rejected_++;
+            run_[rejected_run_++] = pressure_pa;
+            if (rejected_run_ < config_.reseed_after) return false;
+            // Insertion sort of a handful of values for the median
+            uint32_t n = rejected_run_;
+            for (uint32_t i = 1; i < n; i++) {
+                float v = run_[i];
+                uint32_t j = i;
+                for (; j > 0 && run_[j - 1] > v; j--) run_[j] = run_[j - 1];
+                run_[j] = v;
+            }
+            pressure_pa = run_[n / 2];
+            reset();
+        }
+    }
+    rejected_run_ = 0;
+    if (samples_++ == 0) {
+        mean_ = pressure_pa;
+        return true;
+    }
+
+    // Running mean/variance: 1/n weights, then a fixed window
+    float n = (float)samples_;
+    float k = n < config_.window_samples ? 1.0f / n : 1.0f / config_.window_samples;
+    mean_ += k * diff;
+    var_ = (1.0f - k) * (var_ + k * diff * diff);
+    abs_dev_ += k * (fabsf(diff) - abs_dev_);
+    return true;
+}
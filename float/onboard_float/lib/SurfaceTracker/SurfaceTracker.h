@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// SURFACE PRESSURE TRACKER
+// ============================================================================
+// Keeps the zero-depth reference current while the float waits at the
+// surface, so deploy can start the dive without a calibration pause.
+//
+// A running mean and variance of the pressure: an exact average of the
+// samples so far, turning into an exponential one over 'window_samples'
+// once that many are in. A sample further from the mean than reject_sigma
+// standard deviations (or reject_floor_pa, whichever is wider) is an
+// outlier (a wave, the float being handled) and is left out. The gate uses
+// the mean absolute deviation of the accepted samples, so a few outliers
+// that got in early cannot widen it the way they would the variance.
+// 'reseed_after' outliers in a row mean the surface really moved (the
+// float was put in the water), or the estimate started on a bad sample: it
+// starts again from the median of that run.
+
+struct SurfaceTrackerConfig {
+    float window_samples;           // averaging length once warmed up
+    uint32_t min_samples;           // accepted samples before ready()
+    float reject_sigma;             // outlier gate, standard deviations
+    float reject_floor_pa;          // ... never tighter than this
+    uint32_t reseed_after;          // consecutive outliers that restart it (<= SURFACE_RESEED_MAX)
+};
+
+#define SURFACE_RESEED_MAX 16
+
+class SurfaceTracker {
+public:
+    explicit SurfaceTracker(const SurfaceTrackerConfig& config);
+
+    void reset();
+    // One absolute pressure sample; false if it was rejected as an outlier
+    bool add(float pressure_pa);
+
+    bool ready() const { return samples_ >= config_.min_samples; }
+    float pressurePa() const { return mean_; }
+    float variancePa2() const { return var_; }
+    uint32_t samples() const { return samples_; }      // accepted since the last (re)start
+    uint32_t rejected() const { return rejected_; }    // outliers since the last (re)start
+
+private:
+    SurfaceTrackerConfig config_;
+    float mean_ = 0;
+    float var_ = 0;
+    float abs_dev_ = 0;             // mean |sample - mean|, for the gate
+    uint32_t samples_ = 0;
+    uint32_t rejected_ = 0;
+    uint32_t rejected_run_ = 0;
+    float run_[SURFACE_RESEED_MAX];     // the current run of outliers
+};
@@ -0,0 +1,62 @@
+#include "FloatPhysics.h"
+#include <math.h>
+
+static const float GRAVITY = 9.80665f;
+static const float ATMOSPHERE_MBAR = 1013.25f;
+
+const FloatPhysicsParams DEFAULT_FLOAT_PHYSICS = {
+    4.0e-3f,                // hull volume
+    0.60f,                  // hull length
+    4.0e-6f,                // 4 ml per m compression (~18 steps/m)
+    500.0e-6f / 2200.0f,    // 500 ml syringe, full stroke 2200 steps
+    1100.0f,                // neutral mid-stroke
+    0.00785f,               // Cd 1.0, 10 cm diameter
+    0.3f,
+    1025.0f,                // EGADS solution
+    4.0f,
+    0.5f                    // ~5 mm depth noise
+};
+
+FloatPhysics::FloatPhysics(const FloatPhysicsParams& params) : params_(params) {
+    mass_ = params.water_density *
+            (params.hull_volume_m3
+             - params.hull_compress_m3_per_m * params.hull_length_m
+             - params.neutral_surface_steps * params.syringe_m3_per_step);
+    depth_ = restingDepthM(0);
+    velocity_ = 0;
+}
+
+float FloatPhysics::restingDepthM(int32_t piston_steps) const {
+    float needed_m3 = mass_ / params_.water_density + piston_steps * params_.syringe_m3_per_step;
+    return needed_m3 / params_.hull_volume_m3 * params_.hull_length_m;
+}
+
+void FloatPhysics::step(float dt_s, int32_t piston_steps) {
+    float submerged = depth_ / params_.hull_length_m;
+    if (submerged > 1) submerged = 1;
+    if (submerged < 0) submerged = 0;
+
+    float volume = submerged * params_.hull_volume_m3
+                 - params_.hull_compress_m3_per_m * (depth_ > 0 ? depth_ : 0)
+                 - piston_steps * params_.syringe_m3_per_step;
+    float buoyancy = params_.water_density * GRAVITY * volume;
+    float drag = 0.5f * params_.water_density * params_.drag_area_cd_m2 * velocity_ * fabsf(velocity_);
+    float force = mass_ * GRAVITY - buoyancy - drag;     // + = down
+
+    velocity_ += force / (mass_ * (1.0f + params_.added_mass_ratio)) * dt_s;
+    depth_ += velocity_ * dt_s;
+
+    if (depth_ < 0) {
+        depth_ = 0;
+        if (velocity_ < 0) velocity_ = 0;
+    }
+    if (depth_ > params_.pool_depth_m) {
+        depth_ = params_.pool_depth_m;
+        if (velocity_ > 0) velocity_ = 0;
+    }
+}
+
+float FloatPhysics::pressureMbar(float noise) const {
+    return ATMOSPHERE_MBAR + params_.water_density * GRAVITY * depth_ / 100.0f
+         + noise * params_.sensor_noise_mbar;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// 1-D FLOAT PHYSICS
+// ============================================================================
+// Vertical motion of the hull with the syringe buoyancy engine:
+//
+//   m_eff * dv/dt = m*g - rho*g*(V_sub(z) - c*z - s*steps) - 0.5*rho*CdA*v|v|
+//
+// z is the absolute depth of the pressure sensor (bottom of the hull), so
+// the hull is partly out of the water for z < hull_length_m. The mass is
+// chosen so the float is neutral, just submerged, at neutral_surface_steps.
+// Deeper the hull compresses by c m^3 per metre and gets heavier.
+
+struct FloatPhysicsParams {
+    float hull_volume_m3;           // displaced volume fully submerged, piston at 0
+    float hull_length_m;            // sensor at the bottom, top this far above
+    float hull_compress_m3_per_m;   // volume lost per metre of depth
+    float syringe_m3_per_step;      // water drawn in per piston step
+    float neutral_surface_steps;    // sets the mass (see above)
+    float drag_area_cd_m2;          // Cd * frontal area
+    float added_mass_ratio;         // entrained water, fraction of the mass
+    float water_density;            // kg/m^3
+    float pool_depth_m;             // floor under the sensor
+    float sensor_noise_mbar;        // 1 sigma
+};
+
+// Defaults: 4 l hull, 60 cm long, 500 ml syringe over 2200 steps
+extern const FloatPhysicsParams DEFAULT_FLOAT_PHYSICS;
+
+class FloatPhysics {
+public:
+    explicit FloatPhysics(const FloatPhysicsParams& params);
+
+    // Integrate dt_s seconds with the piston at 'piston_steps'.
+    void step(float dt_s, int32_t piston_steps);
+
+    float depthM() const { return depth_; }         // absolute, sensor depth
+    float velocityMps() const { return velocity_; } // + = sinking
+
+    // Absolute pressure at the sensor; noise is a unit normal sample.
+    float pressureMbar(float noise) const;
+
+    // Where the sensor sits when floating at the surface with the piston
+    // at 'piston_steps' (what the surface calibration reads as 0 m).
+    float restingDepthM(int32_t piston_steps) const;
+
+    const FloatPhysicsParams& params() const { return params_; }
+
+private:
+    FloatPhysicsParams params_;
+    float mass_;
+    float depth_;
+    float velocity_;
+};
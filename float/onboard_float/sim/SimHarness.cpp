@@ -0,0 +1,388 @@
+#include "SimHarness.h"
+
+#include <Arduino.h>
+#include <MS5837.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <Preferences.h>
+#include <StepTimer.h>
+#include <LoopbackLink.h>
+#include <FloatTasks.h>
+#include <stdarg.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+
+#include "float_defs.h"
+
+// The firmware's step timer (src/main.cpp)
+extern FakeStepTimer stepTimer;
+
+// Mechanical end stop just past the switch
+static const int32_t PISTON_LIMIT_STEPS = 2200;
+static const int32_t PISTON_HARD_STOP = PISTON_LIMIT_STEPS + 40;
+
+HardwareSerial Serial;
+TwoWire Wire;
+WiFiClass WiFi;
+
+namespace {
+
+struct World {
+    FloatPhysics physics{DEFAULT_FLOAT_PHYSICS};
+    std::mt19937 rng;
+    std::normal_distribution<float> noise{0.0f, 1.0f};
+    std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+    float handling_p = 0;
+    float handling_mbar = 0;
+    uint64_t now_us = 0;
+    uint32_t physics_us = 0;
+    int32_t piston_steps = 0;
+    bool dir_forward = false;
+    bool step_level = false;
+    bool quiet = false;
+    bool held = true;
+    float surface_depth_m = 0;
+    unsigned long sensor_reads = 0;
+    uint32_t submerged_drops = 0;
+    float antenna_reach_m = 0.05f;
+    esp_now_recv_cb_t recv_cb = nullptr;
+    std::vector<sim::RadioPacket> radio;
+    LoopbackLink link;
+    std::mutex radio_mutex;     // two firmware tasks send (--parallel)
+    std::map<std::string, std::vector<uint8_t> > nvs;   // "namespace/key"
+    std::string nvs_path;
+    std::mutex nvs_mutex;
+};
+
+World world;
+
+const uint8_t STATION_MAC[6] = {0xAC, 0xA7, 0x04, 0x29, 0x8F, 0x84};
+
+const int FLOAT_SIDE = 0;
+const int STATION_SIDE = 1;
+
+void floatReceive(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    if (world.recv_cb) world.recv_cb(STATION_MAC, data, (int)len);
+}
+
+}  // namespace
+
+namespace sim {
+
+void begin(const FloatPhysicsParams& params, uint32_t seed, int32_t piston_boot_steps) {
+    world.physics = FloatPhysics(params);
+    world.rng.seed(seed);
+    world.now_us = 0;
+    world.physics_us = 0;
+    world.piston_steps = piston_boot_steps;
+    world.surface_depth_m = world.physics.restingDepthM(0);
+    world.held = true;
+    world.sensor_reads = 0;
+    world.submerged_drops = 0;
+    world.radio.clear();
+    world.link = LoopbackLink(seed);
+    world.link.attach(FLOAT_SIDE, floatReceive, nullptr);
+    // The firmware tasks (lib/FloatTasks) run as threads on this clock
+    floatTasksSetClock(nowUs, advanceUs);
+}
+
+// File format: per entry a length-prefixed name and value
+static void saveNvs() {
+    if (world.nvs_path.empty()) return;
+    FILE* f = fopen(world.nvs_path.c_str(), "wb");
+    if (!f) return;
+    for (const auto& entry : world.nvs) {
+        uint32_t lens[2] = {(uint32_t)entry.first.size(), (uint32_t)entry.second.size()};
+        fwrite(lens, sizeof(lens), 1, f);
+        fwrite(entry.first.data(), 1, lens[0], f);
+        fwrite(entry.second.data(), 1, lens[1], f);
+    }
+    fclose(f);
+}
+
+bool setNvsPath(const char* path) {
+    std::lock_guard<std::mutex> lock(world.nvs_mutex);
+    world.nvs.clear();
+    world.nvs_path = path ? path : "";
+    if (!path) return true;
+    FILE* f = fopen(path, "rb");
+    if (!f) return true;    // first run: empty
+    uint32_t lens[2];
+    bool ok = true;
+    while (fread(lens, sizeof(lens), 1, f) == 1) {
+        std::string name(lens[0], '\0');
+        std::vector<uint8_t> value(lens[1]);
+        if (fread(&name[0], 1, lens[0], f) != lens[0] ||
+            (lens[1] && fread(value.data(), 1, lens[1], f) != lens[1])) {
+            ok = false;
+            break;
+        }
+        world.nvs[name] = value;
+    }
+    fclose(f);
+    return ok;
+}
+
+void setHeld(bool held) { world.held = held; }
+
+void setHandling(float probability, float mbar) {
+    world.handling_p = probability;
+    world.handling_mbar = mbar;
+}
+
+void setQuiet(bool quiet) { world.quiet = quiet; }
+
+uint64_t nowUs() { return world.now_us; }
+
+void advanceUs(uint64_t us) {
+    while (us > 0) {
+        uint32_t chunk = 1000 - world.physics_us;
+        if (chunk > us) chunk = (uint32_t)us;
+        stepTimer.advance(chunk);
+        world.now_us += chunk;
+        world.physics_us += chunk;
+        us -= chunk;
+        world.link.pump(world.now_us);
+        if (world.physics_us >= 1000) {
+            world.physics_us = 0;
+            int32_t steps = world.piston_steps < 0 ? 0 : world.piston_steps;
+            if (world.held) {
+                world.physics = FloatPhysics(world.physics.params());
+            } else {
+                world.physics.step(0.001f, steps);
+            }
+        }
+    }
+}
+
+const FloatPhysics& physics() { return world.physics; }
+int32_t pistonSteps() { return world.piston_steps; }
+
+float relativeDepthM() {
+    return world.physics.depthM() - world.surface_depth_m;
+}
+
+unsigned long sensorReads() { return world.sensor_reads; }
+
+void deliver(const void* data, int len) {
+    if (world.recv_cb) world.recv_cb(STATION_MAC, (const uint8_t*)data, len);
+}
+
+const std::vector<RadioPacket>& radioLog() { return world.radio; }
+
+void setRadioLoss(float probability) { world.link.setLoss(probability); }
+
+void setRadioLatency(uint32_t latency_us, uint32_t jitter_us) {
+    world.link.setLatencyUs(latency_us);
+    world.link.setJitterUs(jitter_us);
+}
+
+void setAntennaReach(float reach_m) { world.antenna_reach_m = reach_m; }
+
+bool antennaSubmerged() {
+    return world.physics.depthM() - world.physics.params().hull_length_m > world.antenna_reach_m;
+}
+
+uint32_t radioSubmergedDrops() { return world.submerged_drops; }
+
+uint32_t radioDropped() {
+    return world.link.dropped(FLOAT_SIDE) + world.link.dropped(STATION_SIDE);
+}
+
+void setStation(StationHandler handler, void* ctx) {
+    world.link.attach(STATION_SIDE, handler, ctx);
+}
+
+void stationSend(const void* data, int len) {
+    if (antennaSubmerged()) {
+        world.submerged_drops++;
+        return;
+    }
+    world.link.send(STATION_SIDE, (const uint8_t*)data, (size_t)len, world.now_us);
+}
+
+}  // namespace sim
+
+// ============================================================================
+// ARDUINO CORE
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin == DIR_PIN) {
+        world.dir_forward = (level == HIGH);
+    } else if (pin == STEP_PIN) {
+        bool rising = (level == HIGH) && !world.step_level;
+        world.step_level = (level == HIGH);
+        if (rising) {
+            world.piston_steps += world.dir_forward ? 1 : -1;
+            if (world.piston_steps > PISTON_HARD_STOP) world.piston_steps = PISTON_HARD_STOP;
+        }
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin == LIMIT_FWD) return world.piston_steps >= PISTON_LIMIT_STEPS ? LOW : HIGH;
+    return HIGH;
+}
+
+unsigned long millis() { return (unsigned long)(world.now_us / 1000); }
+unsigned long micros() { return (unsigned long)world.now_us; }
+// In a firmware task: sleep on the virtual clock. On the main thread (setup,
+// loop): run the tasks and the world forward.
+static void sleepUs(uint64_t us) {
+    if (floatTasksOnTaskThread()) floatTaskSleepUs(us);
+    else floatTasksRunUs(us);
+}
+
+void delay(uint32_t ms) { sleepUs((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { sleepUs(us); }
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (uint32_t)(ns * 240 / 1000);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    if (world.quiet) return 0;
+    return fwrite(data, 1, len, stdout);
+}
+
+size_t HardwareSerial::print(const char* s) {
+    if (world.quiet) return 0;
+    return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+}
+
+size_t HardwareSerial::print(char c) {
+    if (world.quiet) return 0;
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::print(long v) {
+    if (world.quiet) return 0;
+    return (size_t)::printf("%ld", v);
+}
+
+size_t HardwareSerial::print(unsigned long v) {
+    if (world.quiet) return 0;
+    return (size_t)::printf("%lu", v);
+}
+
+size_t HardwareSerial::print(double v, int digits) {
+    if (world.quiet) return 0;
+    return (size_t)::printf("%.*f", digits, v);
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    if (world.quiet) return 0;
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+// ============================================================================
+// PREFERENCES (NVS)
+// ============================================================================
+
+bool Preferences::begin(const char* name, bool read_only, const char* partition_label) {
+    (void)partition_label;
+    name_ = name;
+    read_only_ = read_only;
+    open_ = true;
+    return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!open_ || read_only_) return 0;
+    std::lock_guard<std::mutex> lock(world.nvs_mutex);
+    const uint8_t* bytes = (const uint8_t*)value;
+    world.nvs[name_ + "/" + key].assign(bytes, bytes + len);
+    sim::saveNvs();
+    return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t max_len) {
+    if (!open_) return 0;
+    std::lock_guard<std::mutex> lock(world.nvs_mutex);
+    auto it = world.nvs.find(name_ + "/" + key);
+    if (it == world.nvs.end() || it->second.size() > max_len) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!open_) return 0;
+    std::lock_guard<std::mutex> lock(world.nvs_mutex);
+    auto it = world.nvs.find(name_ + "/" + key);
+    return it == world.nvs.end() ? 0 : it->second.size();
+}
+
+bool Preferences::remove(const char* key) {
+    if (!open_ || read_only_) return false;
+    std::lock_guard<std::mutex> lock(world.nvs_mutex);
+    bool found = world.nvs.erase(name_ + "/" + key) > 0;
+    sim::saveNvs();
+    return found;
+}
+
+// ============================================================================
+// MS5837
+// ============================================================================
+
+// Reset, PROM read and a first conversion
+bool MS5837::init() {
+    delay(20);
+    return true;
+}
+
+void MS5837::read() {
+    world.sensor_reads++;
+    pressure_mbar_ = world.physics.pressureMbar(world.noise(world.rng));
+    if (world.held && world.handling_p > 0 && world.uniform(world.rng) < world.handling_p) {
+        pressure_mbar_ += world.handling_mbar * (2.0f * world.uniform(world.rng) - 1.0f);
+    }
+    temperature_c_ = 18.0f + 0.02f * world.noise(world.rng);
+}
+
+// ============================================================================
+// ESP-NOW
+// ============================================================================
+
+esp_err_t esp_now_init() { return ESP_OK; }
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+    world.recv_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+    (void)peer;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len) {
+    (void)peer_addr;
+    if (len > ESP_NOW_MAX_DATA_LEN) return ESP_FAIL;
+    std::lock_guard<std::mutex> lock(world.radio_mutex);
+    sim::RadioPacket packet;
+    packet.time_us = world.now_us;
+    packet.data.assign(data, data + len);
+    world.radio.push_back(packet);
+    // ESP-NOW reports success either way; the station just never hears it
+    if (sim::antennaSubmerged()) {
+        world.submerged_drops++;
+        return ESP_OK;
+    }
+    world.link.send(FLOAT_SIDE, data, len, world.now_us);
+    return ESP_OK;
+}
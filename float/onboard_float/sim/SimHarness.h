@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "FloatPhysics.h"
+
+// ============================================================================
+// SIMULATOR HARNESS
+// ============================================================================
+// Owns the virtual clock and the simulated world behind the stub headers in
+// sim/stubs: float physics, MS5837 samples, the piston mechanics driven by
+// STEP/DIR edges, the LIMIT_FWD switch and the ESP-NOW link.
+
+namespace sim {
+
+struct RadioPacket {
+    uint64_t time_us;
+    std::vector<uint8_t> data;
+};
+
+// Reset the world. The piston starts at piston_boot_steps in homed
+// coordinates (0 = surface, LIMIT_FWD at PISTON_LIMIT_STEPS), unknown to
+// the firmware until it homes.
+void begin(const FloatPhysicsParams& params, uint32_t seed, int32_t piston_boot_steps);
+
+// While held (boot, on deck) the hull floats at its surface rest depth
+// whatever the piston does. Released at deploy.
+void setHeld(bool held);
+
+// Handling while held: each sensor read is knocked by up to +/-mbar with
+// this probability (waves, the float being moved), 0 by default.
+void setHandling(float probability, float mbar);
+
+// Silence the firmware's Serial output.
+void setQuiet(bool quiet);
+
+uint64_t nowUs();
+
+// Run the world forward: step timer, piston and physics (1 ms steps).
+void advanceUs(uint64_t us);
+
+const FloatPhysics& physics();
+int32_t pistonSteps();
+
+// Depth relative to floating at the surface with the piston at 0,
+// i.e. what a perfect surface calibration would report.
+float relativeDepthM();
+
+// MS5837::read() calls so far (each one is a ~40 ms conversion on hardware).
+unsigned long sensorReads();
+
+// NVS (Preferences) lives in this file across runs; nullptr (the default)
+// keeps it in memory for this run only. Call before setup().
+bool setNvsPath(const char* path);
+
+// Hand a packet to the firmware as if it came from the Control Station.
+void deliver(const void* data, int len);
+
+// Everything the firmware sent over ESP-NOW (before any loss).
+const std::vector<RadioPacket>& radioLog();
+
+// The air between float and station: a seeded LoopbackLink with this
+// frame loss probability, applied in both directions.
+void setRadioLoss(float probability);
+void setRadioLatency(uint32_t latency_us, uint32_t jitter_us);
+uint32_t radioDropped();
+
+// 2.4 GHz does not get through water: frames either way are lost while the
+// top of the hull (the antenna) is deeper than 'reach' (default 5 cm; more
+// for a mast or trailing antenna).
+void setAntennaReach(float reach_m);
+bool antennaSubmerged();
+uint32_t radioSubmergedDrops();
+
+// Frames that make it from the float to the station go to this handler.
+typedef void (*StationHandler)(const uint8_t* data, size_t len, void* ctx);
+void setStation(StationHandler handler, void* ctx);
+
+// Station to float over the lossy link (deliver() is lossless).
+void stationSend(const void* data, int len);
+
+}  // namespace sim
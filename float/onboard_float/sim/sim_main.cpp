@@ -0,0 +1,821 @@
+// ============================================================================
+// FLOAT MISSION SIMULATOR
+// ============================================================================
+// Runs the real firmware (src/main.cpp) against the stubs in sim/stubs and
+// the 1-D physics in FloatPhysics: boot and homing, deploy, the full
+// two-profile mission, then the send_now download over a lossy radio with
+// this program playing the Control Station.
+//
+//   pio run -e native
+//   .pio/build/native/program --quiet --trace trace.csv --log log.csv
+//
+// Prints per-state durations, the live telemetry heard during the dive
+// (--live writes it as CSV), the recovered log and the recovered high-rate
+// trace (--trace-log writes it as CSV); exits non-zero if the mission does
+// not reach MISSION_DONE within --max-time or a download is incomplete.
+//
+// The flash log lives in a file (--flash), so a reset can be rehearsed:
+//   program --flash f.bin --reset-at 60     (power cut 60 s into the dive)
+//   program --flash f.bin --download-only   (reboot, recover, download)
+//
+// NVS is a file too (--nvs), so the neutral-buoyancy map learned in the
+// holds and the parked piston position carry over to the next run like
+// they do across power cycles:
+//   program --nvs nvs.bin && program --nvs nvs.bin   (second mission uses it)
+// The same file keeps where the simulated piston was left (namespace
+// "sim"), which is where the next run boots it unless --boot-steps says
+// otherwise (e.g. moved by hand while off).
+// Each segment reports its settle time: from the start of its travel
+// until the true depth first stays within 1 cm of the target for 5 s.
+//
+// The float waits --idle seconds at the surface after boot (the operator
+// checking the pre-dive packet), then the station sends predive and
+// deploy. The summary shows the surface reference the float tracked
+// meanwhile and the time from deploy to the first piston step; --idle 0
+// deploys before it is ready. --handling P knocks each surface sample by
+// up to 5 cm with probability P, which the tracker should reject.
+//
+// --profiles N uploads an N-profile segment table with deploy instead of
+// the classic two profiles. --replay FILE runs only the mission executor
+// over a recorded depth trace (--trace-log output, or a float trace
+// captured from the station) and checks its transitions against the
+// recorded ones:
+//   program --replay tracelog.csv [--fd M] [--sd M] [--hold S] [--profiles N]
+//
+// Every run scores the downloaded log the way the judge does (in-band
+// packets per hold, MissionCompliance.h) and fails if a hold is not met;
+// --check-log does the same for a log CSV saved earlier (--log output):
+//   program --check-log log.csv [--fd M] [--sd M] [--hold S] [--profiles N]
+//
+// The firmware tasks run as threads on the virtual clock, one at a time so
+// a seed always gives the same run. --parallel lets tasks that are due at
+// the same instant overlap (build with -fsanitize=thread to hunt races).
+//
+// The native build has the hot-path probes in (-DFLOAT_PROBES): the report
+// the float sends after its log is summarised here and --probes writes it
+// as CSV, in microseconds of host time, to compare runs across changes.
+
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <CompactLog.h>
+#include <FloatProbe.h>
+#include <LogLink.h>
+#include <MissionCompliance.h>
+#include <MissionExecutor.h>
+#include <NeutralMap.h>
+#include <Telemetry.h>
+#include <TraceLog.h>
+
+#include <FlashRingLog.h>
+#include <Preferences.h>
+#include <FloatTasks.h>
+
+#include "SimHarness.h"
+#include "float_defs.h"
+
+// Firmware entry points and state (src/main.cpp)
+void setup();
+void loop();
+extern MissionState currentState;
+extern MissionExecutor mission;
+extern FileFlash logFlash;
+extern FlashRingLog missionLog;
+extern uint32_t telemetry_sent;
+extern uint32_t telemetry_dropped;
+extern JitterStats samplePeriodJitter;
+extern JitterStats controlLatency;
+extern NeutralMap neutralMap;
+
+static const size_t SIM_FLASH_BYTES = 0x160000;     // floatlog in partitions.csv
+
+static const int STATE_COUNT = MISSION_DONE + 1;
+
+// Settled: within SETTLE_BAND_M of the target for SETTLE_HOLD_US
+static const float SETTLE_BAND_M = 0.01f;
+static const uint64_t SETTLE_HOLD_US = 5000000;
+
+struct Options {
+    uint32_t seed = 1;
+    int32_t piston_boot_steps = 700;
+    bool boot_steps_given = false;
+    float target_fd = 2.5f;
+    float target_sd = 0.4f;
+    int hold_s = 30;
+    float max_time_s = 1800.0f;
+    const char* trace_path = nullptr;
+    const char* log_path = nullptr;
+    const char* trace_log_path = nullptr;
+    float radio_loss = 0.0f;
+    float radio_latency_ms = 1.0f;
+    float radio_jitter_ms = 0.0f;
+    float antenna_reach_m = 0.05f;
+    const char* live_path = nullptr;
+    const char* probes_path = nullptr;
+    int profiles = 0;                   // 0: classic deploy, no table
+    float idle_s = 3.0f;                // at the surface between boot and deploy
+    float handling = 0;                 // surface sample knock probability
+    const char* replay_path = nullptr;
+    const char* check_log_path = nullptr;
+    const char* flash_path = nullptr;
+    const char* nvs_path = nullptr;
+    float reset_at_s = 0;
+    bool download_only = false;
+    bool parallel = false;
+    bool quiet = false;
+};
+
+// ============================================================================
+// CONTROL STATION SIDE OF THE DOWNLOAD
+// ============================================================================
+
+// Segments are decoded as they arrive, like the real station
+struct Station {
+    FILE* log = nullptr;
+    FILE* trace = nullptr;
+    FILE* live = nullptr;
+    FILE* probes = nullptr;
+    TelemetryStats live_stats;
+    uint32_t live_by_state[STATE_COUNT] = {0};
+    std::vector<LogSample> packets;     // the downloaded log, for the compliance check
+    struct_predive predive;
+    bool predive_heard = false;
+};
+
+static Station station;
+
+static void onSample(const compact_log_header& header, const LogSample& sample, void* ctx) {
+    (void)ctx;
+    station.packets.push_back(sample);
+    if (station.log) {
+        fprintf(station.log, "%.10s,%.2f,%.2f,%.3f,%.2f\n", header.company_id,
+                sample.time_ms / 1000.0, sample.pressure_kpa, sample.depth_m, sample.temp_c);
+    }
+}
+
+static CompactLogStreamReader logDecoder(onSample, nullptr);
+
+static void onLogBytes(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    logDecoder.feed(data, len);
+}
+
+static LogLinkReceiver logReceiver(STREAM_MISSION_LOG, onLogBytes, nullptr);
+
+static void onTraceRecord(const trace_log_header& header, const trace_record& r, void* ctx) {
+    (void)header;
+    (void)ctx;
+    if (station.trace) {
+        fprintf(station.trace, "%.3f,%s,%u,%.3f,%.3f,%.3f,%d,%d\n", r.time_ms / 1000.0,
+                missionStateName((MissionState)r.state), r.segment + 1, r.depth_mm / 1000.0,
+                r.measured_mm / 1000.0, r.velocity_mm_s / 1000.0, r.piston, r.piston_target);
+    }
+}
+
+static TraceStreamReader traceDecoder(onTraceRecord, nullptr);
+
+static void onTraceBytes(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    traceDecoder.feed(data, len);
+}
+
+static LogLinkReceiver traceReceiver(STREAM_TRACE, onTraceBytes, nullptr);
+
+static uint32_t probe_overruns = 0;
+
+static void onProbeEntry(const probe_report_header& header, const probe_report_entry& e, void* ctx) {
+    (void)ctx;
+    if (e.state == PROBE_ALL_STATES) probe_overruns += e.overruns;
+    if (station.probes) {
+        double mhz = header.cpu_mhz;
+        fprintf(station.probes, "%s,%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u\n", probeSectionName(e.section),
+                e.state == PROBE_ALL_STATES ? "all" : missionStateName((MissionState)e.state), e.count,
+                e.min_cycles / mhz, e.mean_cycles / mhz, e.p50_cycles / mhz, e.p99_cycles / mhz,
+                e.max_cycles / mhz, e.budget_cycles / mhz, e.overruns);
+    }
+}
+
+static ProbeReportReader probeDecoder(onProbeEntry, nullptr);
+
+static void onProbeBytes(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    probeDecoder.feed(data, len);
+}
+
+static LogLinkReceiver probeReceiver(STREAM_PROBES, onProbeBytes, nullptr);
+
+static void onTelemetry(const link_telemetry_frame& frame) {
+    uint32_t rx_ms = (uint32_t)(sim::nowUs() / 1000);
+    station.live_stats.onFrame(frame, rx_ms);
+    if (frame.state < STATE_COUNT) station.live_by_state[frame.state]++;
+    if (station.live) {
+        // One clock in the simulator, so the offset is the true latency
+        fprintf(station.live, "%.3f,%u,%s,%u,%.3f,%.3f,%d,%d\n", rx_ms / 1000.0, frame.seq,
+                missionStateName((MissionState)frame.state), frame.hold_packets,
+                frame.depth_mm / 1000.0, frame.velocity_mm_s / 1000.0, frame.piston,
+                (int)(rx_ms - frame.sent_ms));
+    }
+}
+
+static void stationReceive(const uint8_t* data, size_t len, void* ctx) {
+    (void)ctx;
+    if (len == sizeof(struct_predive) && !isLinkFrame(data, (int)len)) {
+        memcpy(&station.predive, data, sizeof(station.predive));
+        station.predive_heard = true;
+        return;
+    }
+    if (!isLinkFrame(data, (int)len)) return;
+    if (data[0] == LINK_TELEMETRY) {
+        if (len != sizeof(link_telemetry_frame)) return;
+        link_telemetry_frame frame;
+        memcpy(&frame, data, sizeof(frame));
+        onTelemetry(frame);
+        return;
+    }
+    link_ack_frame ack;
+    if (logReceiver.onFrame(data, len, ack) || traceReceiver.onFrame(data, len, ack) ||
+        probeReceiver.onFrame(data, len, ack)) {
+        sim::stationSend(&ack, sizeof(ack));
+    }
+}
+
+struct DownloadResult {
+    double seconds;
+    int presses;
+    size_t frames;
+    uint32_t dropped;
+};
+
+// Control Station: send 'cmd' over the lossy link, pressed again every few
+// seconds (as an operator would) until 'receiver' is complete
+static DownloadResult download(const char* cmd, LogLinkReceiver& receiver) {
+    DownloadResult result = {};
+    size_t radio_before = sim::radioLog().size();
+    uint32_t dropped_before = sim::radioDropped();
+    uint64_t request_us = sim::nowUs();
+    uint64_t end_us = request_us + 60000000;
+    uint64_t next_press_us = request_us;
+    while (sim::nowUs() < end_us && !receiver.complete()) {
+        if (sim::nowUs() >= next_press_us) {
+            struct_command request = {};
+            strcpy(request.cmd, cmd);
+            sim::stationSend(&request, sizeof(request));
+            result.presses++;
+            next_press_us = sim::nowUs() + 6000000;
+        }
+        loop();
+    }
+    result.seconds = (sim::nowUs() - request_us) / 1e6;
+    // Let the float see the final ACK
+    uint64_t settle_us = sim::nowUs() + 500000;
+    while (sim::nowUs() < settle_us) loop();
+    result.frames = sim::radioLog().size() - radio_before;
+    result.dropped = sim::radioDropped() - dropped_before;
+    return result;
+}
+
+// --profiles N: fd, sd repeated N times, judged like the classic mission
+static void buildPlan(const Options& opt, MissionPlan& plan) {
+    missionPlanTwoProfiles(plan, opt.target_fd, opt.hold_s, opt.target_sd, opt.hold_s, 0, 0);
+    if (opt.profiles > 0) {
+        plan.count = (uint8_t)(2 * opt.profiles);
+        for (int i = 0; i < plan.count; i++) {
+            plan.segments[i] = missionSegment(i % 2 ? opt.target_sd : opt.target_fd, opt.hold_s, 0);
+        }
+    }
+}
+
+// ============================================================================
+// REPLAY
+// ============================================================================
+
+static MissionState replayState(MissionPhase phase) {
+    switch (phase) {
+        case PHASE_TRAVEL:    return TRAVEL;
+        case PHASE_HOLD:      return HOLD;
+        case PHASE_SURFACING: return SURFACING;
+        default:              return MISSION_DONE;
+    }
+}
+
+// Column index of 'name' in a CSV header line, or -1
+static int csvColumn(const char* header, const char* name) {
+    int col = 0;
+    size_t n = strlen(name);
+    for (const char* p = header; *p; col++) {
+        if (!strncmp(p, name, n) && (p[n] == ',' || p[n] == '\n' || p[n] == '\r' || !p[n])) return col;
+        p = strchr(p, ',');
+        if (!p) break;
+        p++;
+    }
+    return -1;
+}
+
+// The executor is in the recorded state (and segment, while it has one)
+static bool replayMatches(const MissionExecutor& executor, const char* state, unsigned segment) {
+    bool seg_matters = executor.phase() == PHASE_TRAVEL || executor.phase() == PHASE_HOLD;
+    return !strcmp(missionStateName(replayState(executor.phase())), state) &&
+           (!seg_matters || (unsigned)executor.segmentIndex() + 1 == segment);
+}
+
+// Feed a recorded depth trace through the executor, one row per sample.
+// Rows with a recorded state and segment are checked against the
+// executor's; the exit code is non-zero on any mismatch or if the plan
+// does not finish. The trace keeps depth to the millimetre, and a sample
+// within rounding of the arrive band edge can enter a hold (and so leave
+// it) a sample or more before or after the float did. Two more executors
+// therefore run on the depths 0.5 mm shallower and deeper, and a row is a
+// mismatch only if none of the three is in the recorded state.
+static int replay(const Options& opt) {
+    FILE* f = fopen(opt.replay_path, "r");
+    if (!f) { perror(opt.replay_path); return 2; }
+    char line[512];
+    if (!fgets(line, sizeof(line), f)) { fclose(f); return 2; }
+    int col_t = csvColumn(line, "t_s");
+    int col_depth = csvColumn(line, "depth_m");
+    int col_measured = csvColumn(line, "measured_m");     // what the float logs, if recorded
+    int col_state = csvColumn(line, "state");
+    int col_segment = csvColumn(line, "segment");
+    if (col_t < 0 || col_depth < 0) {
+        fprintf(stderr, "%s: needs t_s and depth_m columns\n", opt.replay_path);
+        fclose(f);
+        return 2;
+    }
+
+    MissionPlan plan;
+    buildPlan(opt, plan);
+    static const float rounding_m[3] = {0.0f, -0.0005f, 0.0005f};
+    MissionExecutor executors[3] = {MissionExecutor(5000), MissionExecutor(5000), MissionExecutor(5000)};
+    MissionExecutor& executor = executors[0];
+    for (MissionExecutor& e : executors) {
+        if (!e.load(plan)) { fprintf(stderr, "invalid plan\n"); fclose(f); return 2; }
+    }
+
+    unsigned long rows = 0, checked = 0, mismatches = 0;
+    bool started = false;
+    while (fgets(line, sizeof(line), f)) {
+        char* fields[16];
+        int n = 0;
+        for (char* p = strtok(line, ",\r\n"); p && n < 16; p = strtok(nullptr, ",\r\n")) fields[n++] = p;
+        if (n <= col_t || n <= col_depth) continue;
+        uint32_t t_ms = (uint32_t)(atof(fields[col_t]) * 1000.0 + 0.5);
+        float depth = (float)atof(fields[col_depth]);
+        if (depth < 0) depth = 0;
+        float logged = col_measured >= 0 && n > col_measured ? (float)atof(fields[col_measured]) : depth;
+        if (logged < 0) logged = 0;
+        bool changed = false;
+        rows++;
+        for (int k = 0; k < 3; k++) {
+            MissionExecutor& e = executors[k];
+            float d = depth + rounding_m[k] < 0 ? 0 : depth + rounding_m[k];
+            float l = logged + rounding_m[k] < 0 ? 0 : logged + rounding_m[k];
+            if (!started) {
+                e.start(t_ms);
+                e.onPacket(l, t_ms);
+            }
+            bool c = e.update(d, t_ms);
+            if (e.packetDue(t_ms)) c |= e.onPacket(l, t_ms);
+            if (k == 0) changed = c;
+        }
+        started = true;
+        if (changed) {
+            if (executor.phase() == PHASE_TRAVEL || executor.phase() == PHASE_HOLD) {
+                printf("%9.3f s  segment %u/%u  %s\n", t_ms / 1000.0, executor.segmentIndex() + 1,
+                       executor.segmentCount(), missionStateName(replayState(executor.phase())));
+            } else {
+                printf("%9.3f s  %s\n", t_ms / 1000.0, missionStateName(replayState(executor.phase())));
+            }
+        }
+        if (col_state >= 0 && col_segment >= 0 && n > col_state && n > col_segment) {
+            const char* got = missionStateName(replayState(executor.phase()));
+            unsigned seg = (unsigned)atoi(fields[col_segment]);
+            checked++;
+            if (!replayMatches(executors[0], fields[col_state], seg) &&
+                !replayMatches(executors[1], fields[col_state], seg) &&
+                !replayMatches(executors[2], fields[col_state], seg)) {
+                if (mismatches < 10) {
+                    printf("  MISMATCH at %.3f s: recorded %s/%u, replay %s/%u\n", t_ms / 1000.0,
+                           fields[col_state], seg, got, executor.segmentIndex() + 1);
+                }
+                mismatches++;
+            }
+        }
+    }
+    fclose(f);
+
+    bool finished = executor.phase() == PHASE_SURFACING || executor.phase() == PHASE_DONE;
+    printf("Replay: %lu samples, plan of %u segments %s, %lu rows checked, %lu mismatches\n",
+           rows, executor.segmentCount(), finished ? "completed" : "NOT completed", checked, mismatches);
+    return (finished && mismatches == 0) ? 0 : 1;
+}
+
+// ============================================================================
+// HOLD COMPLIANCE
+// ============================================================================
+
+// Score logged packets against the plan; true if every hold was met
+static bool reportCompliance(const MissionPlan& plan, const std::vector<LogSample>& packets) {
+    MissionCompliance compliance(plan, 5000);
+    for (const LogSample& p : packets) compliance.addPacket(p.time_ms, p.depth_m);
+    printf("Hold compliance (from %zu logged packets): %u of %u holds met\n", packets.size(),
+           compliance.holdsMet(), compliance.segmentCount());
+    for (int i = 0; i < compliance.segmentCount(); i++) {
+        const hold_compliance& h = compliance.hold(i);
+        printf("  segment %d %5.2f m  ", i + 1, plan.segments[i].target_mm / 1000.0);
+        if (!h.packets) {
+            printf("NOT MET: no packet in the band\n");
+            continue;
+        }
+        printf("%s %u packets %.1f..%.1f s (%.0f s), max error %.3f m\n", h.met ? "met:" : "NOT MET, best run",
+               h.packets, h.first_ms / 1000.0, h.last_ms / 1000.0, (h.last_ms - h.first_ms) / 1000.0,
+               h.max_error_m);
+    }
+    return compliance.complete();
+}
+
+// --check-log: a log CSV as written by --log
+static int checkLog(const Options& opt) {
+    FILE* f = fopen(opt.check_log_path, "r");
+    if (!f) { perror(opt.check_log_path); return 2; }
+    char line[512];
+    if (!fgets(line, sizeof(line), f)) { fclose(f); return 2; }
+    int col_t = csvColumn(line, "timestamp_s");
+    int col_depth = csvColumn(line, "depth_m");
+    if (col_t < 0 || col_depth < 0) {
+        fprintf(stderr, "%s: needs timestamp_s and depth_m columns\n", opt.check_log_path);
+        fclose(f);
+        return 2;
+    }
+    std::vector<LogSample> packets;
+    while (fgets(line, sizeof(line), f)) {
+        char* fields[16];
+        int n = 0;
+        for (char* p = strtok(line, ",\r\n"); p && n < 16; p = strtok(nullptr, ",\r\n")) fields[n++] = p;
+        if (n <= col_t || n <= col_depth) continue;
+        LogSample p = {};
+        p.time_ms = (uint32_t)(atof(fields[col_t]) * 1000.0 + 0.5);
+        p.depth_m = (float)atof(fields[col_depth]);
+        packets.push_back(p);
+    }
+    fclose(f);
+
+    MissionPlan plan;
+    buildPlan(opt, plan);
+    return reportCompliance(plan, packets) ? 0 : 1;
+}
+
+// Where the simulated piston was left by the last run with this NVS file
+static void loadPistonFromNvs(Options& opt) {
+    Preferences world;
+    int32_t steps;
+    if (!opt.boot_steps_given && world.begin("sim", true) &&
+        world.getBytes("piston", &steps, sizeof(steps)) == sizeof(steps)) {
+        opt.piston_boot_steps = steps;
+    }
+    world.end();
+}
+
+static void savePistonToNvs() {
+    Preferences world;
+    int32_t steps = sim::pistonSteps();
+    if (world.begin("sim", false)) world.putBytes("piston", &steps, sizeof(steps));
+    world.end();
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: program [--seed N] [--boot-steps N] [--fd M] [--sd M] [--hold S]\n"
+            "               [--max-time S] [--radio-loss P] [--trace FILE] [--log FILE]\n"
+            "               [--trace-log FILE] [--live FILE] [--radio-latency MS]\n"
+            "               [--radio-jitter MS] [--antenna-reach M] [--profiles N]\n"
+            "               [--idle S] [--handling P]\n"
+            "       program --replay FILE | --check-log FILE [--fd M] [--sd M] [--hold S] [--profiles N]\n"
+            "               [--flash FILE] [--nvs FILE] [--reset-at S] [--download-only] [--parallel]\n"
+            "               [--probes FILE] [--quiet]\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (!strcmp(a, "--quiet")) opt.quiet = true;
+        else if (!strcmp(a, "--download-only")) opt.download_only = true;
+        else if (!strcmp(a, "--parallel")) opt.parallel = true;
+        else if (!strcmp(a, "--flash") && has_value) opt.flash_path = argv[++i];
+        else if (!strcmp(a, "--nvs") && has_value) opt.nvs_path = argv[++i];
+        else if (!strcmp(a, "--reset-at") && has_value) opt.reset_at_s = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--seed") && has_value) opt.seed = (uint32_t)atol(argv[++i]);
+        else if (!strcmp(a, "--boot-steps") && has_value) {
+            opt.piston_boot_steps = atoi(argv[++i]);
+            opt.boot_steps_given = true;
+        }
+        else if (!strcmp(a, "--fd") && has_value) opt.target_fd = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--sd") && has_value) opt.target_sd = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--hold") && has_value) opt.hold_s = atoi(argv[++i]);
+        else if (!strcmp(a, "--max-time") && has_value) opt.max_time_s = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--radio-loss") && has_value) opt.radio_loss = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--trace") && has_value) opt.trace_path = argv[++i];
+        else if (!strcmp(a, "--log") && has_value) opt.log_path = argv[++i];
+        else if (!strcmp(a, "--trace-log") && has_value) opt.trace_log_path = argv[++i];
+        else if (!strcmp(a, "--live") && has_value) opt.live_path = argv[++i];
+        else if (!strcmp(a, "--probes") && has_value) opt.probes_path = argv[++i];
+        else if (!strcmp(a, "--profiles") && has_value) opt.profiles = atoi(argv[++i]);
+        else if (!strcmp(a, "--idle") && has_value) opt.idle_s = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--handling") && has_value) opt.handling = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--replay") && has_value) opt.replay_path = argv[++i];
+        else if (!strcmp(a, "--check-log") && has_value) opt.check_log_path = argv[++i];
+        else if (!strcmp(a, "--radio-latency") && has_value) opt.radio_latency_ms = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--radio-jitter") && has_value) opt.radio_jitter_ms = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--antenna-reach") && has_value) opt.antenna_reach_m = (float)atof(argv[++i]);
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt) || opt.profiles * 2 > MISSION_MAX_SEGMENTS) {
+        usage();
+        return 2;
+    }
+    if (opt.replay_path) return replay(opt);
+    if (opt.check_log_path) return checkLog(opt);
+
+    FILE* trace = nullptr;
+    if (opt.trace_path) {
+        trace = fopen(opt.trace_path, "w");
+        if (!trace) { perror(opt.trace_path); return 2; }
+        fprintf(trace, "t_s,state,segment,depth_m,velocity_mps,piston_steps\n");
+    }
+
+    if (opt.log_path) {
+        station.log = fopen(opt.log_path, "w");
+        if (!station.log) { perror(opt.log_path); return 2; }
+        fprintf(station.log, "company_id,timestamp_s,pressure_kpa,depth_m,temp_c\n");
+    }
+    if (opt.trace_log_path) {
+        station.trace = fopen(opt.trace_log_path, "w");
+        if (!station.trace) { perror(opt.trace_log_path); return 2; }
+        fprintf(station.trace, "t_s,state,segment,depth_m,measured_m,velocity_mps,piston_steps,piston_target\n");
+    }
+    if (opt.live_path) {
+        station.live = fopen(opt.live_path, "w");
+        if (!station.live) { perror(opt.live_path); return 2; }
+        fprintf(station.live, "rx_s,seq,state,hold_packets,depth_m,velocity_mps,piston_steps,latency_ms\n");
+    }
+    if (opt.probes_path) {
+        station.probes = fopen(opt.probes_path, "w");
+        if (!station.probes) { perror(opt.probes_path); return 2; }
+        fprintf(station.probes, "section,state,count,min_us,mean_us,p50_us,p99_us,max_us,budget_us,overruns\n");
+    }
+    if (!logFlash.open(opt.flash_path, SIM_FLASH_BYTES)) {
+        perror(opt.flash_path ? opt.flash_path : "tmpfile");
+        return 2;
+    }
+
+    if (!sim::setNvsPath(opt.nvs_path)) {
+        fprintf(stderr, "%s: not an NVS file from this simulator\n", opt.nvs_path);
+        return 2;
+    }
+    loadPistonFromNvs(opt);
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    sim::begin(DEFAULT_FLOAT_PHYSICS, opt.seed, opt.piston_boot_steps);
+    sim::setQuiet(opt.quiet);
+    sim::setRadioLoss(opt.radio_loss);
+    sim::setRadioLatency((uint32_t)(opt.radio_latency_ms * 1000), (uint32_t)(opt.radio_jitter_ms * 1000));
+    sim::setAntennaReach(opt.antenna_reach_m);
+    sim::setHandling(opt.handling, 5.0f);
+    sim::setStation(stationReceive, nullptr);
+    floatTasksSetParallel(opt.parallel);
+    setup();
+    uint64_t boot_us = sim::nowUs();
+
+    uint64_t deploy_us = 0;
+    uint64_t mission_us = 0;
+    unsigned long reads_at_deploy = 0;
+    unsigned long mission_reads = 0;
+    unsigned long loops = 0;
+    uint64_t state_us[STATE_COUNT] = {0};
+    uint64_t segment_us[MISSION_MAX_SEGMENTS][2] = {{0}};   // travel, hold
+    uint64_t settle_us[MISSION_MAX_SEGMENTS] = {0};         // 0 = never settled
+    float map_surface_before = neutralMap.surfaceSteps();
+    float map_per_m_before = neutralMap.stepsPerM();
+    uint32_t map_holds_before = neutralMap.holds();
+    bool done = opt.download_only;
+
+    uint64_t first_move_us = 0;
+    if (!opt.download_only) {
+        // Control Station: wait at the surface, pre-dive check, deploy
+        uint64_t predive_us = boot_us + (uint64_t)(opt.idle_s * 1e6f);
+        while (sim::nowUs() < predive_us) loop();
+        if (opt.idle_s > 0) {
+            struct_command predive = {};
+            strcpy(predive.cmd, "predive");
+            strcpy(predive.company_id, "SIM");
+            sim::deliver(&predive, sizeof(predive));
+            uint64_t reply_us = sim::nowUs() + 100000;
+            while (sim::nowUs() < reply_us && !station.predive_heard) loop();
+        }
+
+        struct_command cmd = {};
+        strcpy(cmd.cmd, "deploy");
+        strcpy(cmd.company_id, "SIM");
+        cmd.target_fd = opt.target_fd;
+        cmd.target_sd = opt.target_sd;
+        cmd.fdt = opt.hold_s;
+        cmd.sdt = opt.hold_s;
+        if (opt.profiles > 0) {
+            MissionPlan plan;
+            buildPlan(opt, plan);
+            cmd.segment_count = plan.count;
+            cmd.surface_offset_mm = plan.surface_offset_mm;
+            memcpy(cmd.segments, plan.segments, sizeof(cmd.segments));
+        }
+        sim::deliver(&cmd, sizeof(cmd));
+        sim::setHeld(false);
+
+        deploy_us = sim::nowUs();
+        reads_at_deploy = sim::sensorReads();
+        MissionState state = currentState;
+        int32_t steps_at_deploy = sim::pistonSteps();
+        uint8_t segment = mission.segmentIndex();
+        uint64_t state_start_us = deploy_us;
+        uint64_t segment_start_us = 0;
+        uint64_t in_band_since_us = 0;
+        uint64_t next_trace_us = deploy_us;
+        uint64_t max_us = deploy_us + (uint64_t)(opt.max_time_s * 1e6f);
+        uint64_t reset_us = opt.reset_at_s > 0 ? deploy_us + (uint64_t)(opt.reset_at_s * 1e6f) : 0;
+
+        while (currentState != MISSION_DONE && sim::nowUs() < max_us) {
+            if (reset_us && sim::nowUs() >= reset_us) {
+                // Power cut a few bytes into programming the staged page
+                logFlash.setWriteBudget(sizeof(flash_page_header) + 8);
+                missionLog.sync();
+                printf("\n=== POWER CUT at %.1f s in %s: %u entries logged, flash log session %u ===\n",
+                       opt.reset_at_s, missionStateName(currentState),
+                       missionLog.sessionEntries(), missionLog.session());
+                if (station.log) fclose(station.log);
+                if (station.trace) fclose(station.trace);
+                if (station.live) fclose(station.live);
+                savePistonToNvs();
+                return 3;
+            }
+            loop();
+            loops++;
+            uint64_t now_us = sim::nowUs();
+            if (!first_move_us && sim::pistonSteps() != steps_at_deploy) first_move_us = now_us;
+            if ((currentState == TRAVEL || currentState == HOLD) &&
+                (mission.segmentIndex() != segment || !segment_start_us)) {
+                segment_start_us = now_us;
+                in_band_since_us = 0;
+            }
+            if ((currentState == TRAVEL || currentState == HOLD) && !settle_us[mission.segmentIndex()]) {
+                if (fabsf(sim::relativeDepthM() - mission.targetDepth()) > SETTLE_BAND_M) {
+                    in_band_since_us = 0;
+                } else if (!in_band_since_us) {
+                    in_band_since_us = now_us;
+                } else if (now_us - in_band_since_us >= SETTLE_HOLD_US) {
+                    settle_us[mission.segmentIndex()] = in_band_since_us - segment_start_us + 1;
+                }
+            }
+            if (currentState != state || mission.segmentIndex() != segment) {
+                if (state == TRAVEL || state == HOLD) {
+                    segment_us[segment][state == HOLD] += now_us - state_start_us;
+                }
+                state_us[state] += now_us - state_start_us;
+                state = currentState;
+                segment = mission.segmentIndex();
+                state_start_us = now_us;
+            }
+            if (trace && now_us >= next_trace_us) {
+                fprintf(trace, "%.2f,%s,%u,%.4f,%.4f,%d\n",
+                        (now_us - deploy_us) / 1e6, missionStateName(currentState),
+                        mission.segmentIndex() + 1,
+                        sim::relativeDepthM(), sim::physics().velocityMps(), sim::pistonSteps());
+                next_trace_us += 100000;
+            }
+        }
+        state_us[state] += sim::nowUs() - state_start_us;
+        mission_us = sim::nowUs() - deploy_us;
+        mission_reads = sim::sensorReads() - reads_at_deploy;
+        done = (currentState == MISSION_DONE);
+    }
+
+    DownloadResult log_dl = download("send_now", logReceiver);
+    bool log_ok = logReceiver.complete() && logDecoder.badSegments() == 0;
+
+    // The probe report follows the log by itself; ask again if it stalls
+    DownloadResult probe_dl = {};
+    bool probes_ok = true;
+#if defined(FLOAT_PROBES)
+    uint64_t probe_wait_us = sim::nowUs() + 3000000;
+    while (sim::nowUs() < probe_wait_us && !probeReceiver.complete()) loop();
+    if (!probeReceiver.complete()) probe_dl = download("send_probes", probeReceiver);
+    probes_ok = probeReceiver.complete() && !probeDecoder.corrupt() &&
+                probeDecoder.entries() == probeDecoder.header().entry_count;
+#endif
+
+    // The trace is in RAM only: nothing to fetch after a reset
+    DownloadResult trace_dl = {};
+    bool trace_ok = true;
+    if (!opt.download_only) {
+        trace_dl = download("send_trace", traceReceiver);
+        trace_ok = traceReceiver.complete() && !traceDecoder.corrupt() &&
+                   traceDecoder.records() == traceDecoder.header().record_count;
+    }
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    double sim_s = sim::nowUs() / 1e6;
+
+    printf("\n=== SIMULATION SUMMARY (seed %u) ===\n", opt.seed);
+    printf("Boot to FLOAT READY: %.2f s (piston booted at %d steps)\n", boot_us / 1e6, opt.piston_boot_steps);
+    if (!opt.download_only) {
+        if (station.predive_heard) {
+            const struct_predive& p = station.predive;
+            printf("Pre-dive packet at %.1f s: surface %.3f kPa, sd %.1f Pa over %u samples (%u outliers)\n",
+                   (boot_us / 1e6) + opt.idle_s, p.surface_kpa, sqrtf(p.surface_var_pa2),
+                   p.surface_samples, p.surface_outliers);
+        }
+        printf("Deploy to first piston step: %.0f ms\n",
+               first_move_us ? (first_move_us - deploy_us) / 1000.0 : -1.0);
+        printf("  %-16s %8.2f s\n", "IDLE", state_us[IDLE] / 1e6);
+        printf("  %-16s %8.2f s\n", "CALIBRATING", state_us[CALIBRATING] / 1e6);
+        for (int i = 0; i < mission.segmentCount(); i++) {
+            printf("  segment %d %5.2f m  travel %6.2f s, hold %6.2f s, ", i + 1,
+                   mission.plan().segments[i].target_mm / 1000.0,
+                   segment_us[i][0] / 1e6, segment_us[i][1] / 1e6);
+            if (settle_us[i]) printf("settled in %6.2f s\n", (settle_us[i] - 1) / 1e6);
+            else printf("never settled\n");
+        }
+        printf("  %-16s %8.2f s\n", "SURFACING", state_us[SURFACING] / 1e6);
+        printf("Mission (deploy to MISSION_DONE): %.2f s%s\n", mission_us / 1e6,
+               done ? "" : "  ** TIMED OUT **");
+        printf("Neutral map: %.0f steps at 0 m, %+.1f steps/m at deploy; %.0f, %+.1f after %u hold%s "
+               "(%u in total, %u missions)\n",
+               map_surface_before, map_per_m_before, neutralMap.surfaceSteps(), neutralMap.stepsPerM(),
+               neutralMap.holds() - map_holds_before, neutralMap.holds() - map_holds_before == 1 ? "" : "s",
+               neutralMap.holds(), neutralMap.missions());
+        printf("Sensor reads: %lu (%.2f per loop, %.1f per s)\n", mission_reads,
+               loops ? (double)mission_reads / loops : 0.0,
+               mission_us ? mission_reads / (mission_us / 1e6) : 0.0);
+        // Period error is on the virtual clock (0 unless the sampler is
+        // late); the latency is host time, thread wake-up included
+        printf("Tasks%s: sample period error max %+d us; sample to control done mean %.0f us, max %d us (%u over %u us)\n",
+               opt.parallel ? " (parallel)" : "", samplePeriodJitter.max(), controlLatency.mean(),
+               controlLatency.max(), controlLatency.overBound(), controlLatency.bound());
+    }
+    if (!opt.download_only) {
+        const TelemetryStats& live = station.live_stats;
+        printf("Live telemetry: %u frames heard of %u sent (%u refused by the radio), %u lost in the air (%.0f%%), %u late\n",
+               live.received(), telemetry_sent, telemetry_dropped, live.lost(),
+               live.lossRatio() * 100.0f, live.late());
+        printf("  latency %d ms fastest, +%u ms mean, +%u ms max; longest silence %.1f s\n",
+               live.minOffsetMs(), live.meanDelayMs(), live.maxDelayMs(), live.longestGapMs() / 1000.0);
+        printf("  heard in:");
+        for (int s = IDLE; s <= MISSION_DONE; s++) {
+            if (station.live_by_state[s]) printf(" %s %u", missionStateName((MissionState)s), station.live_by_state[s]);
+        }
+        printf("\n  %u frames lost to the water (antenna reach %.2f m)\n",
+               sim::radioSubmergedDrops(), opt.antenna_reach_m);
+    }
+    printf("Log download: %u entries in %u segments (%u bad), %s in %.2f s (%d request%s)\n",
+           logDecoder.samples(), logDecoder.segments(), logDecoder.badSegments(),
+           log_ok ? "complete" : "INCOMPLETE", log_dl.seconds,
+           log_dl.presses, log_dl.presses == 1 ? "" : "s");
+    printf("  %zu frames from the float, %u dropped (both ways, %.0f%% loss), %u duplicates\n",
+           log_dl.frames, log_dl.dropped, opt.radio_loss * 100.0f, logReceiver.duplicates());
+    if (!opt.download_only) {
+        printf("Trace download: %u records at %u ms (%u overwritten), %s in %.2f s (%d request%s)\n",
+               traceDecoder.records(), traceDecoder.header().period_ms,
+               traceDecoder.header().overwritten, trace_ok ? "complete" : "INCOMPLETE",
+               trace_dl.seconds, trace_dl.presses, trace_dl.presses == 1 ? "" : "s");
+        printf("  %zu frames from the float, %u dropped, %u duplicates\n",
+               trace_dl.frames, trace_dl.dropped, traceReceiver.duplicates());
+    }
+#if defined(FLOAT_PROBES)
+    printf("Probe report: %u entries, %u overruns, %s (%d extra request%s)\n",
+           probeDecoder.entries(), probe_overruns, probes_ok ? "complete" : "INCOMPLETE",
+           probe_dl.presses, probe_dl.presses == 1 ? "" : "s");
+#endif
+    // A log cut short by a reset is scored too, but only a full run fails on it
+    MissionPlan judged_plan;
+    if (opt.download_only) buildPlan(opt, judged_plan);
+    else judged_plan = mission.plan();
+    bool holds_ok = reportCompliance(judged_plan, station.packets) || opt.download_only;
+    printf("Flash: %lu page writes, %lu sector erases\n", logFlash.writes(), logFlash.erases());
+    printf("Simulated %.1f s in %.3f s wall (%.0fx real time)\n",
+           sim_s, wall_s, wall_s > 0 ? sim_s / wall_s : 0.0);
+
+    if (trace) fclose(trace);
+    if (station.log) fclose(station.log);
+    if (station.trace) fclose(station.trace);
+    if (station.live) fclose(station.live);
+    if (station.probes) fclose(station.probes);
+    savePistonToNvs();
+    return (done && log_ok && trace_ok && probes_ok && holds_ok) ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+// NeoPixel stand-in: remembers the colour so the simulator can report it.
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin, uint16_t type) { (void)n; (void)pin; (void)type; }
+    void begin() {}
+    void setBrightness(uint8_t b) { (void)b; }
+    void setPixelColor(uint16_t n, uint32_t c) { (void)n; color_ = c; }
+    void show() {}
+    uint32_t getPixelColor(uint16_t n) const { (void)n; return color_; }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+private:
+    uint32_t color_ = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+// Host stand-in for the Arduino core, just enough for src/main.cpp.
+// Time is virtual: delay() runs the physics and the step timer forward.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cmath>
+#include <cstdlib>
+
+using std::abs;
+
+#define IRAM_ATTR
+
+// Single-threaded host: critical sections have nothing to exclude
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// CPU cycle counter, emulated from the host clock at 240 MHz, so loop-time
+// costs measured with it are real (host) costs, not virtual time
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void setTxBufferSize(size_t size) { (void)size; }
+    size_t write(const uint8_t* data, size_t len);
+    size_t print(const char* s);
+    size_t print(char c);
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned int v) { return print((unsigned long)v); }
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int digits = 2);
+    size_t println() { return print("\n"); }
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + print("\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+// MS5837 stand-in: read() samples the simulated float's pressure.
+class MS5837 {
+public:
+    static const uint8_t MS5837_30BA = 0;
+    static const uint8_t MS5837_02BA = 1;
+
+    bool init();
+    void setModel(uint8_t model) { (void)model; }
+    void setFluidDensity(float density) { (void)density; }
+    void read();
+    float pressure(float conversion = 1.0f) const { return pressure_mbar_ * conversion; }
+    float temperature() const { return temperature_c_; }
+
+private:
+    float pressure_mbar_ = 0;
+    float temperature_c_ = 0;
+};
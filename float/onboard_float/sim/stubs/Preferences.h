@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+// Preferences (NVS) stand-in: a key/value store kept by the simulator,
+// backed by a file when one is given (sim::setNvsPath) so a value saved by
+// one run is there on the next boot. Bytes only, which is all the
+// firmware uses.
+class Preferences {
+public:
+    bool begin(const char* name, bool read_only = false, const char* partition_label = nullptr);
+    void end() { open_ = false; }
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytes(const char* key, void* buf, size_t max_len);
+    size_t getBytesLength(const char* key);
+    bool remove(const char* key);
+
+private:
+    std::string name_;
+    bool read_only_ = false;
+    bool open_ = false;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define WIFI_STA 1
+
+// Bringing the radio up takes a few hundred ms on the ESP32-S3
+#define SIM_WIFI_START_MS 250
+
+class WiFiClass {
+public:
+    bool mode(int m) { (void)m; delay(SIM_WIFI_START_MS); return true; }
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin(int sda, int scl) { (void)sda; (void)scl; return true; }
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// ESP-NOW stand-in: sends land in the simulator's radio log, receives are
+// injected by the simulator through the registered callback.
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef struct {
+    uint8_t peer_addr[6];
+    uint8_t channel;
+    bool encrypt;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int len);
+
+esp_err_t esp_now_init();
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
@@ -4,77 +4,43 @@
 #include <MS5837.h>
 #include <Wire.h>
 #include <Adafruit_NeoPixel.h> // Added for ESP32-S3 Built-in LED
+#include <Preferences.h>
+#include <StepperEngine.h>
+#include <StepTimer.h>
+#include <DepthController.h>
+#include <DepthEstimator.h>
+#include <NeutralMap.h>
+#include <SurfaceTracker.h>
+#include <LogLink.h>
+#include <FlashRingLog.h>
+#include <TraceLog.h>
+#include <MissionExecutor.h>
+#include <FloatTasks.h>
+#include <SpscRing.h>
+#include <LatestValue.h>
+#include <atomic>
+#include "float_defs.h"
+#include "float_probes.h"
 
 // ============================================================================
-// SHARED STRUCTURES (PACKED for ESP-NOW)
+// NEOPIXEL
 // ============================================================================
 
-typedef struct __attribute__((packed)) {
-    char company_id[10];
-    uint32_t timestamp;  
-    float pressure_kpa;
-    float depth_m;
-    float temp_c;
-} struct_message;
-
-typedef struct __attribute__((packed)) {
-    char cmd[16];
-    char company_id[10];
-    float target_fd;      // First depth target (2.5m)
-    float target_sd;      // Second depth target (0.4m)
-    int fdt;              // First depth hold time (30 sec)
-    int sdt;              // Second depth hold time (30 sec)
-} struct_command;
-
-typedef struct __attribute__((packed)) {
-    char msg[32];
-} struct_status;
-
-// ============================================================================
-// PIN DEFINITIONS
-// ============================================================================
-
-#define STEP_PIN 13
-#define DIR_PIN 12
-#define LIMIT_FWD 9
-#define LIMIT_BWD 10
-#define SDA_PIN 4
-#define SCL_PIN 5
-
 // NeoPixel Configuration for ESP32-S3
 #define RGB_BRIGHTNESS 50 // 0-255 scale
 #define LED_PIN 48        // Built-in NeoPixel on ESP32-S3
 Adafruit_NeoPixel pixel(1, LED_PIN, NEO_GRB + NEO_KHZ800);
 
-// ============================================================================
-// STATE MACHINE DEFINITION
-// ============================================================================
-
-enum MissionState { 
-    IDLE, 
-    CALIBRATING, 
-    DESCEND_P1_LOW, 
-    HOLD_P1_LOW, 
-    ASCEND_P1_HIGH, 
-    HOLD_P1_HIGH, 
-    DESCEND_P2_LOW, 
-    HOLD_P2_LOW, 
-    ASCEND_P2_HIGH, 
-    HOLD_P2_HIGH, 
-    SURFACING, 
-    MISSION_DONE 
-};
-
 // ============================================================================
 // GLOBAL VARIABLES
 // ============================================================================
 
-MissionState currentState = IDLE;
+MissionState currentState = IDLE;     // control task
 
-MS5837 sensor;
+MS5837 sensor;                        // sample task
 uint8_t controlMac[] = {0xAC, 0xA7, 0x04, 0x29, 0x8F, 0x84};  // Control station MAC
 
-// Mission parameters
+// Mission parameters (control task)
 float surface_pressure_kpa = 0;
 float surface_pressure_pa = 0;      // For accurate depth calculation
 char active_company_id[10] = "PENDING";
@@ -82,35 +48,40 @@ float target_fd = 0;                 // Target first depth (2.5m)
 float target_sd = 0;                 // Target second depth (0.4m)
 int fdt = 0;                         // First depth hold time
 int sdt = 0;                         // Second depth hold time
+MissionPlan deploy_plan;             // Segment table from the last deploy
 
-// Control flags
+// Control flags (control task, set by commands from the station)
 bool start_mission = false;
 bool transmit_requested = false;
+bool trace_requested = false;
+bool probes_requested = false;
 
-// Timing variables
+// Timing variables (sample clock, ms)
 unsigned long missionStartTime = 0; 
-unsigned long logTimer = 0;
-
-// Hold tracking variables for 7-packet verification
-// Profile 1
-unsigned long p1_low_hold_start = 0;
-int p1_low_valid_packets = 0;
-bool p1_low_active = false;
-unsigned long p1_high_hold_start = 0;
-int p1_high_valid_packets = 0;
-bool p1_high_active = false;
-
-// Profile 2
-unsigned long p2_low_hold_start = 0;
-int p2_low_valid_packets = 0;
-bool p2_low_active = false;
-unsigned long p2_high_hold_start = 0;
-int p2_high_valid_packets = 0;
-bool p2_high_active = false;
-
-// Data logging
-struct_message sensor_data[500]; 
-int log_index = 0;
+
+// Mission segments and their 7-packet hold verification (MissionExecutor.h).
+// The executor also schedules the log packets, so a hold's packets start
+// when the hold does and it ends on the packet that completes it.
+const unsigned long LOG_INTERVAL_MS = 5000;
+MissionExecutor mission(LOG_INTERVAL_MS);
+
+// Data logging: compact delta-encoded entries (see CompactLog.h) in a flash
+// ring (FlashRingLog.h), so the log survives a reset and is not capped by
+// RAM. Only the page being filled lives in RAM.
+#if defined(ARDUINO_ARCH_ESP32)
+PartitionFlash logFlash("floatlog");    // partitions.csv
+#else
+FileFlash logFlash;                     // Host simulator opens the backing file
+#endif
+FlashRingLog missionLog(logFlash);
+const int LOG_ERASE_AHEAD_SECTORS = 4;  // 64 pages pre-erased per mission
+
+// High-rate trace (TraceLog.h): one record per sensor tick for tuning the
+// buoyancy engine, kept in RAM apart from the scoring log. 7000 records
+// (112 kB) hold the last 11 minutes at 10 Hz.
+const uint32_t TRACE_CAPACITY = 7000;
+trace_record trace_buffer[TRACE_CAPACITY];
+TraceLog traceLog(trace_buffer, TRACE_CAPACITY);
 
 // Sensor offset (if pressure sensor not at bottom/top)
 // For this example, assume sensor is at bottom of float
@@ -120,20 +91,156 @@ const float SENSOR_BOTTOM_OFFSET = 0.0;   // Sensor at bottom: offset 0
 const float SENSOR_TOP_OFFSET = 0.0;      // Sensor at top: offset 0
 // Declare these to judge before deployment!
 
+// ============================================================================
+// TASKS
+// ============================================================================
+// The firmware runs as pinned FreeRTOS tasks (lib/FloatTasks), not one
+// loop() with a delay(10):
+//
+//   sample   core 1, prio 5, every 100 ms: sensor.read() -> sampleRing
+//   control  core 1, prio 4, on each sample and command: estimator,
+//            mission, piston, trace; log entries -> logRing, replies ->
+//            radioOutbox, status -> floatStatus
+//   radio    core 0, prio 3, every 20 ms: radioOutbox, live telemetry
+//   log      core 0, prio 2, every 10 ms: flash log, downloads
+//   loop()   core 1, prio 1: NeoPixel
+//
+// The ESP-NOW callback (WiFi task) only queues: commands for the control
+// task, ACKs for the log task. Each global is owned by the task noted next
+// to it; the others only see it through these rings and mailboxes.
+
+enum FloatTaskId { TASK_SAMPLE, TASK_CONTROL, TASK_RADIO, TASK_LOG, TASK_COUNT };
+
+// One raw measurement, sample task -> control task
+struct sensor_sample {
+    uint32_t time_ms;           // when the sample task woke
+    float pressure_mbar;
+    float temp_c;
+    uint32_t cycles;            // CPU cycle count when queued (latency)
+    int32_t period_error_us;    // wake time minus schedule
+    bool periodic;              // false for the first sample
+};
+
+// Control task -> log task
+enum LogRequestKind : uint8_t { LOG_BEGIN_SESSION, LOG_ENTRY };
+
+struct log_request {
+    uint8_t kind;
+    char company_id[10];            // LOG_BEGIN_SESSION
+    float surface_pressure_kpa;     // LOG_BEGIN_SESSION
+    LogSample sample;               // LOG_ENTRY
+};
+
+// Control task -> radio task: a packet for the station
+struct radio_message {
+    uint8_t len;
+    uint8_t data[40];           // the largest reply is struct_predive
+};
+
+// Published by the control task on every sample (telemetry, LEDs)
+struct float_status {
+    uint32_t time_ms;
+    uint8_t state;              // MissionState
+    uint8_t segment;
+    uint8_t hold_packets;
+    uint8_t in_band;
+    int16_t target_mm;          // current segment
+    int16_t depth_mm;           // filtered
+    int16_t velocity_mm_s;
+    int16_t piston;             // position (steps)
+    uint8_t piston_moving;
+};
+
+SpscRing<sensor_sample, 4> sampleRing;      // sample -> control
+SpscRing<struct_command, 4> commandRing;    // ESP-NOW callback -> control
+SpscRing<link_ack_frame, 8> ackRing;        // ESP-NOW callback -> log
+SpscRing<log_request, 8> logRing;           // control -> log
+SpscRing<radio_message, 4> radioOutbox;     // control -> radio
+LatestValue<float_status> floatStatus;      // control -> radio, loop()
+std::atomic<uint8_t> download_request(0);   // control -> log: stream to send, 0 = none
+std::atomic<bool> download_active(false);   // log -> radio
+
+// Control loop timing, measured by the control task. The control task has
+// core 1 to itself apart from the sampler, so both should stay within a
+// millisecond or two; anything over the bound is counted and reported.
+const uint32_t SAMPLE_JITTER_BOUND_US = 2000;       // sample wake vs schedule
+const uint32_t CONTROL_LATENCY_BOUND_US = 2000;     // sample queued -> control done
+JitterStats samplePeriodJitter(SAMPLE_JITTER_BOUND_US);
+JitterStats controlLatency(CONTROL_LATENCY_BOUND_US);
+
+// Hot-path probes (float_probes.h, -DFLOAT_PROBES): recorded by the task
+// that runs each section; the log task snapshots them into probe_blob for
+// the Serial dump and the download.
+#if defined(FLOAT_PROBES)
+ProbeTable probes;
+uint8_t probe_blob[PROBE_REPORT_MAX_BYTES];     // log task
+size_t probe_blob_bytes = 0;
+uint8_t probe_transfer = 0;                     // new number per snapshot
+#endif
+
 // ============================================================================
 // DEPTH CALCULATION
 // ============================================================================
 
-float getDepth() {
-    sensor.read();
+// The sample task takes exactly one sensor.read() per period and queues it;
+// the control task feeds it to the estimator. getDepth() and everything
+// else read the cached, filtered values.
+// Depth calculation using EGADS solution density (1025 kg/m³)
+// P = ρ * g * h  =>  h = P / (ρ * g), g = 9.80665 m/s²
+DepthEstimator depthEstimator(0.5f, 0.1f, 1025.0f);     // control task
+
+// Surface reference, tracked in the background while IDLE (control task)
+// so deploy goes straight into the dive. CALIBRATING is only entered when
+// deploy comes before the tracker is ready (just after boot, or just put
+// in the water).
+SurfaceTrackerConfig surfaceConfig = {
+    100,        // 10 s running average once warmed up
+    10,         // ready after 1 s of samples
+    4.0f,       // outliers beyond 4 standard deviations ...
+    100.0f,     // ... and at least 100 Pa (1 cm)
+    10          // 1 s of outliers in a row: the surface moved, start again
+};
+SurfaceTracker surfaceTracker(surfaceConfig);
+
+const unsigned long SAMPLE_PERIOD_MS = 100;
+
+// Sample task: runs every SAMPLE_PERIOD_MS (vTaskDelayUntil)
+void sampleStep() {
+    static uint32_t lastWakeUs = 0;
+    static bool first = true;
+    uint32_t wake_us = micros();
+
+    sensor_sample s;
+    s.time_ms = millis();
+    s.periodic = !first;
+    s.period_error_us = first ? 0 : (int32_t)(wake_us - lastWakeUs - SAMPLE_PERIOD_MS * 1000);
+    lastWakeUs = wake_us;
+    first = false;
+
+    {
+        PROBE_SCOPE(PROBE_SENSOR_READ);
+        sensor.read();
+    }
     // MS5837 pressure() returns pressure in millibars (mbar)
-    // 1 mbar = 100 Pa = 0.1 kPa
-    float pressure_pa = sensor.pressure() * 100.0f;  // Convert to Pascals
-    
-    // Depth calculation using EGADS solution density (1025 kg/m³)
-    // P = ρ * g * h  =>  h = P / (ρ * g)
-    // g = 9.80665 m/s², ρ = 1025 kg/m³
-    float depth = (pressure_pa - surface_pressure_pa) / (1025.0f * 9.80665f);
+    s.pressure_mbar = sensor.pressure();
+    s.temp_c = sensor.temperature();
+    s.cycles = ESP.getCycleCount();
+    // Full only if control is 4 samples behind; the ring counts the drop
+    sampleRing.push(s);
+    floatTaskNotify(TASK_CONTROL);
+}
+
+// Control task: feed one sample to the estimator
+void updateDepth(const sensor_sample& s) {
+    PROBE_SCOPE(PROBE_DEPTH_UPDATE);
+    static unsigned long lastSampleTime = 0;
+    unsigned long elapsed = s.time_ms - lastSampleTime;
+    lastSampleTime = s.time_ms;
+    depthEstimator.update(s.pressure_mbar, s.temp_c, elapsed / 1000.0f);
+}
+
+float getDepth() {
+    float depth = depthEstimator.depth();
     
     // Ensure depth is not negative due to noise
     if (depth < 0) depth = 0;
@@ -141,30 +248,25 @@ float getDepth() {
     return depth;
 }
 
-// Get depth with bottom offset (for 2.5m target)
-float getBottomDepth() {
-    return getDepth() + SENSOR_BOTTOM_OFFSET;
-}
-
-// Get depth with top offset (for 0.4m target)
-float getTopDepth() {
-    return getDepth() + SENSOR_TOP_OFFSET;
-}
-
 // ============================================================================
 // LED INDICATORS (Visual feedback for judge)
 // ============================================================================
 
-void setLEDs(float current_depth, float target_low, float target_high) {
-    // Check ranges based on MATE specs [cite: 179]
-    bool in_low_range = (abs(current_depth - target_low) <= 0.33);
-    bool in_high_range = (abs(current_depth - target_high) <= 0.33);
+const int16_t LED_DEEP_TARGET_MM = 1000;    // Blue at or below, green above
 
-    if (in_low_range) {
+// Runs in loop() from the control task's status, never in the control task
+void setLEDs(const float_status& status) {
+    // In the band of the current segment's target [cite: 179]
+    bool in_range = status.in_band;
+    bool deep_target = status.target_mm >= LED_DEEP_TARGET_MM;
+
+    if (status.state == MISSION_DONE) {
+        pixel.setPixelColor(0, pixel.Color(128, 0, 128)); // Purple for Done
+    } else if (in_range && deep_target) {
         pixel.setPixelColor(0, pixel.Color(0, 0, 255)); // Blue for 2.5m
-    } else if (in_high_range) {
+    } else if (in_range) {
         pixel.setPixelColor(0, pixel.Color(0, 255, 0)); // Green for 0.4m
-    } else if (currentState != IDLE && currentState != MISSION_DONE) {
+    } else if (status.state != IDLE) {
         // Blink Red if moving/active but not in range
         static bool blink = false;
         blink = !blink;
@@ -175,33 +277,181 @@ void setLEDs(float current_depth, float target_low, float target_high) {
     pixel.show();
 }
 
+// Once per new status while a mission runs or is done. IDLE and
+// CALIBRATING leave the pixel alone (boot colours, sensor error).
+void serviceLEDs() {
+    static uint32_t shownTime = 0;
+    float_status status;
+    if (!floatStatus.tryRead(status) || status.time_ms == shownTime) return;
+    shownTime = status.time_ms;
+    if (status.state == IDLE || status.state == CALIBRATING) return;
+    setLEDs(status);
+}
+
 // ============================================================================
 // DATA LOGGING
 // ============================================================================
 
-void logData() {
-    if (log_index >= 500) {
-        Serial.println("WARNING: Log buffer full!");
+// Control task: queue the latest measurement as taken (unfiltered) for
+// the log task, which owns the flash. Returns the depth logged, which is
+// what the hold is judged on.
+float logData(unsigned long now_ms) {
+    PROBE_SCOPE(PROBE_LOG_DATA);
+    log_request r;
+    r.kind = LOG_ENTRY;
+    r.sample.time_ms = now_ms - missionStartTime;
+    r.sample.pressure_kpa = depthEstimator.pressureMbar() / 10.0f;
+    r.sample.depth_m = depthEstimator.measuredDepth();
+    if (r.sample.depth_m < 0) r.sample.depth_m = 0;
+    r.sample.temp_c = depthEstimator.temperatureC();
+    if (!logRing.push(r)) Serial.println("WARNING: log queue full, entry lost!");
+    return r.sample.depth_m;
+}
+
+void beginLogSession() {
+    log_request r;
+    r.kind = LOG_BEGIN_SESSION;
+    memset(r.company_id, 0, sizeof(r.company_id));
+    memcpy(r.company_id, active_company_id, strnlen(active_company_id, sizeof(r.company_id)));
+    r.surface_pressure_kpa = surface_pressure_kpa;
+    if (!logRing.push(r)) Serial.println("WARNING: log queue full, session not started!");
+}
+
+// Log task
+void writeLogEntry(const LogSample& sample) {
+    PROBE_SCOPE(PROBE_LOG_WRITE);
+    if (!missionLog.append(sample)) {
+        Serial.println("WARNING: Flash log unavailable!");
         return;
     }
     
-    sensor.read();
-    float current_depth = getDepth();
-    
-    strncpy(sensor_data[log_index].company_id, active_company_id, 10);
-    sensor_data[log_index].timestamp = (millis() - missionStartTime) / 1000;
-    sensor_data[log_index].pressure_kpa = sensor.pressure() / 10.0f;
-    sensor_data[log_index].depth_m = current_depth;
-    sensor_data[log_index].temp_c = sensor.temperature();
-    
-    Serial.printf("[LOG %d] T:%us D:%.3fm P:%.1fkPa T:%.1fC\n", 
-                  log_index, 
-                  sensor_data[log_index].timestamp, 
-                  sensor_data[log_index].depth_m, 
-                  sensor_data[log_index].pressure_kpa,
-                  sensor_data[log_index].temp_c);
-    
-    log_index++;
+    Serial.printf("[LOG %u] T:%.1fs D:%.3fm P:%.1fkPa T:%.1fC\n", 
+                  missionLog.sessionEntries() - 1,
+                  sample.time_ms / 1000.0f,
+                  sample.depth_m,
+                  sample.pressure_kpa,
+                  sample.temp_c);
+}
+
+// ============================================================================
+// LOG DOWNLOAD (windowed, acknowledged)
+// ============================================================================
+// The newest session goes out as one blob (its flash pages, see
+// FlashRingLog::read()) through LogLinkSender: up to LINK_WINDOW frames in
+// flight, selective ACKs from the station, lost frames resent after
+// LINK_RTO_MS. Replaces one struct_message per 80 ms with no way to tell
+// what was lost.
+
+bool espNowSend(const uint8_t* frame, size_t len, void* ctx) {
+    (void)ctx;
+    PROBE_SCOPE(PROBE_LINK_SEND);
+    // Fails when the ESP-NOW queue is full; the sender retries next poll
+    return esp_now_send(controlMac, frame, len) == ESP_OK;
+}
+
+LogLinkSender logSender(espNowSend, nullptr);
+const char* download_name = "LOG";     // for the progress messages
+uint8_t download_stream = 0;            // LinkStream being sent
+uint8_t trace_transfer = 0;             // new number per trace (beginTrace())
+
+// ACKs arrive in the WiFi task and go to the log task through ackRing.
+// The log task owns missionLog and the sender; the trace is read while the
+// control task is not recording (IDLE, MISSION_DONE).
+
+size_t readLogBlob(uint32_t offset, uint8_t* dst, size_t len, void* ctx) {
+    (void)ctx;
+    return missionLog.read(offset, dst, len);
+}
+
+void startLogDownload() {
+    missionLog.sync();      // Program the tail so the download has it all
+    uint32_t size = missionLog.sessionBytes();
+    // One session is one blob: a repeat request resumes it at the station
+    logSender.begin(STREAM_MISSION_LOG, (uint8_t)missionLog.session(), size, readLogBlob, nullptr, millis());
+    download_name = "LOG";
+    download_stream = STREAM_MISSION_LOG;
+    Serial.printf(">>> SENDING LOG: session %u, %u entries, %u bytes in %u frames\n",
+                  missionLog.session(), missionLog.sessionEntries(), size, linkChunkCount(size));
+}
+
+size_t readTraceBlob(uint32_t offset, uint8_t* dst, size_t len, void* ctx) {
+    (void)ctx;
+    return traceLog.read(offset, dst, len);
+}
+
+// Same link, separate stream: starting one download stops the other
+void startTraceDownload() {
+    uint32_t size = traceLog.blobBytes();
+    logSender.begin(STREAM_TRACE, trace_transfer, size, readTraceBlob, nullptr, millis());
+    download_name = "TRACE";
+    download_stream = STREAM_TRACE;
+    Serial.printf(">>> SENDING TRACE: %u records, %u bytes in %u frames\n",
+                  traceLog.count(), size, linkChunkCount(size));
+}
+
+#if defined(FLOAT_PROBES)
+// Probe report: a snapshot taken when the download starts, so it covers
+// the mission and the log download before it
+void takeProbeReport() {
+    probe_blob_bytes = probes.report(probe_blob, sizeof(probe_blob), ESP.getCpuFreqMHz(), millis());
+    probe_transfer++;
+}
+
+size_t readProbeBlob(uint32_t offset, uint8_t* dst, size_t len, void* ctx) {
+    (void)ctx;
+    if (offset >= probe_blob_bytes) return 0;
+    if (len > probe_blob_bytes - offset) len = probe_blob_bytes - offset;
+    memcpy(dst, probe_blob + offset, len);
+    return len;
+}
+
+void startProbeDownload() {
+    takeProbeReport();
+    logSender.begin(STREAM_PROBES, probe_transfer, probe_blob_bytes, readProbeBlob, nullptr, millis());
+    download_name = "PROBES";
+    download_stream = STREAM_PROBES;
+    Serial.printf(">>> SENDING PROBES: %u bytes in %u frames\n",
+                  (unsigned)probe_blob_bytes, linkChunkCount(probe_blob_bytes));
+}
+
+void printProbeEntry(const probe_report_header& header, const probe_report_entry& e, void* ctx) {
+    (void)ctx;
+    float mhz = header.cpu_mhz;
+    Serial.printf("[PROBE] %-13s %-12s n %6u  min %7.1f mean %7.1f p50 %7.1f p99 %7.1f max %8.1f us, %u over\n",
+                  probeSectionName(e.section),
+                  e.state == PROBE_ALL_STATES ? "all" : missionStateName((MissionState)e.state),
+                  e.count, e.min_cycles / mhz, e.mean_cycles / mhz, e.p50_cycles / mhz,
+                  e.p99_cycles / mhz, e.max_cycles / mhz, e.overruns);
+}
+
+void printProbeReport() {
+    takeProbeReport();
+    ProbeReportReader reader(printProbeEntry, nullptr);
+    reader.feed(probe_blob, probe_blob_bytes);
+}
+#endif
+
+// Log task, every pass: feed in the ACKs, send/resend what is due
+void serviceLogLink() {
+    link_ack_frame ack;
+    if (!logSender.active()) {
+        while (ackRing.pop(ack)) {}     // stale
+        return;
+    }
+
+    while (ackRing.pop(ack)) logSender.onAck(ack, millis());
+    logSender.poll(millis());
+
+    if (logSender.complete()) {
+        Serial.printf(">>> %s DELIVERED: %u frames, %u resent\n",
+                      download_name, logSender.framesSent(), logSender.retransmits());
+#if defined(FLOAT_PROBES)
+        // The probe report follows the mission log on its own stream
+        if (download_stream == STREAM_MISSION_LOG) startProbeDownload();
+#endif
+    } else if (logSender.failed()) {
+        Serial.printf(">>> %s DOWNLOAD STALLED - press Send again to resume\n", download_name);
+    }
 }
 
 // ============================================================================
@@ -215,163 +465,859 @@ void logData() {
 //const int PISTON_POS_SURFACE = 0;      // Most volume displaced (float up)
 //const int PISTON_POS_40CM = 200;       // Partial volume (neutral at 40cm)
 //const int PISTON_POS_2_5M = 400;       // Least volume displaced (float down)
-int currentPistonPosition = 0;
+const int PISTON_MAX_STEPS = 2200;       // Forward limit switch, max sink
+
+// Stepper pin hooks (run inside the step timer interrupt)
+void IRAM_ATTR pistonSetDir(bool sink) { digitalWrite(DIR_PIN, sink ? HIGH : LOW); }
+void IRAM_ATTR pistonSetStep(bool level) { digitalWrite(STEP_PIN, level ? HIGH : LOW); }
+bool IRAM_ATTR pistonLimitHit() { return digitalRead(LIMIT_FWD) == LOW; }
+
+#if defined(ARDUINO_ARCH_ESP32)
+Esp32StepTimer stepTimer(0);
+#else
+FakeStepTimer stepTimer;    // Host simulator advances it with the sim clock
+#endif
+StepperEngine piston({pistonSetDir, pistonSetStep, pistonLimitHit}, stepTimer);
+
+// Acceleration profiles (steps/s, steps/s^2). The mission profile can be
+// overridden from the control station in the deploy command.
+MotionProfile pistonProfile = {2000.0f, 8000.0f};
+
+// ============================================================================
+// HOMING AND THE PARKED POSITION
+// ============================================================================
+// Full homing (setup): fast approach to LIMIT_FWD with the mission profile,
+// back off, then a slow final touch that sets the reference, then out to 0.
+// The approach runs on the step timer while the radio and sensor start.
+// The switch counts as closed after LIMIT_DEBOUNCE_READS steps in a row.
+//
+// While the float rests in IDLE or MISSION_DONE the log task keeps the
+// piston position in NVS ("parked"); as soon as a mission starts it erases
+// it, and movePistonTo() holds off until then. A record found at boot
+// therefore means the piston has not moved since, so homing is shortened:
+// fast from the parked position to HOMING_BACKOFF_STEPS short of the
+// switch, then the slow touch. If the switch closes early, or is not
+// found within HOMING_BACKOFF_STEPS of where the record puts it, the
+// record was wrong and full homing runs instead.
+
+const MotionProfile homingProfile = {200.0f, 4000.0f};  // final touch, 5 ms/step
+const int HOMING_BACKOFF_STEPS = 60;
+const uint8_t LIMIT_DEBOUNCE_READS = 3;
+
+struct piston_park_record {
+    uint32_t magic;
+    int32_t position;
+};
+
+#define PISTON_PARK_MAGIC 0x5041524Bu    // "PARK"
+
+Preferences nvs;
+const char* NVS_NAMESPACE = "float";
+const char* NVS_PARK_KEY = "park";
+
+std::atomic<bool> piston_parked(false);  // NVS holds the position (log task)
+int32_t parked_position = 0;             // log task (setup() before)
+bool piston_move_pending = false;        // control task: held back while parked
+int piston_pending_target = 0;
+
+// Boot: take the parked position from NVS if it has one and the switch
+// agrees
+bool restoreParkedPosition() {
+    piston_park_record r;
+    bool found = false;
+    if (nvs.begin(NVS_NAMESPACE, true)) {
+        found = nvs.getBytesLength(NVS_PARK_KEY) == sizeof(r) &&
+                nvs.getBytes(NVS_PARK_KEY, &r, sizeof(r)) == sizeof(r) &&
+                r.magic == PISTON_PARK_MAGIC && r.position >= 0 && r.position <= PISTON_MAX_STEPS;
+        nvs.end();
+    }
+    if (!found) return false;
+    if (pistonLimitHit() != (r.position >= PISTON_MAX_STEPS)) {
+        Serial.printf("Parked position %d disagrees with LIMIT_FWD, full homing\n", r.position);
+        return false;
+    }
+    piston.setPosition(r.position);
+    parked_position = r.position;
+    piston_parked.store(true);
+    return true;
+}
+
+// Boot, phase 1: fast approach (returns at once)
+void startHoming() {
+    piston.setProfile(pistonProfile);
+    piston.setPosition(0);
+    piston.moveTo(2 * PISTON_MAX_STEPS);   // More than a full stroke
+}
+
+// Parked boot, phase 1: fast to just short of the switch (returns at once)
+void startParkedHoming() {
+    piston.setProfile(pistonProfile);
+    piston.moveTo(PISTON_MAX_STEPS - HOMING_BACKOFF_STEPS);
+}
+
+// Boot, phase 2: wait for the approach, back off, touch again slowly for
+// the reference, then out to the surface position
+void finishHoming() {
+    while (piston.isMoving()) delay(1);
+    if (piston.consumeLimitEvent()) {
+        piston.moveTo(piston.currentPosition() - HOMING_BACKOFF_STEPS);
+        while (piston.isMoving()) delay(1);
+        piston.setProfile(homingProfile);
+        piston.moveTo(piston.currentPosition() + 2 * HOMING_BACKOFF_STEPS);
+        while (piston.isMoving()) delay(1);
+    }
+    if (!piston.consumeLimitEvent()) {
+        Serial.println("WARNING: LIMIT_FWD not found, homing from current position");
+        piston.setPosition(PISTON_MAX_STEPS);
+    }
+    piston.setProfile(pistonProfile);
+    piston.moveTo(0);
+    while (piston.isMoving()) delay(1);
+}
+
+// Parked boot, phase 2: touch the switch slowly where the record puts it,
+// then out to the surface position. Falls back to full homing (and returns
+// false) if the switch is not there.
+bool finishParkedHoming() {
+    while (piston.isMoving()) delay(1);
+    if (!piston.consumeLimitEvent()) {
+        piston.setProfile(homingProfile);
+        piston.moveTo(PISTON_MAX_STEPS + HOMING_BACKOFF_STEPS);
+        while (piston.isMoving()) delay(1);
+        if (piston.consumeLimitEvent()) {
+            piston.setProfile(pistonProfile);
+            piston.moveTo(0);
+            while (piston.isMoving()) delay(1);
+            return true;
+        }
+    }
+    Serial.printf("LIMIT_FWD not where parked position %d puts it, full homing\n", parked_position);
+    startHoming();
+    finishHoming();
+    return false;
+}
+
+// Log task: park the piston while resting, unpark once a mission runs.
+// A failed write is not retried; a failed erase still unparks, or the
+// mission could never move the piston.
+void serviceParkedPosition(const float_status& status) {
+    bool resting_state = status.state == IDLE || status.state == MISSION_DONE;
+    static bool park_failed = false;
+    if (resting_state && !status.piston_moving) {
+        if (park_failed || (piston_parked.load() && parked_position == status.piston)) return;
+        piston_park_record r = {PISTON_PARK_MAGIC, status.piston};
+        bool ok = nvs.begin(NVS_NAMESPACE, false) && nvs.putBytes(NVS_PARK_KEY, &r, sizeof(r)) == sizeof(r);
+        nvs.end();
+        parked_position = status.piston;
+        piston_parked.store(ok);
+        park_failed = !ok;
+        if (!ok) Serial.println("WARNING: could not park the piston position in NVS");
+    } else if (!resting_state) {
+        park_failed = false;
+        if (!piston_parked.load()) return;
+        bool ok = nvs.begin(NVS_NAMESPACE, false) && nvs.remove(NVS_PARK_KEY);
+        nvs.end();
+        piston_parked.store(false);
+        floatTaskNotify(TASK_CONTROL);      // for the move it held back
+        if (!ok) Serial.println("WARNING: could not clear the parked position in NVS");
+    }
+}
 
 //Stepper movement control
-void movePistonTo(int target_steps, int speed_us = 800) {
-    if (target_steps == currentPistonPosition) return;
-    
-    // DIR HIGH = SINK (Forward to switch)
-    // DIR LOW = RISE (Backward away from switch)
-    digitalWrite(DIR_PIN, (target_steps > currentPistonPosition) ? HIGH : LOW);
-    
-    int steps_to_move = abs(target_steps - currentPistonPosition);
-    
-    for (int i = 0; i < steps_to_move; i++) {
-        // Safety: Only check limit switch if moving HIGH (Sinking/Forward)
-        if (digitalRead(LIMIT_FWD) == LOW && (target_steps > currentPistonPosition)) {
-        //    break; 
+// Non-blocking: queues the target and returns, the step timer does the rest.
+// Use piston.isMoving() / piston.currentPosition() to follow the move.
+// Held back while the position is still parked in NVS (a few ms after
+// deploy); controlStep() issues it once the log task has unparked.
+void movePistonTo(int target_steps) {
+    PROBE_SCOPE(PROBE_MOVE_PISTON);
+    if (piston_parked.load()) {
+        piston_move_pending = true;
+        piston_pending_target = target_steps;
+        return;
+    }
+    piston_move_pending = false;
+    if (target_steps < 0) target_steps = 0;
+    if (target_steps > PISTON_MAX_STEPS) target_steps = PISTON_MAX_STEPS;
+    piston.moveTo(target_steps);
+}
+// Closed-loop depth control: PID on depth error with a feed-forward guess of
+// the neutral piston position. Gains tuned against a 1-D buoyancy/drag model
+// of the hull and 500 ml syringe; recalibrate the feed-forward per float.
+DepthControllerConfig depthConfig = {
+    1080.0f,                  // neutral piston position at the surface (steps)
+    -15.0f,                   // neutral shift per metre (hull compression)
+    {800.0f, 20.0f, 1500.0f}, // shallow gains: kp, ki, kd
+    {1200.0f, 20.0f, 2000.0f},// deep gains (at schedule depth and below)
+    2.5f,                     // schedule depth (m)
+    0.30f,                    // integrate only within 30 cm of target
+    150.0f,                   // integral clamp (steps)
+    0, PISTON_MAX_STEPS
+};
+DepthController depthController(depthConfig);
+
+// Neutral-buoyancy map (lib/NeutralMap): learned from the piston position
+// in settled holds, kept in NVS across power cycles and fed back as the
+// controller's feed-forward, so later segments and missions start from
+// where this float is really neutral instead of depthConfig's guess.
+const NeutralMapConfig neutralMapConfig = {
+    depthConfig.neutral_surface_steps,  // prior until a hold has counted
+    depthConfig.neutral_steps_per_m,
+    0.02f,                    // settled: slower than 2 cm/s
+    0.10f,                    // ... and within 10 cm of the target
+    0.005f,                   // hold dropped if it drifted > 5 mm/s on average
+    50,                       // at least 5 s of settled samples per hold
+    0.30f,                    // slope fitted once holds span +-30 cm (std-dev)
+    -60.0f, 0.0f,             // plausible steps per metre
+    0.5f                      // each new mission halves the older ones
+};
+NeutralMap neutralMap(neutralMapConfig);          // control task
+LatestValue<neutral_map_record> neutralMapOut;    // control -> log: save to NVS
+neutral_map_record neutral_map_saved;             // log task (setup() before)
+const char* NVS_NEUTRAL_KEY = "neutral";
+
+// Boot: the map from the last missions, if any
+void loadNeutralMap() {
+    neutral_map_record r;
+    bool found = false;
+    if (nvs.begin(NVS_NAMESPACE, true)) {
+        found = nvs.getBytesLength(NVS_NEUTRAL_KEY) == sizeof(r) &&
+                nvs.getBytes(NVS_NEUTRAL_KEY, &r, sizeof(r)) == sizeof(r) && neutralMap.load(r);
+        nvs.end();
+    }
+    neutral_map_saved = neutralMap.record();
+    depthController.setNeutral(neutralMap.surfaceSteps(), neutralMap.stepsPerM());
+    if (found) {
+        Serial.printf("Neutral map: %.0f steps at 0 m, %+.1f steps/m (%u holds, %u missions)\n",
+                      neutralMap.surfaceSteps(), neutralMap.stepsPerM(),
+                      neutralMap.holds(), neutralMap.missions());
+    } else {
+        Serial.println("Neutral map: none saved, using depthConfig");
+    }
+}
+
+// Log task: NVS writes stall the flash cache like log pages do, so only
+// with the piston idle, and only when the map changed
+void saveNeutralMap(bool idle) {
+    neutral_map_record r;
+    if (!idle || !neutralMapOut.tryRead(r)) return;
+    if (memcmp(&r, &neutral_map_saved, sizeof(r)) == 0) return;
+    bool ok = nvs.begin(NVS_NAMESPACE, false) && nvs.putBytes(NVS_NEUTRAL_KEY, &r, sizeof(r)) == sizeof(r);
+    nvs.end();
+    neutral_map_saved = r;      // no retry loop on a failed write
+    Serial.printf("Neutral map %s to NVS (%u holds)\n", ok ? "saved" : "NOT saved", r.holds);
+}
+
+// Control task, on every tick in HOLD and on every transition
+void learnNeutral(MissionState from, uint8_t from_segment) {
+    bool left_hold = from == HOLD && (currentState != HOLD || mission.segmentIndex() != from_segment);
+    bool entered_hold = currentState == HOLD && (from != HOLD || mission.segmentIndex() != from_segment);
+    if (left_hold) {
+        bool counted = neutralMap.endHold();
+        Serial.printf("[NEUTRAL] hold at %.2fm: piston %.0f over %u settled samples, drift %+.1f mm/s%s\n",
+                      neutralMap.holdDepthM(), neutralMap.holdSteps(), neutralMap.holdSamples(),
+                      neutralMap.holdVelocityMps() * 1000.0f, counted ? "" : " (not counted)");
+        if (counted) {
+            // The integral held the old feed-forward's error; start over
+            depthController.setNeutral(neutralMap.surfaceSteps(), neutralMap.stepsPerM());
+            depthController.reset();
+            Serial.printf("[NEUTRAL] map: %.0f steps at 0 m, %+.1f steps/m%s\n", neutralMap.surfaceSteps(),
+                          neutralMap.stepsPerM(), neutralMap.slopeLearned() ? "" : " (prior slope)");
         }
-        
-        digitalWrite(STEP_PIN, HIGH);
-        delayMicroseconds(speed_us);
-        digitalWrite(STEP_PIN, LOW);
-        delayMicroseconds(speed_us);
     }
-    currentPistonPosition = target_steps; 
+    if (entered_hold) neutralMap.beginHold();
+    if (currentState == HOLD) {
+        neutralMap.addSample(mission.targetDepth(), getDepth(), depthEstimator.velocity(),
+                             piston.currentPosition());
+    }
 }
-// Set buoyancy for target depth using discrete positions
 
+const int MIN_RETARGET_STEPS = 5;    // Ignore corrections smaller than this
+
+// Set buoyancy for target depth (called every loop, acts on each new sample)
 void setBuoyancyForDepth(float target_depth) {
-    static unsigned long lastAdjustTime = 0;
-    float current_depth = getDepth(); 
-    const int NUDGE_STEPS = 50;   
-    const float DEADZONE = 0.08;  
-    
-    if (millis() - lastAdjustTime < 1500) return;
+    static unsigned long lastSampleCount = 0;
+    static unsigned long lastControlTime = 0;
+
+    if (depthEstimator.samples() == lastSampleCount) return;
+    lastSampleCount = depthEstimator.samples();
+
+    unsigned long now = millis();
+    float dt = (now - lastControlTime) / 1000.0f;
+    lastControlTime = now;
+    if (dt > 1.0f) dt = SAMPLE_PERIOD_MS / 1000.0f;   // First call after a pause
+
+    float current_depth = getDepth();
+    float velocity = depthEstimator.velocity();
 
     if (target_depth <= 0.1) {
-        if (currentPistonPosition > 0) {
-            movePistonTo(0); // Move to 0
-            lastAdjustTime = millis();
-        }
+        // Surface: full buoyancy, no control needed
+        depthController.reset();
+        movePistonTo(0);
         return;
     }
 
-    if (current_depth < target_depth - DEADZONE) {
-        // Create a LOCAL target variable
-        int new_target = currentPistonPosition + NUDGE_STEPS;
-        if (new_target > 2200) new_target = 2200; // Updated to 2200
-        
-        Serial.printf(">>> Nudging SINK: From %d to %d\n", currentPistonPosition, new_target);
-        movePistonTo(new_target); 
-        lastAdjustTime = millis();
+    int new_target = depthController.update(target_depth, current_depth, velocity, dt);
+    if (abs(new_target - piston.targetPosition()) >= MIN_RETARGET_STEPS) {
+        movePistonTo(new_target);
+    }
+}
+
+// ============================================================================
+// HIGH-RATE TRACE
+// ============================================================================
+// Called on every new sensor sample while the mission runs. Allocation-free:
+// fills one record on the stack and copies it into the ring. Its own cost
+// is measured with the CPU cycle counter and printed when the mission ends.
+
+uint64_t trace_cycles_total = 0;
+uint32_t trace_cycles_max = 0;
+
+int16_t metresToMm(float metres) {
+    float mm = metres * 1000.0f;
+    if (mm > 32767.0f) return 32767;
+    if (mm < -32768.0f) return -32768;
+    return (int16_t)lroundf(mm);
+}
+
+void beginTrace() {
+    traceLog.begin(SAMPLE_PERIOD_MS);
+    trace_transfer++;
+    trace_cycles_total = 0;
+    trace_cycles_max = 0;
+}
+
+void traceData(unsigned long now_ms) {
+    uint32_t start = ESP.getCycleCount();
+
+    trace_record r;
+    r.time_ms = now_ms - missionStartTime;
+    r.depth_mm = metresToMm(depthEstimator.depth());
+    r.measured_mm = metresToMm(depthEstimator.measuredDepth());
+    r.velocity_mm_s = metresToMm(depthEstimator.velocity());
+    r.piston = (int16_t)piston.currentPosition();
+    r.piston_target = (int16_t)piston.targetPosition();
+    r.state = (uint8_t)currentState;
+    r.segment = mission.segmentIndex();
+    traceLog.record(r);
+
+    uint32_t cycles = ESP.getCycleCount() - start;
+    trace_cycles_total += cycles;
+    if (cycles > trace_cycles_max) trace_cycles_max = cycles;
+}
+
+void printTraceStats() {
+    uint32_t n = traceLog.count() + traceLog.overwritten();
+    float mhz = ESP.getCpuFreqMHz();
+    Serial.printf("[TRACE] %u records (%u overwritten), cost per record: mean %.2fus, max %.2fus\n",
+                  traceLog.count(), traceLog.overwritten(),
+                  n ? trace_cycles_total / mhz / n : 0.0f, trace_cycles_max / mhz);
+}
+
+// ============================================================================
+// LIVE TELEMETRY
+// ============================================================================
+// While the antenna can clear the water (holds at a shallow target,
+// surfacing, waiting for recovery) the float sends a small state frame
+// every TELEMETRY_PERIOD_MS. Fire and forget: a frame the radio will not
+// take is dropped, never queued or retried. Built by the radio task from
+// the control task's published status, so the control tick never waits on
+// the radio. Paused while a download owns the link.
+
+const unsigned long TELEMETRY_PERIOD_MS = 500;
+const int16_t TELEMETRY_MAX_TARGET_MM = 500;    // holds at 40 cm
+uint16_t telemetry_seq = 0;         // radio task
+uint32_t telemetry_sent = 0;
+uint32_t telemetry_dropped = 0;     // refused by the radio
+
+// Control task, on every sample
+void publishStatus(unsigned long now_ms) {
+    float_status status;
+    status.time_ms = now_ms;
+    status.state = (uint8_t)currentState;
+    status.segment = mission.segmentIndex();
+    status.hold_packets = currentState == HOLD ? mission.validPackets() : 0;
+    status.in_band = mission.inBand(getDepth());
+    status.target_mm = mission.segment().target_mm;
+    status.depth_mm = metresToMm(depthEstimator.depth());
+    status.velocity_mm_s = metresToMm(depthEstimator.velocity());
+    status.piston = (int16_t)piston.currentPosition();
+    status.piston_moving = piston.isMoving();
+    floatStatus.publish(status);
+}
+
+bool telemetryWanted(const float_status& status) {
+    switch (status.state) {
+        case HOLD:
+            return status.target_mm <= TELEMETRY_MAX_TARGET_MM;
+        case SURFACING:
+        case MISSION_DONE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Radio task
+void serviceTelemetry(const float_status& status) {
+    static unsigned long lastSendTime = 0;
+    if (!telemetryWanted(status) || download_active.load()) return;
+    unsigned long now = millis();
+    if (now - lastSendTime < TELEMETRY_PERIOD_MS) return;
+    lastSendTime = now;
+
+    link_telemetry_frame frame;
+    frame.type = LINK_TELEMETRY;
+    frame.seq = telemetry_seq++;
+    frame.sent_ms = now;
+    frame.state = status.state;
+    frame.segment = status.segment;
+    frame.hold_packets = status.hold_packets;
+    frame.depth_mm = status.depth_mm;
+    frame.velocity_mm_s = status.velocity_mm_s;
+    frame.piston = status.piston;
+    PROBE_SCOPE(PROBE_RADIO_SEND);
+    if (esp_now_send(controlMac, (uint8_t *) &frame, sizeof(frame)) == ESP_OK) {
+        telemetry_sent++;
+    } else {
+        telemetry_dropped++;
+    }
+}
+
+// ============================================================================
+// MISSION SEGMENTS
+// ============================================================================
+// The executor runs the deploy table (MissionPlan.h) on each new depth
+// sample. It only looks at the current segment, so a tick costs the same
+// however many segments the mission has. The bottom/top sensor offsets
+// travel with each segment.
+
+MissionState stateForPhase(MissionPhase phase) {
+    switch (phase) {
+        case PHASE_TRAVEL:    return TRAVEL;
+        case PHASE_HOLD:      return HOLD;
+        case PHASE_SURFACING: return SURFACING;
+        default:              return MISSION_DONE;
+    }
+}
+
+void printTaskStats() {
+    Serial.printf("[TASKS] sample period error %+d..%+d us (mean %+.0f), %u of %u over +/-%u us\n",
+                  samplePeriodJitter.min(), samplePeriodJitter.max(), samplePeriodJitter.mean(),
+                  samplePeriodJitter.overBound(), samplePeriodJitter.count(), samplePeriodJitter.bound());
+    Serial.printf("[TASKS] sample to control done: mean %.0f us, max %d us, %u of %u over %u us\n",
+                  controlLatency.mean(), controlLatency.max(),
+                  controlLatency.overBound(), controlLatency.count(), controlLatency.bound());
+    Serial.printf("[TASKS] queue drops: samples %u, commands %u, acks %u, log %u, outbox %u\n",
+                  sampleRing.dropped(), commandRing.dropped(), ackRing.dropped(),
+                  logRing.dropped(), radioOutbox.dropped());
+}
+
+void runMission(unsigned long now_ms) {
+    PROBE_SCOPE(PROBE_MISSION);
+    float depth = getDepth();
+    MissionState from = currentState;
+    uint8_t from_segment = mission.segmentIndex();
+    bool changed = mission.update(depth, now_ms);
+    if (mission.packetDue(now_ms)) changed |= mission.onPacket(logData(now_ms), now_ms);
+    if (changed) currentState = stateForPhase(mission.phase());
+    learnNeutral(from, from_segment);
+    if (changed) {
+        if (currentState == TRAVEL || currentState == HOLD) {
+            Serial.printf("[SEGMENT %u/%u] %s %.2fm\n", mission.segmentIndex() + 1,
+                          mission.segmentCount(), missionStateName(currentState),
+                          mission.targetDepth());
+        } else if (currentState == MISSION_DONE) {
+            printTraceStats();
+            printTaskStats();
+            neutralMapOut.publish(neutralMap.record());
+            return;
+        }
+    }
+    setBuoyancyForDepth(mission.targetDepth());
+}
+
+// ============================================================================
+// STATION COMMANDS (control task)
+// ============================================================================
+
+// Queue a packet for the radio task
+void radioSend(const void* data, size_t len) {
+    radio_message m;
+    if (len > sizeof(m.data)) return;
+    m.len = (uint8_t)len;
+    memcpy(m.data, data, len);
+    if (!radioOutbox.push(m)) Serial.println("WARNING: radio outbox full, reply lost");
+}
+
+void handleCommand(const struct_command& received_cmd) {
+    if (strcmp(received_cmd.cmd, "predive") == 0) {
+        // Pre-dive verification - send current data to control station
+        // (latest sample, the sensor is sampled continuously) and the
+        // surface reference deploy would start from
+        struct_predive p;
+        strncpy(p.sample.company_id, received_cmd.company_id, 10);
+        p.sample.timestamp = 0;
+        p.sample.pressure_kpa = depthEstimator.pressureMbar() / 10.0f;
+        p.sample.depth_m = 0;
+        p.sample.temp_c = depthEstimator.temperatureC();
+        p.surface_kpa = surfaceTracker.pressurePa() / 1000.0f;
+        p.surface_var_pa2 = surfaceTracker.variancePa2();
+        p.surface_samples = surfaceTracker.samples() > 0xFFFF ? 0xFFFF : (uint16_t)surfaceTracker.samples();
+        p.surface_outliers = surfaceTracker.rejected() > 0xFFFF ? 0xFFFF : (uint16_t)surfaceTracker.rejected();
+        radioSend(&p, sizeof(p));
+        Serial.println(">>> PRE-DIVE DATA SENT to control station");
     } 
-    else if (current_depth > target_depth + DEADZONE) {
-        int new_target = currentPistonPosition - NUDGE_STEPS;
-        if (new_target < 0) new_target = 0; 
-        
-        Serial.printf(">>> Nudging RISE: From %d to %d\n", currentPistonPosition, new_target);
-        movePistonTo(new_target); 
-        lastAdjustTime = millis();
+    else if (strcmp(received_cmd.cmd, "deploy") == 0) {
+        strncpy(active_company_id, received_cmd.company_id, 10);
+        target_fd = received_cmd.target_fd; 
+        target_sd = received_cmd.target_sd;
+        fdt = received_cmd.fdt; 
+        sdt = received_cmd.sdt;
+        if (received_cmd.max_sps > 0) pistonProfile.max_sps = received_cmd.max_sps;
+        if (received_cmd.accel_sps2 > 0) pistonProfile.accel_sps2 = received_cmd.accel_sps2;
+        if (received_cmd.segment_count == 0) {
+            missionPlanTwoProfiles(deploy_plan, target_fd, fdt, target_sd, sdt,
+                                   SENSOR_BOTTOM_OFFSET, SENSOR_TOP_OFFSET);
+        } else {
+            deploy_plan.count = received_cmd.segment_count;
+            deploy_plan.surface_offset_mm = received_cmd.surface_offset_mm;
+            memcpy(deploy_plan.segments, received_cmd.segments, sizeof(deploy_plan.segments));
+        }
+        if (!MissionExecutor::valid(deploy_plan)) {
+            struct_status status = {"Plan rejected"};
+            radioSend(&status, sizeof(status));
+            Serial.printf(">>> MISSION PLAN REJECTED: %u segments\n", deploy_plan.count);
+            return;
+        }
+        start_mission = true;
+        Serial.printf(">>> MISSION CONFIG: %u segments\n", deploy_plan.count);
+        for (int i = 0; i < deploy_plan.count; i++) {
+            const mission_segment& seg = deploy_plan.segments[i];
+            Serial.printf("    %d: %.2fm +/-%.2fm, %u packets, hold >=%us, offset %.2fm\n", i + 1,
+                          seg.target_mm / 1000.0f, seg.tolerance_mm / 1000.0f, seg.packets,
+                          seg.hold_s, seg.offset_mm / 1000.0f);
+        }
+        Serial.printf(">>> PISTON PROFILE: %.0f steps/s, %.0f steps/s^2, full stroke %ums\n",
+                      pistonProfile.max_sps, pistonProfile.accel_sps2,
+                      pistonProfile.moveDurationUs(PISTON_MAX_STEPS) / 1000);
+    } 
+    else if (strcmp(received_cmd.cmd, "send_now") == 0) {
+        transmit_requested = true;
+        Serial.println(">>> DATA REQUEST RECEIVED - will transmit after recovery");
+    }
+    else if (strcmp(received_cmd.cmd, "send_trace") == 0) {
+        trace_requested = true;
+        Serial.println(">>> TRACE REQUEST RECEIVED - will transmit after recovery");
+    }
+    else if (strcmp(received_cmd.cmd, "send_probes") == 0) {
+        probes_requested = true;
     }
 }
+
 // ============================================================================
 // ESP-NOW CALLBACKS
 // ============================================================================
+// Runs in the WiFi task: queue and return, never touch mission state.
 
 void onDataRecv(const uint8_t * mac, const uint8_t *incomingData, int len) {
+    if (isLinkFrame(incomingData, len)) {
+        if (incomingData[0] == LINK_ACK && len == sizeof(link_ack_frame)) {
+            link_ack_frame ack;
+            memcpy(&ack, incomingData, sizeof(ack));
+            ackRing.push(ack);      // ACKs are cumulative, a dropped one is harmless
+        }
+        return;
+    }
     if (len == sizeof(struct_command)) {
         struct_command received_cmd;
         memcpy(&received_cmd, incomingData, sizeof(received_cmd));
+        if (commandRing.push(received_cmd)) floatTaskNotify(TASK_CONTROL);
+    }
+}
+
+// ============================================================================
+// CONTROL TASK
+// ============================================================================
+// Wakes on every queued sample (and on commands). Everything it does is
+// bounded and non-blocking: flash, radio and LEDs are other tasks' work.
+
+// Take the tracked surface reference and start the first segment. The
+// estimator restarts from the latest sample against it.
+void beginDive(unsigned long now) {
+    surface_pressure_pa = surfaceTracker.pressurePa();
+    surface_pressure_kpa = surface_pressure_pa / 1000.0f;
+    depthEstimator.setSurfacePressurePa(surface_pressure_pa);
+    float pressure_mbar = depthEstimator.pressureMbar();
+    float temp_c = depthEstimator.temperatureC();
+    depthEstimator.reset();
+    depthEstimator.update(pressure_mbar, temp_c, SAMPLE_PERIOD_MS / 1000.0f);
+    beginLogSession();
+    beginTrace();
+    samplePeriodJitter.reset();
+    controlLatency.reset();
+
+    missionStartTime = now; 
+    mission.start(now);
+    mission.onPacket(logData(now), now);
+    neutralMap.beginMission();
+    currentState = TRAVEL;
+    Serial.printf("[CALIBRATION] Surface pressure: %.2f kPa (sd %.1f Pa, %u samples, %u outliers)\n",
+                  surface_pressure_kpa, sqrtf(surfaceTracker.variancePa2()),
+                  surfaceTracker.samples(), surfaceTracker.rejected());
+}
+
+bool missionRunning() {
+    return currentState == TRAVEL || currentState == HOLD || currentState == SURFACING;
+}
+
+// Deploy, as soon as the command is in (not on the next sample): with a
+// ready surface reference the first piston command goes out right here
+void startMission(unsigned long now) {
+    Serial.println("[START] Initializing mission...");
+    piston.setProfile(pistonProfile);
+    mission.load(deploy_plan);
+    start_mission = false;
+    if (surfaceTracker.ready()) {
+        beginDive(now);
+        runMission(now);
+        publishStatus(now);     // the log task unparks the piston on it
+    } else {
+        setBuoyancyForDepth(0);  // Surface position
+        Serial.printf("[CALIBRATING] Surface pressure: %u of %u samples...\n",
+                      surfaceTracker.samples(), surfaceConfig.min_samples);
+        currentState = CALIBRATING;
+    }
+}
+
+void requestDownload(uint8_t stream) {
+    download_request.store(stream);
+}
+
+void controlTick(const sensor_sample& s) {
+    updateDepth(s);
+    unsigned long now = s.time_ms;
+
+    if (currentState == IDLE || currentState == CALIBRATING) {
+        surfaceTracker.add(s.pressure_mbar * 100.0f);
+    }
+
+    // State machine
+    switch(currentState) {
         
-        if (strcmp(received_cmd.cmd, "predive") == 0) {
-            // Pre-dive verification - send current data to control station
-            sensor.read();
-            struct_message p;
-            strncpy(p.company_id, received_cmd.company_id, 10);
-            p.timestamp = 0;
-            p.pressure_kpa = sensor.pressure() / 10.0f;
-            p.depth_m = 0;
-            p.temp_c = sensor.temperature();
-            esp_now_send(controlMac, (uint8_t *) &p, sizeof(p));
-            Serial.println(">>> PRE-DIVE DATA SENT to control station");
-        } 
-        else if (strcmp(received_cmd.cmd, "deploy") == 0) {
-            strncpy(active_company_id, received_cmd.company_id, 10);
-            target_fd = received_cmd.target_fd; 
-            target_sd = received_cmd.target_sd;
-            fdt = received_cmd.fdt; 
-            sdt = received_cmd.sdt;
-            start_mission = true;
-            Serial.printf(">>> MISSION CONFIG: %.2fm (hold %ds), %.2fm (hold %ds)\n", 
-                          target_fd, fdt, target_sd, sdt);
-        } 
-        else if (strcmp(received_cmd.cmd, "send_now") == 0) {
-            transmit_requested = true;
-            Serial.println(">>> DATA REQUEST RECEIVED - will transmit after recovery");
+        // ================================================================
+        // CALIBRATION - Only until the surface tracker has enough samples
+        // ================================================================
+        case CALIBRATING:
+            if (surfaceTracker.ready()) beginDive(now);
+            break;
+        
+        // ================================================================
+        // MISSION SEGMENTS - travel, hold, then surface (runMission)
+        // ================================================================
+        case TRAVEL:
+        case HOLD:
+        case SURFACING:
+            runMission(now);
+            break;
+        
+        // ================================================================
+        // MISSION DONE / IDLE - Hand data requests to the log task. After
+        // a reset the last mission is still in flash (the trace is not).
+        // ================================================================
+        case MISSION_DONE:
+        case IDLE:
+            if (transmit_requested) {
+                // A repeat request restarts the sender; the station keeps
+                // what it already has and acks past it
+                requestDownload(STREAM_MISSION_LOG);
+                transmit_requested = false;
+            }
+            if (trace_requested) {
+                requestDownload(STREAM_TRACE);
+                trace_requested = false;
+            }
+            if (probes_requested) {
+                requestDownload(STREAM_PROBES);
+                probes_requested = false;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    // High-rate trace, after the state machine so the record carries this
+    // tick's piston command
+    if (missionRunning()) traceData(now);
+
+    publishStatus(now);
+}
+
+void controlStep() {
+    struct_command cmd;
+    while (commandRing.pop(cmd)) handleCommand(cmd);
+    if (start_mission && currentState == IDLE) startMission(millis());
+    // A move held back while the position was parked (the log task wakes
+    // this task once it has unparked)
+    if (piston_move_pending && !piston_parked.load()) movePistonTo(piston_pending_target);
+
+    // Forward limit tripped mid-move: the engine re-referenced to max sink
+    if (piston.consumeLimitEvent()) {
+        Serial.printf(">>> LIMIT_FWD hit, piston re-referenced to %d\n", PISTON_MAX_STEPS);
+    }
+
+    sensor_sample s;
+    while (sampleRing.pop(s)) {
+        {
+            PROBE_SCOPE(PROBE_CONTROL_TICK);
+            controlTick(s);
+        }
+        // Probes in the next tick count against the state it starts in
+        PROBE_SET_STATE(currentState);
+        if (s.periodic) samplePeriodJitter.add(s.period_error_us);
+        controlLatency.add((int32_t)((ESP.getCycleCount() - s.cycles) / ESP.getCpuFreqMHz()));
+    }
+}
+
+// ============================================================================
+// LOG AND RADIO TASKS
+// ============================================================================
+
+void logStep() {
+#if defined(FLOAT_PROBES)
+    // Dump the probes once the mission is done (outside the LOG_STEP probe)
+    static bool probes_printed = false;
+    float_status last;
+    if (floatStatus.tryRead(last)) {
+        if (last.state == MISSION_DONE && !probes_printed) printProbeReport();
+        probes_printed = (last.state == MISSION_DONE);
+    }
+#endif
+    PROBE_SCOPE(PROBE_LOG_STEP);
+
+    log_request r;
+    while (logRing.pop(r)) {
+        if (r.kind == LOG_BEGIN_SESSION) {
+            missionLog.beginSession(r.company_id, r.surface_pressure_kpa, 1025.0f);
+            PROBE_SCOPE(PROBE_FLASH_SERVICE);
+            missionLog.prepare(LOG_ERASE_AHEAD_SECTORS);
+        } else {
+            writeLogEntry(r.sample);
         }
     }
+
+    switch (download_request.exchange(0)) {
+        case STREAM_MISSION_LOG:
+            if (missionLog.sessionEntries() > 0) startLogDownload();
+            break;
+        case STREAM_TRACE:
+            if (traceLog.count() > 0) startTraceDownload();
+            break;
+        case STREAM_PROBES:
+#if defined(FLOAT_PROBES)
+            startProbeDownload();
+#else
+            Serial.println(">>> PROBES not built in (-DFLOAT_PROBES)");
+#endif
+            break;
+        default:
+            break;
+    }
+    serviceLogLink();
+    download_active.store(logSender.active());
+
+    // Program sealed log pages while the piston is still (flash writes
+    // hold off non-IRAM interrupts and code on both cores for ~1 ms). The
+    // control task publishes a new move in the same tick it starts it.
+    float_status status;
+    bool have_status = floatStatus.tryRead(status);
+    bool idle = have_status && !status.piston_moving;
+    if (have_status) serviceParkedPosition(status);
+    saveNeutralMap(idle);
+    // Erase ahead while waiting for deploy, which starts the dive at once
+    if (idle && status.state == IDLE && !logSender.active()) {
+        PROBE_SCOPE(PROBE_FLASH_SERVICE);
+        missionLog.prepare(LOG_ERASE_AHEAD_SECTORS);
+    }
+    PROBE_SCOPE(PROBE_FLASH_SERVICE);
+    missionLog.service(idle);
 }
 
+void radioStep() {
+    PROBE_SCOPE(PROBE_RADIO_STEP);
+    static bool reported = false;
+
+    radio_message m;
+    while (radioOutbox.pop(m)) {
+        PROBE_SCOPE(PROBE_RADIO_SEND);
+        esp_now_send(controlMac, m.data, m.len);
+    }
+
+    float_status status;
+    if (!floatStatus.tryRead(status)) return;
+    serviceTelemetry(status);
+
+    if (status.state == MISSION_DONE && !reported) {
+        Serial.printf("[LIVE] %u telemetry frames sent, %u refused by the radio\n",
+                      telemetry_sent, telemetry_dropped);
+    }
+    reported = (status.state == MISSION_DONE);
+}
+
+// Core 1 (APP_CPU) runs the control chain, core 0 (PRO_CPU) shares the
+// WiFi stack with the radio and flash work.
+const FloatTaskSpec FLOAT_TASKS[TASK_COUNT] = {
+    // name       step          period  notify  core  prio  stack
+    {"sample",   sampleStep,   SAMPLE_PERIOD_MS, false, 1, 5, 4096},
+    {"control",  controlStep,  SAMPLE_PERIOD_MS, true,  1, 4, 8192},
+    {"radio",    radioStep,    20,               false, 0, 3, 4096},
+    {"log",      logStep,      10,               false, 0, 2, 8192},
+};
+
 // ============================================================================
 // SETUP
 // ============================================================================
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
     Serial.println("---SYSTEM BOOTING---");
 
+    // Pin configuration
+    pinMode(LIMIT_FWD, INPUT_PULLUP);
+    pinMode(STEP_PIN, OUTPUT);
+    pinMode(DIR_PIN, OUTPUT);
+    
+    // The step timer owns STEP/DIR from here on, homing included
+    stepTimer.begin(piston);
+    piston.setForwardLimitPosition(PISTON_MAX_STEPS);
+    piston.setLimitDebounce(LIMIT_DEBOUNCE_READS);
+
+    // The fast approach to LIMIT_FWD (Deepest/Least Buoyant point), from
+    // the parked position if NVS has one, runs while everything else
+    // starts up
+    bool parked = restoreParkedPosition();
+    if (parked) startParkedHoming();
+    else startHoming();
+
     // Initialize NeoPixel
     pixel.begin();
     pixel.setBrightness(RGB_BRIGHTNESS);
     pixel.setPixelColor(0, pixel.Color(255, 255, 255)); // White on boot
     pixel.show();
 
-    // Pin configuration
-    pinMode(LIMIT_FWD, INPUT_PULLUP);
-    pinMode(STEP_PIN, OUTPUT);
-    pinMode(DIR_PIN, OUTPUT);
-    
-    // PHASE 1: Seek the Forward Limit Switch (Deepest/Least Buoyant point)
-    digitalWrite(DIR_PIN, HIGH); 
-    while(digitalRead(LIMIT_FWD) == HIGH) {
-        digitalWrite(STEP_PIN, HIGH);
-        delayMicroseconds(800);
-        digitalWrite(STEP_PIN, LOW);
-        delayMicroseconds(800);
-    }
-    // At this exact moment, the piston is at its MAX SINK position.
-
-    // PHASE 2: Move 2200 steps BACKWARD to the Surface position
-    digitalWrite(DIR_PIN, LOW); 
-    for(int i = 0; i < 2200; i++) {
-        digitalWrite(STEP_PIN, HIGH);
-        delayMicroseconds(800);
-        digitalWrite(STEP_PIN, LOW);
-        delayMicroseconds(800);
-    }
-
-    // PHASE 3: THE FIX
-    // We tell the code: "Where we are right now is ZERO (Surface)."
-    currentPistonPosition = 0; 
-    
-    Serial.println("Piston homed: Surface = 0, Max Sink capability = 2200");
-    
     // ESP-NOW initialization
     WiFi.mode(WIFI_STA);
     if (esp_now_init() != ESP_OK) {
         Serial.println("ESP-NOW init failed!");
-        return;
+    } else {
+        esp_now_register_recv_cb(onDataRecv);
+        
+        esp_now_peer_info_t peerInfo = {};
+        memcpy(peerInfo.peer_addr, controlMac, 6);
+        peerInfo.channel = 0;
+        peerInfo.encrypt = false;
+        esp_now_add_peer(&peerInfo);
     }
-    esp_now_register_recv_cb(onDataRecv);
-    
-    esp_now_peer_info_t peerInfo = {};
-    memcpy(peerInfo.peer_addr, controlMac, 6);
-    peerInfo.channel = 0;
-    peerInfo.encrypt = false;
-    esp_now_add_peer(&peerInfo);
     
     // Pressure sensor initialization
     Wire.begin(SDA_PIN, SCL_PIN);
@@ -392,255 +1338,53 @@ void setup() {
     }
     pixel.show();
     
+    // Flash log: find the newest page and the mission it belongs to
+    if (!missionLog.begin()) {
+        Serial.println("WARNING: Flash log partition missing, nothing will be logged");
+    } else if (missionLog.sessionPages() > 0) {
+        Serial.printf("Flash log: session %u recovered, %u entries (Send to download)\n",
+                      missionLog.session(), missionLog.sessionEntries());
+    }
+
+    loadNeutralMap();
+
+    // Touch the switch slowly for the reference, then out to the surface
+    // position (Surface = 0, Max Sink = 2200)
+    if (parked && finishParkedHoming()) {
+        Serial.printf("Piston homed from parked position %d: Surface = 0, Max Sink capability = 2200\n",
+                      parked_position);
+    } else {
+        if (!parked) finishHoming();
+        Serial.println("Piston homed: Surface = 0, Max Sink capability = 2200");
+    }
+
     Serial.println("--- FLOAT READY ---");
     Serial.println("Sensor offset declarations (provide to judge):");
     Serial.printf("  Bottom offset (2.5m target): %.2fm\n", SENSOR_BOTTOM_OFFSET);
     Serial.printf("  Top offset (0.4m target): %.2fm\n", SENSOR_TOP_OFFSET);
+
+    // Probe budgets: a task step that takes longer than its period is an
+    // overrun, so is a control tick over the latency bound
+    PROBE_BUDGET_US(PROBE_CONTROL_TICK, CONTROL_LATENCY_BOUND_US);
+    PROBE_BUDGET_US(PROBE_SENSOR_READ, SAMPLE_PERIOD_MS * 1000);
+    PROBE_BUDGET_US(PROBE_RADIO_STEP, FLOAT_TASKS[TASK_RADIO].period_ms * 1000);
+    PROBE_BUDGET_US(PROBE_LOG_STEP, FLOAT_TASKS[TASK_LOG].period_ms * 1000);
+
+    // From here on the tasks own the sensor, piston, flash and radio
+    if (!floatTasksStart(FLOAT_TASKS, TASK_COUNT)) {
+        Serial.println("ERROR: could not start the firmware tasks!");
+        pixel.setPixelColor(0, pixel.Color(255, 0, 0));
+        pixel.show();
+    }
 }
 
 // ============================================================================
 // MAIN LOOP
 // ============================================================================
+// Arduino's loopTask (core 1, lowest priority) only drives the NeoPixel;
+// the mission runs in the tasks above.
 
 void loop() {
-    // Continuous logging every 5 seconds during entire mission
-    // (excluding IDLE before mission start and after completion)
-    if (currentState != IDLE && currentState != MISSION_DONE) {
-        if (millis() - logTimer >= 5000) { 
-            logData(); 
-            logTimer = millis(); 
-        }
-    }
-    
-    // Mission start sequence
-    if (start_mission && currentState == IDLE) {
-        Serial.println("[START] Initializing mission...");
-        setBuoyancyForDepth(0);  // Surface position
-        currentState = CALIBRATING;
-        start_mission = false;
-    }
-    
-    // State machine
-    switch(currentState) {
-        
-        // ================================================================
-        // CALIBRATION - Get surface pressure reference
-        // ================================================================
-        case CALIBRATING: {
-            Serial.println("[CALIBRATING] Measuring surface pressure...");
-            float sum_pa = 0;
-            for(int i = 0; i < 20; i++) { 
-                sensor.read(); 
-                sum_pa += (sensor.pressure() * 100.0f); 
-                delay(50); 
-            }
-            surface_pressure_pa = sum_pa / 20.0f;
-            surface_pressure_kpa = surface_pressure_pa / 1000.0f;
-            
-            missionStartTime = millis(); 
-            logTimer = millis();
-            logData();
-            
-            currentState = DESCEND_P1_LOW;
-            Serial.printf("[CALIBRATION] Surface pressure: %.2f kPa\n", surface_pressure_kpa);
-            break;
-        }
-        
-        // ================================================================
-        // PROFILE 1 - DESCEND to 2.5m
-        // ================================================================
-        case DESCEND_P1_LOW:
-            setBuoyancyForDepth(target_fd);
-            setLEDs(getBottomDepth(), target_fd, target_sd);
-            if (abs(getBottomDepth() - target_fd) < 0.05) {
-                currentState = HOLD_P1_LOW;
-                p1_low_hold_start = millis();
-                p1_low_valid_packets = 0;
-                p1_low_active = true;
-            }
-            break;
-        
-        // ================================================================
-        // PROFILE 1 - HOLD at 2.5m (±33cm) with 7-packet verification
-        // ================================================================
-        case HOLD_P1_LOW: { 
-            setBuoyancyForDepth(target_fd);
-            float p1_low_depth = getBottomDepth();
-            bool p1_low_in_range = (abs(p1_low_depth - target_fd) <= 0.33);
-            
-            setLEDs(p1_low_depth, target_fd, target_sd);
-            
-            if (!p1_low_in_range) {
-                p1_low_hold_start = millis();
-                p1_low_valid_packets = 0;
-            } else {
-                int intervals_completed = (millis() - p1_low_hold_start) / 5000;
-                if (intervals_completed > p1_low_valid_packets && intervals_completed <= 7) {
-                    p1_low_valid_packets = intervals_completed;
-                }
-            }
-            
-            if (p1_low_valid_packets >= 7) {
-                currentState = ASCEND_P1_HIGH;
-                p1_low_active = false;
-            }
-            break;
-        } 
-        
-        // ================================================================
-        // PROFILE 1 - ASCEND to 40cm
-        // ================================================================
-        case ASCEND_P1_HIGH:
-            setBuoyancyForDepth(target_sd);
-            setLEDs(getTopDepth(), target_fd, target_sd);
-            if (abs(getTopDepth() - target_sd) < 0.05) {
-                currentState = HOLD_P1_HIGH;
-                p1_high_hold_start = millis();
-                p1_high_valid_packets = 0;
-                p1_high_active = true;
-            }
-            break;
-        
-        // ================================================================
-        // PROFILE 1 - HOLD at 40cm (±33cm) with 7-packet verification
-        // ================================================================
-        case HOLD_P1_HIGH: { 
-            setBuoyancyForDepth(target_sd);
-            float p1_high_depth = getTopDepth();
-            bool p1_high_in_range = (abs(p1_high_depth - target_sd) <= 0.33);
-            
-            setLEDs(p1_high_depth, target_fd, target_sd);
-            
-            if (!p1_high_in_range) {
-                p1_high_hold_start = millis();
-                p1_high_valid_packets = 0;
-            } else {
-                int intervals_completed = (millis() - p1_high_hold_start) / 5000;
-                if (intervals_completed > p1_high_valid_packets && intervals_completed <= 7) {
-                    p1_high_valid_packets = intervals_completed;
-                }
-            }
-            
-            if (p1_high_valid_packets >= 7) {
-                currentState = DESCEND_P2_LOW;
-                p1_high_active = false;
-            }
-            break;
-        } 
-        
-        // ================================================================
-        // PROFILE 2 - DESCEND to 2.5m
-        // ================================================================
-        case DESCEND_P2_LOW:
-            setBuoyancyForDepth(target_fd);
-            setLEDs(getBottomDepth(), target_fd, target_sd);
-            if (abs(getBottomDepth() - target_fd) < 0.05) {
-                currentState = HOLD_P2_LOW;
-                p2_low_hold_start = millis();
-                p2_low_valid_packets = 0;
-                p2_low_active = true;
-            }
-            break;
-        
-        // ================================================================
-        // PROFILE 2 - HOLD at 2.5m with verification
-        // ================================================================
-        case HOLD_P2_LOW: { 
-            setBuoyancyForDepth(target_fd);
-            float p2_low_depth = getBottomDepth();
-            bool p2_low_in_range = (abs(p2_low_depth - target_fd) <= 0.33);
-            
-            setLEDs(p2_low_depth, target_fd, target_sd);
-            
-            if (!p2_low_in_range) {
-                p2_low_hold_start = millis();
-                p2_low_valid_packets = 0;
-            } else {
-                int intervals_completed = (millis() - p2_low_hold_start) / 5000;
-                if (intervals_completed > p2_low_valid_packets && intervals_completed <= 7) {
-                    p2_low_valid_packets = intervals_completed;
-                }
-            }
-            
-            if (p2_low_valid_packets >= 7) {
-                currentState = ASCEND_P2_HIGH;
-                p2_low_active = false;
-            }
-            break;
-        } 
-        
-        // ================================================================
-        // PROFILE 2 - ASCEND to 40cm
-        // ================================================================
-        case ASCEND_P2_HIGH:
-            setBuoyancyForDepth(target_sd);
-            setLEDs(getTopDepth(), target_fd, target_sd);
-            if (abs(getTopDepth() - target_sd) < 0.05) {
-                currentState = HOLD_P2_HIGH;
-                p2_high_hold_start = millis();
-                p2_high_valid_packets = 0;
-                p2_high_active = true;
-            }
-            break;
-        
-        // ================================================================
-        // PROFILE 2 - HOLD at 40cm with verification
-        // ================================================================
-        case HOLD_P2_HIGH: { 
-            setBuoyancyForDepth(target_sd);
-            float p2_high_depth = getTopDepth();
-            bool p2_high_in_range = (abs(p2_high_depth - target_sd) <= 0.33);
-            
-            setLEDs(p2_high_depth, target_fd, target_sd);
-            
-            if (!p2_high_in_range) {
-                p2_high_hold_start = millis();
-                p2_high_valid_packets = 0;
-            } else {
-                int intervals_completed = (millis() - p2_high_hold_start) / 5000;
-                if (intervals_completed > p2_high_valid_packets && intervals_completed <= 7) {
-                    p2_high_valid_packets = intervals_completed;
-                }
-            }
-            
-            if (p2_high_valid_packets >= 7) {
-                currentState = SURFACING;
-                p2_high_active = false;
-            }
-            break;
-        } 
-        
-        // ================================================================
-        // SURFACING - Return to surface for recovery
-        // ================================================================
-        case SURFACING:
-            setBuoyancyForDepth(0);
-            setLEDs(getTopDepth(), target_fd, target_sd);
-            if (getTopDepth() < 0.10) {
-                currentState = MISSION_DONE;
-            }
-            break;
-        
-        // ================================================================
-        // MISSION DONE - Wait for data transmission request
-        // ================================================================
-        case MISSION_DONE:
-            pixel.setPixelColor(0, pixel.Color(128, 0, 128)); // Purple for Done
-            pixel.show();
-            if (transmit_requested) {
-                for(int i = 0; i < log_index; i++) {
-                    esp_now_send(controlMac, (uint8_t *) &sensor_data[i], sizeof(sensor_data[i]));
-                    delay(80);
-                }
-                transmit_requested = false;
-            }
-            break;
-        
-        case IDLE:
-        default:
-            break;
-    }
-        
-    // Small delay to prevent watchdog issues
+    serviceLEDs();
     delay(10);
 }
@@ -0,0 +1,202 @@
+// CompactLog encode/decode round trip (CompactLogWriter, CompactLogReader,
+// CompactLogStreamReader):
+//   pio test -e native -f test_compact_log
+// The codec is lossless on the quantized values, so every decoded field must
+// equal the writer's quantization of the sample exactly, whatever the deltas.
+
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <CompactLog.h>
+
+#define SURFACE_KPA 101.325f
+#define DENSITY 1025.0f
+
+// The writer's fixed-point units (see CompactLog.h)
+static int32_t units(float value, float scale) {
+    return (int32_t)floorf(value * scale + 0.5f);
+}
+
+static void assertDecoded(const LogSample& in, const LogSample& out) {
+    TEST_ASSERT_EQUAL_UINT32(in.time_ms / 10 * 10, out.time_ms);
+    TEST_ASSERT_TRUE(units(in.pressure_kpa, 100.0f) / 100.0f == out.pressure_kpa);
+    TEST_ASSERT_TRUE(units(in.depth_m, 1000.0f) / 1000.0f == out.depth_m);
+    TEST_ASSERT_TRUE(units(in.temp_c, 100.0f) / 100.0f == out.temp_c);
+}
+
+// Write all samples to one log and read them back
+static void roundTrip(const std::vector<LogSample>& samples) {
+    static uint8_t buffer[4096];
+    CompactLogWriter writer(buffer, sizeof(buffer));
+    writer.begin("FLOAT-01", SURFACE_KPA, DENSITY);
+    for (const LogSample& s : samples) TEST_ASSERT_TRUE(writer.append(s));
+
+    CompactLogReader reader(writer.data(), writer.bytes());
+    TEST_ASSERT_TRUE(reader.valid());
+    TEST_ASSERT_EQUAL_UINT32(samples.size(), reader.header().record_count);
+    LogSample out;
+    for (const LogSample& s : samples) {
+        TEST_ASSERT_TRUE(reader.next(out));
+        assertDecoded(s, out);
+    }
+    TEST_ASSERT_FALSE(reader.next(out));
+    TEST_ASSERT_TRUE(reader.valid());
+}
+
+// A dive: 1 s samples, depth as the calibration predicts it
+static std::vector<LogSample> dive(size_t n) {
+    std::vector<LogSample> samples;
+    for (size_t i = 0; i < n; i++) {
+        float depth = 2.5f * sinf(i * 0.05f) * sinf(i * 0.05f);
+        float kpa = SURFACE_KPA + depth * DENSITY * 9.80665f / 1000.0f;
+        samples.push_back({(uint32_t)(i * 1000 + (i % 3) * 10), kpa, depth, 18.0f - depth * 0.4f});
+    }
+    return samples;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_dive_round_trip() {
+    roundTrip(dive(200));
+}
+
+// Deltas at the ends of the zigzag range: every signed field swings close
+// to +-2^31 units and back, and through 0, -1, +1
+void test_zigzag_extremes() {
+    std::vector<LogSample> samples = {
+        {0, SURFACE_KPA, 0.0f, 20.0f},
+        {10, 1.07e7f, -1.0e6f, 1.07e7f},
+        {20, -1.07e7f, 1.0e6f, -1.07e7f},
+        {30, 1.07e7f, -1.0e6f, 1.07e7f},
+        {40, SURFACE_KPA, 0.0f, 20.0f},
+        {50, SURFACE_KPA - 0.01f, -0.001f, 19.99f},
+        {60, SURFACE_KPA + 0.01f, 0.001f, 20.01f},
+        {70, SURFACE_KPA, 0.0f, 20.0f},
+    };
+    roundTrip(samples);
+}
+
+// Big jumps in time (the sample interval) and pressure between ordinary
+// samples, each followed by the jump back
+void test_big_deltas() {
+    std::vector<LogSample> samples = dive(20);
+    uint32_t t = samples.back().time_ms;
+    samples.push_back({t + 3600000u, 5000.0f, 490.0f, 2.0f});      // an hour later, 490 m
+    samples.push_back({t + 3601000u, SURFACE_KPA, 0.0f, 25.0f});
+    samples.push_back({4294967290u, SURFACE_KPA, 0.0f, 25.0f});     // end of the clock
+    samples.push_back({4294967290u, SURFACE_KPA, 0.0f, 25.0f});     // interval 0
+    roundTrip(samples);
+}
+
+struct Collected {
+    std::vector<LogSample> samples;
+    std::vector<int32_t> surfaces;  // header surface_pressure per sample
+};
+
+static void collect(const compact_log_header& header, const LogSample& sample, void* ctx) {
+    Collected* c = (Collected*)ctx;
+    c->samples.push_back(sample);
+    c->surfaces.push_back(header.surface_pressure);
+}
+
+// Writes samples into flash-page-sized segments as the float does, starting
+// a new segment (with a drifted surface calibration) whenever one fills
+static std::vector<uint8_t> segmentedBlob(const std::vector<LogSample>& samples, int& segments) {
+    std::vector<uint8_t> blob;
+    uint8_t page[COMPACT_LOG_SEGMENT_BYTES];
+    CompactLogWriter writer(page, sizeof(page));
+    segments = 1;
+    writer.begin("FLOAT-01", SURFACE_KPA, DENSITY);
+    for (const LogSample& s : samples) {
+        if (writer.append(s)) continue;
+        blob.insert(blob.end(), writer.data(), writer.data() + writer.bytes());
+        writer.begin("FLOAT-01", SURFACE_KPA + 0.1f * segments++, DENSITY);
+        TEST_ASSERT_TRUE(writer.append(s));
+    }
+    blob.insert(blob.end(), writer.data(), writer.data() + writer.bytes());
+    return blob;
+}
+
+// Segment restarts: each segment decodes against its own header, whatever
+// the chunking of the blob on the link
+void test_segment_restarts() {
+    std::vector<LogSample> samples = dive(600);
+    int segments = 0;
+    std::vector<uint8_t> blob = segmentedBlob(samples, segments);
+    TEST_ASSERT_TRUE(segments >= 3);
+
+    const size_t chunks[] = {1, 7, 200, 4096};
+    for (size_t chunk : chunks) {
+        Collected got;
+        CompactLogStreamReader stream(collect, &got);
+        for (size_t i = 0; i < blob.size(); i += chunk) {
+            stream.feed(blob.data() + i, blob.size() - i < chunk ? blob.size() - i : chunk);
+        }
+        TEST_ASSERT_FALSE(stream.corrupt());
+        TEST_ASSERT_EQUAL_UINT32(segments, stream.segments());
+        TEST_ASSERT_EQUAL_UINT32(0, stream.badSegments());
+        TEST_ASSERT_EQUAL_UINT32(samples.size(), got.samples.size());
+        for (size_t i = 0; i < samples.size(); i++) assertDecoded(samples[i], got.samples[i]);
+        TEST_ASSERT_EQUAL_INT(units(SURFACE_KPA, 100.0f), got.surfaces.front());
+        TEST_ASSERT_TRUE(got.surfaces.back() > got.surfaces.front());
+    }
+}
+
+// A truncated stream: the segments that arrived whole decode in full, the
+// cut one yields nothing, and a log cut inside its bits is not valid
+void test_truncated_stream() {
+    std::vector<LogSample> samples = dive(600);
+    int segments = 0;
+    std::vector<uint8_t> blob = segmentedBlob(samples, segments);
+
+    // Length of the first segment, from its header
+    compact_log_header first;
+    memcpy(&first, blob.data(), sizeof(first));
+    size_t first_bytes = sizeof(first) + (first.bit_count + 7) / 8;
+
+    Collected got;
+    CompactLogStreamReader stream(collect, &got);
+    stream.feed(blob.data(), first_bytes + sizeof(first) + 5);
+    TEST_ASSERT_FALSE(stream.corrupt());
+    TEST_ASSERT_EQUAL_UINT32(1, stream.segments());
+    TEST_ASSERT_EQUAL_UINT32(first.record_count, got.samples.size());
+    for (size_t i = 0; i < got.samples.size(); i++) assertDecoded(samples[i], got.samples[i]);
+
+    CompactLogReader cut(blob.data(), first_bytes - 1);
+    TEST_ASSERT_FALSE(cut.valid());
+    CompactLogReader header_only(blob.data(), sizeof(first) - 1);
+    TEST_ASSERT_FALSE(header_only.valid());
+
+    // A record count beyond the bits: the records present decode, the
+    // segment is counted bad
+    std::vector<uint8_t> lying(blob.begin(), blob.begin() + first_bytes);
+    compact_log_header h = first;
+    h.record_count += 3;
+    memcpy(lying.data(), &h, sizeof(h));
+    Collected partial;
+    CompactLogStreamReader again(collect, &partial);
+    again.feed(lying.data(), lying.size());
+    TEST_ASSERT_EQUAL_UINT32(first.record_count, partial.samples.size());
+    TEST_ASSERT_EQUAL_UINT32(1, again.badSegments());
+
+    // A broken header ends decoding for good
+    std::vector<uint8_t> broken(blob);
+    broken[first_bytes] ^= 0xFF;                // magic of segment 2
+    Collected rest;
+    CompactLogStreamReader stopped(collect, &rest);
+    stopped.feed(broken.data(), broken.size());
+    TEST_ASSERT_TRUE(stopped.corrupt());
+    TEST_ASSERT_EQUAL_UINT32(first.record_count, rest.samples.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_dive_round_trip);
+    RUN_TEST(test_zigzag_extremes);
+    RUN_TEST(test_big_deltas);
+    RUN_TEST(test_segment_restarts);
+    RUN_TEST(test_truncated_stream);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// Hold scoring (MissionExecutor, MissionCompliance) against the rule:
+// each depth held for at least 35 s, 7 packets 5 s apart in the band.
+//   pio test -e native -f test_compliance
+// The fixture is a log downloaded by the simulator (--seed 1 --log), flown
+// with the station's default 30 s holds.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <MissionCompliance.h>
+#include <MissionExecutor.h>
+
+#define LOG_FIXTURE "test/fixtures/mission_log.csv"
+#define INTERVAL_MS 5000
+#define RULE_HOLD_S 35
+#define STATION_HOLD_S 30
+
+struct Packet {
+    uint32_t time_ms;
+    float depth_m;
+};
+
+// timestamp_s and depth_m of a log CSV as written by --log
+static std::vector<Packet> readLog(const char* path) {
+    std::vector<Packet> packets;
+    FILE* f = fopen(path, "r");
+    if (!f) return packets;
+    char line[256];
+    if (fgets(line, sizeof(line), f)) {
+        while (fgets(line, sizeof(line), f)) {
+            char id[16];
+            double t, pressure, depth;
+            if (sscanf(line, "%15[^,],%lf,%lf,%lf", id, &t, &pressure, &depth) != 4) continue;
+            packets.push_back({(uint32_t)(t * 1000.0 + 0.5), (float)depth});
+        }
+    }
+    fclose(f);
+    return packets;
+}
+
+// 2.5 m / 0.4 m twice, as the station deploys it
+static MissionPlan stationPlan(uint16_t hold_s = STATION_HOLD_S) {
+    MissionPlan plan;
+    missionPlanTwoProfiles(plan, 2.5f, hold_s, 0.4f, hold_s, 0, 0);
+    return plan;
+}
+
+// Dive to 2.5 m in 10 s and hold there, until the executor enters the hold
+static uint32_t intoHold(MissionExecutor& executor) {
+    executor.start(0);
+    executor.onPacket(0, 0);
+    for (uint32_t t = 100; t < 20000; t += 100) {
+        float depth = t < 10000 ? 2.5f * t / 10000 : 2.5f;
+        if (executor.packetDue(t)) executor.onPacket(depth, t);
+        if (executor.update(depth, t) && executor.phase() == PHASE_HOLD) return t;
+    }
+    return 0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_recorded_log_meets_every_hold() {
+    std::vector<Packet> packets = readLog(LOG_FIXTURE);
+    TEST_ASSERT_TRUE_MESSAGE(!packets.empty(), "missing " LOG_FIXTURE);
+    MissionCompliance compliance(stationPlan(), INTERVAL_MS);
+    for (const Packet& p : packets) compliance.addPacket(p.time_ms, p.depth_m);
+    TEST_ASSERT_TRUE(compliance.complete());
+    for (int i = 0; i < compliance.segmentCount(); i++) {
+        const hold_compliance& h = compliance.hold(i);
+        TEST_ASSERT_TRUE(h.met);
+        TEST_ASSERT_TRUE(h.packets >= MISSION_PACKETS + 1);
+        TEST_ASSERT_TRUE(h.last_ms - h.first_ms >= RULE_HOLD_S * 1000u);
+        TEST_ASSERT_TRUE(h.max_error_m <= MISSION_TOLERANCE_MM / 1000.0f);
+    }
+}
+
+// A packet missing from the log restarts the run: the first hold is met
+// later, from the packet after the gap
+void test_missing_packet_restarts_the_hold() {
+    std::vector<Packet> packets = readLog(LOG_FIXTURE);
+    TEST_ASSERT_TRUE_MESSAGE(packets.size() > 6, "missing " LOG_FIXTURE);
+    MissionCompliance full(stationPlan(), INTERVAL_MS);
+    for (const Packet& p : packets) full.addPacket(p.time_ms, p.depth_m);
+
+    uint32_t first_ms = full.hold(0).first_ms;
+    MissionCompliance gap(stationPlan(), INTERVAL_MS);
+    size_t dropped = 0;
+    for (const Packet& p : packets) {
+        if (!dropped && p.time_ms > first_ms + 2 * INTERVAL_MS) {
+            dropped = 1;
+            continue;
+        }
+        gap.addPacket(p.time_ms, p.depth_m);
+    }
+    TEST_ASSERT_TRUE(gap.hold(0).first_ms > first_ms + 2 * INTERVAL_MS);
+}
+
+// The requirement follows from the packets as well as hold_s: 7 packets
+// 5 s apart are 35 s, whatever shorter hold time the plan carries
+void test_required_span_and_packets() {
+    MissionPlan plan = stationPlan();
+    TEST_ASSERT_EQUAL_UINT32(RULE_HOLD_S * 1000u, missionHoldSpanMs(plan.segments[0], INTERVAL_MS));
+    TEST_ASSERT_EQUAL_UINT32(8, missionHoldPackets(plan.segments[0], INTERVAL_MS));
+    plan = stationPlan(RULE_HOLD_S);
+    TEST_ASSERT_EQUAL_UINT32(RULE_HOLD_S * 1000u, missionHoldSpanMs(plan.segments[0], INTERVAL_MS));
+    TEST_ASSERT_EQUAL_UINT32(8, missionHoldPackets(plan.segments[0], INTERVAL_MS));
+    plan = stationPlan(42);
+    TEST_ASSERT_EQUAL_UINT32(42000, missionHoldSpanMs(plan.segments[0], INTERVAL_MS));
+    TEST_ASSERT_EQUAL_UINT32(10, missionHoldPackets(plan.segments[0], INTERVAL_MS));
+}
+
+// Seven packets span only 30 s: a 35 s hold needs the eighth, even on the
+// station's 30 s plan
+void test_seven_packets_are_not_35_s() {
+    MissionCompliance compliance(stationPlan(), INTERVAL_MS);
+    for (int i = 0; i < 7; i++) compliance.addPacket(10000 + i * INTERVAL_MS, 2.5f);
+    TEST_ASSERT_FALSE(compliance.hold(0).met);
+    compliance.addPacket(10000 + 7 * INTERVAL_MS, 2.5f);
+    TEST_ASSERT_TRUE(compliance.hold(0).met);
+    TEST_ASSERT_EQUAL_UINT32(RULE_HOLD_S * 1000u, compliance.hold(0).last_ms - compliance.hold(0).first_ms);
+}
+
+// The executor ends a clean hold on the packet 35 s after it began, with
+// the station's 30 s plan as with the rule's 35 s
+void test_executor_holds_for_35_s() {
+    const uint16_t holds[] = {STATION_HOLD_S, RULE_HOLD_S};
+    for (uint16_t hold_s : holds) {
+        MissionExecutor executor(INTERVAL_MS);
+        TEST_ASSERT_TRUE(executor.load(stationPlan(hold_s)));
+        uint32_t hold_ms = intoHold(executor), left_ms = 0;
+        TEST_ASSERT_TRUE(hold_ms > 0);
+        for (uint32_t t = hold_ms; t < 120000 && !left_ms; t += 100) {
+            executor.update(2.5f, t);
+            if (executor.packetDue(t) && executor.onPacket(2.5f, t)) left_ms = t;
+        }
+        TEST_ASSERT_EQUAL_UINT32(hold_ms + RULE_HOLD_S * 1000u, left_ms);
+        TEST_ASSERT_EQUAL_UINT8(1, executor.segmentIndex());
+    }
+}
+
+// A packet out of the band restarts the count, and the next one is logged
+// as soon as the depth is back in the band, not an interval later
+void test_packet_due_back_in_the_band() {
+    MissionExecutor executor(INTERVAL_MS);
+    TEST_ASSERT_TRUE(executor.load(stationPlan()));
+    uint32_t t = intoHold(executor);
+    TEST_ASSERT_TRUE(t > 0);
+    TEST_ASSERT_TRUE(executor.packetDue(t));
+    executor.onPacket(2.5f, t);
+    t += INTERVAL_MS;
+    TEST_ASSERT_TRUE(executor.packetDue(t));
+    executor.onPacket(3.0f, t);                 // 50 cm deep
+    TEST_ASSERT_EQUAL_UINT8(0, executor.validPackets());
+
+    executor.update(2.9f, t + 100);             // still out
+    TEST_ASSERT_FALSE(executor.packetDue(t + 100));
+    uint32_t back_ms = t + 1300;
+    executor.update(2.7f, back_ms);             // in again
+    TEST_ASSERT_TRUE(executor.packetDue(back_ms));
+    executor.onPacket(2.7f, back_ms);
+    TEST_ASSERT_EQUAL_UINT8(1, executor.validPackets());
+    TEST_ASSERT_EQUAL_UINT32(back_ms, executor.holdStartMs());
+    TEST_ASSERT_FALSE(executor.packetDue(back_ms + 100));
+
+    // The restarted hold ends 35 s after the re-entry packet
+    uint32_t left_ms = 0;
+    for (uint32_t now = back_ms + 100; now < back_ms + 60000 && !left_ms; now += 100) {
+        executor.update(2.5f, now);
+        if (executor.packetDue(now) && executor.onPacket(2.5f, now)) left_ms = now;
+    }
+    TEST_ASSERT_EQUAL_UINT32(back_ms + RULE_HOLD_S * 1000u, left_ms);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_recorded_log_meets_every_hold);
+    RUN_TEST(test_missing_packet_restarts_the_hold);
+    RUN_TEST(test_required_span_and_packets);
+    RUN_TEST(test_seven_packets_are_not_35_s);
+    RUN_TEST(test_executor_holds_for_35_s);
+    RUN_TEST(test_packet_due_back_in_the_band);
+    return UNITY_END();
+}
@@ -0,0 +1,216 @@
+// FlashRingLog on FileFlash (NOR semantics, power cuts by write budget):
+//   pio test -e native -f test_flash_log
+// A log reopened after a reset must give the same download as before it,
+// whatever happened to single pages, and the download view must stay
+// consistent when the ring wraps onto the session being written.
+
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <FlashRingLog.h>
+
+#define SURFACE_KPA 101.325f
+#define DENSITY 1025.0f
+#define CHUNK 240                   // one link frame of log data
+
+static const uint32_t PAGES_PER_SECTOR = FLASH_SECTOR_BYTES / FLASH_PAGE_BYTES;
+
+static FileFlash flash_;
+
+// Sample i of a dive, one a second
+static LogSample sample(uint32_t i) {
+    float depth = 2.5f * sinf(i * 0.05f) * sinf(i * 0.05f);
+    return {i * 1000, SURFACE_KPA + depth * DENSITY * 9.80665f / 1000.0f, depth, 18.0f - depth * 0.4f};
+}
+
+// Appends as the float does, the log task programming a page per sample
+static void fly(FlashRingLog& log, uint32_t first, uint32_t count) {
+    log.beginSession("FLOAT-01", SURFACE_KPA, DENSITY);
+    for (uint32_t i = first; i < first + count; i++) {
+        TEST_ASSERT_TRUE(log.append(sample(i)));
+        log.service(true);
+    }
+    log.sync();
+}
+
+static void collect(const compact_log_header&, const LogSample& s, void* ctx) {
+    ((std::vector<uint32_t>*)ctx)->push_back(s.time_ms / 1000);
+}
+
+// The session as the station gets it: read() in link chunks, decoded
+static std::vector<uint32_t> download(FlashRingLog& log) {
+    std::vector<uint32_t> got;
+    CompactLogStreamReader stream(collect, &got);
+    uint8_t chunk[CHUNK];
+    for (uint32_t offset = 0; offset < log.sessionBytes(); offset += CHUNK) {
+        size_t n = log.read(offset, chunk, sizeof(chunk));
+        TEST_ASSERT_TRUE(n > 0);
+        stream.feed(chunk, n);
+    }
+    TEST_ASSERT_FALSE(stream.corrupt());
+    TEST_ASSERT_EQUAL_UINT32(0, stream.badSegments());
+    return got;
+}
+
+// Samples first .. first + count - 1, in order
+static void assertRun(const std::vector<uint32_t>& got, uint32_t first, uint32_t count) {
+    TEST_ASSERT_EQUAL_UINT32(count, got.size());
+    for (uint32_t i = 0; i < count; i++) TEST_ASSERT_EQUAL_UINT32(first + i, got[i]);
+}
+
+// Clears bits of a programmed page, as a program that went wrong would
+static void damage(uint32_t page, uint32_t offset) {
+    const uint8_t zeros[4] = {0, 0, 0, 0};
+    TEST_ASSERT_TRUE(flash_.write(page * FLASH_PAGE_BYTES + offset, zeros, sizeof(zeros)));
+}
+
+// Record count of a programmed page
+static uint32_t pageEntries(uint32_t page) {
+    uint8_t buf[FLASH_PAGE_BYTES];
+    TEST_ASSERT_TRUE(flash_.read(page * FLASH_PAGE_BYTES, buf, sizeof(buf)));
+    CompactLogReader reader(buf + sizeof(flash_page_header), COMPACT_LOG_SEGMENT_BYTES);
+    return reader.header().record_count;
+}
+
+void setUp() {
+    TEST_ASSERT_TRUE(flash_.open(nullptr, 16 * FLASH_SECTOR_BYTES));
+    flash_.setWriteBudget(-1);
+}
+
+void tearDown() {}
+
+// A reopened log recovers the newest session byte for byte
+void test_recovers_the_session() {
+    FlashRingLog log(flash_);
+    TEST_ASSERT_TRUE(log.begin());
+    fly(log, 0, 200);
+    fly(log, 1000, 600);
+    TEST_ASSERT_EQUAL_UINT32(600, log.sessionEntries());
+    assertRun(download(log), 1000, 600);
+
+    FlashRingLog after(flash_);
+    TEST_ASSERT_TRUE(after.begin());
+    TEST_ASSERT_EQUAL_UINT32(log.session(), after.session());
+    TEST_ASSERT_EQUAL_UINT32(log.sessionPages(), after.sessionPages());
+    TEST_ASSERT_EQUAL_UINT32(log.sessionBytes(), after.sessionBytes());
+    TEST_ASSERT_EQUAL_UINT32(600, after.sessionEntries());
+    assertRun(download(after), 1000, 600);
+
+    // The next mission is a new session after the recovered one
+    fly(after, 5000, 100);
+    TEST_ASSERT_EQUAL_UINT32(log.session() + 1, after.session());
+    FlashRingLog again(flash_);
+    TEST_ASSERT_TRUE(again.begin());
+    assertRun(download(again), 5000, 100);
+}
+
+// A power cut in the middle of a page: the pages before it are recovered,
+// and the next session starts past the torn page
+void test_torn_page() {
+    FlashRingLog log(flash_);
+    TEST_ASSERT_TRUE(log.begin());
+    fly(log, 0, 300);
+    uint32_t pages = log.sessionPages();
+    log.beginSession("FLOAT-01", SURFACE_KPA, DENSITY);
+    for (uint32_t i = 300; i < 330; i++) TEST_ASSERT_TRUE(log.append(sample(i)));
+    flash_.setWriteBudget(sizeof(flash_page_header) + 8);
+    log.sync();
+    flash_.setWriteBudget(-1);
+
+    FlashRingLog after(flash_);
+    TEST_ASSERT_TRUE(after.begin());
+    TEST_ASSERT_EQUAL_UINT32(pages, after.sessionPages());
+    assertRun(download(after), 0, 300);
+
+    fly(after, 1000, 100);
+    FlashRingLog again(flash_);
+    TEST_ASSERT_TRUE(again.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, again.pageErrors());
+    assertRun(download(again), 1000, 100);
+}
+
+// Pages inside the session that fail their CRC (a bad payload, a bad
+// header) cost only their own entries: recovery walks on past them
+void test_failed_pages_inside_the_session() {
+    FlashRingLog log(flash_);
+    TEST_ASSERT_TRUE(log.begin());
+    fly(log, 0, 600);
+    TEST_ASSERT_TRUE(log.sessionPages() > 8);
+    uint32_t lost_entries = pageEntries(3) + pageEntries(5);
+    damage(3, sizeof(flash_page_header) + 40);
+    damage(5, 0);
+
+    FlashRingLog after(flash_);
+    TEST_ASSERT_TRUE(after.begin());
+    TEST_ASSERT_EQUAL_UINT32(log.sessionPages(), after.sessionPages());
+    TEST_ASSERT_EQUAL_UINT32(600 - lost_entries, after.sessionEntries());
+    std::vector<uint32_t> got = download(after);
+    TEST_ASSERT_EQUAL_UINT32(600 - lost_entries, got.size());
+    TEST_ASSERT_EQUAL_UINT32(0, got.front());
+    TEST_ASSERT_EQUAL_UINT32(599, got.back());
+}
+
+// A session longer than the ring: eraseAhead() drops its oldest pages with
+// their sector, and the download is the newest part, whole and in order,
+// before and after a reset
+void test_ring_wrap_trims_the_oldest_pages() {
+    FlashRingLog log(flash_);
+    TEST_ASSERT_TRUE(log.begin());
+    fly(log, 0, 300);
+    const uint32_t count = 12000;
+    fly(log, 10000, count);
+    TEST_ASSERT_EQUAL_UINT32(0, log.pageErrors());
+    TEST_ASSERT_TRUE(log.sessionPages() <= log.capacityPages());
+    TEST_ASSERT_TRUE(log.sessionPages() + 2 * PAGES_PER_SECTOR > log.capacityPages());
+    TEST_ASSERT_TRUE(log.sessionEntries() < count);
+
+    std::vector<uint32_t> got = download(log);
+    uint32_t kept = log.sessionEntries();
+    assertRun(got, 10000 + count - kept, kept);
+
+    FlashRingLog after(flash_);
+    TEST_ASSERT_TRUE(after.begin());
+    TEST_ASSERT_EQUAL_UINT32(log.sessionPages(), after.sessionPages());
+    TEST_ASSERT_EQUAL_UINT32(log.sessionBytes(), after.sessionBytes());
+    TEST_ASSERT_EQUAL_UINT32(kept, after.sessionEntries());
+    assertRun(download(after), 10000 + count - kept, kept);
+}
+
+// Retransmits: reads that step back (and jump about) give the same bytes
+// as one pass front to back
+void test_read_steps_back() {
+    FlashRingLog log(flash_);
+    TEST_ASSERT_TRUE(log.begin());
+    fly(log, 0, 600);
+    const uint32_t size = log.sessionBytes();
+    std::vector<uint8_t> blob(size);
+    TEST_ASSERT_EQUAL_UINT32(size, log.read(0, blob.data(), size));
+
+    uint8_t chunk[CHUNK];
+    const uint32_t offsets[] = {CHUNK, 0, 5 * CHUNK, 2 * CHUNK + 17, size - 1, 1, size / 2, 3};
+    for (uint32_t offset : offsets) {
+        size_t n = log.read(offset, chunk, sizeof(chunk));
+        size_t want = size - offset < CHUNK ? size - offset : CHUNK;
+        TEST_ASSERT_EQUAL_UINT32(want, n);
+        TEST_ASSERT_EQUAL_MEMORY(blob.data() + offset, chunk, n);
+    }
+    // The whole session backwards, a chunk at a time
+    for (uint32_t end = size; end > 0;) {
+        uint32_t offset = end > CHUNK ? end - CHUNK : 0;
+        TEST_ASSERT_EQUAL_UINT32(end - offset, log.read(offset, chunk, end - offset));
+        TEST_ASSERT_EQUAL_MEMORY(blob.data() + offset, chunk, end - offset);
+        end = offset;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.read(size, chunk, sizeof(chunk)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_recovers_the_session);
+    RUN_TEST(test_torn_page);
+    RUN_TEST(test_failed_pages_inside_the_session);
+    RUN_TEST(test_ring_wrap_trims_the_oldest_pages);
+    RUN_TEST(test_read_steps_back);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+// LogLinkSender to LogLinkReceiver over a seeded LoopbackLink:
+//   pio test -e native -f test_log_link
+// Whatever the link loses, repeats or reorders, the receiver must hand over
+// the blob exactly once, in order. A repeated request for the same blob
+// resumes where the last one stopped; another blob of the same size must
+// start over, not be spliced onto what the receiver holds.
+
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include <LogLink.h>
+#include <LoopbackLink.h>
+
+#define BLOB_BYTES (40 * LINK_CHUNK_BYTES + 100)
+
+struct Station {
+    LogLinkReceiver* receiver;
+    std::vector<uint8_t> got;
+    int16_t transfer = -1;          // as the Control Station tracks it
+    int restarts = 0;
+};
+
+static LoopbackLink* link_ = nullptr;
+static uint64_t now_us_ = 0;
+static std::vector<uint8_t> blob_;
+
+static std::vector<uint8_t> makeBlob(uint8_t salt) {
+    std::vector<uint8_t> blob(BLOB_BYTES);
+    for (size_t i = 0; i < blob.size(); i++) blob[i] = (uint8_t)(i * 7 + i / 251 + salt);
+    return blob;
+}
+
+static size_t readBlob(uint32_t offset, uint8_t* dst, size_t len, void* ctx) {
+    (void)ctx;
+    if (offset >= blob_.size()) return 0;
+    if (len > blob_.size() - offset) len = blob_.size() - offset;
+    memcpy(dst, blob_.data() + offset, len);
+    return len;
+}
+
+static bool floatSend(const uint8_t* frame, size_t len, void* ctx) {
+    (void)ctx;
+    return link_->send(0, frame, len, now_us_);
+}
+
+static void floatReceive(const uint8_t* data, size_t len, void* ctx) {
+    if (len != sizeof(link_ack_frame)) return;
+    link_ack_frame ack;
+    memcpy(&ack, data, sizeof(ack));
+    ((LogLinkSender*)ctx)->onAck(ack, (uint32_t)(now_us_ / 1000));
+}
+
+// Bytes in order; a new transfer throws away what came of the last one
+static void deliver(const uint8_t* data, size_t len, void* ctx) {
+    Station* station = (Station*)ctx;
+    if (station->transfer >= 0 && station->receiver->transfer() != station->transfer) {
+        station->got.clear();
+        station->restarts++;
+    }
+    station->transfer = station->receiver->transfer();
+    station->got.insert(station->got.end(), data, data + len);
+}
+
+static void stationReceive(const uint8_t* data, size_t len, void* ctx) {
+    link_ack_frame ack;
+    if (((Station*)ctx)->receiver->onFrame(data, len, ack)) {
+        link_->send(1, (const uint8_t*)&ack, sizeof(ack), now_us_);
+    }
+}
+
+// Runs the link in 1 ms steps until the sender stops or 'ms' have passed
+static void run(LogLinkSender& sender, uint32_t ms) {
+    for (uint32_t i = 0; i < ms && sender.active(); i++) {
+        now_us_ += 1000;
+        link_->pump(now_us_);
+        sender.poll((uint32_t)(now_us_ / 1000));
+    }
+    now_us_ += 100000;
+    link_->pump(now_us_);           // let the last frames land
+}
+
+struct Rig {
+    LoopbackLink link;
+    Station station;
+    LogLinkReceiver receiver;
+    LogLinkSender sender;
+
+    explicit Rig(uint32_t seed)
+        : link(seed), receiver(STREAM_MISSION_LOG, deliver, &station), sender(floatSend, nullptr) {
+        station.receiver = &receiver;
+        link_ = &link;
+        link.attach(0, floatReceive, &sender);
+        link.attach(1, stationReceive, &station);
+    }
+
+    void send(uint8_t transfer, const std::vector<uint8_t>& blob) {
+        blob_ = blob;
+        sender.begin(STREAM_MISSION_LOG, transfer, blob.size(), readBlob, nullptr, (uint32_t)(now_us_ / 1000));
+    }
+};
+
+static void assertGot(const Station& station, const std::vector<uint8_t>& blob) {
+    TEST_ASSERT_EQUAL_UINT32(blob.size(), station.got.size());
+    TEST_ASSERT_EQUAL_MEMORY(blob.data(), station.got.data(), blob.size());
+}
+
+void setUp() {
+    now_us_ = 0;
+}
+
+void tearDown() {}
+
+// A clean link: every chunk once, no retransmits
+void test_clean_transfer() {
+    Rig rig(1);
+    std::vector<uint8_t> blob = makeBlob(0);
+    rig.send(1, blob);
+    run(rig.sender, 10000);
+    TEST_ASSERT_TRUE(rig.sender.complete());
+    TEST_ASSERT_TRUE(rig.receiver.complete());
+    TEST_ASSERT_EQUAL_UINT32(linkChunkCount(BLOB_BYTES), rig.sender.framesSent());
+    TEST_ASSERT_EQUAL_UINT32(0, rig.receiver.duplicates());
+    assertGot(rig.station, blob);
+}
+
+// 30 % of the frames lost both ways, and jitter past the retransmit
+// timeout, so frames arrive late, out of order and twice
+void test_loss_and_duplicates() {
+    const uint32_t seeds[] = {1, 2, 3, 4};
+    for (uint32_t seed : seeds) {
+        Rig rig(seed);
+        rig.link.setLoss(0.3f);
+        rig.link.setJitterUs(LINK_RTO_MS * 1500);
+        std::vector<uint8_t> blob = makeBlob((uint8_t)seed);
+        rig.send(1, blob);
+        run(rig.sender, 60000);
+        TEST_ASSERT_TRUE(rig.sender.complete());
+        TEST_ASSERT_TRUE(rig.receiver.complete());
+        TEST_ASSERT_TRUE(rig.sender.retransmits() > 0);
+        TEST_ASSERT_TRUE(rig.receiver.duplicates() > 0);
+        TEST_ASSERT_EQUAL_INT(0, rig.station.restarts);
+        assertGot(rig.station, blob);
+    }
+}
+
+// The link dies half way and the sender gives up; the same blob requested
+// again continues from the receiver's base instead of from chunk 0
+void test_resume_same_transfer() {
+    Rig rig(5);
+    rig.link.setLoss(0.2f);
+    std::vector<uint8_t> blob = makeBlob(5);
+    rig.send(3, blob);
+    while (rig.station.got.size() < BLOB_BYTES / 2) run(rig.sender, 1);
+    rig.link.setLoss(1.0f);
+    run(rig.sender, LINK_GIVE_UP_MS + 1000);
+    TEST_ASSERT_TRUE(rig.sender.failed());
+    TEST_ASSERT_FALSE(rig.receiver.complete());
+    size_t had = rig.station.got.size();
+
+    rig.link.setLoss(0);
+    rig.send(3, blob);
+    run(rig.sender, 10000);
+    TEST_ASSERT_TRUE(rig.sender.complete());
+    TEST_ASSERT_EQUAL_INT(0, rig.station.restarts);
+    assertGot(rig.station, blob);
+    // Only what was missing went out again (plus the first window, sent
+    // before the receiver's ack told the sender where it stood)
+    TEST_ASSERT_TRUE(rig.sender.framesSent() <= linkChunkCount(BLOB_BYTES - had) + (uint32_t)LINK_WINDOW);
+}
+
+// An interrupted transfer, then a different blob of the same size: the
+// receiver starts over and hands over only the new blob
+void test_new_transfer_starts_over() {
+    Rig rig(6);
+    std::vector<uint8_t> first = makeBlob(6);
+    rig.send(3, first);
+    while (rig.station.got.size() < BLOB_BYTES / 2) run(rig.sender, 1);
+    rig.link.setLoss(1.0f);
+    run(rig.sender, LINK_GIVE_UP_MS + 1000);
+    TEST_ASSERT_TRUE(rig.sender.failed());
+
+    rig.link.setLoss(0);
+    std::vector<uint8_t> second = makeBlob(60);
+    rig.send(4, second);
+    run(rig.sender, 10000);
+    TEST_ASSERT_TRUE(rig.sender.complete());
+    TEST_ASSERT_TRUE(rig.receiver.complete());
+    TEST_ASSERT_EQUAL_UINT32(4, rig.receiver.transfer());
+    TEST_ASSERT_EQUAL_INT(1, rig.station.restarts);
+    assertGot(rig.station, second);
+}
+
+// A late ACK of another transfer does not move the sender on
+void test_stale_ack_ignored() {
+    Rig rig(7);
+    rig.link.setLoss(1.0f);
+    rig.send(9, makeBlob(7));
+    run(rig.sender, 10);
+    link_ack_frame ack = {LINK_ACK, STREAM_MISSION_LOG, 8, linkChunkCount(BLOB_BYTES), 0};
+    rig.sender.onAck(ack, (uint32_t)(now_us_ / 1000));
+    TEST_ASSERT_FALSE(rig.sender.complete());
+    ack.transfer = 9;
+    rig.sender.onAck(ack, (uint32_t)(now_us_ / 1000));
+    TEST_ASSERT_TRUE(rig.sender.complete());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_clean_transfer);
+    RUN_TEST(test_loss_and_duplicates);
+    RUN_TEST(test_resume_same_transfer);
+    RUN_TEST(test_new_transfer_starts_over);
+    RUN_TEST(test_stale_ack_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+// Mission executor replay of a recorded trace: the transitions it makes
+// on the recorded depths must be the ones the float made.
+//   pio test -e native -f test_replay
+// The fixture is a high-rate trace downloaded by the simulator
+// (--seed 1 --trace-log). The simulator checks any trace the same way:
+//   program --replay test/fixtures/mission_trace.csv
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <MissionExecutor.h>
+
+#define TRACE_FIXTURE "test/fixtures/mission_trace.csv"
+#define INTERVAL_MS 5000
+#define ROUNDING_M 0.0005f              // the trace keeps depth to the mm
+#define HOLD_S 30                       // the station default, as recorded
+
+struct Row {
+    uint32_t t_ms;
+    char state[16];
+    unsigned segment;               // 1-based, as recorded
+    float depth_m;
+    float measured_m;               // what the float logged
+};
+
+struct Transition {
+    uint32_t t_ms;
+    const char* state;
+    unsigned segment;
+};
+
+// What the float did in the recorded run, from its state column
+static const Transition EXPECTED[] = {
+    {70, "TRAVEL", 1},
+    {8370, "HOLD", 1},
+    {43370, "TRAVEL", 2},
+    {50370, "HOLD", 2},
+    {85370, "TRAVEL", 3},
+    {92670, "HOLD", 3},
+    {127670, "TRAVEL", 4},
+    {134970, "HOLD", 4},
+    {169970, "SURFACING", 5},
+};
+static const size_t EXPECTED_COUNT = sizeof(EXPECTED) / sizeof(EXPECTED[0]);
+
+// t_s,state,segment,depth_m,measured_m,... as written by --trace-log
+static std::vector<Row> readTrace(const char* path) {
+    std::vector<Row> rows;
+    FILE* f = fopen(path, "r");
+    if (!f) return rows;
+    char line[256];
+    if (fgets(line, sizeof(line), f)) {
+        while (fgets(line, sizeof(line), f)) {
+            Row r;
+            double t, depth, measured;
+            if (sscanf(line, "%lf,%15[^,],%u,%lf,%lf", &t, r.state, &r.segment, &depth, &measured) != 5) continue;
+            r.t_ms = (uint32_t)(t * 1000.0 + 0.5);
+            r.depth_m = depth < 0 ? 0 : (float)depth;
+            r.measured_m = measured < 0 ? 0 : (float)measured;
+            rows.push_back(r);
+        }
+    }
+    fclose(f);
+    return rows;
+}
+
+static const char* phaseName(MissionPhase phase) {
+    switch (phase) {
+        case PHASE_TRAVEL:    return "TRAVEL";
+        case PHASE_HOLD:      return "HOLD";
+        case PHASE_SURFACING: return "SURFACING";
+        default:              return "MISSION_DONE";
+    }
+}
+
+// Changes of state or segment along a run of per-row states
+static void addTransition(std::vector<Transition>& out, uint32_t t_ms, const char* state, unsigned segment) {
+    if (!out.empty() && !strcmp(out.back().state, state) && out.back().segment == segment) return;
+    out.push_back({t_ms, state, segment});
+}
+
+// The executor on the recorded depths plus 'offset_m', as the firmware
+// drives it each tick, logging packets on its schedule
+static std::vector<Transition> replay(const std::vector<Row>& rows, const MissionPlan& plan, float offset_m) {
+    std::vector<Transition> out;
+    MissionExecutor executor(INTERVAL_MS);
+    TEST_ASSERT_TRUE(executor.load(plan));
+    for (size_t i = 0; i < rows.size(); i++) {
+        const Row& r = rows[i];
+        float depth = r.depth_m + offset_m < 0 ? 0 : r.depth_m + offset_m;
+        float logged = r.measured_m + offset_m < 0 ? 0 : r.measured_m + offset_m;
+        if (i == 0) {
+            executor.start(r.t_ms);
+            executor.onPacket(logged, r.t_ms);
+        }
+        executor.update(depth, r.t_ms);
+        if (executor.packetDue(r.t_ms)) executor.onPacket(logged, r.t_ms);
+        addTransition(out, r.t_ms, phaseName(executor.phase()), executor.segmentIndex() + 1);
+    }
+    return out;
+}
+
+static MissionPlan stationPlan(uint16_t hold_s) {
+    MissionPlan plan;
+    missionPlanTwoProfiles(plan, 2.5f, hold_s, 0.4f, hold_s, 0, 0);
+    return plan;
+}
+
+static bool sameStates(const std::vector<Transition>& got) {
+    if (got.size() != EXPECTED_COUNT) return false;
+    for (size_t i = 0; i < EXPECTED_COUNT; i++) {
+        if (strcmp(got[i].state, EXPECTED[i].state) || got[i].segment != EXPECTED[i].segment) return false;
+    }
+    return true;
+}
+
+// The expected transitions, at exactly the recorded times
+static bool sameTransitions(const std::vector<Transition>& got) {
+    if (!sameStates(got)) return false;
+    for (size_t i = 0; i < EXPECTED_COUNT; i++) {
+        if (got[i].t_ms != EXPECTED[i].t_ms) return false;
+    }
+    return true;
+}
+
+// Replays on the recorded depths and on them ROUNDING_M shallower and
+// deeper all make the expected transitions, and each recorded time lies
+// between the earliest and the latest of theirs. The trace keeps depth to
+// the millimetre, so a sample on the edge of the arrive band may switch a
+// sample or more either way.
+static bool bracketsTransitions(const std::vector<Row>& rows, const MissionPlan& plan) {
+    std::vector<Transition> runs[3] = {replay(rows, plan, 0), replay(rows, plan, -ROUNDING_M),
+                                       replay(rows, plan, ROUNDING_M)};
+    for (const std::vector<Transition>& run : runs) {
+        if (!sameStates(run)) return false;
+    }
+    for (size_t i = 0; i < EXPECTED_COUNT; i++) {
+        uint32_t first = runs[0][i].t_ms, last = runs[0][i].t_ms;
+        for (const std::vector<Transition>& run : runs) {
+            if (run[i].t_ms < first) first = run[i].t_ms;
+            if (run[i].t_ms > last) last = run[i].t_ms;
+        }
+        if (EXPECTED[i].t_ms < first || EXPECTED[i].t_ms > last) return false;
+    }
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The fixture records the expected transitions
+void test_recorded_transitions() {
+    std::vector<Row> rows = readTrace(TRACE_FIXTURE);
+    TEST_ASSERT_TRUE_MESSAGE(!rows.empty(), "missing " TRACE_FIXTURE);
+    std::vector<Transition> recorded;
+    for (const Row& r : rows) addTransition(recorded, r.t_ms, r.state, r.segment);
+    TEST_ASSERT_TRUE(sameTransitions(recorded));
+}
+
+void test_replay_makes_the_recorded_transitions() {
+    std::vector<Row> rows = readTrace(TRACE_FIXTURE);
+    TEST_ASSERT_TRUE_MESSAGE(!rows.empty(), "missing " TRACE_FIXTURE);
+    TEST_ASSERT_TRUE(bracketsTransitions(rows, stationPlan(HOLD_S)));
+}
+
+// The check bites: a 40 s hold stays in every hold too long
+void test_replay_of_another_plan_mismatches() {
+    std::vector<Row> rows = readTrace(TRACE_FIXTURE);
+    TEST_ASSERT_TRUE_MESSAGE(!rows.empty(), "missing " TRACE_FIXTURE);
+    TEST_ASSERT_FALSE(bracketsTransitions(rows, stationPlan(40)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_recorded_transitions);
+    RUN_TEST(test_replay_makes_the_recorded_transitions);
+    RUN_TEST(test_replay_of_another_plan_mismatches);
+    return UNITY_END();
+}
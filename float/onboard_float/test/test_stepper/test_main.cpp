@@ -0,0 +1,205 @@
+// StepperEngine step timing against MotionProfile, edge by edge on
+// FakeStepTimer:
+//   pio test -e native -f test_stepper
+// Each step's interval (STEP rising edge to rising edge) is checked against
+// the ideal constant-acceleration timing of the profile: exactly the first
+// and cruise intervals where the profile gives them, within the error of
+// Austin's recurrence on the ramps.
+
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include <StepperEngine.h>
+#include <StepTimer.h>
+
+static const MotionProfile PROFILE = {2000.0f, 8000.0f};   // the mission profile
+
+static FakeStepTimer* timer_ = nullptr;
+static std::vector<uint64_t> rises_;        // STEP rising edges, us
+static std::vector<uint64_t> dir_changes_;
+static bool step_level_ = false;
+static bool limit_closed_ = false;
+
+static void setDir(bool) { dir_changes_.push_back(timer_->nowUs()); }
+static void setStep(bool level) {
+    if (level && !step_level_) rises_.push_back(timer_->nowUs());
+    step_level_ = level;
+}
+static bool limitHit() { return limit_closed_; }
+
+static const StepperPins PINS = {setDir, setStep, limitHit};
+
+// Step k (0-based) of a ramp from standstill ideally starts at sqrt(2k/a)
+static double idealRampIntervalUs(uint32_t k) {
+    return sqrt(2.0 / PROFILE.accel_sps2) * (sqrt(k + 1.0) - sqrt((double)k)) * 1e6;
+}
+
+// Intervals between rising edges; interval k belongs to step k
+static std::vector<uint32_t> intervals() {
+    std::vector<uint32_t> out;
+    for (size_t i = 1; i < rises_.size(); i++) out.push_back((uint32_t)(rises_[i] - rises_[i - 1]));
+    return out;
+}
+
+static void runMove(StepperEngine& engine, FakeStepTimer& timer, int32_t target) {
+    engine.moveTo(target);
+    for (int i = 0; i < 100000 && engine.isMoving(); i++) timer.advance(1000);
+}
+
+void setUp() {
+    rises_.clear();
+    dir_changes_.clear();
+    step_level_ = false;
+    limit_closed_ = false;
+}
+
+void tearDown() {}
+
+// Ramp steps and the move time match the closed forms
+void test_profile_closed_forms() {
+    TEST_ASSERT_EQUAL_UINT32(250, PROFILE.rampSteps());
+    TEST_ASSERT_EQUAL_INT((int32_t)(1e6f / 2000.0f * 256.0f), PROFILE.cruiseIntervalQ8());
+    TEST_ASSERT_EQUAL_INT((int32_t)(0.676f * sqrtf(2.0f / 8000.0f) * 1e6f * 256.0f), PROFILE.firstIntervalQ8());
+    TEST_ASSERT_EQUAL_UINT32(2 * 250000 + 1700 * 500, PROFILE.moveDurationUs(2200));
+}
+
+// Full stroke: accelerate, cruise at max_sps, decelerate into the target
+void test_trapezoidal_move_intervals() {
+    FakeStepTimer timer;
+    timer_ = &timer;
+    StepperEngine engine(PINS, timer);
+    timer.begin(engine);
+    engine.setProfile(PROFILE);
+    runMove(engine, timer, 2200);
+
+    TEST_ASSERT_EQUAL_INT(2200, engine.currentPosition());
+    TEST_ASSERT_EQUAL_UINT32(2200, rises_.size());
+    TEST_ASSERT_EQUAL_UINT32(1, dir_changes_.size());
+
+    std::vector<uint32_t> c = intervals();
+    const uint32_t first_us = (uint32_t)PROFILE.firstIntervalQ8() >> 8;
+    const uint32_t cruise_us = (uint32_t)PROFILE.cruiseIntervalQ8() >> 8;
+    // The first interval is Austin's corrected c0
+    TEST_ASSERT_EQUAL_UINT32(first_us, c[0]);
+
+    uint32_t accel = 0, cruise = 0, decel = 0;
+    for (size_t k = 0; k < c.size(); k++) {
+        if (c[k] == cruise_us) {
+            cruise++;
+            continue;
+        }
+        // On a ramp: accelerating from the start or braking into the end
+        bool braking = k > c.size() / 2;
+        uint32_t ramp_k = braking ? (uint32_t)(c.size() - k) : (uint32_t)k;
+        double ideal = idealRampIntervalUs(ramp_k);
+        if (ramp_k > 0) {
+            TEST_ASSERT_FLOAT_WITHIN(ideal * 0.03 + 1.0, ideal, c[k]);
+        }
+        TEST_ASSERT_TRUE(c[k] > cruise_us);
+        if (braking) {
+            decel++;
+            TEST_ASSERT_TRUE(c[k] >= c[k - 1]);
+        } else {
+            accel++;
+            if (k > 0) TEST_ASSERT_TRUE(c[k] <= c[k - 1]);
+        }
+    }
+    // Ramp lengths follow rampSteps(), cruise takes the rest
+    TEST_ASSERT_TRUE(accel + 2 >= PROFILE.rampSteps() && accel <= PROFILE.rampSteps() + 2);
+    TEST_ASSERT_TRUE(decel + 2 >= PROFILE.rampSteps() && decel <= PROFILE.rampSteps() + 2);
+    TEST_ASSERT_EQUAL_UINT32(c.size(), accel + cruise + decel);
+
+    // The whole move within 2 % of the closed form. The recurrence runs
+    // slightly ahead of ideal on both ramps, never behind it.
+    double move_us = (double)(rises_.back() - rises_.front()) + cruise_us;
+    TEST_ASSERT_FLOAT_WITHIN(PROFILE.moveDurationUs(2200) * 0.02, PROFILE.moveDurationUs(2200), move_us);
+    TEST_ASSERT_TRUE(move_us <= PROFILE.moveDurationUs(2200));
+}
+
+// Short move: a triangle that never reaches max_sps
+void test_triangular_move_intervals() {
+    FakeStepTimer timer;
+    timer_ = &timer;
+    StepperEngine engine(PINS, timer);
+    timer.begin(engine);
+    engine.setProfile(PROFILE);
+    engine.setPosition(1000);
+    const int32_t steps = 200;          // < 2 * rampSteps()
+    runMove(engine, timer, 1000 - steps);
+
+    TEST_ASSERT_EQUAL_INT(1000 - steps, engine.currentPosition());
+    TEST_ASSERT_EQUAL_UINT32(steps, rises_.size());
+
+    std::vector<uint32_t> c = intervals();
+    const uint32_t cruise_us = (uint32_t)PROFILE.cruiseIntervalQ8() >> 8;
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)PROFILE.firstIntervalQ8() >> 8, c[0]);
+    size_t fastest = 0;
+    for (size_t k = 0; k < c.size(); k++) {
+        TEST_ASSERT_TRUE(c[k] > cruise_us);
+        if (c[k] < c[fastest]) fastest = k;
+        uint32_t ramp_k = k < c.size() / 2 ? (uint32_t)k : (uint32_t)(c.size() - k);
+        if (ramp_k > 0) {
+            double ideal = idealRampIntervalUs(ramp_k);
+            TEST_ASSERT_FLOAT_WITHIN(ideal * 0.03 + 1.0, ideal, c[k]);
+        }
+    }
+    // Peak speed half way, accelerating before it, braking after it
+    TEST_ASSERT_TRUE(fastest + 3 >= c.size() / 2 && fastest <= c.size() / 2 + 3);
+    for (size_t k = 1; k <= fastest; k++) TEST_ASSERT_TRUE(c[k] <= c[k - 1]);
+    for (size_t k = fastest + 1; k < c.size(); k++) TEST_ASSERT_TRUE(c[k] >= c[k - 1]);
+
+    double move_us = (double)(rises_.back() - rises_.front()) + c.back();
+    TEST_ASSERT_FLOAT_WITHIN(PROFILE.moveDurationUs(steps) * 0.05, PROFILE.moveDurationUs(steps), move_us);
+    TEST_ASSERT_TRUE(move_us <= PROFILE.moveDurationUs(steps));
+}
+
+// FakeStepTimer: nothing fires before its time, and the engine leaves the
+// timer idle once the move is done
+void test_fake_timer_fires_on_time() {
+    FakeStepTimer timer;
+    timer_ = &timer;
+    StepperEngine engine(PINS, timer);
+    timer.begin(engine);
+    engine.setProfile(PROFILE);
+    engine.moveTo(3);
+    TEST_ASSERT_TRUE(timer.armed());
+    timer.advance(49);                  // DIR setup is 50 us
+    TEST_ASSERT_EQUAL_UINT32(0, dir_changes_.size());
+    timer.advance(1);
+    TEST_ASSERT_EQUAL_UINT32(1, dir_changes_.size());
+    TEST_ASSERT_EQUAL_UINT32(0, rises_.size());
+    timer.advance(50);                  // first STEP after another DIR setup
+    TEST_ASSERT_EQUAL_UINT32(1, rises_.size());
+    TEST_ASSERT_EQUAL_UINT32(100, rises_[0]);
+    timer.advance(1000000);
+    TEST_ASSERT_FALSE(engine.isMoving());
+    TEST_ASSERT_FALSE(timer.armed());
+    TEST_ASSERT_EQUAL_INT(3, engine.currentPosition());
+}
+
+// The forward limit aborts a move and re-references the position
+void test_forward_limit_aborts() {
+    FakeStepTimer timer;
+    timer_ = &timer;
+    StepperEngine engine(PINS, timer);
+    timer.begin(engine);
+    engine.setProfile(PROFILE);
+    engine.setForwardLimitPosition(2200);
+    engine.moveTo(4400);
+    for (int i = 0; i < 100 && engine.isMoving(); i++) timer.advance(1000);
+    limit_closed_ = true;
+    runMove(engine, timer, 4400);
+    TEST_ASSERT_TRUE(engine.consumeLimitEvent());
+    TEST_ASSERT_EQUAL_INT(2200, engine.currentPosition());
+    TEST_ASSERT_FALSE(engine.isMoving());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_closed_forms);
+    RUN_TEST(test_trapezoidal_move_intervals);
+    RUN_TEST(test_triangular_move_intervals);
+    RUN_TEST(test_fake_timer_fires_on_time);
+    RUN_TEST(test_forward_limit_aborts);
+    return UNITY_END();
+}
@@ -0,0 +1,40 @@
+# Keyboard and servo nodes in one process, messages passed intra-process
+# (unique_ptr, no serialization), for bench and single-board setups:
+#   ros2 launch gripper claw_container.launch.py i2c_device:=mock
+# launch does not hand its stdin to the container, so the keyboard opens
+# the terminal itself (keyboard_tty, /dev/tty: the one launch runs in).
+
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+
+
+def generate_launch_description():
+    intra = {'use_intra_process_comms': True}
+    return LaunchDescription([
+        DeclareLaunchArgument('i2c_device', default_value='/dev/i2c-1'),
+        DeclareLaunchArgument('keyboard_tty', default_value='/dev/tty'),
+        ComposableNodeContainer(
+            name='claw_container',
+            namespace='',
+            package='rclcpp_components',
+            executable='component_container',
+            composable_node_descriptions=[
+                ComposableNode(
+                    package='gripper',
+                    plugin='ServoController',
+                    name='servo_controller',
+                    parameters=[{'i2c_device': LaunchConfiguration('i2c_device')}],
+                    extra_arguments=[intra]),
+                ComposableNode(
+                    package='gripper',
+                    plugin='KeyboardNode',
+                    name='keyboard_node',
+                    parameters=[{'input_device': LaunchConfiguration('keyboard_tty')}],
+                    extra_arguments=[intra]),
+            ],
+            output='screen',
+            emulate_tty=True),
+    ])
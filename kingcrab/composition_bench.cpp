@@ -0,0 +1,221 @@
+// Publish-to-callback latency and CPU of /servo_targets with the keyboard
+// and servo nodes as two processes (the standalone executables), and in one
+// process with and without intra-process communication:
+//
+//   ros2 run gripper composition_bench [rate_hz] [seconds]
+//
+// The sender publishes ServoTargets as unique_ptr from a timer at rate_hz.
+// "procs" runs the receiver in a forked process with its own context, so
+// messages cross processes through the middleware as between the keyboard
+// and servo executables; send times are in memory both processes share,
+// and the steady clock is the same for both. CPU is both processes'.
+// "dds" and "intra" put both nodes on one single-threaded executor, as in a
+// component container: "dds" goes through serialization and the
+// middleware's loopback, "intra" hands the same pointer to the subscription.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "rclcpp/rclcpp.hpp"
+#include "gripper/msg/servo_targets.hpp"
+
+#define SERVO_COUNT 13
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpu_us() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void report(const char* name, std::vector<double> latency, int total, double cpu, double wall) {
+    std::sort(latency.begin(), latency.end());
+    size_t n = latency.size();
+    double sum = 0;
+    for (double l : latency) sum += l;
+    printf("  %-5s %5zu/%d received, latency mean %6.1f us, p50 %6.1f us, p99 %6.1f us, "
+           "CPU %5.1f %% of a core\n",
+           name, n, total, n ? sum / n : 0.0, n ? latency[n / 2] : 0.0,
+           n ? latency[n * 99 / 100] : 0.0, 100 * cpu / wall);
+}
+
+// Between the sender and the forked receiver: a header, then 'total' send
+// times (sender) and 'total' latencies (receiver), in a MAP_SHARED mapping
+struct Shared {
+    std::atomic<bool> started{false};   // sender's clock is running
+    std::atomic<bool> done{false};      // sender is finished
+    std::atomic<int> received{0};
+    double receiver_cpu_us = 0;
+    double* sent() { return reinterpret_cast<double*>(this + 1); }
+};
+
+static Shared* map_shared(int total) {
+    size_t bytes = sizeof(Shared) + 2 * total * sizeof(double);
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : new (p) Shared();     // mmap memory is zeroed
+}
+
+// The servo side of "procs", in the child; CPU counts from the sender's start
+static int receive_process(int argc, char** argv, Shared* shared, int total, double seconds) {
+    rclcpp::init(argc, argv);
+    double* sent = shared->sent();
+    double* latency = sent + total;
+    auto receiver = std::make_shared<rclcpp::Node>("composition_bench_servo");
+    auto sub = receiver->create_subscription<gripper::msg::ServoTargets>("servo_targets", 10,
+        [&](gripper::msg::ServoTargets::UniquePtr msg) {
+            double t = now_us();
+            int n = static_cast<int>(msg->angle_deg[0]);
+            int k = shared->received.load();
+            if (n >= 0 && n < total && sent[n] > 0 && k < total) {
+                latency[k] = t - sent[n];
+                shared->received = k + 1;
+            }
+        });
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(receiver);
+    double cpu0 = -1;
+    double end = now_us() + seconds * 1e6 + 10e6;      // discovery on top
+    while (!shared->done && now_us() < end) {
+        executor.spin_once(std::chrono::milliseconds(10));
+        if (cpu0 < 0 && shared->started) cpu0 = cpu_us();
+    }
+    shared->receiver_cpu_us = cpu0 < 0 ? 0 : cpu_us() - cpu0;
+    rclcpp::shutdown();
+    return 0;
+}
+
+// The keyboard side of "procs", in the parent
+static void bench_processes(pid_t child, Shared* shared, double rate_hz, double seconds) {
+    const int total = static_cast<int>(rate_hz * seconds);
+    double* sent = shared->sent();
+    auto sender = std::make_shared<rclcpp::Node>("composition_bench_keyboard");
+    auto pub = sender->create_publisher<gripper::msg::ServoTargets>("servo_targets", 10);
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(sender);
+    double settle_until = now_us() + 500000;
+    double give_up = now_us() + 10e6;
+    while ((pub->get_subscription_count() == 0 || now_us() < settle_until) && now_us() < give_up) {
+        executor.spin_once(std::chrono::milliseconds(10));
+    }
+
+    int next = 0;
+    auto timer = sender->create_wall_timer(
+        std::chrono::microseconds(static_cast<int64_t>(1e6 / rate_hz)), [&]() {
+            if (next >= total) return;
+            auto msg = std::make_unique<gripper::msg::ServoTargets>();
+            msg->mask = (1u << SERVO_COUNT) - 1;
+            for (int i = 0; i < SERVO_COUNT; ++i) msg->angle_deg[i] = 90;
+            msg->angle_deg[0] = static_cast<float>(next);
+            sent[next++] = now_us();
+            pub->publish(std::move(msg));
+        });
+
+    shared->started = true;
+    double wall0 = now_us(), cpu0 = cpu_us();
+    double end = wall0 + seconds * 1e6 + 200000;
+    while (now_us() < end && shared->received < total) {
+        executor.spin_once(std::chrono::milliseconds(10));
+    }
+    double wall = now_us() - wall0, cpu = cpu_us() - cpu0;
+    shared->done = true;
+    waitpid(child, nullptr, 0);
+
+    const double* latency = sent + total;
+    report("procs", std::vector<double>(latency, latency + shared->received), total,
+           cpu + shared->receiver_cpu_us, wall);
+}
+
+static void bench(bool intra, double rate_hz, double seconds) {
+    rclcpp::NodeOptions options;
+    options.use_intra_process_comms(intra);
+    auto sender = std::make_shared<rclcpp::Node>("composition_bench_keyboard", options);
+    auto receiver = std::make_shared<rclcpp::Node>("composition_bench_servo", options);
+
+    // The send time of message n, matched up by the number in angle_deg[0]
+    const int total = static_cast<int>(rate_hz * seconds);
+    std::vector<double> sent(total, 0), latency;
+    latency.reserve(total);
+
+    auto sub = receiver->create_subscription<gripper::msg::ServoTargets>("servo_targets", 10,
+        [&](gripper::msg::ServoTargets::UniquePtr msg) {
+            double t = now_us();
+            int n = static_cast<int>(msg->angle_deg[0]);
+            if (n >= 0 && n < total && sent[n] > 0) latency.push_back(t - sent[n]);
+        });
+    auto pub = sender->create_publisher<gripper::msg::ServoTargets>("servo_targets", 10);
+
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(sender);
+    executor.add_node(receiver);
+    // Let discovery finish before the clock starts (DDS only)
+    double settle_until = now_us() + 500000;
+    while (pub->get_subscription_count() == 0 || now_us() < settle_until) {
+        executor.spin_once(std::chrono::milliseconds(10));
+    }
+
+    int next = 0;
+    auto timer = sender->create_wall_timer(
+        std::chrono::microseconds(static_cast<int64_t>(1e6 / rate_hz)), [&]() {
+            if (next >= total) return;
+            auto msg = std::make_unique<gripper::msg::ServoTargets>();
+            msg->mask = (1u << SERVO_COUNT) - 1;
+            for (int i = 0; i < SERVO_COUNT; ++i) msg->angle_deg[i] = 90;
+            msg->angle_deg[0] = static_cast<float>(next);
+            sent[next++] = now_us();
+            pub->publish(std::move(msg));
+        });
+
+    // spin_once sleeps until there is work, so the CPU is what the
+    // messages cost, not a busy loop
+    double wall0 = now_us(), cpu0 = cpu_us();
+    double end = wall0 + seconds * 1e6 + 200000;
+    while (now_us() < end && static_cast<int>(latency.size()) < total) {
+        executor.spin_once(std::chrono::milliseconds(10));
+    }
+    double wall = now_us() - wall0, cpu = cpu_us() - cpu0;
+    report(intra ? "intra" : "dds", latency, total, cpu, wall);
+}
+
+int main(int argc, char** argv) {
+    double rate_hz = argc > 1 ? atof(argv[1]) : 1000;
+    double seconds = argc > 2 ? atof(argv[2]) : 5;
+
+    // Fork before either side starts ROS: a process must not fork with the
+    // middleware's threads running
+    Shared* shared = map_shared(static_cast<int>(rate_hz * seconds));
+    if (!shared) {
+        perror("mmap");
+        return 2;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 2;
+    }
+    if (child == 0) _exit(receive_process(argc, argv, shared, static_cast<int>(rate_hz * seconds), seconds));
+    rclcpp::init(argc, argv);
+
+    printf("ServoTargets at %.0f Hz for %.0f s: two processes, then one process on one executor\n",
+           rate_hz, seconds);
+    bench_processes(child, shared, rate_hz, seconds);
+    bench(false, rate_hz, seconds);
+    bench(true, rate_hz, seconds);
+
+    rclcpp::shutdown();
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "key_input.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+
+static int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+KeyInput::KeyInput(int fd, const KeyInputConfig& config, Publish publish, Other other)
+    : fd_(fd), config_(config), publish_(std::move(publish)), other_(std::move(other)) {}
+
+KeyInput::~KeyInput() {
+    stop();
+}
+
+void KeyInput::map_key(char key, int servo, int direction) {
+    Key& k = keys_[static_cast<unsigned char>(key)];
+    k.servo = servo;
+    k.direction = direction;
+}
+
+bool KeyInput::start() {
+    if (running_.load()) return true;
+    if (pipe(wake_) != 0) return false;
+    finished_ = false;
+    escape_ = ESCAPE_NONE;
+
+    // Raw once for the whole session: no line buffering, no echo, one
+    // byte is enough for read(). ISIG stays, so Ctrl-C still works.
+    if (isatty(fd_) && tcgetattr(fd_, &saved_) == 0) {
+        termios raw = saved_;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        raw_ = tcsetattr(fd_, TCSANOW, &raw) == 0;
+    }
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+void KeyInput::stop() {
+    if (!running_.exchange(false)) return;
+    char c = 0;
+    if (write(wake_[1], &c, 1) < 0) {}     // the thread sees running_ on its next poll anyway
+    if (thread_.joinable()) thread_.join();
+    close(wake_[0]);
+    close(wake_[1]);
+}
+
+void KeyInput::run() {
+    const int64_t period_ns = static_cast<int64_t>(1e9 / config_.rate_hz);
+    while (running_.load(std::memory_order_relaxed) && !finished_.load(std::memory_order_relaxed)) {
+        // Sleep until a byte comes, or the next held-key command is due
+        timespec timeout = {0, 0};
+        if (next_tick_ns_) {
+            int64_t wait_ns = next_tick_ns_ - monotonic_ns();
+            if (wait_ns > 0) {
+                timeout.tv_sec = wait_ns / 1000000000LL;
+                timeout.tv_nsec = wait_ns % 1000000000LL;
+            }
+        }
+        pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+        int ready = ppoll(fds, 2, next_tick_ns_ ? &timeout : nullptr, nullptr);
+        if (ready < 0 && errno != EINTR) break;
+        int64_t now = monotonic_ns();
+
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            char buf[64];
+            ssize_t n = read(fd_, buf, sizeof(buf));
+            if (n > 0) on_bytes(buf, n, now);
+        }
+        if (ready > 0 && (fds[0].revents & (POLLHUP | POLLERR)) && !(fds[0].revents & POLLIN)) {
+            break;      // the terminal (or pty) went away
+        }
+        if (next_tick_ns_ && now >= next_tick_ns_) {
+            double late_us = (now - next_tick_ns_) / 1000.0;
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                if (late_us > stats_.tick_late_max_us) stats_.tick_late_max_us = late_us;
+            }
+            on_tick(now);
+            if (next_tick_ns_) {
+                next_tick_ns_ += period_ns;
+                if (next_tick_ns_ <= now) next_tick_ns_ = now + period_ns;     // skip the missed ones
+            }
+        }
+    }
+    // Input is over: the terminal back to normal at once, not at stop()
+    if (raw_) tcsetattr(fd_, TCSANOW, &saved_);
+    raw_ = false;
+}
+
+void KeyInput::on_bytes(const char* buf, ssize_t n, int64_t now_ns) {
+    const int64_t hold_ns = config_.hold_detect_ms * 1000000LL;
+    std::vector<int32_t> pairs;
+    for (ssize_t i = 0; i < n && !finished_.load(std::memory_order_relaxed); ++i) {
+        char c = buf[i];
+        unsigned char u = static_cast<unsigned char>(c);
+        if (escape_ == ESCAPE_CSI) {
+            // Parameter and intermediate bytes up to the final byte. Anything
+            // else means the sequence was cut; the byte counts as typed.
+            if (u >= 0x40 && u <= 0x7E) escape_ = ESCAPE_NONE;
+            if (u >= 0x20 && u <= 0x7E) continue;
+            escape_ = ESCAPE_NONE;
+        } else if (escape_ == ESCAPE_SS3) {
+            escape_ = ESCAPE_NONE;      // its one final byte
+            continue;
+        }
+        if (c == 27) {
+            // ESC last in the read (or before another ESC) is the key itself:
+            // quit. ESC [ and ESC O start arrow and function key sequences,
+            // skipped to their end (across reads if need be) so keys typed
+            // after them still count. ESC before any other byte is Alt with
+            // that key, ignored.
+            if (i + 1 == n || buf[i + 1] == 27) {
+                other_(c);
+                continue;
+            }
+            char next = buf[++i];
+            if (next == '[') escape_ = ESCAPE_CSI;
+            else if (next == 'O') escape_ = ESCAPE_SS3;
+            continue;
+        }
+        Key& k = keys_[static_cast<unsigned char>(c)];
+        if (k.servo < 0) {
+            other_(c);
+            continue;
+        }
+        if (k.held) {
+            k.last_ns = now_ns;
+        } else if (k.pressed_ns && now_ns - k.pressed_ns <= hold_ns) {
+            // The terminal started repeating: held, first command now
+            k.held = true;
+            k.last_ns = now_ns;
+            k.pending_deg = 0;
+            if (!next_tick_ns_) next_tick_ns_ = now_ns;
+        } else {
+            k.pressed_ns = now_ns;
+            pairs.push_back(k.servo);
+            pairs.push_back(k.direction * config_.step_deg);
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.presses++;
+        }
+    }
+    if (!pairs.empty()) publish(pairs, now_ns);
+}
+
+void KeyInput::on_tick(int64_t now_ns) {
+    const int64_t release_ns = config_.release_ms * 1000000LL;
+    const double step = config_.velocity_deg_s / config_.rate_hz;
+    std::vector<int32_t> pairs;
+    bool any_held = false;
+    for (Key& k : keys_) {
+        if (!k.held) continue;
+        if (now_ns - k.last_ns > release_ns) {
+            k.held = false;
+            k.pressed_ns = 0;
+            continue;
+        }
+        any_held = true;
+        k.pending_deg += k.direction * step;
+        int32_t delta = static_cast<int32_t>(std::trunc(k.pending_deg));
+        if (!delta) continue;
+        k.pending_deg -= delta;
+        pairs.push_back(k.servo);
+        pairs.push_back(delta);
+    }
+    if (!any_held) next_tick_ns_ = 0;
+    if (!pairs.empty()) publish(pairs, 0);
+}
+
+// Latency only for commands a byte caused; the held ones are on a schedule
+void KeyInput::publish(const std::vector<int32_t>& pairs, int64_t since_ns) {
+    publish_(pairs);
+    int64_t done_ns = monotonic_ns();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.commands++;
+    if (since_ns) {
+        double us = (done_ns - since_ns) / 1000.0;
+        stats_.latency_count++;
+        latency_sum_us_ += us;
+        if (us > stats_.latency_max_us) stats_.latency_max_us = us;
+        stats_.latency_mean_us = latency_sum_us_ / stats_.latency_count;
+    }
+}
+
+KeyInput::Stats KeyInput::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+void KeyInput::reset_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_ = {};
+    latency_sum_us_ = 0;
+}
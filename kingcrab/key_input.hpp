@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <termios.h>
+#include <thread>
+#include <vector>
+
+// Keyboard input for the keyboard node, on its own thread so the executor
+// never waits for a key. The terminal goes into raw mode once (restored by
+// stop()), and the thread ppoll()s the fd; any fd works, so a pty can stand
+// in for the keyboard.
+//
+// A terminal only sends bytes, never key-up. A press is one step right
+// away. A second byte of the same key within hold_detect_ms (the terminal's
+// own repeat starting) makes it held: from then on the key moves its servo
+// at velocity_deg_s, as commands at rate_hz, whatever the repeat rate is.
+// It counts as released when no repeat comes for release_ms.
+//
+// Arrow and function keys arrive as escape sequences (ESC [ ... final byte,
+// ESC O x) and are skipped; only an ESC on its own is passed on as a key.
+struct KeyInputConfig {
+    double rate_hz = 50;            // commands per second while keys are held
+    double velocity_deg_s = 60;     // servo speed while held
+    int step_deg = 5;               // a single press
+    int hold_detect_ms = 700;       // longer than the terminal's repeat delay
+    int release_ms = 120;           // longer than its repeat interval
+};
+
+class KeyInput {
+public:
+    // [servo_id, delta] pairs, one or more per call
+    typedef std::function<void(const std::vector<int32_t>& pairs)> Publish;
+    // A key that is not mapped: ESC (27) means quit
+    typedef std::function<void(char key)> Other;
+
+    struct Stats {
+        uint64_t presses;           // steps from a press
+        uint64_t commands;          // published messages, presses and held
+        uint64_t latency_count;     // key byte read -> publish returned
+        double latency_mean_us;
+        double latency_max_us;
+        double tick_late_max_us;    // held commands behind their schedule
+    };
+
+    KeyInput(int fd, const KeyInputConfig& config, Publish publish, Other other);
+    ~KeyInput();
+
+    KeyInput(const KeyInput&) = delete;
+    KeyInput& operator=(const KeyInput&) = delete;
+
+    // Before start(): 'key' moves 'servo' by +/- step (direction 1 or -1)
+    void map_key(char key, int servo, int direction);
+
+    // Raw mode (if the fd is a terminal) and the thread. False with errno
+    // set if the wake-up pipe can not be made.
+    bool start();
+    void stop();
+
+    // From a Publish or Other callback: the thread reads nothing more and
+    // puts the terminal back once the callback returns. stop() joins it.
+    void finish() { finished_ = true; }
+
+    Stats stats() const;
+    void reset_stats();
+
+private:
+    struct Key {
+        int servo = -1;             // -1 = not mapped
+        int direction = 0;
+        int64_t pressed_ns = 0;     // last press, 0 = none
+        int64_t last_ns = 0;        // last byte while held
+        bool held = false;
+        double pending_deg = 0;     // fraction of a degree not sent yet
+    };
+
+    enum Escape { ESCAPE_NONE, ESCAPE_CSI, ESCAPE_SS3 };
+
+    void run();
+    void on_bytes(const char* buf, ssize_t n, int64_t now_ns);
+    void on_tick(int64_t now_ns);
+    void publish(const std::vector<int32_t>& pairs, int64_t since_ns);
+
+    int fd_;
+    KeyInputConfig config_;
+    Publish publish_;
+    Other other_;
+    std::array<Key, 256> keys_;     // input thread after start()
+    int64_t next_tick_ns_ = 0;      // 0 = no key held
+    Escape escape_ = ESCAPE_NONE;   // inside an escape sequence (input thread)
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> finished_{false};
+    int wake_[2] = {-1, -1};
+    bool raw_ = false;
+    termios saved_ = {};
+
+    mutable std::mutex stats_mutex_;
+    Stats stats_ = {};
+    double latency_sum_us_ = 0;
+};
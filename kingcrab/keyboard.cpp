@@ -1,73 +1,194 @@
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 #include "std_msgs/msg/int32_multi_array.hpp"  // Changed from Int16MultiArray
-#include <termios.h>
+#include "gripper/msg/servo_state.hpp"
+#include "gripper/msg/servo_targets.hpp"
+#include <fcntl.h>
 #include <unistd.h>
-#include <map>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <array>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "key_input.hpp"
+
+#define SERVO_COUNT 13
 
 class KeyboardNode : public rclcpp::Node {
 public:
-    KeyboardNode() : Node("keyboard_node") {
-        // Changed to Int32MultiArray
-        pub_ = create_publisher<std_msgs::msg::Int32MultiArray>("keyboard_command", 10);
+    explicit KeyboardNode(const rclcpp::NodeOptions& options = rclcpp::NodeOptions())
+        : Node("keyboard_node", options) {
+        // "targets": absolute targets on /servo_targets, kept here and
+        // seeded from /servo_state, so a lost message does not leave the
+        // servo node off for good. "delta": [servo_id, delta] pairs on
+        // /keyboard_command as before.
+        std::string protocol = declare_parameter<std::string>("protocol", "targets");
+        use_targets_ = protocol != "delta";
+        intent_deg_.fill(90);   // the servo node's start position
+        if (use_targets_) {
+            targets_pub_ = create_publisher<gripper::msg::ServoTargets>("servo_targets", 10);
+            state_sub_ = create_subscription<gripper::msg::ServoState>(
+                "servo_state", 10,
+                [this](const gripper::msg::ServoState::ConstSharedPtr msg) { seed_intent(*msg); });
+        } else {
+            // Changed to Int32MultiArray
+            pub_ = create_publisher<std_msgs::msg::Int32MultiArray>("keyboard_command", 10);
+        }
+
+        // "" reads the terminal the node runs in; a tty or pty path reads
+        // that instead (e.g. a pty driven by a test)
+        std::string device = declare_parameter<std::string>("input_device", "");
+        KeyInputConfig config;
+        config.rate_hz = declare_parameter<double>("rate_hz", config.rate_hz);
+        config.velocity_deg_s = declare_parameter<double>("velocity_deg_s", config.velocity_deg_s);
+        config.step_deg = declare_parameter<int>("step_deg", config.step_deg);
+        config.hold_detect_ms = declare_parameter<int>("hold_detect_ms", config.hold_detect_ms);
+        config.release_ms = declare_parameter<int>("release_ms", config.release_ms);
+
+        // ESC ends the process only where the process is this node's (the
+        // keyboard executable sets it). In a container it stops the keyboard
+        // input and leaves the servo node and the container running.
+        exit_on_escape_ = declare_parameter<bool>("exit_on_escape", false);
+
+        // Errors are thrown, not rclcpp::shutdown(): a container reports a
+        // component that fails to load and keeps running
+        int fd = 0;
+        if (!device.empty()) {
+            fd = open(device.c_str(), O_RDWR | O_NOCTTY);
+            if (fd < 0) throw std::runtime_error("cannot open " + device + ": " + strerror(errno));
+            device_fd_ = fd;
+        }
+
+        input_ = std::make_unique<KeyInput>(fd, config,
+            [this](const std::vector<int32_t>& pairs) { publish(pairs); },
+            [this](char key) { other_key(key); });
         setup_keymap();
-        RCLCPP_INFO(get_logger(), "Press keys (a-z) to control servos. ESC to quit.");
-        timer_ = create_wall_timer(std::chrono::milliseconds(50), [this]() { read_key(); });
+        if (!input_->start()) {
+            std::string error = strerror(errno);
+            if (device_fd_ >= 0) close(device_fd_);
+            throw std::runtime_error("keyboard input failed to start: " + error);
+        }
+        RCLCPP_INFO(get_logger(), "Press keys (a-z) to control servos, hold to keep moving "
+                    "(%.0f°/s, %.0f commands/s). ESC to %s.", config.velocity_deg_s, config.rate_hz,
+                    exit_on_escape_ ? "quit" : "stop keyboard input");
+        RCLCPP_INFO(get_logger(), "Publishing %s", use_targets_ ? "absolute targets on /servo_targets"
+                                                                : "deltas on /keyboard_command");
+
+        // Key-to-publish latency while keys come in
+        stats_timer_ = create_wall_timer(std::chrono::seconds(10), [this]() { report_input(); });
+    }
+
+    ~KeyboardNode() {
+        if (input_) {
+            input_->stop();     // terminal back to normal
+            report_input();
+        }
+        if (device_fd_ >= 0) close(device_fd_);
     }
 
 private:
     // Changed to Int32MultiArray
     rclcpp::Publisher<std_msgs::msg::Int32MultiArray>::SharedPtr pub_;
-    rclcpp::TimerBase::SharedPtr timer_;
-    std::map<char, std::pair<int16_t, int16_t>> keymap_;
+    rclcpp::Publisher<gripper::msg::ServoTargets>::SharedPtr targets_pub_;
+    rclcpp::Subscription<gripper::msg::ServoState>::SharedPtr state_sub_;
+    bool use_targets_ = true;
+    bool exit_on_escape_ = false;
+    std::mutex intent_mutex_;
+    std::array<float, SERVO_COUNT> intent_deg_;     // targets mode: where each servo should be
+    bool seeded_ = false;                           // intent_deg_ taken from /servo_state
+    rclcpp::TimerBase::SharedPtr stats_timer_;
+    std::unique_ptr<KeyInput> input_;
+    int device_fd_ = -1;
 
     void setup_keymap() {
         char key = 'a';
-        for (int servo = 0; servo < 13; servo++) {
-            keymap_[key++] = {servo, +5};
-            keymap_[key++] = {servo, -5};
+        for (int servo = 0; servo < SERVO_COUNT; servo++) {
+            input_->map_key(key++, servo, +1);
+            input_->map_key(key++, servo, -1);
         }
     }
 
-    void read_key() {
-        char key = getch();
-        if (key == 27) {  // ESC key
-            RCLCPP_INFO(get_logger(), "Shutting down...");
-            rclcpp::shutdown();
+    // Executor: the servo node's targets at startup (or after it restarts
+    // before any key was pressed) become the starting intent
+    void seed_intent(const gripper::msg::ServoState& msg) {
+        std::lock_guard<std::mutex> lock(intent_mutex_);
+        if (seeded_) return;
+        for (int i = 0; i < SERVO_COUNT; ++i) intent_deg_[i] = msg.target_deg[i];
+        seeded_ = true;
+        RCLCPP_INFO(get_logger(), "Servo targets taken from /servo_state");
+    }
+
+    // Input thread: one or more [servo_id, delta] pairs
+    void publish(const std::vector<int32_t>& pairs) {
+        if (use_targets_) {
+            publish_targets(pairs);
             return;
         }
+        auto msg = std::make_unique<std_msgs::msg::Int32MultiArray>();  // Changed to Int32
+        msg->data = pairs;
+        pub_->publish(std::move(msg));  // moved, not copied, within a container
 
-        if (keymap_.count(key)) {
-            auto [servo_id, delta] = keymap_[key];
-            auto msg = std_msgs::msg::Int32MultiArray();  // Changed to Int32
-            msg.data = {static_cast<int32_t>(servo_id), static_cast<int32_t>(delta)};  // Explicit casting
-            pub_->publish(msg);
+        for (size_t k = 0; k + 1 < pairs.size(); k += 2) {
+            RCLCPP_DEBUG(get_logger(), "Servo %d %+d°", pairs[k], pairs[k + 1]);
+        }
+    }
 
-            std::cout << "Pressed: '" << key << "' → Servo " << servo_id 
-                      << (delta > 0 ? " +" : " ") << delta << "°\n";
-        } else if (isprint(key)) {
+    // The deltas applied to the intent, sent as absolute targets for the
+    // servos they touch
+    void publish_targets(const std::vector<int32_t>& pairs) {
+        auto msg = std::make_unique<gripper::msg::ServoTargets>();
+        {
+            std::lock_guard<std::mutex> lock(intent_mutex_);
+            seeded_ = true;     // from here on this node's intent leads
+            for (size_t k = 0; k + 1 < pairs.size(); k += 2) {
+                int servo = pairs[k];
+                if (servo < 0 || servo >= SERVO_COUNT) continue;
+                float angle = intent_deg_[servo] + pairs[k + 1];
+                intent_deg_[servo] = angle < 0 ? 0 : angle > 180 ? 180 : angle;
+                msg->mask |= 1u << servo;
+            }
+            msg->angle_deg = intent_deg_;
+        }
+        targets_pub_->publish(std::move(msg));
+    }
+
+    // Input thread: keys that are not mapped
+    void other_key(char key) {
+        if (key == 27) {  // ESC key
+            if (exit_on_escape_) {
+                RCLCPP_INFO(get_logger(), "Shutting down...");
+                rclcpp::shutdown();
+            } else {
+                RCLCPP_INFO(get_logger(), "Keyboard input stopped (ESC), the node keeps running");
+                input_->finish();
+            }
+        } else if (isprint(static_cast<unsigned char>(key))) {
             std::cout << "Pressed invalid key: '" << key << "' (a-z only)\n";
         }
     }
 
-    char getch() {
-        char buf = 0;
-        struct termios old = {};
-        tcgetattr(0, &old);
-        old.c_lflag &= ~ICANON;
-        old.c_lflag &= ~ECHO;
-        tcsetattr(0, TCSANOW, &old);
-        read(0, &buf, 1);
-        old.c_lflag |= ICANON;
-        old.c_lflag |= ECHO;
-        tcsetattr(0, TCSANOW, &old);
-        return buf;
+    // Commands since the last report; latency from the key byte being
+    // read to its command being published
+    void report_input() {
+        KeyInput::Stats st = input_->stats();
+        if (st.commands == 0) return;
+        input_->reset_stats();
+        RCLCPP_INFO(get_logger(), "Keyboard: %lu presses, %lu commands, key to publish mean %.0fus max %.0fus, "
+                    "held commands up to %.0fus late",
+                    static_cast<unsigned long>(st.presses), static_cast<unsigned long>(st.commands),
+                    st.latency_mean_us, st.latency_max_us, st.tick_late_max_us);
     }
 };
 
-int main(int argc, char **argv) {
-    rclcpp::init(argc, argv);
-    rclcpp::spin(std::make_shared<KeyboardNode>());
-    rclcpp::shutdown();
-    return 0;
+// A component, so it can share a container (and intra-process messages)
+// with the servo node
+RCLCPP_COMPONENTS_REGISTER_NODE(KeyboardNode)
+
+// For the keyboard executable (keyboard_main.cpp)
+std::shared_ptr<rclcpp::Node> make_keyboard_node(const rclcpp::NodeOptions& options) {
+    return std::make_shared<KeyboardNode>(options);
 }
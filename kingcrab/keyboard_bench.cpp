@@ -0,0 +1,175 @@
+// The keyboard node's input path without ROS: KeyInput reads the slave side
+// of a pty in raw mode while this program types on the master side like a
+// terminal would (one byte per press, auto-repeat while held).
+//
+//   keyboard_bench
+//
+// Checks single presses, a held key, two keys held together and escape
+// sequences, and reports byte-to-publish latency. Exits non-zero on any
+// failed check.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "key_input.hpp"
+
+struct Published {
+    double t_us;
+    std::vector<int32_t> pairs;
+};
+
+static std::mutex mutex;
+static std::vector<Published> published;
+static std::vector<char> others;
+static int failures = 0;
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void sleep_ms(double ms) {
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long>(ms * 1000)));
+}
+
+static void check(bool ok, const char* what) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// Everything published since the last call
+static std::vector<Published> take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Published> out;
+    out.swap(published);
+    return out;
+}
+
+// Types 'keys' once, then repeats them every 'interval_ms' from 'delay_ms'
+// on for 'hold_ms', as a terminal does for held keys. Returns when the
+// last byte went out.
+static double type_held(int master, const char* keys, double delay_ms, double interval_ms, double hold_ms) {
+    size_t n = strlen(keys);
+    if (write(master, keys, n) != static_cast<ssize_t>(n)) return 0;
+    sleep_ms(delay_ms);
+    double start = now_us();
+    double last = start;
+    while (now_us() - start < hold_ms * 1000) {
+        if (write(master, keys, n) != static_cast<ssize_t>(n)) return 0;
+        last = now_us();
+        sleep_ms(interval_ms);
+    }
+    return last;
+}
+
+int main() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("pty");
+        return 2;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        perror(ptsname(master));
+        return 2;
+    }
+
+    KeyInputConfig config;
+    KeyInput input(slave, config,
+        [](const std::vector<int32_t>& pairs) {
+            std::lock_guard<std::mutex> lock(mutex);
+            published.push_back({now_us(), pairs});
+        },
+        [](char key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            others.push_back(key);
+        });
+    // The node's map: a/b servo 0 +/-, c/d servo 1 +/-, ...
+    char key = 'a';
+    for (int servo = 0; servo < 13; servo++) {
+        input.map_key(key++, servo, +1);
+        input.map_key(key++, servo, -1);
+    }
+    if (!input.start()) {
+        perror("KeyInput");
+        return 2;
+    }
+    printf("pty %s, %.0f commands/s, %.0f deg/s held, %d deg per press\n",
+           ptsname(master), config.rate_hz, config.velocity_deg_s, config.step_deg);
+
+    // A single press, read without a newline (raw mode)
+    double typed = now_us();
+    if (write(master, "a", 1) != 1) return 2;
+    sleep_ms(300);
+    std::vector<Published> got = take();
+    check(got.size() == 1 && got[0].pairs == std::vector<int32_t>({0, config.step_deg}), "press 'a' -> one [0, +5]");
+    if (!got.empty()) printf("    pty write -> publish %.0f us\n", got[0].t_us - typed);
+
+    // Held for 1.5 s after a 500 ms repeat delay, repeating every 33 ms
+    double last = type_held(master, "d", 500, 33, 1500);
+    sleep_ms(400);
+    got = take();
+    int total = 0, held_msgs = 0;
+    bool one_servo = true;
+    double last_msg = 0;
+    for (size_t i = 0; i < got.size(); ++i) {
+        if (got[i].pairs.size() != 2 || got[i].pairs[0] != 1 || got[i].pairs[1] >= 0) one_servo = false;
+        if (got[i].pairs.size() == 2) total += got[i].pairs[1];
+        if (i > 0) held_msgs++;
+        last_msg = got[i].t_us;
+    }
+    // Held from the first repeat to release_ms after the last one
+    double held_s = 1.5 + config.release_ms / 1000.0;
+    double expect = config.step_deg + config.velocity_deg_s * held_s;
+    printf("    %d held commands, %d deg in total (about %.0f expected), last %.0f ms after the last byte\n",
+           held_msgs, -total, expect, (last_msg - last) / 1000);
+    check(one_servo && !got.empty() && got[0].pairs[1] == -config.step_deg, "hold 'd' -> servo 1 negative only, press first");
+    check(std::fabs(-total - expect) < 0.15 * expect, "hold 'd' -> distance within 15 % of velocity x time");
+    check(std::fabs(held_msgs - config.rate_hz * held_s) < 0.2 * config.rate_hz * held_s,
+          "hold 'd' -> commands at rate_hz, not at the repeat rate");
+    check(last_msg - last < (config.release_ms + 3000 / config.rate_hz + 30) * 1000,
+          "release -> commands stop within release_ms");
+
+    // Two keys held together: both servos in the same messages
+    type_held(master, "eh", 500, 33, 1000);
+    sleep_ms(400);
+    got = take();
+    int both = 0;
+    for (const Published& p : got) {
+        if (p.pairs.size() == 4 && p.pairs[0] == 2 && p.pairs[1] > 0 && p.pairs[2] == 3 && p.pairs[3] < 0) both++;
+    }
+    printf("    %zu commands, %d carrying both servos\n", got.size(), both);
+    check(both > 0.8 * config.rate_hz, "hold 'e'+'h' -> servos 2 and 3 move in one message");
+
+    // An arrow key is not ESC, nor does it hide the key read with it;
+    // unmapped keys and a lone ESC are passed on
+    if (write(master, "\x1b[A1", 4) != 4) return 2;
+    sleep_ms(100);
+    if (write(master, "\x1b", 1) != 1) return 2;
+    sleep_ms(100);
+    got = take();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        check(got.empty() && others == std::vector<char>({'1', 27}), "arrow ignored, '1' and lone ESC passed on");
+    }
+
+    input.stop();
+    KeyInput::Stats st = input.stats();
+    printf("  %lu presses, %lu commands, byte read -> publish mean %.0f us max %.0f us, "
+           "held commands up to %.0f us late\n",
+           static_cast<unsigned long>(st.presses), static_cast<unsigned long>(st.commands),
+           st.latency_mean_us, st.latency_max_us, st.tick_late_max_us);
+    close(slave);
+    close(master);
+    printf("%s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
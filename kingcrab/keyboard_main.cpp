@@ -0,0 +1,27 @@
+// The keyboard node on its own:
+//
+//   ros2 run gripper keyboard
+//
+// The process is the node's, so ESC quits it (exit_on_escape). Loaded into
+// a container (claw_container.launch.py) ESC only stops the keyboard input.
+
+#include <exception>
+#include <memory>
+#include "rclcpp/rclcpp.hpp"
+
+std::shared_ptr<rclcpp::Node> make_keyboard_node(const rclcpp::NodeOptions& options);
+
+int main(int argc, char** argv) {
+    rclcpp::init(argc, argv);
+    rclcpp::NodeOptions options;
+    options.append_parameter_override("exit_on_escape", true);
+    try {
+        rclcpp::spin(make_keyboard_node(options));
+    } catch (const std::exception& e) {
+        RCLCPP_ERROR(rclcpp::get_logger("keyboard"), "%s", e.what());
+        rclcpp::shutdown();
+        return 1;
+    }
+    rclcpp::shutdown();
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include "pca9685.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+void I2cBus::count(const I2cMessage* msgs, size_t count) {
+    transactions_++;
+    messages_ += count;
+    for (size_t i = 0; i < count; ++i) bytes_ += msgs[i].len;
+}
+
+// ============================================================================
+// /dev/i2c-N
+// ============================================================================
+
+LinuxI2cBus::~LinuxI2cBus() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool LinuxI2cBus::open(const std::string& device, uint8_t address) {
+    fd_ = ::open(device.c_str(), O_RDWR);
+    if (fd_ < 0) return false;
+    if (ioctl(fd_, I2C_SLAVE, address) < 0) {
+        int err = errno;
+        close(fd_);
+        fd_ = -1;
+        errno = err;
+        return false;
+    }
+    address_ = address;
+    unsigned long funcs = 0;
+    rdwr_ = ioctl(fd_, I2C_FUNCS, &funcs) == 0 && (funcs & I2C_FUNC_I2C);
+    return true;
+}
+
+bool LinuxI2cBus::write(const I2cMessage* msgs, size_t count) {
+    if (count == 0) return true;
+    this->count(msgs, count);
+    if (rdwr_) {
+        struct i2c_msg parts[PCA9685_CHANNELS];
+        if (count > PCA9685_CHANNELS) {
+            errno = EINVAL;
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            parts[i].addr = address_;
+            parts[i].flags = 0;
+            parts[i].len = msgs[i].len;
+            parts[i].buf = const_cast<uint8_t*>(msgs[i].buf);
+        }
+        struct i2c_rdwr_ioctl_data data = {parts, static_cast<uint32_t>(count)};
+        return ioctl(fd_, I2C_RDWR, &data) >= 0;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (::write(fd_, msgs[i].buf, msgs[i].len) != msgs[i].len) return false;
+    }
+    return true;
+}
+
+bool LinuxI2cBus::read(uint8_t reg, uint8_t* value) {
+    if (::write(fd_, &reg, 1) != 1) return false;
+    return ::read(fd_, value, 1) == 1;
+}
+
+// ============================================================================
+// MOCK
+// ============================================================================
+
+MockI2cBus::MockI2cBus() {
+    regs_.fill(0);
+    regs_[PCA9685_MODE1] = 0x11;        // power-on: SLEEP, ALLCALL
+    regs_[PCA9685_MODE2] = 0x04;        // OUTDRV
+    regs_[PCA9685_PRESCALE] = 0x1E;     // 200 Hz
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) regs_[LED0_ON_L + 4 * c + 3] = 0x10;   // full OFF
+}
+
+bool MockI2cBus::write(const I2cMessage* msgs, size_t count) {
+    this->count(msgs, count);
+    if (bit_rate_hz_) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < count; ++i) bits += 9u * (msgs[i].len + 1);
+        usleep(static_cast<useconds_t>(bits * 1000000 / bit_rate_hz_));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (msgs[i].len == 0) continue;
+        uint8_t reg = msgs[i].buf[0];
+        bool ai = regs_[PCA9685_MODE1] & 0x20;
+        for (uint16_t b = 1; b < msgs[i].len; ++b) {
+            regs_[reg] = msgs[i].buf[b];
+            if (reg == PCA9685_MODE1) regs_[reg] &= 0x7F;      // RESTART clears itself
+            if (reg >= ALL_LED_ON_L && reg <= ALL_LED_ON_L + 3) {
+                for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+                    regs_[LED0_ON_L + 4 * c + (reg - ALL_LED_ON_L)] = msgs[i].buf[b];
+                }
+            }
+            if (!ai) break;
+            reg++;
+        }
+    }
+    return true;
+}
+
+bool MockI2cBus::read(uint8_t reg, uint8_t* value) {
+    *value = regs_[reg];
+    return true;
+}
+
+uint16_t MockI2cBus::off_count(int channel) const {
+    uint8_t base = LED0_ON_L + 4 * channel;
+    return static_cast<uint16_t>(regs_[base + 2] | ((regs_[base + 3] & 0x1F) << 8));
+}
+
+// ============================================================================
+// PCA9685
+// ============================================================================
+
+static bool write_byte(I2cBus& bus, uint8_t reg, uint8_t value) {
+    uint8_t buf[2] = {reg, value};
+    I2cMessage msg = {buf, 2};
+    return bus.write(&msg, 1);
+}
+
+bool Pca9685::initialize(uint8_t prescale) {
+    // Reset MODE1 to a known state (normal mode, but we'll modify it)
+    if (!write_byte(bus_, PCA9685_MODE1, 0x00)) return false;
+
+    uint8_t old_mode1 = 0;
+    if (!bus_.read(PCA9685_MODE1, &old_mode1)) return false;
+
+    // Put PCA9685 to sleep to set prescaler
+    uint8_t sleep_mode1 = (old_mode1 & 0x7F) | 0x10;   // Set sleep bit (bit 4), clear restart (bit 7)
+    uint8_t awake_mode1 = old_mode1 & ~0x10;            // Restore old_mode1, sleep bit cleared
+    if (!write_byte(bus_, PCA9685_MODE1, sleep_mode1) ||
+        !write_byte(bus_, PCA9685_PRESCALE, prescale) ||
+        !write_byte(bus_, PCA9685_MODE1, awake_mode1)) {
+        return false;
+    }
+
+    usleep(500);    // Wait for oscillator to stabilize (min 500µs)
+
+    // Set Restart bit (bit 7) and Auto-Increment (AI bit 5). Every frame
+    // relies on AI to write a run of channels in one message.
+    if (!write_byte(bus_, PCA9685_MODE1, awake_mode1 | 0x80 | 0x20)) return false;
+    known_ = 0;
+    return bus_.read(PCA9685_MODE1, &mode1_);
+}
+
+bool Pca9685::write_all(uint16_t off_count) {
+    uint8_t buf[5] = {ALL_LED_ON_L, 0x00, 0x00,
+                      static_cast<uint8_t>(off_count & 0xFF),
+                      static_cast<uint8_t>((off_count >> 8) & 0x0F)};
+    I2cMessage msg = {buf, 5};
+    if (!bus_.write(&msg, 1)) {
+        known_ = 0;
+        return false;
+    }
+    off_.fill(off_count);
+    known_ = 0xFFFF;
+    return true;
+}
+
+bool Pca9685::write_frame(const Frame& frame, uint16_t mask) {
+    // What changes, and whether the whole chip ends up at one count
+    uint16_t dirty = 0;
+    bool uniform = true;
+    uint16_t value0 = (mask & 1) ? frame[0] : off_[0];
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        uint16_t bit = 1u << c;
+        if ((mask & bit) && (!(known_ & bit) || frame[c] != off_[c])) dirty |= bit;
+        bool known_after = (mask & bit) || (known_ & bit);
+        uint16_t next = (mask & bit) ? frame[c] : off_[c];
+        if (!known_after || next != value0) uniform = false;
+    }
+    if (dirty == 0) return true;
+    if (uniform) return write_all(value0);
+
+    // Runs of dirty channels, bridged over short gaps of known channels
+    uint8_t buf[PCA9685_CHANNELS * 4 + PCA9685_CHANNELS];
+    I2cMessage msgs[PCA9685_CHANNELS];
+    size_t used = 0;
+    size_t count = 0;
+    int c = 0;
+    while (c < PCA9685_CHANNELS) {
+        if (!(dirty & (1u << c))) {
+            c++;
+            continue;
+        }
+        int first = c;
+        int last = c;
+        for (int next = c + 1; next < PCA9685_CHANNELS; ++next) {
+            if (dirty & (1u << next)) {
+                last = next;
+            } else if (!(known_ & (1u << next)) || next - last > MAX_GAP_CHANNELS) {
+                break;
+            }
+        }
+
+        uint8_t* p = buf + used;
+        *p++ = static_cast<uint8_t>(LED0_ON_L + 4 * first);
+        for (int ch = first; ch <= last; ++ch) {
+            uint16_t value = (dirty & (1u << ch)) ? frame[ch] : off_[ch];
+            *p++ = 0x00;                                            // ON_L = 0 (pulse starts at count 0)
+            *p++ = 0x00;                                            // ON_H = 0
+            *p++ = static_cast<uint8_t>(value & 0xFF);              // OFF_L
+            *p++ = static_cast<uint8_t>((value >> 8) & 0x0F);       // OFF_H
+        }
+        msgs[count].buf = buf + used;
+        msgs[count].len = static_cast<uint16_t>(p - (buf + used));
+        used += msgs[count].len;
+        count++;
+        c = last + 1;
+    }
+
+    if (!bus_.write(msgs, count)) {
+        known_ &= ~dirty;       // unknown until written again
+        return false;
+    }
+    for (int ch = 0; ch < PCA9685_CHANNELS; ++ch) {
+        if (dirty & (1u << ch)) off_[ch] = frame[ch];
+    }
+    known_ |= dirty;
+    return true;
+}
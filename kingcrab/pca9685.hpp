@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// PCA9685 Registers
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_PRESCALE 0xFE
+#define LED0_ON_L 0x06
+#define ALL_LED_ON_L 0xFA
+
+#define PCA9685_CHANNELS 16
+#define PCA9685_COUNTS 4096
+#define PCA9685_OSC_HZ 25000000.0      // internal oscillator
+
+// One register write inside a bus transaction: buf[0] is the start
+// register, the rest are the bytes written from there (MODE1 AI set).
+struct I2cMessage {
+    const uint8_t* buf;
+    uint16_t len;
+};
+
+// The PCA9685 behind a file descriptor or a mock. write() sends all the
+// messages as one transaction: repeated START between them, one STOP at
+// the end. With MODE2.OCH = 0 the outputs change on that STOP, so every
+// channel in the transaction switches in the same PWM period.
+class I2cBus {
+public:
+    virtual ~I2cBus() = default;
+
+    virtual bool write(const I2cMessage* msgs, size_t count) = 0;
+    virtual bool read(uint8_t reg, uint8_t* value) = 0;
+
+    // Bus traffic so far: transactions (syscalls), messages (STARTs), bytes
+    uint64_t transactions() const { return transactions_; }
+    uint64_t messages() const { return messages_; }
+    uint64_t bytes() const { return bytes_; }
+
+protected:
+    void count(const I2cMessage* msgs, size_t count);
+
+private:
+    uint64_t transactions_ = 0;
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+// /dev/i2c-N. Uses I2C_RDWR for the combined transaction, or one write()
+// per message if the adapter can not do it.
+class LinuxI2cBus : public I2cBus {
+public:
+    LinuxI2cBus() = default;
+    ~LinuxI2cBus() override;
+
+    // False with errno set
+    bool open(const std::string& device, uint8_t address);
+    int fd() const { return fd_; }
+
+    bool write(const I2cMessage* msgs, size_t count) override;
+    bool read(uint8_t reg, uint8_t* value) override;
+
+private:
+    int fd_ = -1;
+    uint8_t address_ = 0;
+    bool rdwr_ = false;
+};
+
+// In-memory PCA9685 register file (i2c_device:=mock): auto-increment,
+// ALL_LED fan-out, and the same traffic counters as the real bus.
+class MockI2cBus : public I2cBus {
+public:
+    MockI2cBus();
+
+    bool write(const I2cMessage* msgs, size_t count) override;
+    bool read(uint8_t reg, uint8_t* value) override;
+
+    uint8_t reg(uint8_t r) const { return regs_[r]; }
+    uint16_t off_count(int channel) const;
+
+    // Take as long as a real bus at this SCL rate (0 = no delay): 9 bits
+    // per byte plus the address byte of every message
+    void set_bit_rate(uint32_t hz) { bit_rate_hz_ = hz; }
+
+private:
+    std::array<uint8_t, 256> regs_;
+    uint32_t bit_rate_hz_ = 0;
+};
+
+// Channel frames for the PCA9685. A frame is the OFF count of every
+// channel (ON is always 0); write_frame() sends only the channels that
+// differ from what the chip already holds, as contiguous-register bursts,
+// all in one transaction.
+class Pca9685 {
+public:
+    typedef std::array<uint16_t, PCA9685_CHANNELS> Frame;
+
+    // Clean channels shorter than this between two dirty runs are written
+    // again rather than starting a new message (4 bytes vs ~2 bytes of
+    // START/address/register plus the message setup)
+    static constexpr int MAX_GAP_CHANNELS = 1;
+
+    explicit Pca9685(I2cBus& bus) : bus_(bus) {}
+
+    // Sleep, set the prescaler, wake, then RESTART + auto-increment
+    bool initialize(uint8_t prescale);
+
+    // Channels in 'mask' take their count from 'frame'. If every channel
+    // in the mask ends up equal and the mask covers the whole chip, one
+    // ALL_LED write does it.
+    bool write_frame(const Frame& frame, uint16_t mask);
+
+    // Every channel to the same count through ALL_LED
+    bool write_all(uint16_t off_count);
+
+    uint16_t off_count(int channel) const { return off_[channel]; }
+    uint8_t mode1() const { return mode1_; }
+
+private:
+    I2cBus& bus_;
+    Frame off_ = {};
+    uint16_t known_ = 0;        // channels whose registers match off_
+    uint8_t mode1_ = 0;
+};
@@ -0,0 +1,165 @@
+// Delta pairs on /keyboard_command against absolute targets on
+// /servo_targets, through a real ROS 2 middleware on this machine:
+//
+//   ros2 run gripper protocol_bench [frames_per_test]
+//
+// For a frame that moves all 13 servos it measures the serialization cost
+// and size of each form, the frame rate a publisher can sustain, and the
+// latency from the first publish of a frame to the subscriber holding
+// the whole frame. "delta x13" is the original protocol (one pair per
+// message), "delta 13-pair" the multi-pair message, "targets" the
+// fixed-size ServoTargets.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "std_msgs/msg/int32_multi_array.hpp"
+#include "gripper/msg/servo_targets.hpp"
+
+#define SERVO_COUNT 13
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Frame number 'seq' in each form. The frame number rides in the payload
+// (delta value, or the last angle) so the subscriber can match it up.
+static std::vector<std_msgs::msg::Int32MultiArray> delta_frame(int32_t seq, bool one_per_message) {
+    std::vector<std_msgs::msg::Int32MultiArray> msgs;
+    std_msgs::msg::Int32MultiArray msg;
+    for (int servo = 0; servo < SERVO_COUNT; ++servo) {
+        msg.data.push_back(servo);
+        msg.data.push_back(seq);
+        if (one_per_message) {
+            msgs.push_back(msg);
+            msg.data.clear();
+        }
+    }
+    if (!one_per_message) msgs.push_back(msg);
+    return msgs;
+}
+
+static std::vector<gripper::msg::ServoTargets> targets_frame(int32_t seq) {
+    gripper::msg::ServoTargets msg;
+    msg.mask = (1u << SERVO_COUNT) - 1;
+    for (int servo = 0; servo < SERVO_COUNT; ++servo) msg.angle_deg[servo] = 90;
+    msg.angle_deg[SERVO_COUNT - 1] = static_cast<float>(seq);
+    return {msg};
+}
+
+static int32_t frame_of(const std_msgs::msg::Int32MultiArray& msg) { return msg.data.back(); }
+static int32_t frame_of(const gripper::msg::ServoTargets& msg) {
+    return static_cast<int32_t>(msg.angle_deg[SERVO_COUNT - 1]);
+}
+
+template <class Msg>
+static void bench_serialize(const char* name, const std::vector<Msg>& frame, int rounds) {
+    rclcpp::Serialization<Msg> serializer;
+    rclcpp::SerializedMessage out;
+    size_t bytes = 0;
+    double start = now_us();
+    for (int r = 0; r < rounds; ++r) {
+        bytes = 0;
+        for (const Msg& msg : frame) {
+            serializer.serialize_message(&msg, &out);
+            bytes += out.size();
+        }
+    }
+    double per_frame = (now_us() - start) / rounds;
+    printf("  %-14s serialize: %2zu msg/frame, %4zu bytes/frame, %7.2f us/frame\n",
+           name, frame.size(), bytes, per_frame);
+}
+
+// Publishes 'frames' frames back to back on a fresh topic; the subscriber
+// node spins on its own thread, as the servo node would in its process
+template <class Msg>
+static void bench_e2e(const char* name, std::function<std::vector<Msg>(int32_t)> make, int frames) {
+    static int run = 0;
+    std::string topic = "protocol_bench_" + std::to_string(run++);
+    auto qos = rclcpp::QoS(1000);
+
+    auto sub_node = std::make_shared<rclcpp::Node>("protocol_bench_sub");
+    const size_t per_frame = make(0).size();
+    std::vector<double> sent(frames, 0), done(frames, 0);
+    std::vector<size_t> got(frames, 0);
+    std::mutex mutex;
+    std::atomic<size_t> received{0};
+    auto sub = sub_node->create_subscription<Msg>(topic, qos,
+        [&](const typename Msg::ConstSharedPtr msg) {
+            double t = now_us();
+            int32_t seq = frame_of(*msg);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (seq < 0 || seq >= frames) return;
+            if (++got[seq] == per_frame) done[seq] = t;
+            received++;
+        });
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(sub_node);
+    std::thread spinner([&executor]() { executor.spin(); });
+
+    auto pub_node = std::make_shared<rclcpp::Node>("protocol_bench_pub");
+    auto pub = pub_node->create_publisher<Msg>(topic, qos);
+    double wait_until = now_us() + 5e6;
+    while (pub->get_subscription_count() == 0 && now_us() < wait_until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // discovery settles
+
+    double start = now_us();
+    for (int seq = 0; seq < frames; ++seq) {
+        std::vector<Msg> frame = make(seq);
+        sent[seq] = now_us();
+        for (const Msg& msg : frame) pub->publish(msg);
+        // Keep within the history depth so nothing is dropped by design
+        while (seq * per_frame > received.load() + 500 && now_us() - sent[seq] < 1e6) std::this_thread::yield();
+    }
+    double publish_s = (now_us() - start) / 1e6;
+    double drain_until = now_us() + 2e6;
+    while (received.load() < frames * per_frame && now_us() < drain_until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    executor.cancel();
+    spinner.join();
+
+    std::vector<double> latency;
+    for (int seq = 0; seq < frames; ++seq) {
+        if (done[seq] > 0) latency.push_back(done[seq] - sent[seq]);
+    }
+    std::sort(latency.begin(), latency.end());
+    double sum = 0;
+    for (double l : latency) sum += l;
+    size_t n = latency.size();
+    printf("  %-14s %6.0f frames/s (%6.0f msg/s), %zu/%d frames whole, latency mean %6.0f us, "
+           "p50 %6.0f us, p99 %6.0f us\n",
+           name, frames / publish_s, frames * per_frame / publish_s, n, frames,
+           n ? sum / n : 0.0, n ? latency[n / 2] : 0.0, n ? latency[n * 99 / 100] : 0.0);
+}
+
+int main(int argc, char** argv) {
+    rclcpp::init(argc, argv);
+    int frames = argc > 1 ? atoi(argv[1]) : 5000;
+
+    printf("One frame = all %d servos\n", SERVO_COUNT);
+    bench_serialize("delta x13", delta_frame(1, true), 20000);
+    bench_serialize("delta 13-pair", delta_frame(1, false), 20000);
+    bench_serialize("targets", targets_frame(1), 20000);
+
+    bench_e2e<std_msgs::msg::Int32MultiArray>("delta x13", [](int32_t seq) { return delta_frame(seq, true); }, frames);
+    bench_e2e<std_msgs::msg::Int32MultiArray>("delta 13-pair", [](int32_t seq) { return delta_frame(seq, false); }, frames);
+    bench_e2e<gripper::msg::ServoTargets>("targets", targets_frame, frames);
+
+    rclcpp::shutdown();
+    return 0;
+}
@@ -1,217 +1,306 @@
 #include <cstddef>
 #include <array>
 #include <cmath> // For round()
-#include <vector> // For i2c_buffer in process_command
+#include <memory>
+#include <string>
+#include <vector> // For the command pairs
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 #include "std_msgs/msg/int32_multi_array.hpp"
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
-#include <sys/ioctl.h>
-#include <unistd.h>
+#include "gripper/msg/servo_state.hpp"
+#include "gripper/msg/servo_targets.hpp"
 #include <cerrno>  // For errno
 #include <cstring> // For strerror
+#include "pca9685.hpp"
+#include "servo_calibration.hpp"
+#include "servo_writer.hpp"
 
-// PCA9685 Registers
-#define PCA9685_MODE1 0x00
-#define PCA9685_PRESCALE 0xFE
-#define LED0_ON_L 0x06
+#define SERVO_COUNT 13      // claw channels 0-12 on the PCA9685
+#define PCA9685_ADDRESS 0x40
+#define PWM_PRESCALE 19     // 25 MHz / (4096 * 20) = 305.18 Hz
+#define US_PER_DEG ((SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) / 180.0)
 
 class ServoController : public rclcpp::Node {
 public:
-    ServoController() : Node("servo_controller") {
+    explicit ServoController(const rclcpp::NodeOptions& options = rclcpp::NodeOptions())
+        : Node("servo_controller", options) {
         RCLCPP_INFO(this->get_logger(), "Servo controller node started!");
 
+        // "/dev/i2c-1" on the ROV; "mock" runs against an in-memory PCA9685
+        // that counts the bus traffic (bench testing without the WTC)
+        std::string device = this->declare_parameter<std::string>("i2c_device", "/dev/i2c-1");
+        // The mock takes as long as a real bus at this SCL rate (0 = instant)
+        int mock_bus_hz = this->declare_parameter<int>("mock_bus_hz", 400000);
+        // Frames go out from the writer thread at this rate, by default
+        // once per PWM period (prescale 19: 305 Hz)
+        double flush_rate_hz = this->declare_parameter<double>("flush_rate_hz", 305.0);
+        int writer_priority = this->declare_parameter<int>("writer_priority", 80);
+        // /servo_state goes out at this rate (0 = not at all)
+        double state_rate_hz = this->declare_parameter<double>("state_rate_hz", 50.0);
+        // Servos ramp to their targets within these limits. The budget caps
+        // the summed speed of all servos, and so the current they draw
+        // together from the 6 V rail (0 = no cap).
+        TrajectoryLimits limits;
+        limits.max_velocity_us_s = this->declare_parameter<double>("max_velocity_deg_s", 120.0) * US_PER_DEG;
+        limits.max_accel_us_s2 = this->declare_parameter<double>("max_accel_deg_s2", 600.0) * US_PER_DEG;
+        limits.motion_budget_us_s = this->declare_parameter<double>("motion_budget_deg_s", 300.0) * US_PER_DEG;
+
         // Initialize I2C
-        i2c_fd_ = open("/dev/i2c-1", O_RDWR);
-        if (i2c_fd_ < 0) {
-            RCLCPP_ERROR(this->get_logger(), "I2C init failed! Error: %s", strerror(errno));
-            rclcpp::shutdown();
-            return;
+        if (device == "mock") {
+            auto bus = std::make_unique<MockI2cBus>();
+            bus->set_bit_rate(static_cast<uint32_t>(mock_bus_hz));
+            bus_ = std::move(bus);
+            RCLCPP_INFO(this->get_logger(), "I2C mock back-end in use (%d Hz)", mock_bus_hz);
+        } else {
+            auto bus = std::make_unique<LinuxI2cBus>();
+            if (!bus->open(device, PCA9685_ADDRESS)) {
+                RCLCPP_ERROR(this->get_logger(), "I2C init on %s (0x%02X) failed! Error: %s",
+                             device.c_str(), PCA9685_ADDRESS, strerror(errno));
+                rclcpp::shutdown();
+                return;
+            }
+            RCLCPP_INFO(this->get_logger(), "I2C initialized (FD: %d), slave address 0x%02X set.",
+                        bus->fd(), PCA9685_ADDRESS);
+            bus_ = std::move(bus);
         }
-        RCLCPP_INFO(this->get_logger(), "I2C initialized (FD: %d)", i2c_fd_);
+        pca_ = std::make_unique<Pca9685>(*bus_);
+
+        // Initialize PCA9685
+        initialize_pca9685();
 
-        if (ioctl(i2c_fd_, I2C_SLAVE, 0x40) < 0) {
-            RCLCPP_ERROR(this->get_logger(), "Failed to set I2C slave address. Error: %s", strerror(errno));
-            close(i2c_fd_);
+        // Per-servo pulse range, trim and direction: the arrays (one entry
+        // per servo, or empty), then calibration_file on top of them
+        if (!load_calibration()) {
             rclcpp::shutdown();
             return;
         }
-        RCLCPP_INFO(this->get_logger(), "I2C slave address 0x40 set.");
 
-        // Initialize PCA9685
-        initialize_pca9685();
+        // From here on only the writer thread touches the bus
+        writer_ = std::make_unique<ServoWriter>(*pca_, *table_, flush_rate_hz, limits);
+
+        // Initialize pulses (e.g., to 90 degrees); a channel is first
+        // written by its first command and moves from there
+        pulses_.fill((SERVO_PULSE_MIN_US + SERVO_PULSE_MAX_US) / 2); // Example: center all servos
+        for (int i = 0; i < SERVO_COUNT; ++i) writer_->set_position(i, pulses_[i]);
 
-        // Initialize angles (e.g., to 90 degrees) and set initial servo positions
-        angles_.fill(90); // Example: center all servos
-        // set_initial_servo_positions(); // Optional: function to move all servos to initial angle
+        if (!writer_->start(writer_priority)) {
+            RCLCPP_WARN(this->get_logger(), "I2C writer runs without real-time priority %d "
+                        "(needs CAP_SYS_NICE or an rtprio limit)", writer_priority);
+        }
+        RCLCPP_INFO(this->get_logger(), "I2C writer flushing at %.1f Hz, servos up to %.0f°/s, %.0f°/s², "
+                    "%.0f°/s together", flush_rate_hz, limits.max_velocity_us_s / US_PER_DEG,
+                    limits.max_accel_us_s2 / US_PER_DEG, limits.motion_budget_us_s / US_PER_DEG);
 
-        // Subscription
+        // Subscription: [servo_id, delta] pairs, one or more per message.
+        // All the pairs of a message go out as one frame.
         subscription_ = this->create_subscription<std_msgs::msg::Int32MultiArray>(
             "keyboard_command", 10,
             [this](const std_msgs::msg::Int32MultiArray::ConstSharedPtr msg) {
-                RCLCPP_INFO(this->get_logger(), "Received message with %zu elements", msg->data.size());
-                if (msg->data.size() >= 2) {
-                    RCLCPP_DEBUG(this->get_logger(), "Processing command: [%d, %d]",
-                                 msg->data[0], msg->data[1]);
-                    process_command(msg->data[0], msg->data[1]);
-                } else {
-                    RCLCPP_WARN(this->get_logger(), "Malformed message received");
+                if (msg->data.size() < 2 || msg->data.size() % 2 != 0) {
+                    RCLCPP_WARN(this->get_logger(), "Malformed message received (%zu elements)",
+                                msg->data.size());
+                    return;
                 }
+                process_commands(msg->data);
             });
 
-        RCLCPP_INFO(this->get_logger(), "Ready to receive commands on /keyboard_command");
+        // Absolute targets, all servos or a masked subset, as one frame.
+        // A lost message is made good by the next one.
+        targets_subscription_ = this->create_subscription<gripper::msg::ServoTargets>(
+            "servo_targets", 10,
+            [this](const gripper::msg::ServoTargets::ConstSharedPtr msg) { process_targets(*msg); });
+
+        if (state_rate_hz > 0) {
+            state_publisher_ = this->create_publisher<gripper::msg::ServoState>("servo_state", 10);
+            state_timer_ = this->create_wall_timer(
+                std::chrono::microseconds(static_cast<int64_t>(1e6 / state_rate_hz)), [this]() { publish_state(); });
+        }
+
+        // Command-to-bus latency while commands come in
+        stats_timer_ = this->create_wall_timer(std::chrono::seconds(10), [this]() { report_writer(); });
+
+        RCLCPP_INFO(this->get_logger(), "Ready to receive commands on /keyboard_command and /servo_targets");
     }
 
     ~ServoController() {
-        if (i2c_fd_ >= 0) {
+        if (writer_) {
+            writer_->stop();
+            report_writer();
+        }
+        if (bus_) {
             // Optionally set servos to a safe state or turn off PWM output
             // For example, set MODE1 to sleep
-            // write_i2c_byte(PCA9685_MODE1, 0x10); // Sleep
-            close(i2c_fd_);
+            RCLCPP_INFO(this->get_logger(), "I2C traffic: %lu transactions, %lu messages, %lu bytes",
+                        static_cast<unsigned long>(bus_->transactions()),
+                        static_cast<unsigned long>(bus_->messages()),
+                        static_cast<unsigned long>(bus_->bytes()));
             RCLCPP_INFO(this->get_logger(), "I2C device closed.");
         }
     }
 
 private:
-    int i2c_fd_;
-    std::array<int16_t, 13> angles_; // Assuming 13 servos (0-12)
+    std::unique_ptr<I2cBus> bus_;
+    std::unique_ptr<Pca9685> pca_;
+    std::unique_ptr<ServoCountTable> table_;
+    std::unique_ptr<ServoWriter> writer_;
+    rclcpp::TimerBase::SharedPtr stats_timer_;
+    std::array<double, SERVO_COUNT> pulses_; // targets in us, 13 servos (0-12)
     rclcpp::Subscription<std_msgs::msg::Int32MultiArray>::SharedPtr subscription_;
-
-    // Writes a single byte to an I2C register
-    void write_i2c_byte(uint8_t reg, uint8_t value) {
-        uint8_t buffer[2] = {reg, value};
-        if (write(i2c_fd_, buffer, 2) != 2) {
-            RCLCPP_ERROR(this->get_logger(), "I2C write to reg 0x%02X failed! Error: %s", reg, strerror(errno));
-        }
-    }
-
-    // Reads a single byte from an I2C register
-    uint8_t read_i2c_byte(uint8_t reg) {
-        uint8_t value = 0xFF; // Default error value
-        if (write(i2c_fd_, &reg, 1) != 1) {
-            RCLCPP_ERROR(this->get_logger(), "I2C read: failed to write register address 0x%02X. Error: %s", reg, strerror(errno));
-            return value;
-        }
-        if (read(i2c_fd_, &value, 1) != 1) {
-            RCLCPP_ERROR(this->get_logger(), "I2C read: failed to read value from reg 0x%02X. Error: %s", reg, strerror(errno));
-            return 0xFF; // Indicate read failure
-        }
-        return value;
-    }
+    rclcpp::Subscription<gripper::msg::ServoTargets>::SharedPtr targets_subscription_;
+    rclcpp::Publisher<gripper::msg::ServoState>::SharedPtr state_publisher_;
+    rclcpp::TimerBase::SharedPtr state_timer_;
 
     void initialize_pca9685() {
         RCLCPP_INFO(this->get_logger(), "Initializing PCA9685...");
 
-        // Reset MODE1 to a known state (normal mode, but we'll modify it)
-        write_i2c_byte(PCA9685_MODE1, 0x00);
-
         // Calculate prescaler for 300Hz (typical 25MHz internal oscillator)
         // prescale = round(osc_clock / (4096 * update_rate)) - 1
         // prescale = round(25,000,000 / (4096 * 300)) - 1 = round(20.345) - 1 = 20 - 1 = 19
-        uint8_t prescale_val = 19; // For ~300Hz (actual: 305Hz)
+        uint8_t prescale_val = PWM_PRESCALE; // For ~300Hz (actual: 305Hz)
 
-        uint8_t old_mode1 = read_i2c_byte(PCA9685_MODE1);
-        if (old_mode1 == 0xFF) { // Read error
-             RCLCPP_ERROR(this->get_logger(), "Failed to read MODE1. PCA9685 initialization aborted.");
-             return;
+        if (!pca_->initialize(prescale_val)) {
+            RCLCPP_ERROR(this->get_logger(), "PCA9685 initialization failed. Error: %s", strerror(errno));
+            return;
         }
-
-        // Put PCA9685 to sleep to set prescaler
-        uint8_t new_mode1 = (old_mode1 & 0x7F) | 0x10; // Set sleep bit (bit 4), clear restart (bit 7)
-        write_i2c_byte(PCA9685_MODE1, new_mode1);
-        write_i2c_byte(PCA9685_PRESCALE, prescale_val);
-
-        // Wake up PCA9685
-        // Restore old_mode1 but ensure sleep bit is cleared
-        uint8_t mode1_awake = old_mode1 & ~0x10; // Clear sleep bit
-        write_i2c_byte(PCA9685_MODE1, mode1_awake);
-
-        usleep(500); // Wait for oscillator to stabilize (min 500µs)
-
-        // Set Restart bit (bit 7) and Auto-Increment (AI bit 5)
-        // It's important to set Restart after oscillator is running and stable.
-        // Auto-Increment (AI) allows writing to subsequent registers automatically.
-        write_i2c_byte(PCA9685_MODE1, mode1_awake | 0x80 | 0x20); // Set RESTART, Set AI
-
         RCLCPP_INFO(this->get_logger(), "PCA9685 initialized. MODE1: 0x%02X, Prescaler: %d (for ~300Hz)",
-                    read_i2c_byte(PCA9685_MODE1), prescale_val);
+                    pca_->mode1(), prescale_val);
     }
 
-    // Optional: Function to set all servos to their initial angles stored in angles_
-    // void set_initial_servo_positions() {
-    //     RCLCPP_INFO(this->get_logger(), "Setting initial servo positions...");
-    //     for (int i = 0; i < 13; ++i) { // Assuming 13 servos
-    //         // This needs to call the PWM setting logic, similar to process_command
-    //         // For simplicity, this is left as a conceptual step.
-    //         // You would calculate pulse and value, then write to the servo's registers.
-    //         // For now, process_command will handle setting them upon first keyboard input.
-    //     }
-    // }
-
-    void process_command(int32_t servo_id, int32_t delta) {
-        RCLCPP_INFO(this->get_logger(), "Command: Servo %d, Delta %d", servo_id, delta);
-
-        if (servo_id < 0 || servo_id >= static_cast<int32_t>(angles_.size())) {
-            RCLCPP_WARN(this->get_logger(), "Invalid servo ID: %d. Max ID: %zu", servo_id, angles_.size() -1);
-            return;
+    // Builds the angle-to-count table from the calibration parameters.
+    // False (logged) on a malformed parameter or file.
+    bool load_calibration() {
+        std::vector<double> min_us = this->declare_parameter<std::vector<double>>("servo_min_us", {});
+        std::vector<double> max_us = this->declare_parameter<std::vector<double>>("servo_max_us", {});
+        std::vector<double> trim_us = this->declare_parameter<std::vector<double>>("servo_trim_us", {});
+        std::vector<bool> inverted = this->declare_parameter<std::vector<bool>>("servo_inverted", {});
+        std::string file = this->declare_parameter<std::string>("calibration_file", "");
+
+        for (size_t n : {min_us.size(), max_us.size(), trim_us.size(), inverted.size()}) {
+            if (n != 0 && n != SERVO_COUNT) {
+                RCLCPP_ERROR(this->get_logger(), "Calibration arrays need %d entries (one per servo) or none, got %zu",
+                             SERVO_COUNT, n);
+                return false;
+            }
+        }
+        ServoCalibrations cals;
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            if (!min_us.empty()) cals[i].min_us = min_us[i];
+            if (!max_us.empty()) cals[i].max_us = max_us[i];
+            if (!trim_us.empty()) cals[i].trim_us = trim_us[i];
+            if (!inverted.empty()) cals[i].inverted = inverted[i];
+        }
+        if (!file.empty()) {
+            std::string error;
+            if (!load_calibration_file(file, cals, error)) {
+                RCLCPP_ERROR(this->get_logger(), "Calibration: %s", error.c_str());
+                return false;
+            }
+            RCLCPP_INFO(this->get_logger(), "Calibration loaded from %s", file.c_str());
         }
 
-        int16_t new_angle = angles_[servo_id] + delta;
-        if (new_angle < 0) new_angle = 0;
-        else if (new_angle > 180) new_angle = 180;
-
-        if (new_angle != angles_[servo_id]) {
-            angles_[servo_id] = new_angle;
-
-            // Convert angle to pulse width (1000-2000µs for typical 0-180 degree servos)
-            uint16_t pulse_us = 1000 + (static_cast<uint32_t>(new_angle) * 1000 / 180);
+        table_ = std::make_unique<ServoCountTable>(cals, PWM_PRESCALE);
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            const ServoCalibration& cal = table_->calibration(i);
+            RCLCPP_DEBUG(this->get_logger(), "Servo %d: %.1f-%.1fus trim %+.1fus%s, counts %d-%d", i,
+                         cal.min_us, cal.max_us, cal.trim_us, cal.inverted ? " inverted" : "",
+                         table_->count(i, SERVO_PULSE_MIN_US), table_->count(i, SERVO_PULSE_MAX_US));
+        }
+        return true;
+    }
 
-            // Convert pulse width to PCA9685 ON/OFF register values
-            // PCA9685 period = 1,000,000 µs / PWM_freq_Hz
-            // For 300Hz, period = 1,000,000 / 300 = 3333.33 µs
-            // For 305.17Hz (with prescale 19), period = 1,000,000 / 305.1757 = 3276.8 µs
-            // PCA9685 counts from 0 to 4095
-            // OFF_time_count = (pulse_us / period_us) * 4096
-            // Using integer math for period: (1000000 / PWM_FREQ_INT_APPROX)
-            uint16_t off_value = static_cast<uint16_t>((static_cast<uint32_t>(pulse_us) * 4096) / (1000000 / 300)); // Approx 300Hz
-            // uint16_t off_value = static_cast<uint16_t>((static_cast<float>(pulse_us) / (1000000.0f / 305.1757f)) * 4095.0f); // More precise for 305Hz
+    // Frame API: new targets for the servos in 'mask' (bit i = servo i),
+    // a full or partial vector, as nominal pulse widths in us (1000-2000
+    // for 0-180°; the calibration maps them onto each servo). Handed to
+    // the writer thread, which ramps the servos there.
+    void set_pulses(const std::array<double, SERVO_COUNT>& pulses, uint16_t mask) {
+        ServoTrajectory::Pulses frame = {};
+        uint16_t changed = 0;
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            if (!(mask & (1u << i))) continue;
+            double pulse = std::fmin(std::fmax(pulses[i], SERVO_PULSE_MIN_US), SERVO_PULSE_MAX_US);
+            if (pulse == pulses_[i]) continue;
+            pulses_[i] = pulse;
+            frame[i] = pulse;
+            changed |= 1u << i;
+        }
+        if (!changed) return;
 
+        writer_->set_pulses(frame, changed);
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            if (changed & (1u << i)) {
+                RCLCPP_DEBUG(this->get_logger(), "Servo %d -> %.1f° (%.1fus)", i,
+                             (pulses_[i] - SERVO_PULSE_MIN_US) / US_PER_DEG, pulses_[i]);
+            }
+        }
+    }
 
-            if (off_value > 4095) off_value = 4095;
+    // Frames written since the last report, latency from the newest
+    // target being stored to its frame being on the bus
+    void report_writer() {
+        ServoWriter::Stats st = writer_->stats();
+        if (st.flushes == 0 && st.errors == 0) return;
+        writer_->reset_stats();
+        RCLCPP_INFO(this->get_logger(),
+                    "I2C writer: %lu frames, %lu targets superseded, latency mean %.0fus max %.0fus, "
+                    "%lu overruns, %lu errors",
+                    static_cast<unsigned long>(st.flushes), static_cast<unsigned long>(st.superseded),
+                    st.latency_mean_us, st.latency_max_us,
+                    static_cast<unsigned long>(st.overruns), static_cast<unsigned long>(st.errors));
+    }
 
-            uint8_t start_reg = LED0_ON_L + 4 * servo_id;
-            uint8_t i2c_payload[5];
+    // Absolute targets in degrees for the servos in the mask
+    void process_targets(const gripper::msg::ServoTargets& msg) {
+        std::array<double, SERVO_COUNT> targets = pulses_;
+        uint16_t mask = 0;
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            if (!(msg.mask & (1u << i))) continue;
+            if (!std::isfinite(msg.angle_deg[i])) {
+                RCLCPP_WARN(this->get_logger(), "Servo %d: target is not a number, ignored", i);
+                continue;
+            }
+            targets[i] = SERVO_PULSE_MIN_US + msg.angle_deg[i] * US_PER_DEG;
+            mask |= 1u << i;
+        }
+        if (msg.mask >> SERVO_COUNT) {
+            RCLCPP_WARN(this->get_logger(), "Target mask 0x%04X has bits past servo %d", msg.mask, SERVO_COUNT - 1);
+        }
+        set_pulses(targets, mask);
+    }
 
-            i2c_payload[0] = start_reg;    // Register address to start writing (LEDx_ON_L)
-            i2c_payload[1] = 0x00;         // ON_L = 0 (pulse starts at count 0)
-            i2c_payload[2] = 0x00;         // ON_H = 0
-            i2c_payload[3] = static_cast<uint8_t>(off_value & 0xFF);       // OFF_L
-            i2c_payload[4] = static_cast<uint8_t>((off_value >> 8) & 0xFF); // OFF_H
+    // Targets and the trajectory's position and speed, in degrees
+    void publish_state() {
+        ServoWriter::State state = writer_->state();
+        auto msg = std::make_unique<gripper::msg::ServoState>();
+        msg->stamp = this->now();
+        for (int i = 0; i < SERVO_COUNT; ++i) {
+            msg->target_deg[i] = static_cast<float>((state.target[i] - SERVO_PULSE_MIN_US) / US_PER_DEG);
+            msg->position_deg[i] = static_cast<float>((state.position[i] - SERVO_PULSE_MIN_US) / US_PER_DEG);
+            msg->velocity_deg_s[i] = static_cast<float>(state.velocity[i] / US_PER_DEG);
+            if (state.velocity[i] != 0 || state.position[i] != state.target[i]) msg->moving |= 1u << i;
+        }
+        state_publisher_->publish(std::move(msg));
+    }
 
-            if (write(i2c_fd_, i2c_payload, 5) != 5) {
-                RCLCPP_ERROR(this->get_logger(), "PWM set failed for servo %d. Reg: 0x%02X. Error: %s",
-                             servo_id, start_reg, strerror(errno));
-            } else {
-                RCLCPP_INFO(this->get_logger(),
-                            "Servo %d -> %d° (Pulse: %dµs, PCA_val: %d). Reg: 0x%02X",
-                            servo_id, new_angle, pulse_us, off_value, start_reg);
+    // [servo_id, delta] pairs from the keyboard (delta in degrees),
+    // applied as one frame
+    void process_commands(const std::vector<int32_t>& data) {
+        std::array<double, SERVO_COUNT> targets = pulses_;
+        uint16_t mask = 0;
+        for (size_t k = 0; k + 1 < data.size(); k += 2) {
+            int32_t servo_id = data[k];
+            int32_t delta = data[k + 1];
+            if (servo_id < 0 || servo_id >= SERVO_COUNT) {
+                RCLCPP_WARN(this->get_logger(), "Invalid servo ID: %d. Max ID: %d", servo_id, SERVO_COUNT - 1);
+                continue;
             }
+            targets[servo_id] += delta * US_PER_DEG;
+            mask |= 1u << servo_id;
         }
+        set_pulses(targets, mask);
     }
 };
 
-int main(int argc, char **argv) {
-    rclcpp::init(argc, argv);
-    auto node = std::make_shared<ServoController>();
-
-    // Enable debug output if needed
-    // auto ret = rcutils_logging_set_logger_level(
-    //     node->get_logger().get_name(), RCUTILS_LOG_SEVERITY_DEBUG);
-    // if (ret != RCUTILS_RET_OK) {
-    //     RCLCPP_ERROR(node->get_logger(), "Failed to set logger level to DEBUG");
-    // }
-
-    rclcpp::spin(node);
-    rclcpp::shutdown();
-    return 0;
-}
+// A component, so it can share a container (and intra-process messages)
+// with the keyboard node; the servo executable is generated from it.
+// Debug output: --ros-args --log-level servo_controller:=debug
+RCLCPP_COMPONENTS_REGISTER_NODE(ServoController)
@@ -0,0 +1,203 @@
+// Command-to-bus latency of the servo node's I2C path, without ROS or the
+// PCA9685: the mock bus takes as long as a real one at the given SCL rate.
+//
+//   servo_bench [bus_hz] [seconds_per_rate]
+//   servo_bench calibration [file] [--dump]
+//
+// For each command rate it compares writing every command straight from
+// the caller (the old subscription callback) against ServoWriter flushing
+// the newest targets once per PWM frame.
+//
+// 'calibration' builds the count table from a calibration file (the
+// node's calibration_file; defaults without one) and checks the register
+// value of every channel at every whole degree against the exact formula,
+// read back from the mock PCA9685. --dump prints them all as CSV.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "pca9685.hpp"
+#include "servo_calibration.hpp"
+#include "servo_writer.hpp"
+
+#define SERVO_COUNT 13
+#define FRAME_RATE_HZ 305.0
+#define PRESCALE 19
+
+static const ServoCountTable default_table(ServoCalibrations(), PRESCALE);
+
+static double now_us() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Commands arrive every 'interval_us'; each one waits for the bus if the
+// previous writes are still going (the executor is blocked meanwhile)
+static void bench_direct(uint32_t bus_hz, double rate_hz, double seconds) {
+    MockI2cBus bus;
+    bus.set_bit_rate(bus_hz);
+    Pca9685 pca(bus);
+    pca.initialize(PRESCALE);
+
+    double interval_us = 1e6 / rate_hz;
+    double start = now_us();
+    double next = start;
+    double sum = 0, max = 0;
+    unsigned long n = 0;
+    Pca9685::Frame frame = {};
+    while (next - start < seconds * 1e6) {
+        int servo = n % SERVO_COUNT;
+        frame[servo] = static_cast<uint16_t>(1000 + (n % 200));
+        pca.write_frame(frame, 1u << servo);
+        double latency = now_us() - next;       // queued since 'next'
+        sum += latency;
+        if (latency > max) max = latency;
+        n++;
+        next += interval_us;
+        double wait = next - now_us();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long>(wait)));
+    }
+    printf("  direct  %6.0f cmd/s: %7lu cmds, latency mean %8.0f us, max %8.0f us, %8lu bus bytes\n",
+           rate_hz, n, sum / n, max, static_cast<unsigned long>(bus.bytes()));
+}
+
+static void bench_writer(uint32_t bus_hz, double rate_hz, double seconds) {
+    MockI2cBus bus;
+    bus.set_bit_rate(bus_hz);
+    Pca9685 pca(bus);
+    pca.initialize(PRESCALE);
+    // No motion limits: every target is written on the next frame
+    ServoWriter writer(pca, default_table, FRAME_RATE_HZ, TrajectoryLimits{1e9, 1e9, 0});
+    writer.start(0);
+
+    double interval_us = 1e6 / rate_hz;
+    double start = now_us();
+    double next = start;
+    unsigned long n = 0;
+    ServoTrajectory::Pulses pulses = {};
+    while (next - start < seconds * 1e6) {
+        int servo = n % SERVO_COUNT;
+        pulses[servo] = 1000 + (n % 200) * 5;
+        writer.set_pulses(pulses, 1u << servo);
+        n++;
+        next += interval_us;
+        double wait = next - now_us();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long>(wait)));
+    }
+    writer.stop();
+    ServoWriter::Stats st = writer.stats();
+    printf("  writer  %6.0f cmd/s: %7lu cmds, latency mean %8.0f us, max %8.0f us, %8lu bus bytes "
+           "(%lu frames, %lu superseded, %lu overruns)\n",
+           rate_hz, n, st.latency_mean_us, st.latency_max_us, static_cast<unsigned long>(bus.bytes()),
+           static_cast<unsigned long>(st.flushes), static_cast<unsigned long>(st.superseded),
+           static_cast<unsigned long>(st.overruns));
+}
+
+// Pulse for a nominal pulse and OFF count for it, worked out here in full
+// from the calibration and the period
+static double calibrated_pulse(const ServoCalibration& cal, double nominal_us) {
+    double f = (nominal_us - SERVO_PULSE_MIN_US) / (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US);
+    if (cal.inverted) f = 1 - f;
+    return cal.min_us + f * (cal.max_us - cal.min_us) + cal.trim_us;
+}
+
+static long exact_count(const ServoCalibration& cal, double period_us, double nominal_us) {
+    long count = std::lround(calibrated_pulse(cal, nominal_us) * 4096 / period_us);
+    return count < 0 ? 0 : count > 4095 ? 4095 : count;
+}
+
+// Every channel at every whole degree, read back from the register the mock
+// ends up holding. The table has the nominal pulse on a quarter-us grid, so
+// the register must be the exact count of the grid point the degree falls
+// on. Against the degree itself it is off by the grid's rounding only: at
+// most 1/8 us of nominal pulse, scaled by the servo's range.
+static int run_calibration_checks(const char* path, bool dump) {
+    ServoCalibrations cals;
+    if (path) {
+        std::string error;
+        if (!load_calibration_file(path, cals, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+    ServoCountTable table(cals, PRESCALE);
+    const double period_us = 4096.0 * (PRESCALE + 1) / 25.0;    // 25 MHz oscillator
+    MockI2cBus bus;
+    Pca9685 pca(bus);
+    pca.initialize(PRESCALE);
+
+    printf("%s, prescale %d: period %.1f us (%.2f Hz)\n", path ? path : "default calibration",
+           PRESCALE, table.period_us(), 1e6 / table.period_us());
+    if (dump) printf("channel,angle,pulse_us,count\n");
+    int failures = 0;
+    for (int c = 0; c < SERVO_COUNT; ++c) {
+        const ServoCalibration& cal = table.calibration(c);
+        // Grid rounding in counts, and the most a register may be off the
+        // degree for it
+        const double grid_counts = 0.5 / SERVO_TABLE_STEPS_PER_US * std::fabs(cal.max_us - cal.min_us) /
+                                   (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) * 4096 / period_us;
+        const int bound = static_cast<int>(std::ceil(grid_counts + 1)) - 1;
+        int prev = -1, worst = 0;
+        bool monotonic = true;
+        for (int angle = 0; angle <= 180; ++angle) {
+            double nominal = SERVO_PULSE_MIN_US + angle * (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) / 180;
+            double grid = SERVO_PULSE_MIN_US +
+                std::floor((nominal - SERVO_PULSE_MIN_US) * SERVO_TABLE_STEPS_PER_US + 0.5) / SERVO_TABLE_STEPS_PER_US;
+            long expected = exact_count(cal, period_us, grid);
+            long at_degree = exact_count(cal, period_us, nominal);
+
+            Pca9685::Frame frame = {};
+            frame[c] = table.count(c, nominal);
+            pca.write_frame(frame, 1u << c);
+            int count = bus.off_count(c);
+            int off = std::abs(count - static_cast<int>(at_degree));
+            if (off > worst) worst = off;
+            if (count != expected || off > bound) {
+                if (failures++ < 10) {
+                    printf("    ch %d %3d°: register %d, expected %ld (%ld at the degree)\n",
+                           c, angle, count, expected, at_degree);
+                }
+            }
+            if (prev >= 0 && (cal.inverted ? count > prev : count < prev)) monotonic = false;
+            prev = count;
+            if (dump) printf("%d,%d,%.2f,%d\n", c, angle, calibrated_pulse(cal, nominal), count);
+        }
+        if (!monotonic) failures++;
+        if (!dump) {
+            printf("  ch %2d %6.1f-%6.1f us trim %+5.1f%s: 0° %4d, 90° %4d, 180° %4d counts, "
+                   "%d off the degree (%d allowed)%s\n",
+                   c, cal.min_us, cal.max_us, cal.trim_us, cal.inverted ? " inv" : "    ",
+                   table.count(c, SERVO_PULSE_MIN_US), table.count(c, 1500), table.count(c, SERVO_PULSE_MAX_US),
+                   worst, bound, monotonic ? "" : ", NOT monotonic");
+        }
+    }
+    printf("%s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "calibration") == 0) {
+        const char* path = nullptr;
+        bool dump = false;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--dump") == 0) dump = true;
+            else path = argv[i];
+        }
+        return run_calibration_checks(path, dump);
+    }
+
+    uint32_t bus_hz = argc > 1 ? static_cast<uint32_t>(atol(argv[1])) : 100000;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+
+    printf("Mock PCA9685 at %u Hz SCL, %.1f s per rate\n", bus_hz, seconds);
+    const double rates[] = {20, 100, 1000, 5000};
+    for (double rate : rates) {
+        bench_direct(bus_hz, rate, seconds);
+        bench_writer(bus_hz, rate, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "servo_calibration.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+bool load_calibration_file(const std::string& path, ServoCalibrations& cals, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        int channel;
+        if (!(fields >> channel)) continue;     // blank or comment
+
+        ServoCalibration cal;
+        int inverted = 0;
+        if (!(fields >> cal.min_us >> cal.max_us >> cal.trim_us >> inverted) ||
+            channel < 0 || channel >= PCA9685_CHANNELS || cal.min_us <= 0 || cal.max_us <= 0) {
+            error = path + ":" + std::to_string(line_no) + ": expected 'channel min_us max_us trim_us inverted'";
+            return false;
+        }
+        cal.inverted = inverted != 0;
+        cals[channel] = cal;
+    }
+    return true;
+}
+
+double ServoCountTable::period_us(uint8_t prescale) {
+    return PCA9685_COUNTS * (prescale + 1) * 1e6 / PCA9685_OSC_HZ;
+}
+
+uint16_t ServoCountTable::compute(const ServoCalibration& cal, double period_us, double nominal_us) {
+    double f = (nominal_us - SERVO_PULSE_MIN_US) / (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US);
+    f = std::fmin(std::fmax(f, 0.0), 1.0);
+    if (cal.inverted) f = 1.0 - f;
+    double pulse_us = cal.min_us + f * (cal.max_us - cal.min_us) + cal.trim_us;
+    double off_value = std::round(pulse_us * PCA9685_COUNTS / period_us);
+    if (off_value < 0) return 0;
+    return off_value > PCA9685_COUNTS - 1 ? PCA9685_COUNTS - 1 : static_cast<uint16_t>(off_value);
+}
+
+ServoCountTable::ServoCountTable(const ServoCalibrations& cals, uint8_t prescale)
+    : cals_(cals), period_us_(period_us(prescale)), counts_(PCA9685_CHANNELS) {
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        for (int i = 0; i < SIZE; ++i) {
+            counts_[c][i] = compute(cals_[c], period_us_, SERVO_PULSE_MIN_US + double(i) / SERVO_TABLE_STEPS_PER_US);
+        }
+    }
+}
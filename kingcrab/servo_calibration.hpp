@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pca9685.hpp"
+
+// Nominal pulse range the node and the trajectories work in: 0-180°.
+// Each channel's calibration maps it onto that servo's real range.
+#define SERVO_PULSE_MIN_US 1000.0
+#define SERVO_PULSE_MAX_US 2000.0
+#define SERVO_TABLE_STEPS_PER_US 4      // well under one count (0.8 us at 305 Hz)
+
+struct ServoCalibration {
+    double min_us = SERVO_PULSE_MIN_US;     // pulse at 0°
+    double max_us = SERVO_PULSE_MAX_US;     // pulse at 180°
+    double trim_us = 0;                     // added after scaling
+    bool inverted = false;                  // 0° <-> 180°
+};
+
+typedef std::array<ServoCalibration, PCA9685_CHANNELS> ServoCalibrations;
+
+// Reads "channel min_us max_us trim_us inverted" lines ('#' starts a
+// comment) over the defaults already in 'cals'. False with a message in
+// 'error' on a bad line or an unreadable file.
+bool load_calibration_file(const std::string& path, ServoCalibrations& cals, std::string& error);
+
+// OFF count for every channel and nominal pulse, computed once from the
+// calibrations and the exact PWM period of the prescale, so a frame is a
+// table read per channel.
+class ServoCountTable {
+public:
+    static constexpr int SIZE =
+        static_cast<int>((SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) * SERVO_TABLE_STEPS_PER_US) + 1;
+
+    ServoCountTable(const ServoCalibrations& cals, uint8_t prescale);
+
+    // PWM period for a prescale: 4096 * (prescale + 1) / 25 MHz
+    static double period_us(uint8_t prescale);
+
+    // The exact value the table holds for a nominal pulse (no table)
+    static uint16_t compute(const ServoCalibration& cal, double period_us, double nominal_us);
+
+    uint16_t count(int channel, double nominal_us) const {
+        double i = (nominal_us - SERVO_PULSE_MIN_US) * SERVO_TABLE_STEPS_PER_US + 0.5;
+        int index = i < 0 ? 0 : i >= SIZE ? SIZE - 1 : static_cast<int>(i);
+        return counts_[channel][index];
+    }
+
+    double period_us() const { return period_us_; }
+    const ServoCalibration& calibration(int channel) const { return cals_[channel]; }
+
+private:
+    ServoCalibrations cals_;
+    double period_us_;
+    std::vector<std::array<uint16_t, SIZE>> counts_;
+};
@@ -0,0 +1,86 @@
+#include "servo_trajectory.hpp"
+
+#include <cmath>
+
+// Closer than this (and slow enough to stop in one step) counts as there
+static constexpr double SETTLE_US = 0.05;
+
+ServoTrajectory::ServoTrajectory(const TrajectoryLimits& limits) : limits_(limits) {
+    position_.fill(0);
+    velocity_.fill(0);
+    target_.fill(0);
+}
+
+void ServoTrajectory::set_position(int channel, double pulse_us) {
+    position_[channel] = pulse_us;
+    target_[channel] = pulse_us;
+    velocity_[channel] = 0;
+}
+
+void ServoTrajectory::set_target(int channel, double pulse_us) {
+    target_[channel] = pulse_us;
+}
+
+bool ServoTrajectory::moving() const {
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        if (velocity_[c] != 0 || position_[c] != target_[c]) return true;
+    }
+    return false;
+}
+
+void ServoTrajectory::step(double dt) {
+    const double dv = limits_.max_accel_us_s2 * dt;
+    Pulses next;
+    double held = 0;        // speed of the channels that do not speed up
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        double v = velocity_[c];
+        double d = target_[c] - position_[c];
+        if (std::fabs(d) < SETTLE_US && std::fabs(v) <= dv) {
+            next[c] = 0;
+            continue;
+        }
+        // Fastest speed that can still brake, dv per step, to a stop on
+        // the target: (k + ... + 1) * dv * dt = |d| for v = k * dv
+        double k = (std::sqrt(1.0 + 8.0 * std::fabs(d) / (dt * dv)) - 1.0) / 2.0;
+        double v_stop = k * dv;
+        double v_want = std::copysign(std::fmin(limits_.max_velocity_us_s, v_stop), d);
+        double v_next = std::fmin(std::fmax(v_want, v - dv), v + dv);
+        next[c] = v_next;
+        if (!(std::fabs(v_next) > std::fabs(v) && v_next * v >= 0)) held += std::fabs(v_next);
+    }
+
+    // Speed-ups share what the budget leaves. Each keeps at least its
+    // current speed: last step's total was within the budget.
+    if (limits_.motion_budget_us_s > 0) {
+        double spare = limits_.motion_budget_us_s - held;
+        for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+            double v = velocity_[c];
+            if (!(std::fabs(next[c]) > std::fabs(v) && next[c] * v >= 0)) continue;
+            spare -= std::fabs(v);
+        }
+        for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+            double v = velocity_[c];
+            if (!(std::fabs(next[c]) > std::fabs(v) && next[c] * v >= 0)) continue;
+            double extra = std::fabs(next[c]) - std::fabs(v);
+            if (extra > spare) extra = spare > 0 ? spare : 0;
+            spare -= extra;
+            next[c] = std::copysign(std::fabs(v) + extra, next[c]);
+        }
+    }
+
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        double d = target_[c] - position_[c];
+        double moved = next[c] * dt;
+        if (next[c] == 0 && std::fabs(d) < SETTLE_US) {
+            position_[c] = target_[c];
+            velocity_[c] = 0;
+        } else if (moved != 0 && std::fabs(moved) >= std::fabs(d) && moved * d > 0 && std::fabs(next[c]) <= dv) {
+            // Lands this step, slow enough to stop within the limit
+            position_[c] = target_[c];
+            velocity_[c] = 0;
+        } else {
+            position_[c] += moved;
+            velocity_[c] = next[c];
+        }
+    }
+}
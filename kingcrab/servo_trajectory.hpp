@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "pca9685.hpp"
+
+// Per-channel motion toward the commanded pulse widths, stepped at a fixed
+// rate by the writer thread. Each channel follows a trapezoid: accelerate
+// at no more than max_accel, cruise at no more than max_velocity, and
+// brake so it stops on the target. All in microseconds of pulse width, so
+// a step can be a fraction of a degree.
+//
+// The 6 V buck rail feeds every servo, and a servo draws most while it
+// moves. motion_budget caps the sum of all channel speeds: a channel may
+// only speed up with what the others leave, in channel order; slowing
+// down is never held back, so the acceleration limit always holds.
+struct TrajectoryLimits {
+    double max_velocity_us_s;   // per channel
+    double max_accel_us_s2;     // per channel
+    double motion_budget_us_s;  // sum over all channels, 0 = no cap
+};
+
+class ServoTrajectory {
+public:
+    typedef std::array<double, PCA9685_CHANNELS> Pulses;
+
+    explicit ServoTrajectory(const TrajectoryLimits& limits);
+
+    void set_limits(const TrajectoryLimits& limits) { limits_ = limits; }
+    const TrajectoryLimits& limits() const { return limits_; }
+
+    // Where a channel is now (its first target starts from here)
+    void set_position(int channel, double pulse_us);
+    void set_target(int channel, double pulse_us);
+
+    // Advance every channel by dt seconds
+    void step(double dt);
+
+    double position(int channel) const { return position_[channel]; }
+    double velocity(int channel) const { return velocity_[channel]; }
+    double target(int channel) const { return target_[channel]; }
+    bool moving() const;
+
+private:
+    TrajectoryLimits limits_;
+    Pulses position_;
+    Pulses velocity_;
+    Pulses target_;
+};
@@ -0,0 +1,138 @@
+#include "servo_writer.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+
+static int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ServoWriter::ServoWriter(Pca9685& pca, const ServoCountTable& table, double rate_hz,
+                         const TrajectoryLimits& limits)
+    : pca_(pca), table_(table), rate_hz_(rate_hz), trajectory_(limits) {
+    for (auto& t : targets_) t.store(0, std::memory_order_relaxed);
+}
+
+void ServoWriter::set_position(int channel, double pulse_us) {
+    trajectory_.set_position(channel, pulse_us);
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    state_.target[channel] = pulse_us;
+    state_.position[channel] = pulse_us;
+}
+
+ServoWriter::~ServoWriter() {
+    stop();
+}
+
+bool ServoWriter::start(int rt_priority) {
+    if (running_.exchange(true)) return true;
+    thread_ = std::thread([this]() { run(); });
+    if (rt_priority <= 0) return true;
+    sched_param param = {};
+    param.sched_priority = rt_priority;
+    return pthread_setschedparam(thread_.native_handle(), SCHED_FIFO, &param) == 0;
+}
+
+void ServoWriter::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    flush();    // whatever came in last
+}
+
+void ServoWriter::set_pulses(const ServoTrajectory::Pulses& pulses, uint16_t mask) {
+    if (!mask) return;
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        if (mask & (1u << c)) targets_[c].store(static_cast<float>(pulses[c]), std::memory_order_relaxed);
+    }
+    uint16_t before = dirty_.fetch_or(mask, std::memory_order_release);
+    int64_t none = 0;
+    pending_since_ns_.compare_exchange_strong(none, monotonic_ns(), std::memory_order_relaxed);
+    if (before & mask) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.superseded += __builtin_popcount(before & mask);
+    }
+}
+
+// Absolute deadlines on CLOCK_MONOTONIC, so the rate does not drift with
+// the time a flush takes. A late flush skips the periods it missed.
+void ServoWriter::run() {
+    const int64_t period_ns = static_cast<int64_t>(1e9 / rate_hz_);
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running_.load(std::memory_order_relaxed)) {
+        flush();
+
+        int64_t next_ns = next.tv_sec * 1000000000LL + next.tv_nsec + period_ns;
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+        if (now_ns > next_ns) {
+            int64_t missed = (now_ns - next_ns) / period_ns + 1;
+            next_ns += missed * period_ns;
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.overruns++;
+        }
+        next.tv_sec = next_ns / 1000000000LL;
+        next.tv_nsec = next_ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+    }
+}
+
+void ServoWriter::flush() {
+    uint16_t mask = dirty_.exchange(0, std::memory_order_acquire);
+    int64_t since_ns = pending_since_ns_.exchange(0, std::memory_order_relaxed);
+    for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+        if (mask & (1u << c)) trajectory_.set_target(c, targets_[c].load(std::memory_order_relaxed));
+    }
+    active_ |= mask;
+    if (!mask && !trajectory_.moving()) return;
+
+    // One trajectory step per flush; only counts that changed hit the bus
+    trajectory_.step(1.0 / rate_hz_);
+    Pca9685::Frame frame = {};
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        for (int c = 0; c < PCA9685_CHANNELS; ++c) {
+            if (active_ & (1u << c)) frame[c] = table_.count(c, trajectory_.position(c));
+            state_.target[c] = trajectory_.target(c);
+            state_.position[c] = trajectory_.position(c);
+            state_.velocity[c] = trajectory_.velocity(c);
+        }
+    }
+    bool ok = pca_.write_frame(frame, active_);
+    int64_t done_ns = monotonic_ns();
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (!ok) {
+        stats_.errors++;
+        return;
+    }
+    stats_.flushes++;
+    if (since_ns && mask) {
+        double us = (done_ns - since_ns) / 1000.0;
+        stats_.latency_count++;
+        latency_sum_us_ += us;
+        if (us > stats_.latency_max_us) stats_.latency_max_us = us;
+        stats_.latency_mean_us = latency_sum_us_ / stats_.latency_count;
+    }
+}
+
+ServoWriter::State ServoWriter::state() const {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return state_;
+}
+
+ServoWriter::Stats ServoWriter::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+void ServoWriter::reset_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_ = {};
+    latency_sum_us_ = 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "pca9685.hpp"
+#include "servo_calibration.hpp"
+#include "servo_trajectory.hpp"
+
+// Flushes servo targets to the PCA9685 from its own thread at a fixed
+// rate (one flush per PWM frame by default), so a slow bus never stalls
+// the ROS executor and a burst of commands never queues up behind it.
+//
+// Callers only store the newest pulse width per channel and mark it
+// dirty; a target replaced before the next flush is simply never used.
+// Each flush steps the trajectory (servo_trajectory.hpp) toward the
+// targets, looks the positions up in the count table and writes the
+// channels whose count changed. The writer thread
+// owns the Pca9685 and the trajectory from start() to stop().
+class ServoWriter {
+public:
+    struct Stats {
+        uint64_t flushes;           // frames written
+        uint64_t superseded;        // targets replaced before they were written
+        uint64_t errors;            // failed bus writes
+        uint64_t overruns;          // flush took longer than the period
+        uint64_t latency_count;     // command stored -> frame on the bus
+        double latency_mean_us;
+        double latency_max_us;
+    };
+
+    // Where the trajectory has every channel, as of the last flush
+    struct State {
+        ServoTrajectory::Pulses target;
+        ServoTrajectory::Pulses position;
+        ServoTrajectory::Pulses velocity;
+    };
+
+    ServoWriter(Pca9685& pca, const ServoCountTable& table, double rate_hz, const TrajectoryLimits& limits);
+    ~ServoWriter();
+
+    ServoWriter(const ServoWriter&) = delete;
+    ServoWriter& operator=(const ServoWriter&) = delete;
+
+    // Start the thread, SCHED_FIFO at 'rt_priority' if allowed (0 = normal
+    // scheduling). Returns false if the priority could not be set; the
+    // thread runs anyway.
+    bool start(int rt_priority);
+    void stop();
+
+    // Before start(): where a channel is assumed to be until its first
+    // target (its first frame is written from here)
+    void set_position(int channel, double pulse_us);
+
+    // Any thread: the newest targets (us) for the channels in 'mask'
+    void set_pulses(const ServoTrajectory::Pulses& pulses, uint16_t mask);
+
+    double rate_hz() const { return rate_hz_; }
+    State state() const;
+    Stats stats() const;
+    void reset_stats();
+
+private:
+    void run();
+    void flush();
+
+    Pca9685& pca_;
+    const ServoCountTable& table_;
+    double rate_hz_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::array<std::atomic<float>, PCA9685_CHANNELS> targets_;
+    std::atomic<uint16_t> dirty_{0};
+    ServoTrajectory trajectory_;        // writer thread
+    uint16_t active_ = 0;               // channels with a target, writer thread
+    std::atomic<int64_t> pending_since_ns_{0};      // oldest unflushed set, 0 = none
+
+    mutable std::mutex state_mutex_;
+    State state_ = {};
+
+    mutable std::mutex stats_mutex_;
+    Stats stats_ = {};
+    double latency_sum_us_ = 0;
+};
@@ -0,0 +1,128 @@
+// KeyInput on a pty, typed on the master side as a terminal would: escape
+// sequences from arrow and function keys are skipped without losing the
+// keys around them, and only an ESC on its own is passed on (quit).
+//
+//   colcon test --packages-select gripper --ctest-args -R test_key_input
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "key_input.hpp"
+
+class KeyInputTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        ASSERT_GE(master_, 0);
+        ASSERT_EQ(0, grantpt(master_));
+        ASSERT_EQ(0, unlockpt(master_));
+        slave_ = open(ptsname(master_), O_RDWR | O_NOCTTY);
+        ASSERT_GE(slave_, 0);
+
+        input_ = std::make_unique<KeyInput>(slave_, config_,
+            [this](const std::vector<int32_t>& pairs) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pairs_.insert(pairs_.end(), pairs.begin(), pairs.end());
+            },
+            [this](char key) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                others_.push_back(key);
+            });
+        // The node's map: a/b servo 0 +/-, c/d servo 1 +/-, ...
+        char key = 'a';
+        for (int servo = 0; servo < 13; servo++) {
+            input_->map_key(key++, servo, +1);
+            input_->map_key(key++, servo, -1);
+        }
+        ASSERT_TRUE(input_->start());
+    }
+
+    void TearDown() override {
+        if (input_) input_->stop();
+        if (slave_ >= 0) close(slave_);
+        if (master_ >= 0) close(master_);
+    }
+
+    // One write on the master side, then time for the input thread
+    void type(const char* bytes) {
+        size_t n = strlen(bytes);
+        ASSERT_EQ(static_cast<ssize_t>(n), write(master_, bytes, n));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // [servo, +/-step_deg] of single presses of 'keys'
+    std::vector<int32_t> presses(const char* keys) const {
+        std::vector<int32_t> out;
+        for (const char* k = keys; *k; ++k) {
+            int index = *k - 'a';
+            out.push_back(index / 2);
+            out.push_back(index % 2 ? -config_.step_deg : config_.step_deg);
+        }
+        return out;
+    }
+
+    std::vector<int32_t> pairs() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pairs_;
+    }
+
+    std::vector<char> others() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return others_;
+    }
+
+    KeyInputConfig config_;
+    int master_ = -1;
+    int slave_ = -1;
+    std::unique_ptr<KeyInput> input_;
+    std::mutex mutex_;
+    std::vector<int32_t> pairs_;
+    std::vector<char> others_;
+};
+
+// The key typed right after an arrow, in the same read
+TEST_F(KeyInputTest, KeyAfterArrowCounts) {
+    type("\x1b[Aw");
+    EXPECT_EQ(presses("w"), pairs());
+    EXPECT_TRUE(others().empty());
+}
+
+// CSI with parameters (Ctrl+Right, F5), SS3 (F1) and keys in between
+TEST_F(KeyInputTest, SequencesWithParametersSkipped) {
+    type("c\x1b[1;5Ce\x1bOPg\x1b[15~i");
+    EXPECT_EQ(presses("cegi"), pairs());
+    EXPECT_TRUE(others().empty());
+}
+
+// A sequence cut between two reads is still skipped as a whole
+TEST_F(KeyInputTest, SequenceAcrossReads) {
+    type("k\x1b[");
+    type("Bm");
+    EXPECT_EQ(presses("km"), pairs());
+    EXPECT_TRUE(others().empty());
+}
+
+// ESC on its own is passed on; so is one right before another ESC
+TEST_F(KeyInputTest, BareEscapePassedOn) {
+    type("o\x1b");
+    type("\x1b\x1b");
+    EXPECT_EQ(presses("o"), pairs());
+    EXPECT_EQ(std::vector<char>({27, 27, 27}), others());
+}
+
+// Alt+key (ESC and the key) is neither a press nor a quit; unmapped keys
+// are passed on
+TEST_F(KeyInputTest, AltKeyIgnored) {
+    type("\x1bq1s");
+    EXPECT_EQ(presses("s"), pairs());
+    EXPECT_EQ(std::vector<char>({'1'}), others());
+}
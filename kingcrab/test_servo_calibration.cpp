@@ -0,0 +1,129 @@
+// ServoCountTable against the count formula worked out here in full, for
+// every channel at every whole degree, read back from the mock PCA9685.
+// The table has the nominal pulse on a quarter-us grid: the register must
+// be exactly the count of the grid point a degree falls on, and at most
+// the grid's rounding (1/8 us of nominal pulse, scaled by the servo's
+// range) off the count of the degree itself.
+//
+//   colcon test --packages-select gripper --ctest-args -R test_servo_calibration
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "pca9685.hpp"
+#include "servo_calibration.hpp"
+
+#define SERVO_COUNT 13
+#define PRESCALE 19
+
+namespace {
+
+const double PERIOD_US = 4096.0 * (PRESCALE + 1) / 25.0;    // 25 MHz oscillator
+
+double calibrated_pulse(const ServoCalibration& cal, double nominal_us) {
+    double f = (nominal_us - SERVO_PULSE_MIN_US) / (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US);
+    if (cal.inverted) f = 1 - f;
+    return cal.min_us + f * (cal.max_us - cal.min_us) + cal.trim_us;
+}
+
+long exact_count(const ServoCalibration& cal, double nominal_us) {
+    long count = std::lround(calibrated_pulse(cal, nominal_us) * 4096 / PERIOD_US);
+    return count < 0 ? 0 : count > 4095 ? 4095 : count;
+}
+
+void check_table(const ServoCalibrations& cals) {
+    ServoCountTable table(cals, PRESCALE);
+    EXPECT_DOUBLE_EQ(PERIOD_US, table.period_us());
+    MockI2cBus bus;
+    Pca9685 pca(bus);
+    ASSERT_TRUE(pca.initialize(PRESCALE));
+
+    for (int c = 0; c < SERVO_COUNT; ++c) {
+        const ServoCalibration& cal = cals[c];
+        const double grid_counts = 0.5 / SERVO_TABLE_STEPS_PER_US * std::fabs(cal.max_us - cal.min_us) /
+                                   (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) * 4096 / PERIOD_US;
+        const long bound = static_cast<long>(std::ceil(grid_counts + 1)) - 1;
+        int prev = -1;
+        for (int angle = 0; angle <= 180; ++angle) {
+            double nominal = SERVO_PULSE_MIN_US + angle * (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) / 180;
+            double grid = SERVO_PULSE_MIN_US +
+                std::floor((nominal - SERVO_PULSE_MIN_US) * SERVO_TABLE_STEPS_PER_US + 0.5) / SERVO_TABLE_STEPS_PER_US;
+
+            Pca9685::Frame frame = {};
+            frame[c] = table.count(c, nominal);
+            ASSERT_TRUE(pca.write_frame(frame, 1u << c));
+            int count = bus.off_count(c);
+            ASSERT_EQ(exact_count(cal, grid), count) << "ch " << c << " at " << angle << " deg";
+            ASSERT_LE(std::labs(count - exact_count(cal, nominal)), bound) << "ch " << c << " at " << angle << " deg";
+            if (prev >= 0) {
+                if (cal.inverted) ASSERT_LE(count, prev) << "ch " << c << " at " << angle << " deg";
+                else ASSERT_GE(count, prev) << "ch " << c << " at " << angle << " deg";
+            }
+            prev = count;
+        }
+    }
+}
+
+// A calibration file in the temp directory, removed again
+class CalibrationFile {
+public:
+    explicit CalibrationFile(const char* text) {
+        char path[] = "/tmp/servo_calXXXXXX";
+        int fd = mkstemp(path);
+        path_ = path;
+        if (fd >= 0) {
+            ssize_t n = write(fd, text, std::string(text).size());
+            (void)n;
+            close(fd);
+        }
+    }
+    ~CalibrationFile() { unlink(path_.c_str()); }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+}  // namespace
+
+TEST(ServoCalibrationTest, DefaultTable) {
+    check_table(ServoCalibrations());
+}
+
+// Narrower, wider, inverted, fractional and clamped ranges
+TEST(ServoCalibrationTest, CalibrationFile) {
+    CalibrationFile file(
+        "# channel min_us max_us trim_us inverted\n"
+        "0 1100 1900 0 0\n"
+        "1 900 2100 12.5 1   # wide, trimmed, inverted\n"
+        "\n"
+        "2 500 2500 -3.3 0\n"
+        "3 1000 2000 0 1\n"
+        "4 1234.5 1876.25 0.75 0\n"
+        "12 1000 2000 2000 0\n");
+    ServoCalibrations cals;
+    std::string error;
+    ASSERT_TRUE(load_calibration_file(file.path(), cals, error)) << error;
+    EXPECT_DOUBLE_EQ(900, cals[1].min_us);
+    EXPECT_DOUBLE_EQ(12.5, cals[1].trim_us);
+    EXPECT_TRUE(cals[1].inverted);
+    EXPECT_DOUBLE_EQ(SERVO_PULSE_MIN_US, cals[5].min_us);
+    check_table(cals);
+
+    // Past the top of the period the register holds 4095
+    ServoCountTable table(cals, PRESCALE);
+    EXPECT_EQ(4095, table.count(12, SERVO_PULSE_MAX_US));
+}
+
+TEST(ServoCalibrationTest, BadLineRejected) {
+    CalibrationFile file("0 1000 2000 0 0\n16 1000 2000 0 0\n");
+    ServoCalibrations cals;
+    std::string error;
+    EXPECT_FALSE(load_calibration_file(file.path(), cals, error));
+    EXPECT_NE(std::string::npos, error.find(":2:")) << error;
+}
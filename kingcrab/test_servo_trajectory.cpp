@@ -0,0 +1,128 @@
+// ServoTrajectory through a few target patterns at the node's defaults,
+// every frame written to the mock PCA9685. The OFF counts that land in its
+// registers must keep to the velocity, acceleration and motion budget
+// limits, and the servos must settle on their targets.
+//
+//   colcon test --packages-select gripper --ctest-args -R test_servo_trajectory
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "pca9685.hpp"
+#include "servo_calibration.hpp"
+#include "servo_trajectory.hpp"
+
+#define SERVO_COUNT 13
+#define FRAME_RATE_HZ 305.0
+#define PRESCALE 19
+
+namespace {
+
+const uint16_t ALL = (1u << SERVO_COUNT) - 1;
+const int FRAMES = 4 * static_cast<int>(FRAME_RATE_HZ);
+
+// The node's defaults, deg -> us at 1000 us per 180 deg
+const double US_PER_DEG = 1000.0 / 180.0;
+const TrajectoryLimits LIMITS = {120 * US_PER_DEG, 600 * US_PER_DEG, 300 * US_PER_DEG};
+
+// One target change: at 'step', set the channels in 'mask' to 'pulse_us'
+struct TargetStep {
+    int step;
+    uint16_t mask;
+    double pulse_us;
+};
+
+// Runs the steps and checks each frame's counts against the limits. Each
+// count may be off its exact position by the rounding plus half a table
+// step, so a step gets twice that as tolerance and a change of step four
+// times; the total speed is also checked exactly on the trajectory's own
+// positions.
+void check_trajectory(const TrajectoryLimits& limits, const std::vector<TargetStep>& steps, int frames) {
+    const ServoCountTable table(ServoCalibrations(), PRESCALE);
+    MockI2cBus bus;
+    Pca9685 pca(bus);
+    ASSERT_TRUE(pca.initialize(PRESCALE));
+    ServoTrajectory traj(limits);
+    for (int c = 0; c < SERVO_COUNT; ++c) traj.set_position(c, 1500);
+
+    const double dt = 1.0 / FRAME_RATE_HZ;
+    const double counts_per_us = PCA9685_COUNTS / table.period_us();
+    const double quantum = 0.5 + 0.5 / SERVO_TABLE_STEPS_PER_US * counts_per_us;
+    const double max_dc = limits.max_velocity_us_s * dt * counts_per_us + 2 * quantum;
+    const double max_ddc = limits.max_accel_us_s2 * dt * dt * counts_per_us + 4 * quantum;
+
+    int prev[SERVO_COUNT], prev_dc[SERVO_COUNT] = {};
+    double prev_us[SERVO_COUNT];
+    for (int c = 0; c < SERVO_COUNT; ++c) {
+        prev[c] = table.count(c, 1500);
+        prev_us[c] = 1500;
+    }
+    int settled_at = -1;
+    size_t next_step = 0;
+    for (int f = 0; f < frames; ++f) {
+        while (next_step < steps.size() && steps[next_step].step == f) {
+            for (int c = 0; c < SERVO_COUNT; ++c) {
+                if (steps[next_step].mask & (1u << c)) traj.set_target(c, steps[next_step].pulse_us);
+            }
+            next_step++;
+            settled_at = -1;
+        }
+        traj.step(dt);
+        Pca9685::Frame frame = {};
+        for (int c = 0; c < SERVO_COUNT; ++c) frame[c] = table.count(c, traj.position(c));
+        ASSERT_TRUE(pca.write_frame(frame, ALL));
+
+        double sum = 0, sum_tol = 0, sum_us = 0;
+        for (int c = 0; c < SERVO_COUNT; ++c) {
+            sum_us += std::fabs(traj.position(c) - prev_us[c]);
+            prev_us[c] = traj.position(c);
+            int count = bus.off_count(c);
+            int dc = count - prev[c];
+            int ddc = dc - prev_dc[c];
+            ASSERT_LE(std::abs(dc), max_dc) << "frame " << f << " ch " << c << ": " << prev[c] << " -> " << count;
+            ASSERT_LE(std::abs(ddc), max_ddc) << "frame " << f << " ch " << c << ": step changed by " << ddc;
+            sum += std::abs(dc);
+            if (dc) sum_tol += 2 * quantum;
+            prev[c] = count;
+            prev_dc[c] = dc;
+        }
+        if (limits.motion_budget_us_s > 0) {
+            ASSERT_LE(sum, limits.motion_budget_us_s * dt * counts_per_us + sum_tol) << "frame " << f;
+            ASSERT_LE(sum_us, limits.motion_budget_us_s * dt + 1e-6) << "frame " << f;
+        }
+        if (settled_at < 0 && !traj.moving()) settled_at = f;
+    }
+
+    EXPECT_GE(settled_at, 0) << "still moving after " << frames << " frames";
+    for (int c = 0; c < SERVO_COUNT; ++c) {
+        EXPECT_EQ(table.count(c, traj.target(c)), bus.off_count(c)) << "ch " << c << " not on target";
+    }
+}
+
+}  // namespace
+
+TEST(ServoTrajectoryTest, Single) {
+    check_trajectory(LIMITS, {{0, 1u << 3, 2000}}, FRAMES);
+}
+
+// Every servo across its range at once: held back by the motion budget
+TEST(ServoTrajectoryTest, All) {
+    check_trajectory(LIMITS, {{0, ALL, 1000}}, 3 * FRAMES);
+}
+
+// New targets the other way while still moving
+TEST(ServoTrajectoryTest, Reverse) {
+    check_trajectory(LIMITS, {{0, 0x0f, 2000}, {150, 0x0f, 1100}}, FRAMES);
+}
+
+TEST(ServoTrajectoryTest, Staggered) {
+    check_trajectory(LIMITS, {{0, 0x01, 1900}, {40, 0x06, 1150}, {80, 0x1ff8, 1800}}, 2 * FRAMES);
+}
+
+// Steps of a few us, under a count each
+TEST(ServoTrajectoryTest, Fine) {
+    check_trajectory(LIMITS, {{0, 0x03, 1502}, {30, 0x03, 1503.5}, {60, 0x03, 1501}}, FRAMES);
+}